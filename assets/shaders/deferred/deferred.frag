@@ -12,18 +12,20 @@ layout(set = 0, binding = 0) uniform WorldUBO {
 }
 worldUBO;
 
-layout(set = 1, binding = 0) uniform sampler2D samplerColorPosition;
-layout(set = 1, binding = 1) uniform sampler2D samplerColorNormal;
-layout(set = 1, binding = 2) uniform sampler2D samplerColorAlbedo;
-
-layout(location = 0) in vec2 outTexCoords;
+/* written by the g-buffer subpass, read at the same pixel */
+layout(input_attachment_index = 0, set = 1,
+       binding = 0) uniform subpassInput inputPosition;
+layout(input_attachment_index = 1, set = 1,
+       binding = 1) uniform subpassInput inputNormal;
+layout(input_attachment_index = 2, set = 1,
+       binding = 2) uniform subpassInput inputAlbedo;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-  vec3 fragPos = texture(samplerColorPosition, outTexCoords).rgb;
-  vec3 normal = texture(samplerColorNormal, outTexCoords).rgb;
-  vec4 albedo = texture(samplerColorAlbedo, outTexCoords);
+  vec3 fragPos = subpassLoad(inputPosition).rgb;
+  vec3 normal = subpassLoad(inputNormal).rgb;
+  vec4 albedo = subpassLoad(inputAlbedo);
 
   vec3 color = albedo.rgb * 0.2;
 
@@ -0,0 +1,22 @@
+#version 450
+
+/* reads only the position of the mrt vertices */
+layout(location = 0) in vec3 inPosition;
+
+layout(set = 0, binding = 0) uniform GlobalUBO {
+  mat4 view;
+  mat4 projection;
+}
+globalUBO;
+layout(set = 1, binding = 0) uniform InstanceUBO { mat4 model; }
+instanceUBO;
+
+/* has to be computed exactly as in mrt.vert */
+invariant gl_Position;
+
+void main() {
+  vec3 worldPosition = vec3(instanceUBO.model * vec4(inPosition, 1.0));
+
+  gl_Position =
+      globalUBO.projection * globalUBO.view * vec4(worldPosition, 1.0);
+}
\ No newline at end of file
@@ -1,4 +1,8 @@
+/* keywords: TEXTURED BINDLESS */
 #version 450
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
 
 layout(location = 0) in vec3 outWorldPosition;
 layout(location = 1) in vec3 outNormal;
@@ -9,19 +13,38 @@ layout(location = 0) out vec4 outPositionColor;
 layout(location = 1) out vec4 outNormalColor;
 layout(location = 2) out vec4 outAlbedoColor;
 
+#if defined(TEXTURED) && defined(BINDLESS)
+/* every texture, selected by the indices of the material */
+layout(set = 2, binding = 0) uniform sampler2D textures[];
+layout(push_constant) uniform MaterialIndices {
+  uint diffuse;
+  uint normal;
+}
+materialIndices;
+#define diffuseMap textures[materialIndices.diffuse]
+#define normalMap textures[materialIndices.normal]
+#elif defined(TEXTURED)
 layout(set = 2, binding = 0) uniform sampler2D diffuseMap;
 layout(set = 2, binding = 1) uniform sampler2D specularMap;
 layout(set = 2, binding = 2) uniform sampler2D normalMap;
+#endif
 
 void main() {
   vec3 N = normalize(outNormal);
+
+  outPositionColor = vec4(outWorldPosition, 1.0);
+#ifdef TEXTURED
   vec3 T = normalize(outTangent);
   vec3 B = cross(N, T);
   mat3 TBN = mat3(T, B, N);
   vec3 tnorm =
       TBN * normalize(texture(normalMap, outTexCoords).xyz * 2.0 - vec3(1.0));
 
-  outPositionColor = vec4(outWorldPosition, 1.0);
   outNormalColor = vec4(tnorm, 1.0);
   outAlbedoColor = texture(diffuseMap, outTexCoords);
-}
\ No newline at end of file
+#else
+  /* untextured meshes are shaded with a flat, non-specular material */
+  outNormalColor = vec4(N, 1.0);
+  outAlbedoColor = vec4(0.6, 0.6, 0.6, 0.0);
+#endif
+}
@@ -19,6 +19,9 @@ layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec2 outTexCoords;
 layout(location = 3) out vec3 outTangent;
 
+/* matches the depth prepass, which is tested for EQUAL */
+invariant gl_Position;
+
 void main() {
   outWorldPosition = vec3(instanceUBO.model * vec4(inPosition, 1.0));
   mat3 mNormal = transpose(inverse(mat3(instanceUBO.model)));
@@ -0,0 +1,169 @@
+#version 450
+
+/* Edge adaptive spatial upsampling, after the EASU pass of AMD FidelityFX
+ * Super Resolution 1.0 (Copyright (c) 2021 Advanced Micro Devices, Inc.,
+ * MIT license). The 12 taps around the output pixel give the direction and
+ * the length of the local edge, which stretch and rotate a Lanczos-2 like
+ * kernel along it */
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D samplerSourceTexture;
+
+layout(push_constant) uniform EASUParams {
+  /* part of the source that was rendered to, in pixels */
+  vec4 sourceArea;
+  vec2 outputSize;
+}
+easuParams;
+
+vec3 LoadSource(ivec2 fp, ivec2 offset) {
+  /* never reads past the rendered part of the source */
+  ivec2 areaMin = ivec2(easuParams.sourceArea.xy);
+  ivec2 areaMax = areaMin + ivec2(easuParams.sourceArea.zw) - ivec2(1);
+  return texelFetch(samplerSourceTexture, clamp(fp + offset, areaMin, areaMax),
+                    0)
+      .rgb;
+}
+
+/* approximate luma, times 2 */
+float Luma(vec3 c) { return c.b * 0.5f + (c.r * 0.5f + c.g); }
+
+/* accumulates the direction and the length of the edge from the '+' around
+ * c, weighted by the bilinear weight of the quadrant
+ *     a
+ *   b c d
+ *     e */
+void SetEdge(inout vec2 dir, inout float len, float w, float lA, float lB,
+             float lC, float lD, float lE) {
+  float dc = lD - lC;
+  float cb = lC - lB;
+  float lenX = max(abs(dc), abs(cb));
+  lenX = 1.0f / max(lenX, 1.0e-5f);
+  float dirX = lD - lB;
+  dir.x += dirX * w;
+  lenX = clamp(abs(dirX) * lenX, 0.0f, 1.0f);
+  lenX *= lenX;
+  len += lenX * w;
+
+  float ec = lE - lC;
+  float ca = lC - lA;
+  float lenY = max(abs(ec), abs(ca));
+  lenY = 1.0f / max(lenY, 1.0e-5f);
+  float dirY = lE - lA;
+  dir.y += dirY * w;
+  lenY = clamp(abs(dirY) * lenY, 0.0f, 1.0f);
+  lenY *= lenY;
+  len += lenY * w;
+}
+
+/* accumulates a tap of the kernel, off is the offset of the tap from the
+ * sampled position */
+void Tap(inout vec3 aC, inout float aW, vec2 off, vec2 dir, vec2 len,
+         float lob, float clp, vec3 c) {
+  /* rotated into the edge direction, and scaled by the anisotropy */
+  vec2 v;
+  v.x = (off.x * dir.x) + (off.y * dir.y);
+  v.y = (off.x * (-dir.y)) + (off.y * dir.x);
+  v *= len;
+  float d2 = v.x * v.x + v.y * v.y;
+  d2 = min(d2, clp);
+  /* (25/16 * (2/5 * x^2 - 1)^2 - (25/16 - 1)) * (1/4 * x^2 - 1)^2, with the
+   * second lobe adjusted by lob */
+  float wB = 2.0f / 5.0f * d2 - 1.0f;
+  float wA = lob * d2 - 1.0f;
+  wB *= wB;
+  wA *= wA;
+  wB = 25.0f / 16.0f * wB - (25.0f / 16.0f - 1.0f);
+  float w = wB * wA;
+  aC += c * w;
+  aW += w;
+}
+
+void main() {
+  /* position of the output pixel in the source, relative to the centers of
+   * the source pixels */
+  vec2 scale = easuParams.sourceArea.zw / easuParams.outputSize;
+  vec2 pp = gl_FragCoord.xy * scale + easuParams.sourceArea.xy - 0.5f;
+  vec2 fp = floor(pp);
+  pp -= fp;
+  ivec2 ip = ivec2(fp);
+
+  /* 12 taps around the position, f is at fp
+   *     b c
+   *   e f g h
+   *   i j k l
+   *     n o */
+  vec3 b = LoadSource(ip, ivec2(0, -1));
+  vec3 c = LoadSource(ip, ivec2(1, -1));
+  vec3 e = LoadSource(ip, ivec2(-1, 0));
+  vec3 f = LoadSource(ip, ivec2(0, 0));
+  vec3 g = LoadSource(ip, ivec2(1, 0));
+  vec3 h = LoadSource(ip, ivec2(2, 0));
+  vec3 i = LoadSource(ip, ivec2(-1, 1));
+  vec3 j = LoadSource(ip, ivec2(0, 1));
+  vec3 k = LoadSource(ip, ivec2(1, 1));
+  vec3 l = LoadSource(ip, ivec2(2, 1));
+  vec3 n = LoadSource(ip, ivec2(0, 2));
+  vec3 o = LoadSource(ip, ivec2(1, 2));
+
+  float bL = Luma(b);
+  float cL = Luma(c);
+  float eL = Luma(e);
+  float fL = Luma(f);
+  float gL = Luma(g);
+  float hL = Luma(h);
+  float iL = Luma(i);
+  float jL = Luma(j);
+  float kL = Luma(k);
+  float lL = Luma(l);
+  float nL = Luma(n);
+  float oL = Luma(o);
+
+  /* edge of the 4 pixels around the position, bilinearly weighted */
+  vec2 dir = vec2(0.0f);
+  float len = 0.0f;
+  SetEdge(dir, len, (1.0f - pp.x) * (1.0f - pp.y), bL, eL, fL, gL, jL);
+  SetEdge(dir, len, pp.x * (1.0f - pp.y), cL, fL, gL, hL, kL);
+  SetEdge(dir, len, (1.0f - pp.x) * pp.y, fL, iL, jL, kL, nL);
+  SetEdge(dir, len, pp.x * pp.y, gL, jL, kL, lL, oL);
+
+  /* flat areas get the horizontal direction */
+  vec2 dir2 = dir * dir;
+  float dirR = dir2.x + dir2.y;
+  bool zero = dirR < 1.0f / 32768.0f;
+  dirR = zero ? 1.0f : inversesqrt(dirR);
+  dir.x = zero ? 1.0f : dir.x;
+  dir *= dirR;
+
+  /* stretches the kernel along the edge, more the stronger the edge is */
+  len = len * 0.5f;
+  len *= len;
+  float stretch =
+      (dir.x * dir.x + dir.y * dir.y) / max(abs(dir.x), abs(dir.y));
+  vec2 len2 = vec2(1.0f + (stretch - 1.0f) * len, 1.0f - 0.5f * len);
+  /* negative lobe, from 1/2 in flat areas to 1/4 - 0.04 on edges */
+  float lob = 0.5f + ((1.0f / 4.0f - 0.04f) - 0.5f) * len;
+  float clp = 1.0f / lob;
+
+  vec3 aC = vec3(0.0f);
+  float aW = 0.0f;
+  Tap(aC, aW, vec2(0.0f, -1.0f) - pp, dir, len2, lob, clp, b);
+  Tap(aC, aW, vec2(1.0f, -1.0f) - pp, dir, len2, lob, clp, c);
+  Tap(aC, aW, vec2(-1.0f, 1.0f) - pp, dir, len2, lob, clp, i);
+  Tap(aC, aW, vec2(0.0f, 1.0f) - pp, dir, len2, lob, clp, j);
+  Tap(aC, aW, vec2(0.0f, 0.0f) - pp, dir, len2, lob, clp, f);
+  Tap(aC, aW, vec2(-1.0f, 0.0f) - pp, dir, len2, lob, clp, e);
+  Tap(aC, aW, vec2(1.0f, 1.0f) - pp, dir, len2, lob, clp, k);
+  Tap(aC, aW, vec2(2.0f, 1.0f) - pp, dir, len2, lob, clp, l);
+  Tap(aC, aW, vec2(2.0f, 0.0f) - pp, dir, len2, lob, clp, h);
+  Tap(aC, aW, vec2(1.0f, 0.0f) - pp, dir, len2, lob, clp, g);
+  Tap(aC, aW, vec2(1.0f, 2.0f) - pp, dir, len2, lob, clp, o);
+  Tap(aC, aW, vec2(0.0f, 2.0f) - pp, dir, len2, lob, clp, n);
+
+  /* the negative lobes can overshoot, so the result is clamped to the 4
+   * nearest pixels */
+  vec3 min4 = min(min(f, g), min(j, k));
+  vec3 max4 = max(max(f, g), max(j, k));
+  outColor = vec4(min(max4, max(min4, aC / aW)), 1.0f);
+}
\ No newline at end of file
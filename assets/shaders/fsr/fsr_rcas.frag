@@ -0,0 +1,68 @@
+#version 450
+
+/* Robust contrast adaptive sharpening, after the RCAS pass of AMD FidelityFX
+ * Super Resolution 1.0 (Copyright (c) 2021 Advanced Micro Devices, Inc.,
+ * MIT license). The sharpening lobe is limited by the local contrast, so
+ * that the result never leaves the range of the neighbours */
+
+layout(location = 0) out vec4 outColor;
+
+/* upscaled image, of the size of the render area */
+layout(set = 0, binding = 0) uniform sampler2D samplerUpscaledTexture;
+
+layout(push_constant) uniform RCASParams {
+  /* 1 is the sharpest */
+  float sharpness;
+}
+rcasParams;
+
+/* the lobe can't go below it, or the kernel would be unstable */
+const float RCAS_LIMIT = 0.25f - (1.0f / 16.0f);
+
+vec3 LoadUpscaled(ivec2 ip, ivec2 offset) {
+  ivec2 size = textureSize(samplerUpscaledTexture, 0);
+  return texelFetch(samplerUpscaledTexture,
+                    clamp(ip + offset, ivec2(0), size - ivec2(1)), 0)
+      .rgb;
+}
+
+float Luma(vec3 c) { return c.b * 0.5f + (c.r * 0.5f + c.g); }
+
+float Max3(vec3 v) { return max(v.x, max(v.y, v.z)); }
+
+void main() {
+  /*   b
+   * d e f
+   *   h */
+  ivec2 ip = ivec2(gl_FragCoord.xy);
+  vec3 b = LoadUpscaled(ip, ivec2(0, -1));
+  vec3 d = LoadUpscaled(ip, ivec2(-1, 0));
+  vec3 e = LoadUpscaled(ip, ivec2(0, 0));
+  vec3 f = LoadUpscaled(ip, ivec2(1, 0));
+  vec3 h = LoadUpscaled(ip, ivec2(0, 1));
+
+  /* noise detection, to sharpen the grain less */
+  float bL = Luma(b);
+  float dL = Luma(d);
+  float eL = Luma(e);
+  float fL = Luma(f);
+  float hL = Luma(h);
+  float nz = 0.25f * (bL + dL + fL + hL) - eL;
+  float range = max(max(max(bL, dL), max(eL, fL)), hL) -
+                min(min(min(bL, dL), min(eL, fL)), hL);
+  nz = clamp(abs(nz) / max(range, 1.0e-5f), 0.0f, 1.0f);
+  nz = -0.5f * nz + 1.0f;
+
+  /* largest lobe that keeps the result within the neighbourhood */
+  vec3 mn4 = min(min(b, d), min(f, h));
+  vec3 mx4 = max(max(b, d), max(f, h));
+  vec3 hitMin = min(mn4, e) / (4.0f * mx4 + 1.0e-5f);
+  vec3 hitMax = (1.0f - max(mx4, e)) / (4.0f * mn4 - 4.0f - 1.0e-5f);
+  vec3 lobeRGB = max(-hitMin, hitMax);
+  float lobe = max(-RCAS_LIMIT, min(Max3(lobeRGB), 0.0f)) *
+               rcasParams.sharpness;
+  lobe *= nz;
+
+  vec3 color = (lobe * (b + d + f + h) + e) / (4.0f * lobe + 1.0f);
+  outColor = vec4(color, 1.0f);
+}
\ No newline at end of file
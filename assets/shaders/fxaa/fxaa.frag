@@ -6,6 +6,14 @@ layout(location = 0) out vec4 outColor;
 
 layout(set = 0, binding = 0) uniform sampler2D samplerColorTexture;
 
+layout(push_constant) uniform FXAAParams {
+  /* maps the texture coordinates to the rendered part of the color texture */
+  vec2 uvScale;
+  /* clamps the taps to the rendered part */
+  vec2 uvMax;
+}
+fxaaParams;
+
 /* ---------------------------------------------------------------------------------
  * File:        es3-kepler\FXAA/FXAA3_11.h
  * SDK Version: v3.00
@@ -299,8 +307,9 @@ layout(set = 0, binding = 0) uniform sampler2D samplerColorTexture;
 
 #else
 
-#define FxaaTexTop(t, p) textureLod(t, p, 0.0)
-#define FxaaTexOff(t, p, o, r) textureLodOffset(t, p, 0.0, o)
+#define FxaaTexTop(t, p) textureLod(t, min(p, fxaaParams.uvMax), 0.0)
+#define FxaaTexOff(t, p, o, r)                                                 \
+  textureLod(t, min(p + vec2(o) * r, fxaaParams.uvMax), 0.0)
 
 /* (#B1#) */
 float FxaaLuma(vec4 rgba) {
@@ -926,10 +935,8 @@ vec3 BlurColor(float offset, sampler2D textureSampler, vec2 texCoords) {
 }
 
 void main() {
-  const float offset = 1.0 / 300.0;
-
-  const vec2 viewportSize = vec2(800, 600);
-  outColor = FxaaPixelShader(outTexCoords, samplerColorTexture,
-                             vec2(1 / viewportSize.x, 1 / viewportSize.y), 0.75,
-                             0.063, 0.0625);
+  vec2 rcpFrame = 1.0 / vec2(textureSize(samplerColorTexture, 0));
+  outColor = FxaaPixelShader(outTexCoords * fxaaParams.uvScale,
+                             samplerColorTexture, rcpFrame, 0.75, 0.063,
+                             0.0625);
 }
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 450
+
+layout(location = 0) in vec2 inCorner;
+layout(location = 1) in float inLife;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  float alpha = clamp(1.0f - length(inCorner), 0.0f, 1.0f) * inLife;
+  outColor = vec4(mix(vec3(1.0f, 0.2f, 0.05f), vec3(1.0f, 0.8f, 0.3f), inLife),
+                  alpha);
+}
\ No newline at end of file
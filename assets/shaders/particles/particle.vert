@@ -0,0 +1,48 @@
+#version 450
+
+struct Particle {
+  vec4 position;
+  vec4 velocity;
+};
+
+layout(set = 0, binding = 0) uniform GlobalUBO {
+  mat4 view;
+  mat4 projection;
+}
+globalUBO;
+
+layout(set = 1, binding = 0) readonly buffer Arguments {
+  uvec3 groupCount;
+  uint activeCount;
+}
+arguments;
+
+layout(set = 1, binding = 1) readonly buffer Particles {
+  Particle particles[];
+};
+
+layout(location = 0) out vec2 outCorner;
+layout(location = 1) out float outLife;
+
+const vec2 corners[6] = vec2[](vec2(-1.0f, -1.0f), vec2(1.0f, -1.0f),
+                               vec2(1.0f, 1.0f), vec2(-1.0f, -1.0f),
+                               vec2(1.0f, 1.0f), vec2(-1.0f, 1.0f));
+
+void main() {
+  /* a quad of two triangles per particle, without a vertex buffer */
+  uint index = gl_VertexIndex / 6;
+  outCorner = corners[gl_VertexIndex % 6];
+
+  Particle particle = particles[index];
+  outLife = 1.0f - particle.position.w / max(particle.velocity.w, 0.001f);
+
+  /* the dead slots are clipped away */
+  if (index >= arguments.activeCount) {
+    gl_Position = vec4(0.0f, 0.0f, 2.0f, 1.0f);
+    return;
+  }
+
+  vec4 viewPosition = globalUBO.view * vec4(particle.position.xyz, 1.0f);
+  viewPosition.xy += outCorner * 0.05f;
+  gl_Position = globalUBO.projection * viewPosition;
+}
\ No newline at end of file
@@ -0,0 +1,5 @@
+#version 450
+
+layout(location = 0) out vec4 outColor;
+
+void main() { outColor = vec4(0.3f, 0.3f, 0.35f, 1.0f); }
\ No newline at end of file
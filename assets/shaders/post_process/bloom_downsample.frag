@@ -0,0 +1,66 @@
+/* keywords: PREFILTER */
+#version 450
+
+/* 13 tap downsample of "Next generation post processing in Call of Duty:
+ * Advanced Warfare" (Jimenez 2014). The overlapping boxes keep the bright
+ * pixels from flickering as they move */
+
+layout(location = 0) in vec2 outTexCoords;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D samplerSourceTexture;
+
+layout(push_constant) uniform BloomParams {
+  /* xy maps the texture coordinates to the rendered part of the source, zw
+   * clamps the taps to it */
+  vec4 sourceUV;
+  /* xy is the texel size of the source, z the bloom threshold */
+  vec4 sourceTexel;
+  /* unused by the downsample */
+  vec4 baseUV;
+}
+bloomParams;
+
+vec3 Tap(vec2 uv, vec2 offset) {
+  vec2 tapUV = uv + offset * bloomParams.sourceTexel.xy;
+  return texture(samplerSourceTexture, min(tapUV, bloomParams.sourceUV.zw))
+      .rgb;
+}
+
+void main() {
+  vec2 uv = outTexCoords * bloomParams.sourceUV.xy;
+
+  /* a   b   c
+   *   j   k
+   * d   e   f
+   *   l   m
+   * g   h   i */
+  vec3 a = Tap(uv, vec2(-2.0f, -2.0f));
+  vec3 b = Tap(uv, vec2(0.0f, -2.0f));
+  vec3 c = Tap(uv, vec2(2.0f, -2.0f));
+  vec3 d = Tap(uv, vec2(-2.0f, 0.0f));
+  vec3 e = Tap(uv, vec2(0.0f, 0.0f));
+  vec3 f = Tap(uv, vec2(2.0f, 0.0f));
+  vec3 g = Tap(uv, vec2(-2.0f, 2.0f));
+  vec3 h = Tap(uv, vec2(0.0f, 2.0f));
+  vec3 i = Tap(uv, vec2(2.0f, 2.0f));
+  vec3 j = Tap(uv, vec2(-1.0f, -1.0f));
+  vec3 k = Tap(uv, vec2(1.0f, -1.0f));
+  vec3 l = Tap(uv, vec2(-1.0f, 1.0f));
+  vec3 m = Tap(uv, vec2(1.0f, 1.0f));
+
+  vec3 color = e * 0.125f;
+  color += (a + c + g + i) * 0.03125f;
+  color += (b + d + f + h) * 0.0625f;
+  color += (j + k + l + m) * 0.125f;
+
+#ifdef PREFILTER
+  /* keeps the part of the color above the threshold */
+  float brightness = max(color.r, max(color.g, color.b));
+  float contribution = max(brightness - bloomParams.sourceTexel.z, 0.0f);
+  color *= contribution / max(brightness, 1.0e-5f);
+#endif
+
+  outColor = vec4(color, 1.0f);
+}
\ No newline at end of file
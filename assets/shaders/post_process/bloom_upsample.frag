@@ -0,0 +1,46 @@
+#version 450
+
+/* 3x3 tent upsample of the level below, added to the downsample of this
+ * level */
+
+layout(location = 0) in vec2 outTexCoords;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D samplerSourceTexture;
+layout(set = 0, binding = 1) uniform sampler2D samplerBaseTexture;
+
+layout(push_constant) uniform BloomParams {
+  /* xy maps the texture coordinates to the rendered part of the source, zw
+   * clamps the taps to it */
+  vec4 sourceUV;
+  /* xy is the texel size of the source */
+  vec4 sourceTexel;
+  /* the same as sourceUV, for the base */
+  vec4 baseUV;
+}
+bloomParams;
+
+vec3 Tap(vec2 uv, vec2 offset) {
+  vec2 tapUV = uv + offset * bloomParams.sourceTexel.xy;
+  return texture(samplerSourceTexture, min(tapUV, bloomParams.sourceUV.zw))
+      .rgb;
+}
+
+void main() {
+  vec2 uv = outTexCoords * bloomParams.sourceUV.xy;
+
+  vec3 color = Tap(uv, vec2(0.0f, 0.0f)) * 4.0f;
+  color += (Tap(uv, vec2(0.0f, -1.0f)) + Tap(uv, vec2(-1.0f, 0.0f)) +
+            Tap(uv, vec2(1.0f, 0.0f)) + Tap(uv, vec2(0.0f, 1.0f))) *
+           2.0f;
+  color += Tap(uv, vec2(-1.0f, -1.0f)) + Tap(uv, vec2(1.0f, -1.0f)) +
+           Tap(uv, vec2(-1.0f, 1.0f)) + Tap(uv, vec2(1.0f, 1.0f));
+  color *= 1.0f / 16.0f;
+
+  vec2 baseUV =
+      min(outTexCoords * bloomParams.baseUV.xy, bloomParams.baseUV.zw);
+  color += texture(samplerBaseTexture, baseUV).rgb;
+
+  outColor = vec4(color, 1.0f);
+}
\ No newline at end of file
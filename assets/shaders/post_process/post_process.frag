@@ -0,0 +1,65 @@
+/* keywords: BLOOM TONEMAP COLOR_GRADING */
+#version 450
+
+/* every per pixel effect of the post process stack, so that the image is
+ * read and written once */
+
+layout(location = 0) in vec2 outTexCoords;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D samplerSceneTexture;
+#ifdef BLOOM
+layout(set = 0, binding = 1) uniform sampler2D samplerBloomTexture;
+#endif
+
+layout(push_constant) uniform UberParams {
+  /* xy maps the texture coordinates to the rendered part of the scene */
+  vec4 sceneUV;
+  /* xy maps the texture coordinates to the rendered part of the bloom, zw
+   * clamps to it */
+  vec4 bloomUV;
+  /* rgb is the color filter, w the exposure */
+  vec4 colorFilter;
+  /* x is the bloom intensity, y the contrast, z the saturation */
+  vec4 grading;
+}
+uberParams;
+
+/* fit of the ACES filmic curve by Krzysztof Narkowicz */
+vec3 Tonemap(vec3 color) {
+  const float a = 2.51f;
+  const float b = 0.03f;
+  const float c = 2.43f;
+  const float d = 0.59f;
+  const float e = 0.14f;
+  return clamp((color * (a * color + b)) / (color * (c * color + d) + e), 0.0f,
+               1.0f);
+}
+
+void main() {
+  vec3 color =
+      texture(samplerSceneTexture, outTexCoords * uberParams.sceneUV.xy).rgb;
+
+#ifdef BLOOM
+  vec2 bloomUV =
+      min(outTexCoords * uberParams.bloomUV.xy, uberParams.bloomUV.zw);
+  color += texture(samplerBloomTexture, bloomUV).rgb * uberParams.grading.x;
+#endif
+
+  color *= uberParams.colorFilter.w;
+
+#ifdef TONEMAP
+  color = Tonemap(color);
+#endif
+
+#ifdef COLOR_GRADING
+  color *= uberParams.colorFilter.rgb;
+  /* contrast around the middle gray, then saturation around the luma */
+  color = max((color - 0.5f) * uberParams.grading.y + 0.5f, 0.0f);
+  float luma = dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
+  color = max(mix(vec3(luma), color, uberParams.grading.z), 0.0f);
+#endif
+
+  outColor = vec4(color, 1.0f);
+}
\ No newline at end of file
@@ -16,6 +16,7 @@ Example::Example(const char *example_name, int window_width,
   if (!frontend->Initialize(window, RendererBackendType::RBT_VULKAN)) {
     exit(1);
   }
+  frontend->SetFrameRateLimit(120);
 
   camera = new Camera();
   camera->Create(45, width / height, 0.1f, 100000.0f);
@@ -97,11 +98,6 @@ void Example::UpdateStart() {
 }
 
 void Example::UpdateEnd() {
-  const uint32_t ms_per_frame = 1000 / 120;
-  const uint32_t elapsed_time_ms = SDL_GetTicks() - start_time_ms;
-  if (elapsed_time_ms < ms_per_frame) {
-    SDL_Delay(ms_per_frame - elapsed_time_ms);
-  }
-
+  /* the frame rate is limited by the renderer */
   Input::GetMousePosition(&previous_mouse.x, &previous_mouse.y);
 }
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <rf3d/framework/logger.h>
+#include <rf3d/framework/renderer/gpu_depth_prepass.h>
+#include <rf3d/framework/renderer/gpu_dynamic_resolution.h>
 #include <rf3d/framework/renderer/renderer_frontend.h>
 #include <unordered_map>
 #define STB_IMAGE_IMPLEMENTATION
@@ -20,67 +22,103 @@ public:
     MeshRequiredFormat format = {true, true, true, true};
     sponza_scene = MeshLoader::Load(&format, "assets/models/sponza.obj");
 
-    offscreen_position_attachment = frontend->AttachmentAllocate();
-    offscreen_position_attachment->Create(GPU_FORMAT_R16G16B16A16F,
-                                          GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT,
-                                          width, height);
-    offscreen_position_attachment->SetDebugName(
-
-        "Offscreen position attachment");
-    offscreen_normal_attachment = frontend->AttachmentAllocate();
-    offscreen_normal_attachment->Create(GPU_FORMAT_R16G16B16A16F,
-                                        GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT,
-                                        width, height);
-    offscreen_normal_attachment->SetDebugName("Offscreen normal attachment");
-
-    offscreen_albedo_attachment = frontend->AttachmentAllocate();
-    offscreen_albedo_attachment->Create(GPU_FORMAT_DEVICE_COLOR_OPTIMAL,
-                                        GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT,
-                                        width, height);
-    offscreen_albedo_attachment->SetDebugName("Offscreen albedo attachment");
-
-    offscreen_depth_attachment = frontend->AttachmentAllocate();
-    offscreen_depth_attachment->Create(
-        GPU_FORMAT_DEVICE_DEPTH_OPTIMAL,
-        GPU_ATTACHMENT_USAGE_DEPTH_STENCIL_ATTACHMENT, width, height);
-    offscreen_depth_attachment->SetDebugName("Offscreen depth attachment");
-
-    offscreen_render_pass = frontend->RenderPassAllocate();
-    offscreen_render_pass->Create(
-        std::vector<GPURenderPassAttachmentConfig>{
-            GPURenderPassAttachmentConfig{
-                offscreen_position_attachment->GetFormat(),
-                offscreen_position_attachment->GetUsage(),
-                GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_DONT_CARE,
-                GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_STORE, false},
-            GPURenderPassAttachmentConfig{
-                offscreen_normal_attachment->GetFormat(),
-                offscreen_normal_attachment->GetUsage(),
-                GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_DONT_CARE,
-                GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_STORE, false},
-            GPURenderPassAttachmentConfig{
-                offscreen_albedo_attachment->GetFormat(),
-                offscreen_albedo_attachment->GetUsage(),
-                GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_DONT_CARE,
-                GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_STORE, false},
-            GPURenderPassAttachmentConfig{
-                offscreen_depth_attachment->GetFormat(),
-                offscreen_depth_attachment->GetUsage(),
-                GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_DONT_CARE,
-                GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_DONT_CARE, false}},
-        glm::vec4(0, 0, width, height), glm::vec4(0, 0, 0, 1), 1.0f, 0.0f,
-        GPU_RENDER_PASS_CLEAR_FLAG_COLOR | GPU_RENDER_PASS_CLEAR_FLAG_DEPTH |
-            GPU_RENDER_PASS_CLEAR_FLAG_STENCIL);
-    offscreen_render_pass->SetDebugName("Offscreen render pass");
-
-    offscreen_render_target = frontend->RenderTargetAllocate();
-    offscreen_render_target->Create(
-        offscreen_render_pass,
-        std::vector<GPUAttachment *>{
-            offscreen_position_attachment, offscreen_normal_attachment,
-            offscreen_albedo_attachment, offscreen_depth_attachment},
-        width, height);
-    offscreen_render_target->SetDebugName("Offscreen framebuffer");
+    /* acquired from the render target pool every frame */
+    post_attachment = 0;
+
+    /* the scene is rendered at a lower resolution when the GPU can't keep
+     * up, and upscaled into the window render target by the upscaler */
+    GPUDynamicResolutionConfig resolution_config;
+    resolution_config.target_frame_time = 1000.0f / 120.0f;
+    dynamic_resolution.Create(&resolution_config);
+
+    /* sponza overdraws a lot, so the g-buffer is only written for the
+     * visible surfaces */
+    depth_prepass = true;
+
+    /* the graph owns the g-buffer. It is written by the first subpass and
+     * read by the next one at the same pixel, so it never leaves the tile
+     * memory and doesn't have to be backed by memory. Only the lit scene is
+     * stored, in high dynamic range for the post processing. The attachments
+     * are of the window size, see Resize */
+    render_graph = frontend->RenderGraphAllocate();
+    render_graph->Resize(width, height);
+    graph_width = width;
+    graph_height = height;
+
+    GPURenderGraphAttachmentConfig attachment_config = {
+        GPU_FORMAT_R16G16B16A16F, GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT, 0, 0};
+    attachment_config.flags =
+        GPU_ATTACHMENT_FLAG_INPUT | GPU_ATTACHMENT_FLAG_TRANSIENT;
+    position_attachment =
+        render_graph->AddAttachment("G-buffer position", &attachment_config);
+    normal_attachment =
+        render_graph->AddAttachment("G-buffer normal", &attachment_config);
+
+    attachment_config.format = GPU_FORMAT_DEVICE_COLOR_OPTIMAL;
+    albedo_attachment =
+        render_graph->AddAttachment("G-buffer albedo", &attachment_config);
+
+    attachment_config.format = GPU_FORMAT_DEVICE_DEPTH_OPTIMAL;
+    attachment_config.usage = GPU_ATTACHMENT_USAGE_DEPTH_STENCIL_ATTACHMENT;
+    attachment_config.flags = GPU_ATTACHMENT_FLAG_TRANSIENT;
+    depth_attachment =
+        render_graph->AddAttachment("G-buffer depth", &attachment_config);
+
+    attachment_config.format = GPU_FORMAT_R16G16B16A16F;
+    attachment_config.usage = GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT;
+    attachment_config.flags = 0;
+    attachment_config.exported = true;
+    scene_attachment = render_graph->AddAttachment("Scene", &attachment_config);
+
+    /* depth prepass if enabled, g-buffer pass, then the lighting pass, all
+     * as the subpasses of one render pass. The depth stays in the tile
+     * memory across all of them */
+    depth_prepass_pass = 0;
+    GPURenderGraphPassConfig pass_config;
+    pass_config.clear_color = glm::vec4(0, 0, 0, 1);
+    pass_config.clear_depth = 1.0f;
+    pass_config.clear_stencil = 0.0f;
+    pass_config.clear_flags = GPU_RENDER_PASS_CLEAR_FLAG_COLOR |
+                              GPU_RENDER_PASS_CLEAR_FLAG_DEPTH |
+                              GPU_RENDER_PASS_CLEAR_FLAG_STENCIL;
+    pass_config.user_data = this;
+    if (depth_prepass) {
+      pass_config.outputs = std::vector<uint32_t>{depth_attachment};
+      pass_config.execute = &DeferredExample::DepthPrepassPass;
+      depth_prepass_pass = render_graph->AddPass("Depth prepass", &pass_config);
+      pass_config.subpass = true;
+    }
+
+    pass_config.outputs = std::vector<uint32_t>{
+        position_attachment, normal_attachment, albedo_attachment,
+        depth_attachment};
+    pass_config.execute = &DeferredExample::GBufferPass;
+    gbuffer_pass = render_graph->AddPass("G-buffer pass", &pass_config);
+
+    pass_config.outputs = std::vector<uint32_t>{scene_attachment};
+    pass_config.subpass_inputs = std::vector<uint32_t>{
+        position_attachment, normal_attachment, albedo_attachment};
+    pass_config.subpass = true;
+    pass_config.execute = &DeferredExample::LightingPass;
+    lighting_pass = render_graph->AddPass("Lighting pass", &pass_config);
+
+    render_graph->Compile();
+
+    /* created before the scene textures, so that they always get a slot in
+     * the bindless table. Meshes whose textures did not fit there sample
+     * these instead */
+    unsigned char default_diffuse_pixel[] = {255, 255, 255, 255};
+    default_diffuse_texture = frontend->TextureAllocate();
+    default_diffuse_texture->Create(GPU_FORMAT_RGBA8, GPU_TEXTURE_TYPE_2D, 1,
+                                    1);
+    default_diffuse_texture->WriteData(default_diffuse_pixel, 0);
+    default_diffuse_texture->SetDebugName("Default diffuse texture");
+
+    unsigned char default_normal_pixel[] = {128, 128, 255, 255};
+    default_normal_texture = frontend->TextureAllocate();
+    default_normal_texture->Create(GPU_FORMAT_RGBA8, GPU_TEXTURE_TYPE_2D, 1, 1);
+    default_normal_texture->WriteData(default_normal_pixel, 0);
+    default_normal_texture->SetDebugName("Default normal texture");
 
     for (int i = 0; i < sponza_scene.size(); ++i) {
       GPUVertexBuffer *vertex_buffer = frontend->VertexBufferAllocate();
@@ -156,13 +194,10 @@ public:
         }
         sponza_normal_textures.emplace_back(normal_texture);
       } else {
-        GPUTexture *default_texture = frontend->TextureAllocate();
-        Utils::LoadTexture(default_texture, "assets/textures/metal.png");
-        sponza_diffuse_textures.emplace_back(default_texture);
-        sponza_specular_textures.emplace_back(default_texture);
-        sponza_normal_textures.emplace_back(default_texture);
-        sponza_texture_cache.emplace("assets/textures/metal.png",
-                                     default_texture);
+        /* untextured meshes are drawn with the untextured shader variant */
+        sponza_diffuse_textures.emplace_back((GPUTexture *)0);
+        sponza_specular_textures.emplace_back((GPUTexture *)0);
+        sponza_normal_textures.emplace_back((GPUTexture *)0);
       }
     }
 
@@ -175,14 +210,34 @@ public:
 
     GPUShaderConfig shader_config;
     shader_config.stage_configs = stage_configs;
+    shader_config.keywords =
+        std::vector<const char *>{"TEXTURED", "BINDLESS"};
     shader_config.topology_type = GPU_SHADER_TOPOLOGY_TYPE_TRIANGLE_LIST;
     shader_config.depth_flags = GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE |
                            GPU_SHADER_DEPTH_FLAG_DEPTH_WRITE_ENABLE;
     shader_config.stencil_flags = 0;
-    shader_config.render_pass = offscreen_render_pass; 
+    /* the depth prepass copies it, so both passes cull the same faces */
+    shader_config.render_state.cull_mode = GPU_SHADER_CULL_MODE_BACK;
+    shader_config.render_pass = render_graph->GetRenderPass(gbuffer_pass);
+    shader_config.subpass = render_graph->GetSubpass(gbuffer_pass);
     shader_config.viewport_width = width;
     shader_config.viewport_height = height;
 
+    depth_prepass_shader = 0;
+    if (depth_prepass) {
+      /* position, normal, texture coordinates, tangent and bitangent */
+      uint32_t vertex_stride = (3 + 3 + 2 + 3 + 3) * sizeof(float);
+      GPUShaderConfig prepass_config = GPUDepthPrepass::CreatePrepassConfig(
+          &shader_config, "assets/shaders/depth_prepass.vert.spv",
+          vertex_stride, render_graph->GetSubpass(depth_prepass_pass));
+
+      depth_prepass_shader = frontend->ShaderAllocate();
+      depth_prepass_shader->Create(&prepass_config);
+      depth_prepass_shader->SetDebugName("Depth prepass shader");
+
+      GPUDepthPrepass::ConfigureGeometryPass(&shader_config);
+    }
+
     mrt_shader = frontend->ShaderAllocate();
     mrt_shader->Create(&shader_config);
     mrt_shader->SetDebugName("MRT shader");
@@ -200,7 +255,7 @@ public:
     bindings.emplace_back(GPUDescriptorBinding{
         0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, mrt_global_uniform});
     mrt_global_descriptor_set = frontend->DescriptorSetAllocate();
-    mrt_global_descriptor_set->Create(bindings);
+    mrt_global_descriptor_set->Create(mrt_shader, 0, bindings);
     mrt_global_descriptor_set->SetDebugName("Global descriptor set");
 
     bindings.clear();
@@ -208,10 +263,51 @@ public:
         GPUDescriptorBinding{0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0,
                              mrt_instance_uniform});
     mrt_instance_descriptor_set = frontend->DescriptorSetAllocate();
-    mrt_instance_descriptor_set->Create(bindings);
+    mrt_instance_descriptor_set->Create(mrt_shader, 1, bindings);
     mrt_instance_descriptor_set->SetDebugName("Instance descriptor set");
 
+    /* the prepass reads the same uniform buffers, through sets of its own
+     * layouts */
+    depth_prepass_global_descriptor_set = 0;
+    depth_prepass_instance_descriptor_set = 0;
+    if (depth_prepass) {
+      bindings.clear();
+      bindings.emplace_back(
+          GPUDescriptorBinding{0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER,
+                               0, mrt_global_uniform});
+      depth_prepass_global_descriptor_set = frontend->DescriptorSetAllocate();
+      depth_prepass_global_descriptor_set->Create(depth_prepass_shader, 0,
+                                                  bindings);
+      depth_prepass_global_descriptor_set->SetDebugName(
+          "Depth prepass global descriptor set");
+
+      bindings.clear();
+      bindings.emplace_back(
+          GPUDescriptorBinding{0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER,
+                               0, mrt_instance_uniform});
+      depth_prepass_instance_descriptor_set = frontend->DescriptorSetAllocate();
+      depth_prepass_instance_descriptor_set->Create(depth_prepass_shader, 1,
+                                                    bindings);
+      depth_prepass_instance_descriptor_set->SetDebugName(
+          "Depth prepass instance descriptor set");
+    }
+
+    /* with the bindless table the textures are selected by their indices, so
+     * there are no texture sets */
+    mrt_textured_variant = MRT_VARIANT_TEXTURED;
+    if (frontend->IsBindlessSupported()) {
+      mrt_textured_variant |= MRT_VARIANT_BINDLESS;
+    }
+
+    /* texture set is presented only in the textured variant */
+    mrt_shader->SetVariant(MRT_VARIANT_TEXTURED);
     for (int i = 0; i < sponza_scene.size(); ++i) {
+      if (!sponza_scene[i].textured ||
+          (mrt_textured_variant & MRT_VARIANT_BINDLESS)) {
+        mtr_texture_descriptor_sets.emplace_back((GPUDescriptorSet *)0);
+        continue;
+      }
+
       GPUDescriptorSet *texture_descriptor_set;
 
       bindings.clear();
@@ -225,11 +321,12 @@ public:
           GPUDescriptorBinding{2, GPU_DESCRIPTOR_BINDING_TYPE_TEXTURE,
                                sponza_normal_textures[i], 0, 0});
       texture_descriptor_set = frontend->DescriptorSetAllocate();
-      texture_descriptor_set->Create(bindings);
+      texture_descriptor_set->Create(mrt_shader, 2, bindings);
       texture_descriptor_set->SetDebugName("Texture descriptor set");
 
       mtr_texture_descriptor_sets.emplace_back(texture_descriptor_set);
     }
+    mrt_shader->SetVariant(0);
 
     stage_configs.clear();
     stage_configs.emplace_back(GPUShaderStageConfig{
@@ -238,7 +335,10 @@ public:
         GPU_SHADER_STAGE_TYPE_FRAGMENT, "assets/shaders/deferred.frag.spv"});
 
     shader_config.stage_configs = stage_configs;
-    shader_config.render_pass = frontend->GetWindowRenderPass(); 
+    shader_config.keywords.clear();
+    shader_config.render_state.cull_mode = GPU_SHADER_CULL_MODE_NONE;
+    shader_config.render_pass = render_graph->GetRenderPass(lighting_pass);
+    shader_config.subpass = render_graph->GetSubpass(lighting_pass);
 
     deferred_shader = frontend->ShaderAllocate();
     deferred_shader->Create(&shader_config);
@@ -248,49 +348,51 @@ public:
     deferred_world_uniform->Create(sizeof(WorldUBO));
     deferred_world_uniform->SetDebugName("World uniform buffer");
 
-    bindings.clear();
-    bindings.emplace_back(
-        GPUDescriptorBinding{0, GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT, 0, 0,
-                             offscreen_position_attachment});
-    bindings.emplace_back(
-        GPUDescriptorBinding{1, GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT, 0, 0,
-                             offscreen_normal_attachment});
-    bindings.emplace_back(
-        GPUDescriptorBinding{2, GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT, 0, 0,
-                             offscreen_albedo_attachment});
-    deferred_texture_descriptor_set = frontend->DescriptorSetAllocate();
-    deferred_texture_descriptor_set->Create(bindings);
-    deferred_texture_descriptor_set->SetDebugName(
-        "Deferred texture descriptor set");
+    deferred_texture_descriptor_set = 0;
+    WriteGBufferDescriptorSet();
 
     bindings.clear();
     bindings.emplace_back(
         GPUDescriptorBinding{0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0,
                              deferred_world_uniform, 0});
     deferred_world_descriptor_set = frontend->DescriptorSetAllocate();
-    deferred_world_descriptor_set->Create(bindings);
+    deferred_world_descriptor_set->Create(deferred_shader, 0, bindings);
     deferred_world_descriptor_set->SetDebugName(
         "Deferred world descriptor set");
+
+    /* the post processing runs at the scaled resolution too, the upscaler
+     * expects a tonemapped image */
+    std::vector<GPURenderPassAttachmentConfig> attachment_configs;
+    attachment_configs.emplace_back(GPURenderPassAttachmentConfig{
+        GPU_FORMAT_DEVICE_COLOR_OPTIMAL, GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT,
+        GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_DONT_CARE,
+        GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_STORE, false});
+
+    post_render_pass = frontend->RenderPassAllocate();
+    post_render_pass->Create(attachment_configs, glm::vec4(0, 0, width, height),
+                             glm::vec4(0, 0, 0, 1), 1.0f, 0.0f, 0);
+    post_render_pass->SetDebugName("Post process render pass");
+
+    GPUPostProcessStackConfig post_process_config;
+    post_process_config.effects =
+        GPU_POST_PROCESS_EFFECT_BLOOM | GPU_POST_PROCESS_EFFECT_TONEMAP |
+        GPU_POST_PROCESS_EFFECT_COLOR_GRADING | GPU_POST_PROCESS_EFFECT_FXAA;
+    post_process_config.render_pass = post_render_pass;
+
+    post_process = frontend->PostProcessStackAllocate();
+    post_process->Create(&post_process_config);
+    post_process->GetSettings()->saturation = 1.1f;
+
+    GPUUpscalerConfig upscaler_config;
+    upscaler_config.render_pass = frontend->GetWindowRenderPass();
+
+    upscaler = frontend->UpscalerAllocate();
+    upscaler->Create(&upscaler_config);
   }
 
   virtual ~DeferredExample() {
-    offscreen_position_attachment->Destroy();
-    delete offscreen_position_attachment;
-
-    offscreen_normal_attachment->Destroy();
-    delete offscreen_normal_attachment;
-
-    offscreen_albedo_attachment->Destroy();
-    delete offscreen_albedo_attachment;
-
-    offscreen_depth_attachment->Destroy();
-    delete offscreen_depth_attachment;
-
-    offscreen_render_pass->Destroy();
-    delete offscreen_render_pass;
-
-    offscreen_render_target->Destroy();
-    delete offscreen_render_target;
+    render_graph->Destroy();
+    delete render_graph;
 
     deferred_world_uniform->Destroy();
     delete deferred_world_uniform;
@@ -301,6 +403,15 @@ public:
     deferred_world_descriptor_set->Destroy();
     delete deferred_world_descriptor_set;
 
+    upscaler->Destroy();
+    delete upscaler;
+
+    post_process->Destroy();
+    delete post_process;
+
+    post_render_pass->Destroy();
+    delete post_render_pass;
+
     deferred_texture_descriptor_set->Destroy();
     delete deferred_texture_descriptor_set;
 
@@ -319,12 +430,29 @@ public:
     mrt_shader->Destroy();
     delete mrt_shader;
 
+    if (depth_prepass) {
+      depth_prepass_instance_descriptor_set->Destroy();
+      delete depth_prepass_instance_descriptor_set;
+
+      depth_prepass_global_descriptor_set->Destroy();
+      delete depth_prepass_global_descriptor_set;
+
+      depth_prepass_shader->Destroy();
+      delete depth_prepass_shader;
+    }
+
     for (auto it = sponza_texture_cache.begin();
          it != sponza_texture_cache.end(); ++it) {
       it->second->Destroy();
       delete it->second;
     }
 
+    default_normal_texture->Destroy();
+    delete default_normal_texture;
+
+    default_diffuse_texture->Destroy();
+    delete default_diffuse_texture;
+
     for (int i = 0; i < sponza_scene.size(); ++i) {
       sponza_vertex_buffers[i]->Destroy();
       delete sponza_vertex_buffers[i];
@@ -332,8 +460,10 @@ public:
       sponza_index_buffers[i]->Destroy();
       delete sponza_index_buffers[i];
 
-      mtr_texture_descriptor_sets[i]->Destroy();
-      delete mtr_texture_descriptor_sets[i];
+      if (mtr_texture_descriptor_sets[i]) {
+        mtr_texture_descriptor_sets[i]->Destroy();
+        delete mtr_texture_descriptor_sets[i];
+      }
     }
   }
 
@@ -342,11 +472,6 @@ public:
       UpdateStart();
 
       if (frontend->BeginFrame()) {
-        offscreen_render_pass->Begin(offscreen_render_target);
-        frontend->BeginDebugRegion("Offscreen pass",
-                                   glm::vec4(1.0, 0.0, 0.0, 1.0));
-
-        glm::vec3 camera_position = glm::vec3(0, 0, 0.0f);
         GlobalUBO global_ubo = {};
         global_ubo.view = camera->GetViewMatrix();
         global_ubo.projection = camera->GetProjectionMatrix();
@@ -359,24 +484,6 @@ public:
             glm::translate(instance_ubo.model, glm::vec3(0.0f));
         mrt_instance_uniform->LoadData(0, sizeof(InstanceUBO), &instance_ubo);
 
-        mrt_shader->Bind();
-        mrt_shader->BindUniformBuffer(mrt_global_descriptor_set, 0, 0);
-        mrt_shader->BindUniformBuffer(mrt_instance_descriptor_set, 0, 1);
-        for (int i = 0; i < sponza_scene.size(); ++i) {
-          sponza_index_buffers[i]->Bind(0);
-          sponza_vertex_buffers[i]->Bind(0);
-          mrt_shader->BindSampler(mtr_texture_descriptor_sets[i], 2);
-          frontend->DrawIndexed(sponza_scene[i].indices.size());
-        }
-
-        frontend->EndDebugRegion();
-        offscreen_render_pass->End();
-
-        frontend->GetWindowRenderPass()->Begin(
-            frontend->GetCurrentWindowRenderTarget());
-        frontend->BeginDebugRegion("Main pass",
-                                   glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-
         WorldUBO world_ubo = {};
         world_ubo.viewPos =
             glm::vec4(glm::vec3(glm::inverse(global_ubo.view)[3]), 1.0);
@@ -410,14 +517,48 @@ public:
         deferred_world_uniform->LoadData(0, deferred_world_uniform->GetSize(),
                                          &world_ubo);
 
-        deferred_shader->Bind();
-        deferred_shader->BindUniformBuffer(deferred_world_descriptor_set, 0, 0);
-        deferred_shader->BindSampler(deferred_texture_descriptor_set, 1);
-        frontend->Draw(4);
+        dynamic_resolution.Update(frontend->GetGPUFrameTime());
+
+        if (width != graph_width || height != graph_height) {
+          render_graph->Resize(width, height);
+          graph_width = width;
+          graph_height = height;
+          WriteGBufferDescriptorSet();
+        }
 
-        frontend->EndDebugRegion();
+        /* the attachments are always of the window size, only the render
+         * area shrinks */
+        glm::vec4 render_area = dynamic_resolution.GetRenderArea(width, height);
+        render_graph->GetRenderPass(gbuffer_pass)->SetRenderArea(render_area);
+        render_graph->Execute();
+
+        GPURenderTargetPool *pool = frontend->GetRenderTargetPool();
+        GPURenderTargetPoolAttachmentConfig post_config;
+        post_config.format = GPU_FORMAT_DEVICE_COLOR_OPTIMAL;
+        post_config.usage = GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT;
+        post_config.width = width;
+        post_config.height = height;
+        post_attachment = pool->AcquireAttachment(&post_config);
+
+        post_process->Prepare(render_graph->GetAttachment(scene_attachment),
+                              render_area.z, render_area.w);
+        std::vector<GPUAttachment *> post_attachments = {post_attachment};
+        post_render_pass->SetRenderArea(render_area);
+        post_render_pass->Begin(
+            pool->AcquireRenderTarget(post_render_pass, post_attachments));
+        post_process->Draw();
+        post_render_pass->End();
+
+        upscaler->Upscale(post_attachment, render_area, width, height);
+
+        frontend->GetWindowRenderPass()->Begin(
+            frontend->GetCurrentWindowRenderTarget());
+        upscaler->Sharpen();
         frontend->GetWindowRenderPass()->End();
 
+        /* the post process attachment only lives until it is upscaled */
+        pool->ReleaseAttachment(post_attachment);
+
         frontend->EndFrame();
       }
 
@@ -426,6 +567,101 @@ public:
   }
 
 private:
+  /* the g-buffer attachments are created again when the graph is resized */
+  void WriteGBufferDescriptorSet() {
+    if (deferred_texture_descriptor_set) {
+      deferred_texture_descriptor_set->Destroy();
+      delete deferred_texture_descriptor_set;
+    }
+
+    std::vector<GPUDescriptorBinding> bindings;
+    bindings.emplace_back(GPUDescriptorBinding{
+        0, GPU_DESCRIPTOR_BINDING_TYPE_INPUT_ATTACHMENT, 0, 0,
+        render_graph->GetAttachment(position_attachment)});
+    bindings.emplace_back(GPUDescriptorBinding{
+        1, GPU_DESCRIPTOR_BINDING_TYPE_INPUT_ATTACHMENT, 0, 0,
+        render_graph->GetAttachment(normal_attachment)});
+    bindings.emplace_back(GPUDescriptorBinding{
+        2, GPU_DESCRIPTOR_BINDING_TYPE_INPUT_ATTACHMENT, 0, 0,
+        render_graph->GetAttachment(albedo_attachment)});
+    deferred_texture_descriptor_set = frontend->DescriptorSetAllocate();
+    deferred_texture_descriptor_set->Create(deferred_shader, 1, bindings);
+    deferred_texture_descriptor_set->SetDebugName(
+        "Deferred texture descriptor set");
+  }
+
+  static void DepthPrepassPass(void *user_data) {
+    ((DeferredExample *)user_data)->DrawDepthPrepass();
+  }
+
+  static void GBufferPass(void *user_data) {
+    ((DeferredExample *)user_data)->DrawGBuffer();
+  }
+
+  static void LightingPass(void *user_data) {
+    ((DeferredExample *)user_data)->DrawLighting();
+  }
+
+  void DrawDepthPrepass() {
+    depth_prepass_shader->Bind();
+    depth_prepass_shader->BindUniformBuffer(
+        depth_prepass_global_descriptor_set, 0, 0);
+    depth_prepass_shader->BindUniformBuffer(
+        depth_prepass_instance_descriptor_set, 0, 1);
+    for (int i = 0; i < sponza_scene.size(); ++i) {
+      sponza_index_buffers[i]->Bind(0);
+      sponza_vertex_buffers[i]->Bind(0);
+      frontend->DrawIndexed(sponza_scene[i].indices.size());
+    }
+  }
+
+  void DrawGBuffer() {
+    /* textured meshes first, then the untextured ones, so that each
+     * variant is bound once */
+    const uint32_t variants[] = {mrt_textured_variant, 0};
+    for (int v = 0; v < 2; ++v) {
+      mrt_shader->SetVariant(variants[v]);
+      mrt_shader->Bind();
+      mrt_shader->BindUniformBuffer(mrt_global_descriptor_set, 0, 0);
+      mrt_shader->BindUniformBuffer(mrt_instance_descriptor_set, 0, 1);
+      for (int i = 0; i < sponza_scene.size(); ++i) {
+        Mesh *mesh = &sponza_scene[i];
+        if (mesh->textured != ((variants[v] & MRT_VARIANT_TEXTURED) != 0)) {
+          continue;
+        }
+
+        sponza_index_buffers[i]->Bind(0);
+        sponza_vertex_buffers[i]->Bind(0);
+        if (mesh->textured && (variants[v] & MRT_VARIANT_BINDLESS)) {
+          MaterialIndices indices = {};
+          indices.diffuse = sponza_diffuse_textures[i]->GetBindlessIndex();
+          if (indices.diffuse == GPU_BINDLESS_INDEX_NONE) {
+            indices.diffuse = default_diffuse_texture->GetBindlessIndex();
+          }
+          indices.normal = sponza_normal_textures[i]->GetBindlessIndex();
+          if (indices.normal == GPU_BINDLESS_INDEX_NONE) {
+            indices.normal = default_normal_texture->GetBindlessIndex();
+          }
+          mrt_shader->PushConstant(&indices, sizeof(MaterialIndices), 0);
+        } else if (mesh->textured) {
+          mrt_shader->BindSampler(mtr_texture_descriptor_sets[i], 2);
+        }
+        frontend->DrawIndexed(mesh->indices.size());
+      }
+    }
+  }
+
+  void DrawLighting() {
+    deferred_shader->Bind();
+    deferred_shader->BindUniformBuffer(deferred_world_descriptor_set, 0, 0);
+    deferred_shader->BindSampler(deferred_texture_descriptor_set, 1);
+    frontend->Draw(4);
+  }
+
+  /* keyword bits of the mrt shader */
+  static const uint32_t MRT_VARIANT_TEXTURED = (1 << 0);
+  static const uint32_t MRT_VARIANT_BINDLESS = (1 << 1);
+
   struct GlobalUBO {
     glm::mat4 view;
     glm::mat4 projection;
@@ -433,6 +669,11 @@ private:
   struct InstanceUBO {
     glm::mat4 model;
   };
+  /* indices into the bindless texture table */
+  struct MaterialIndices {
+    uint32_t diffuse;
+    uint32_t normal;
+  };
 
   struct Light {
     glm::vec4 position;
@@ -453,8 +694,11 @@ private:
   std::vector<GPUTexture *> sponza_diffuse_textures;
   std::vector<GPUTexture *> sponza_specular_textures;
   std::vector<GPUTexture *> sponza_normal_textures;
+  GPUTexture *default_diffuse_texture;
+  GPUTexture *default_normal_texture;
 
   GPUShader *mrt_shader;
+  uint32_t mrt_textured_variant;
 
   GPUUniformBuffer *mrt_global_uniform;
   GPUUniformBuffer *mrt_instance_uniform;
@@ -462,18 +706,36 @@ private:
   GPUDescriptorSet *mrt_instance_descriptor_set;
   std::vector<GPUDescriptorSet *> mtr_texture_descriptor_sets;
 
-  GPUAttachment *offscreen_position_attachment;
-  GPUAttachment *offscreen_normal_attachment;
-  GPUAttachment *offscreen_albedo_attachment;
-  GPUAttachment *offscreen_depth_attachment;
-  GPURenderPass *offscreen_render_pass;
-  GPURenderTarget *offscreen_render_target;
+  /* lays down the depth before the g-buffer pass, which then tests EQUAL */
+  bool depth_prepass;
+  GPUShader *depth_prepass_shader;
+  GPUDescriptorSet *depth_prepass_global_descriptor_set;
+  GPUDescriptorSet *depth_prepass_instance_descriptor_set;
+
+  GPURenderGraph *render_graph;
+  uint32_t graph_width;
+  uint32_t graph_height;
+  uint32_t position_attachment;
+  uint32_t normal_attachment;
+  uint32_t albedo_attachment;
+  uint32_t depth_attachment;
+  /* lit scene, at the resolution of the dynamic resolution */
+  uint32_t scene_attachment;
+  uint32_t depth_prepass_pass;
+  uint32_t gbuffer_pass;
+  uint32_t lighting_pass;
 
   GPUShader *deferred_shader;
   GPUUniformBuffer *deferred_world_uniform;
 
   GPUDescriptorSet *deferred_texture_descriptor_set;
   GPUDescriptorSet *deferred_world_descriptor_set;
+
+  GPUDynamicResolution dynamic_resolution;
+  GPUAttachment *post_attachment;
+  GPURenderPass *post_render_pass;
+  GPUPostProcessStack *post_process;
+  GPUUpscaler *upscaler;
 };
 
 int main(int argc, char **argv) {
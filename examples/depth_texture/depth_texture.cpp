@@ -29,10 +29,14 @@ public:
     meshes[1].position = glm::vec3(2, 0, 0.0f);
     meshes[2].position = glm::vec3(-2, 0, 0.0f);
 
-    offscreen_depth_attachment = frontend->AttachmentAllocate();
-    offscreen_depth_attachment->Create(
-        GPU_FORMAT_DEVICE_DEPTH_OPTIMAL,
-        GPU_ATTACHMENT_USAGE_DEPTH_STENCIL_ATTACHMENT, width, height);
+    /* sampled by the main pass, so it is held for the whole example */
+    GPURenderTargetPoolAttachmentConfig depth_config;
+    depth_config.format = GPU_FORMAT_DEVICE_DEPTH_OPTIMAL;
+    depth_config.usage = GPU_ATTACHMENT_USAGE_DEPTH_STENCIL_ATTACHMENT;
+    depth_config.width = width;
+    depth_config.height = height;
+    offscreen_depth_attachment =
+        frontend->GetRenderTargetPool()->AcquireAttachment(&depth_config);
     offscreen_depth_attachment->SetDebugName("Offscreen depth attachment");
 
     offscreen_render_pass = frontend->RenderPassAllocate();
@@ -47,12 +51,6 @@ public:
         GPU_RENDER_PASS_CLEAR_FLAG_COLOR | GPU_RENDER_PASS_CLEAR_FLAG_DEPTH |
             GPU_RENDER_PASS_CLEAR_FLAG_STENCIL);
     offscreen_render_pass->SetDebugName("Offscreen render pass");
-    offscreen_render_target = frontend->RenderTargetAllocate();
-    offscreen_render_target->Create(
-        offscreen_render_pass,
-        std::vector<GPUAttachment *>{offscreen_depth_attachment}, width,
-        height);
-    offscreen_render_target->SetDebugName("Offscreen framebuffer");
 
     std::vector<GPUShaderStageConfig> stage_configs;
     stage_configs.emplace_back(GPUShaderStageConfig{
@@ -84,14 +82,14 @@ public:
     global_descriptor_set = frontend->DescriptorSetAllocate();
     bindings.emplace_back(GPUDescriptorBinding{
         0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, global_uniform});
-    global_descriptor_set->Create(bindings);
+    global_descriptor_set->Create(shader, 0, bindings);
     global_descriptor_set->SetDebugName("Global descriptor set");
     bindings.clear();
 
     instance_descriptor_set = frontend->DescriptorSetAllocate();
     bindings.emplace_back(GPUDescriptorBinding{
         0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, instance_uniform});
-    instance_descriptor_set->Create(bindings);
+    instance_descriptor_set->Create(shader, 1, bindings);
     instance_descriptor_set->SetDebugName("Instance descriptor set");
     bindings.clear();
 
@@ -115,7 +113,7 @@ public:
     bindings.emplace_back(
         GPUDescriptorBinding{0, GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT, 0, 0,
                              offscreen_depth_attachment});
-    post_processing_set->Create(bindings);
+    post_processing_set->Create(post_processing_shader, 0, bindings);
     post_processing_set->SetDebugName("Post processing descriptor set");
   }
   virtual ~DepthTextureExample() {
@@ -124,8 +122,8 @@ public:
     post_processing_shader->Destroy();
     delete post_processing_shader;
 
-    offscreen_render_target->Destroy();
-    offscreen_depth_attachment->Destroy();
+    frontend->GetRenderTargetPool()->ReleaseAttachment(
+        offscreen_depth_attachment);
     offscreen_render_pass->Destroy();
     delete offscreen_render_pass;
     global_descriptor_set->Destroy();
@@ -147,7 +145,11 @@ public:
       UpdateStart();
 
       if (frontend->BeginFrame()) {
-        offscreen_render_pass->Begin(offscreen_render_target);
+        std::vector<GPUAttachment *> offscreen_attachments = {
+            offscreen_depth_attachment};
+        offscreen_render_pass->Begin(
+            frontend->GetRenderTargetPool()->AcquireRenderTarget(
+                offscreen_render_pass, offscreen_attachments));
         frontend->BeginDebugRegion("Offscreen pass",
                                    glm::vec4(1.0, 0.0, 0.0, 1.0));
 
@@ -225,7 +227,6 @@ private:
 
   GPUAttachment *offscreen_depth_attachment;
   GPURenderPass *offscreen_render_pass;
-  GPURenderTarget *offscreen_render_target;
 
   GPUUniformBuffer *global_uniform;
   GPUUniformBuffer *instance_uniform;
@@ -21,22 +21,6 @@ public:
     instance_uniform->Create(sizeof(InstanceUBO));
     instance_uniform->SetDebugName("Instance uniform");
 
-    std::vector<GPUDescriptorBinding> bindings;
-
-    global_descriptor_set = frontend->DescriptorSetAllocate();
-    bindings.emplace_back(GPUDescriptorBinding{
-        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, global_uniform});
-    global_descriptor_set->Create(bindings);
-    global_descriptor_set->SetDebugName("Global descriptor set");
-    bindings.clear();
-
-    instance_descriptor_set = frontend->DescriptorSetAllocate();
-    bindings.emplace_back(GPUDescriptorBinding{
-        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, instance_uniform});
-    instance_descriptor_set->Create(bindings);
-    instance_descriptor_set->SetDebugName("Instance descriptor set");
-    bindings.clear();
-
     vertices = Utils::GenerateSphereVertices(1, 36, 18);
     indices = Utils::GenerateSphereIndices(36, 18);
 
@@ -69,10 +53,24 @@ public:
     shader_config.render_pass = frontend->GetWindowRenderPass(); 
     shader_config.viewport_width = width;
     shader_config.viewport_height = height;
+    /* the instance set is pushed per draw */
+    shader_config.push_descriptor_set_mask = (1 << 1);
 
     shader = frontend->ShaderAllocate();
     shader->Create(&shader_config);
     shader->SetDebugName("Normals debug shader");
+
+    std::vector<GPUDescriptorBinding> bindings;
+
+    global_descriptor_set = frontend->DescriptorSetAllocate();
+    bindings.emplace_back(GPUDescriptorBinding{
+        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, global_uniform});
+    global_descriptor_set->Create(shader, 0, bindings);
+    global_descriptor_set->SetDebugName("Global descriptor set");
+    bindings.clear();
+
+    instance_bindings.emplace_back(GPUDescriptorBinding{
+        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, instance_uniform});
   }
 
   virtual ~GeometryShaderExample() {
@@ -87,8 +85,6 @@ public:
 
     global_descriptor_set->Destroy();
     delete global_descriptor_set;
-    instance_descriptor_set->Destroy();
-    delete instance_descriptor_set;
     instance_uniform->Destroy();
     delete instance_uniform;
     global_uniform->Destroy();
@@ -119,7 +115,7 @@ public:
         vertex_buffer->Bind(0);
         index_buffer->Bind(0);
         shader->BindUniformBuffer(global_descriptor_set, 0, 0);
-        shader->BindUniformBuffer(instance_descriptor_set, 0, 1);
+        shader->PushDescriptorSet(1, instance_bindings, 0);
         frontend->DrawIndexed(indices.size());
 
         frontend->GetWindowRenderPass()->End();
@@ -144,7 +140,7 @@ private:
   GPUUniformBuffer *global_uniform;
   GPUUniformBuffer *instance_uniform;
   GPUDescriptorSet *global_descriptor_set;
-  GPUDescriptorSet *instance_descriptor_set;
+  std::vector<GPUDescriptorBinding> instance_bindings;
 
   std::vector<float> vertices;
   std::vector<unsigned int> indices;
@@ -0,0 +1,393 @@
+#include <iostream>
+
+#include "../base/example.h"
+#include "../base/utils.h"
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <rf3d/framework/logger.h>
+#include <rf3d/framework/renderer/renderer_frontend.h>
+
+#define PARTICLE_MAX_COUNT 16384
+#define PARTICLE_SPAWN_COUNT 64
+
+class ParticlesExample : public Example {
+public:
+  ParticlesExample(const char *example_name, int window_width,
+                   int window_height)
+      : Example(example_name, window_width, window_height) {
+
+    /* both buffers start zeroed: no live particles and no groups */
+    std::vector<Particle> particles(PARTICLE_MAX_COUNT);
+    particle_buffer = frontend->StorageBufferAllocate();
+    particle_buffer->Create(particles.size() * sizeof(particles[0]));
+    particle_buffer->LoadData(0, particles.size() * sizeof(particles[0]),
+                              particles.data());
+    particle_buffer->SetDebugName("Particle storage buffer");
+
+    Arguments arguments = {};
+    arguments_buffer = frontend->StorageBufferAllocate();
+    arguments_buffer->Create(sizeof(Arguments));
+    arguments_buffer->LoadData(0, sizeof(Arguments), &arguments);
+    arguments_buffer->SetDebugName("Particle arguments buffer");
+
+    vertices = Utils::GetCubeVertices();
+
+    vertex_buffer = frontend->VertexBufferAllocate();
+    vertex_buffer->Create(vertices.size() * sizeof(vertices[0]));
+    vertex_buffer->LoadData(0, vertices.size() * sizeof(vertices[0]),
+                            vertices.data());
+    vertex_buffer->SetDebugName("Cube vertex buffer");
+
+    depth_attachment = 0;
+    AcquireDepthAttachment();
+
+    depth_render_pass = frontend->RenderPassAllocate();
+    depth_render_pass->Create(
+        std::vector<GPURenderPassAttachmentConfig>{
+            GPURenderPassAttachmentConfig{
+                depth_attachment->GetFormat(), depth_attachment->GetUsage(),
+                GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_DONT_CARE,
+                GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_STORE, false}},
+        glm::vec4(0, 0, width, height), glm::vec4(0, 0, 0, 1), 1.0f, 0.0f,
+        GPU_RENDER_PASS_CLEAR_FLAG_DEPTH | GPU_RENDER_PASS_CLEAR_FLAG_STENCIL);
+    depth_render_pass->SetDebugName("Depth prepass");
+
+    GPUComputeShaderConfig compute_config;
+    compute_config.file_path = "assets/shaders/particle_spawn.comp.spv";
+    spawn_shader = frontend->ComputeShaderAllocate();
+    spawn_shader->Create(&compute_config);
+    spawn_shader->SetDebugName("Particle spawn shader");
+
+    compute_config.file_path = "assets/shaders/particle_update.comp.spv";
+    update_shader = frontend->ComputeShaderAllocate();
+    update_shader->Create(&compute_config);
+    update_shader->SetDebugName("Particle update shader");
+
+    std::vector<GPUDescriptorBinding> bindings;
+
+    spawn_set = frontend->DescriptorSetAllocate();
+    bindings.emplace_back(
+        GPUDescriptorBinding{0, GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_BUFFER, 0,
+                             0, 0, arguments_buffer});
+    spawn_set->Create(spawn_shader, 0, bindings);
+    spawn_set->SetDebugName("Particle spawn descriptor set");
+
+    update_set = 0;
+    WriteUpdateDescriptorSet();
+
+    std::vector<GPUShaderStageConfig> stage_configs;
+    stage_configs.emplace_back(GPUShaderStageConfig{
+        GPU_SHADER_STAGE_TYPE_VERTEX, "assets/shaders/depth_write.vert.spv"});
+
+    GPUShaderConfig shader_config;
+    shader_config.stage_configs = stage_configs;
+    shader_config.topology_type = GPU_SHADER_TOPOLOGY_TYPE_TRIANGLE_LIST;
+    shader_config.depth_flags = GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE |
+                                GPU_SHADER_DEPTH_FLAG_DEPTH_WRITE_ENABLE;
+    shader_config.stencil_flags = 0;
+    shader_config.render_pass = depth_render_pass;
+    shader_config.viewport_width = width;
+    shader_config.viewport_height = height;
+
+    depth_shader = frontend->ShaderAllocate();
+    depth_shader->Create(&shader_config);
+    depth_shader->SetDebugName("Depth prepass shader");
+
+    stage_configs.emplace_back(
+        GPUShaderStageConfig{GPU_SHADER_STAGE_TYPE_FRAGMENT,
+                             "assets/shaders/particle_ground.frag.spv"});
+    shader_config.stage_configs = stage_configs;
+    shader_config.render_pass = frontend->GetWindowRenderPass();
+
+    ground_shader = frontend->ShaderAllocate();
+    ground_shader->Create(&shader_config);
+    ground_shader->SetDebugName("Ground shader");
+
+    stage_configs.clear();
+    stage_configs.emplace_back(GPUShaderStageConfig{
+        GPU_SHADER_STAGE_TYPE_VERTEX, "assets/shaders/particle.vert.spv"});
+    stage_configs.emplace_back(GPUShaderStageConfig{
+        GPU_SHADER_STAGE_TYPE_FRAGMENT, "assets/shaders/particle.frag.spv"});
+
+    /* additive, so the particles don't have to be sorted */
+    GPUShaderBlendState blend_state;
+    blend_state.dst_color_factor = GPU_SHADER_BLEND_FACTOR_ONE;
+    blend_state.dst_alpha_factor = GPU_SHADER_BLEND_FACTOR_ONE;
+
+    shader_config.stage_configs = stage_configs;
+    shader_config.depth_flags = GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE;
+    shader_config.render_state.blend_states.emplace_back(blend_state);
+
+    particle_shader = frontend->ShaderAllocate();
+    particle_shader->Create(&shader_config);
+    particle_shader->SetDebugName("Particle shader");
+
+    global_uniform = frontend->UniformBufferAllocate();
+    global_uniform->Create(sizeof(GlobalUBO));
+    global_uniform->SetDebugName("Global uniform buffer");
+
+    bindings.clear();
+    global_descriptor_set = frontend->DescriptorSetAllocate();
+    bindings.emplace_back(GPUDescriptorBinding{
+        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, global_uniform});
+    global_descriptor_set->Create(particle_shader, 0, bindings);
+    global_descriptor_set->SetDebugName("Global descriptor set");
+    bindings.clear();
+
+    instance_uniform = frontend->UniformBufferAllocate();
+    instance_uniform->Create(sizeof(InstanceUBO));
+    instance_uniform->SetDebugName("Instance uniform buffer");
+
+    instance_descriptor_set = frontend->DescriptorSetAllocate();
+    bindings.emplace_back(GPUDescriptorBinding{
+        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, instance_uniform});
+    instance_descriptor_set->Create(depth_shader, 1, bindings);
+    instance_descriptor_set->SetDebugName("Instance descriptor set");
+    bindings.clear();
+
+    particle_set = frontend->DescriptorSetAllocate();
+    bindings.emplace_back(
+        GPUDescriptorBinding{0, GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_BUFFER, 0,
+                             0, 0, arguments_buffer});
+    bindings.emplace_back(
+        GPUDescriptorBinding{1, GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_BUFFER, 0,
+                             0, 0, particle_buffer});
+    particle_set->Create(particle_shader, 1, bindings);
+    particle_set->SetDebugName("Particle descriptor set");
+  }
+  virtual ~ParticlesExample() {
+    particle_set->Destroy();
+    delete particle_set;
+    instance_descriptor_set->Destroy();
+    delete instance_descriptor_set;
+    global_descriptor_set->Destroy();
+    delete global_descriptor_set;
+    instance_uniform->Destroy();
+    delete instance_uniform;
+    global_uniform->Destroy();
+    delete global_uniform;
+    particle_shader->Destroy();
+    delete particle_shader;
+    ground_shader->Destroy();
+    delete ground_shader;
+    depth_shader->Destroy();
+    delete depth_shader;
+    update_set->Destroy();
+    delete update_set;
+    spawn_set->Destroy();
+    delete spawn_set;
+    update_shader->Destroy();
+    delete update_shader;
+    spawn_shader->Destroy();
+    delete spawn_shader;
+    arguments_buffer->Destroy();
+    delete arguments_buffer;
+    particle_buffer->Destroy();
+    delete particle_buffer;
+    depth_render_pass->Destroy();
+    delete depth_render_pass;
+    frontend->GetRenderTargetPool()->ReleaseAttachment(depth_attachment);
+    vertex_buffer->Destroy();
+    delete vertex_buffer;
+  }
+
+  void EventLoop() override {
+    uint32_t previous_time = SDL_GetTicks();
+
+    while (running) {
+      UpdateStart();
+
+      uint32_t current_time = SDL_GetTicks();
+      float delta_time = (current_time - previous_time) / 1000.0f;
+      previous_time = current_time;
+
+      if (frontend->BeginFrame()) {
+        if (width != depth_width || height != depth_height) {
+          AcquireDepthAttachment();
+          WriteUpdateDescriptorSet();
+          depth_render_pass->SetRenderArea(glm::vec4(0, 0, width, height));
+        }
+
+        GlobalUBO global_ubo = {};
+        global_ubo.view = camera->GetViewMatrix();
+        global_ubo.projection = camera->GetProjectionMatrix();
+        global_uniform->LoadData(0, global_uniform->GetSize(), &global_ubo);
+
+        InstanceUBO instance_ubo = {};
+        instance_ubo.model =
+            glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)) *
+            glm::scale(glm::mat4(1.0f), glm::vec3(6.0f, 0.2f, 6.0f));
+        instance_uniform->LoadData(0, instance_uniform->GetSize(),
+                                   &instance_ubo);
+
+        std::vector<GPUAttachment *> depth_attachments = {depth_attachment};
+        depth_render_pass->Begin(
+            frontend->GetRenderTargetPool()->AcquireRenderTarget(
+                depth_render_pass, depth_attachments));
+        frontend->BeginDebugRegion("Depth prepass",
+                                   glm::vec4(1.0, 0.0, 0.0, 1.0));
+
+        DrawGround(depth_shader);
+
+        frontend->EndDebugRegion();
+        depth_render_pass->End();
+
+        /* the simulation reads the depth of the prepass submitted above, and
+         * overlaps the main pass */
+        frontend->BeginAsyncCompute(depth_attachments);
+
+        SpawnConstants spawn_constants = {};
+        spawn_constants.max_count = PARTICLE_MAX_COUNT;
+        spawn_constants.spawn_count = PARTICLE_SPAWN_COUNT;
+
+        spawn_shader->Bind();
+        spawn_shader->BindDescriptorSet(spawn_set, 0);
+        spawn_shader->PushConstant(&spawn_constants, sizeof(spawn_constants),
+                                   0);
+        frontend->Dispatch(1, 1, 1);
+
+        /* the update dispatch reads the group counts as its arguments and
+         * the live count in the shader */
+        frontend->PipelineBarrier(GPU_BARRIER_TYPE_COMPUTE_TO_INDIRECT);
+        frontend->PipelineBarrier(GPU_BARRIER_TYPE_COMPUTE_TO_COMPUTE);
+
+        UpdateConstants update_constants = {};
+        update_constants.view_projection =
+            global_ubo.projection * global_ubo.view;
+        update_constants.delta_time = delta_time;
+        update_constants.time = (current_time - start_time_ms) / 1000.0f;
+
+        update_shader->Bind();
+        update_shader->BindDescriptorSet(update_set, 0);
+        update_shader->PushConstant(&update_constants,
+                                    sizeof(update_constants), 0);
+        frontend->DispatchIndirect(arguments_buffer, 0);
+
+        /* the draws of the particles wait for the simulation */
+        frontend->EndAsyncCompute();
+
+        frontend->GetWindowRenderPass()->Begin(
+            frontend->GetCurrentWindowRenderTarget());
+        frontend->BeginDebugRegion("Main pass", glm::vec4(0.0, 1.0, 0.0, 1.0));
+
+        DrawGround(ground_shader);
+
+        particle_shader->Bind();
+        particle_shader->BindUniformBuffer(global_descriptor_set, 0, 0);
+        particle_shader->BindSampler(particle_set, 1);
+        frontend->Draw(PARTICLE_MAX_COUNT * 6);
+
+        frontend->EndDebugRegion();
+        frontend->GetWindowRenderPass()->End();
+
+        frontend->EndFrame();
+      }
+
+      UpdateEnd();
+    }
+  }
+
+private:
+  /* read by the particle update, so it is held across the frames and only
+   * reacquired when the window size changes */
+  void AcquireDepthAttachment() {
+    GPURenderTargetPool *pool = frontend->GetRenderTargetPool();
+    if (depth_attachment) {
+      pool->ReleaseAttachment(depth_attachment);
+    }
+
+    GPURenderTargetPoolAttachmentConfig depth_config;
+    depth_config.format = GPU_FORMAT_DEVICE_DEPTH_OPTIMAL;
+    depth_config.usage = GPU_ATTACHMENT_USAGE_DEPTH_STENCIL_ATTACHMENT;
+    depth_config.width = width;
+    depth_config.height = height;
+    depth_attachment = pool->AcquireAttachment(&depth_config);
+    depth_attachment->SetDebugName("Scene depth attachment");
+    depth_width = width;
+    depth_height = height;
+  }
+
+  void WriteUpdateDescriptorSet() {
+    if (update_set) {
+      update_set->Destroy();
+      delete update_set;
+    }
+
+    std::vector<GPUDescriptorBinding> bindings;
+    bindings.emplace_back(
+        GPUDescriptorBinding{0, GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_BUFFER, 0,
+                             0, 0, arguments_buffer});
+    bindings.emplace_back(
+        GPUDescriptorBinding{1, GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_BUFFER, 0,
+                             0, 0, particle_buffer});
+    bindings.emplace_back(GPUDescriptorBinding{
+        2, GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT, 0, 0, depth_attachment});
+    update_set = frontend->DescriptorSetAllocate();
+    update_set->Create(update_shader, 0, bindings);
+    update_set->SetDebugName("Particle update descriptor set");
+  }
+
+  void DrawGround(GPUShader *shader) {
+    shader->Bind();
+    vertex_buffer->Bind(0);
+    shader->BindUniformBuffer(global_descriptor_set, 0, 0);
+    shader->BindUniformBuffer(instance_descriptor_set, 0, 1);
+    frontend->Draw(vertices.size() / 8);
+  }
+
+  /* std430 layouts of the shader buffers */
+  struct Particle {
+    glm::vec4 position;
+    glm::vec4 velocity;
+  };
+  struct Arguments {
+    uint32_t group_count[3];
+    uint32_t active_count;
+  };
+  struct SpawnConstants {
+    uint32_t max_count;
+    uint32_t spawn_count;
+  };
+  struct UpdateConstants {
+    glm::mat4 view_projection;
+    float delta_time;
+    float time;
+  };
+  struct GlobalUBO {
+    glm::mat4 view;
+    glm::mat4 projection;
+  };
+  struct InstanceUBO {
+    glm::mat4 model;
+  };
+
+  GPUVertexBuffer *vertex_buffer;
+  std::vector<float> vertices;
+  GPUAttachment *depth_attachment;
+  int depth_width, depth_height;
+  GPURenderPass *depth_render_pass;
+  GPUShader *depth_shader;
+  GPUShader *ground_shader;
+
+  GPUStorageBuffer *particle_buffer;
+  GPUStorageBuffer *arguments_buffer;
+
+  GPUComputeShader *spawn_shader;
+  GPUComputeShader *update_shader;
+  GPUDescriptorSet *spawn_set;
+  GPUDescriptorSet *update_set;
+
+  GPUShader *particle_shader;
+  GPUUniformBuffer *global_uniform;
+  GPUUniformBuffer *instance_uniform;
+  GPUDescriptorSet *global_descriptor_set;
+  GPUDescriptorSet *instance_descriptor_set;
+  GPUDescriptorSet *particle_set;
+};
+
+int main(int argc, char **argv) {
+  Example *example = new ParticlesExample("Particles", 800, 600);
+  example->EventLoop();
+  delete example;
+}
\ No newline at end of file
@@ -25,20 +25,6 @@ public:
 
     std::vector<GPUDescriptorBinding> bindings;
 
-    global_descriptor_set = frontend->DescriptorSetAllocate();
-    bindings.emplace_back(GPUDescriptorBinding{
-        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, global_uniform});
-    global_descriptor_set->Create(bindings);
-    global_descriptor_set->SetDebugName("Global descriptor set");
-    bindings.clear();
-
-    instance_descriptor_set = frontend->DescriptorSetAllocate();
-    bindings.emplace_back(GPUDescriptorBinding{
-        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, instance_uniform});
-    instance_descriptor_set->Create(bindings);
-    instance_descriptor_set->SetDebugName("Instance descriptor set");
-    bindings.clear();
-
     cubemap = frontend->TextureAllocate();
     std::array<const char *, 6> cubemap_paths;
     cubemap_paths[0] = "assets/textures/skybox_r.jpg";
@@ -73,8 +59,9 @@ public:
     bindings.clear();
     bindings.emplace_back(GPUDescriptorBinding{
         0, GPU_DESCRIPTOR_BINDING_TYPE_TEXTURE, cubemap, 0, 0});
-    skybox_texture_set->Create(bindings);
+    skybox_texture_set->Create(skybox_shader, 1, bindings);
     skybox_texture_set->SetDebugName("Skybox texture descriptor set");
+    bindings.clear();
 
     skybox_vertices = Utils::GetCubeVerticesPositionsOnly();
     skybox_vertex_buffer = frontend->VertexBufferAllocate();
@@ -118,6 +105,20 @@ public:
     reflect_shader = frontend->ShaderAllocate();
     reflect_shader->Create(&shader_config);
     reflect_shader->SetDebugName("Reflect shader");
+
+    global_descriptor_set = frontend->DescriptorSetAllocate();
+    bindings.emplace_back(GPUDescriptorBinding{
+        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, global_uniform});
+    global_descriptor_set->Create(reflect_shader, 0, bindings);
+    global_descriptor_set->SetDebugName("Global descriptor set");
+    bindings.clear();
+
+    instance_descriptor_set = frontend->DescriptorSetAllocate();
+    bindings.emplace_back(GPUDescriptorBinding{
+        0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, instance_uniform});
+    instance_descriptor_set->Create(reflect_shader, 1, bindings);
+    instance_descriptor_set->SetDebugName("Instance descriptor set");
+    bindings.clear();
   }
 
   virtual ~SkyboxExample() {
@@ -82,14 +82,14 @@ public:
     global_descriptor_set = frontend->DescriptorSetAllocate();
     bindings.emplace_back(GPUDescriptorBinding{
         0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, global_uniform});
-    global_descriptor_set->Create(bindings);
+    global_descriptor_set->Create(toon_shader, 0, bindings);
     global_descriptor_set->SetDebugName("Global descriptor set");
     bindings.clear();
 
     instance_descriptor_set = frontend->DescriptorSetAllocate();
     bindings.emplace_back(GPUDescriptorBinding{
         0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, instance_uniform});
-    instance_descriptor_set->Create(bindings);
+    instance_descriptor_set->Create(toon_shader, 1, bindings);
     instance_descriptor_set->SetDebugName("Instance descriptor set");
     bindings.clear();
   }
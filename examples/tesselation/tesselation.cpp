@@ -69,21 +69,21 @@ public:
     global_descriptor_set = frontend->DescriptorSetAllocate();
     bindings.emplace_back(GPUDescriptorBinding{
         0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, global_uniform});
-    global_descriptor_set->Create(bindings);
+    global_descriptor_set->Create(shader, 0, bindings);
     global_descriptor_set->SetDebugName("Global descriptor set");
     bindings.clear();
 
     instance_descriptor_set = frontend->DescriptorSetAllocate();
     bindings.emplace_back(GPUDescriptorBinding{
         0, GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER, 0, instance_uniform});
-    instance_descriptor_set->Create(bindings);
+    instance_descriptor_set->Create(shader, 1, bindings);
     instance_descriptor_set->SetDebugName("Instance descriptor set");
     bindings.clear();
 
     texture_descriptor_set = frontend->DescriptorSetAllocate();
     bindings.emplace_back(GPUDescriptorBinding{
         0, GPU_DESCRIPTOR_BINDING_TYPE_TEXTURE, texture, 0});
-    texture_descriptor_set->Create(bindings);
+    texture_descriptor_set->Create(shader, 2, bindings);
     texture_descriptor_set->SetDebugName("Texture descriptor set");
     bindings.clear();
   }
@@ -12,13 +12,24 @@ enum GPUAttachmentUsage {
   GPU_ATTACHMENT_USAGE_DEPTH_STENCIL_ATTACHMENT,
 };
 
+enum GPUAttachmentFlagBits {
+  /* the attachment can be read by the later subpasses of the render pass
+   * that writes it, with GPU_DESCRIPTOR_BINDING_TYPE_INPUT_ATTACHMENT */
+  GPU_ATTACHMENT_FLAG_INPUT = (1 << 0),
+  /* the attachment lives only inside of a render pass: it is never sampled,
+   * loaded or stored, so on tile based GPUs it can stay in tile memory and
+   * is not backed by memory at all */
+  GPU_ATTACHMENT_FLAG_TRANSIENT = (1 << 1),
+};
+
 class GPUAttachment {
 public:
   virtual ~GPUAttachment() {}
 
   virtual void Create(GPUFormat attachment_format,
                       GPUAttachmentUsage attachment_usage,
-                      uint32_t texture_width, uint32_t texture_height) = 0;
+                      uint32_t texture_width, uint32_t texture_height,
+                      uint32_t attachment_flags = 0) = 0;
   virtual void Destroy() = 0;
 
   virtual void SetDebugName(const char *name) = 0;
@@ -28,10 +39,12 @@ public:
   inline GPUAttachmentUsage GetUsage() const { return aspect; }
   inline uint32_t GetWidth() const { return width; }
   inline uint32_t GetHeight() const { return height; }
+  inline uint32_t GetFlags() const { return flags; }
 
 protected:
   GPUFormat format;
   GPUAttachmentUsage aspect;
   uint32_t width;
   uint32_t height;
+  uint32_t flags;
 };
\ No newline at end of file
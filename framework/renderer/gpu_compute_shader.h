@@ -0,0 +1,64 @@
+#pragma once
+
+#include "gpu_descriptor_set.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+/* memory dependencies between the dispatches and the work around them */
+enum GPUBarrierType {
+  /* storage writes of a dispatch are visible to the next dispatches */
+  GPU_BARRIER_TYPE_COMPUTE_TO_COMPUTE,
+  /* storage writes of a dispatch are visible to the draws, as vertex and
+   * index data, uniforms or shader reads */
+  GPU_BARRIER_TYPE_COMPUTE_TO_GRAPHICS,
+  /* storage writes of a dispatch are visible as indirect arguments */
+  GPU_BARRIER_TYPE_COMPUTE_TO_INDIRECT,
+  /* writes of the draws are visible to the next dispatches */
+  GPU_BARRIER_TYPE_GRAPHICS_TO_COMPUTE,
+};
+
+struct GPUComputeShaderConfig {
+  /* compiled ".comp.spv" file */
+  const char *file_path;
+  /* same as GPUShaderConfig::keywords */
+  std::vector<const char *> keywords;
+  /* bit i marks set i as written per dispatch with PushDescriptorSet */
+  uint32_t push_descriptor_set_mask = 0;
+};
+
+/* Compute pipeline, bound and dispatched outside of render passes. Sets are
+ * reflected the same way as the GPUShader ones */
+class GPUComputeShader {
+public:
+  virtual ~GPUComputeShader(){};
+
+  virtual bool Create(GPUComputeShaderConfig *config) = 0;
+  virtual void Destroy() = 0;
+
+  /* selects the permutation used by the next Bind */
+  virtual void SetVariant(uint32_t variant_mask) = 0;
+
+  virtual void Bind() = 0;
+  virtual void BindUniformBuffer(GPUDescriptorSet *set, uint32_t offset,
+                                 int32_t set_index) = 0;
+  /* for sets without uniform buffers */
+  virtual void BindDescriptorSet(GPUDescriptorSet *set, int32_t set_index) = 0;
+  virtual void PushDescriptorSet(int32_t set_index,
+                                 std::vector<GPUDescriptorBinding> &bindings,
+                                 uint32_t uniform_buffer_offset) = 0;
+  virtual void PushConstant(void *value, uint64_t size, uint32_t offset) = 0;
+
+  /* local_size of the shader, used to compute the group counts */
+  virtual void GetWorkgroupSize(uint32_t *out_x, uint32_t *out_y,
+                                uint32_t *out_z) = 0;
+
+  virtual void SetDebugName(const char *name) = 0;
+  virtual void SetDebugTag(const void *tag, size_t tag_size) = 0;
+
+  inline uint32_t GetVariant() { return variant_mask; }
+
+protected:
+  uint32_t variant_mask;
+};
\ No newline at end of file
@@ -7,10 +7,25 @@ enum GPUFormat {
   GPU_FORMAT_NONE,
   GPU_FORMAT_RG32F,
   GPU_FORMAT_RGB32F,
+  GPU_FORMAT_R32F,
+  GPU_FORMAT_RGBA32F,
   GPU_FORMAT_RGB8,
   GPU_FORMAT_RGBA8,
   GPU_FORMAT_R16G16B16A16F,
   GPU_FORMAT_D24_S8,
   GPU_FORMAT_DEVICE_COLOR_OPTIMAL,
   GPU_FORMAT_DEVICE_DEPTH_OPTIMAL,
+};
+
+enum GPUPresentMode {
+  /* waits for the vertical blank, never tears. Always supported */
+  GPU_PRESENT_MODE_FIFO,
+  /* FIFO, but an image that missed the vertical blank is presented right
+   * away and may tear */
+  GPU_PRESENT_MODE_FIFO_RELAXED,
+  /* waits for the vertical blank, a newer image replaces the queued one
+   * instead of blocking */
+  GPU_PRESENT_MODE_MAILBOX,
+  /* presented right away, tears */
+  GPU_PRESENT_MODE_IMMEDIATE,
 };
\ No newline at end of file
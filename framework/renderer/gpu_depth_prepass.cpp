@@ -0,0 +1,33 @@
+#include "gpu_depth_prepass.h"
+
+GPUShaderConfig
+GPUDepthPrepass::CreatePrepassConfig(GPUShaderConfig *geometry_config,
+                                     const char *vertex_file_path,
+                                     uint32_t vertex_stride, uint32_t subpass) {
+  GPUShaderConfig config = *geometry_config;
+
+  GPUShaderStageConfig vertex_stage_config;
+  vertex_stage_config.type = GPU_SHADER_STAGE_TYPE_VERTEX;
+  vertex_stage_config.file_path = vertex_file_path;
+  config.stage_configs.clear();
+  config.stage_configs.emplace_back(vertex_stage_config);
+  /* the geometry keywords only select the materials */
+  config.keywords.clear();
+
+  config.depth_flags = GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE |
+                       GPU_SHADER_DEPTH_FLAG_DEPTH_WRITE_ENABLE;
+  config.render_state.depth_compare_operation =
+      GPU_SHADER_COMPARE_OPERATION_LESS;
+  /* no color targets are written */
+  config.render_state.blend_states.clear();
+  config.vertex_stride = vertex_stride;
+  config.subpass = subpass;
+
+  return config;
+}
+
+void GPUDepthPrepass::ConfigureGeometryPass(GPUShaderConfig *geometry_config) {
+  geometry_config->depth_flags = GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE;
+  geometry_config->render_state.depth_compare_operation =
+      GPU_SHADER_COMPARE_OPERATION_EQUAL;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "gpu_shader.h"
+
+#include <stdint.h>
+
+/* Depth prepass of a geometry pass. The prepass draws the geometry with a
+ * position only vertex shader and no fragment shader, so the geometry pass
+ * after it runs its fragment shader once per pixel, testing EQUAL against
+ * the prepass depth without writing it. Both vertex shaders have to compute
+ * gl_Position with the same expressions and declare it invariant, otherwise
+ * the depths may differ in the last bits and the EQUAL test drops pixels.
+ * Geometry that discards fragments doesn't belong in the prepass */
+class GPUDepthPrepass {
+public:
+  /* config of the prepass shader, derived from the config of the geometry
+   * shader. vertex_stride is the stride of the geometry vertex buffers, the
+   * prepass vertex shader reads only the position from them */
+  static GPUShaderConfig CreatePrepassConfig(GPUShaderConfig *geometry_config,
+                                             const char *vertex_file_path,
+                                             uint32_t vertex_stride,
+                                             uint32_t subpass);
+  /* makes the geometry shader test against the prepass depth */
+  static void ConfigureGeometryPass(GPUShaderConfig *geometry_config);
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gpu_attachment.h"
+#include "gpu_storage_buffer.h"
 #include "gpu_texture.h"
 #include "gpu_uniform_buffer.h"
 
@@ -8,10 +9,23 @@
 #include <stdio.h>
 #include <vector>
 
+class GPUShader;
+class GPUComputeShader;
+
 enum GPUDescriptorBindingType {
   GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_BUFFER,
   GPU_DESCRIPTOR_BINDING_TYPE_TEXTURE,
   GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT,
+  GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_BUFFER,
+  /* texture created with GPU_TEXTURE_FLAG_STORAGE */
+  GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_TEXTURE,
+  /* storage buffer created with a texel format, "samplerBuffer" in glsl */
+  GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_TEXEL_BUFFER,
+  /* storage buffer created with a texel format, "imageBuffer" in glsl */
+  GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_TEXEL_BUFFER,
+  /* attachment created with GPU_ATTACHMENT_FLAG_INPUT, written by an earlier
+   * subpass of the render pass. "subpassInput" in glsl */
+  GPU_DESCRIPTOR_BINDING_TYPE_INPUT_ATTACHMENT,
 };
 
 struct GPUDescriptorBinding {
@@ -20,6 +34,7 @@ struct GPUDescriptorBinding {
   GPUTexture *texture;
   GPUUniformBuffer *uniform_buffer;
   GPUAttachment *attachment;
+  GPUStorageBuffer *storage_buffer;
 };
 
 /* TODO: remove descriptorset index from gpudescriptorset - we can bind
@@ -27,7 +42,12 @@ struct GPUDescriptorBinding {
 class GPUDescriptorSet {
 public:
   virtual ~GPUDescriptorSet() {}
-  virtual void Create(std::vector<GPUDescriptorBinding> &set_bindings) = 0;
+  /* the set is created with the layout of set_index in the current variant
+   * of the shader, and can be bound to any shader with the same layout */
+  virtual void Create(GPUShader *shader, uint32_t set_index,
+                      std::vector<GPUDescriptorBinding> &set_bindings) = 0;
+  virtual void Create(GPUComputeShader *shader, uint32_t set_index,
+                      std::vector<GPUDescriptorBinding> &set_bindings) = 0;
   virtual void Destroy() = 0;
 
   virtual void SetDebugName(const char *name) = 0;
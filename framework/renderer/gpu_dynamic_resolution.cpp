@@ -0,0 +1,47 @@
+#include "gpu_dynamic_resolution.h"
+
+#include <algorithm>
+#include <math.h>
+
+void GPUDynamicResolution::Create(
+    GPUDynamicResolutionConfig *resolution_config) {
+  config = *resolution_config;
+  scale = config.max_scale;
+  average_frame_time = 0.0f;
+}
+
+void GPUDynamicResolution::Update(float gpu_frame_time) {
+  /* nothing measured yet */
+  if (gpu_frame_time <= 0.0f) {
+    return;
+  }
+
+  if (average_frame_time == 0.0f) {
+    average_frame_time = gpu_frame_time;
+  } else {
+    average_frame_time += (gpu_frame_time - average_frame_time) * 0.1f;
+  }
+
+  float ratio = config.target_frame_time / average_frame_time;
+  if (fabsf(ratio - 1.0f) <= config.tolerance) {
+    return;
+  }
+
+  /* the fragment load goes with the pixel count, which goes with the square
+   * of the scale */
+  float new_scale = scale * sqrtf(ratio);
+  new_scale = std::clamp(new_scale, scale - config.max_step,
+                         scale + config.max_step);
+  scale = std::clamp(new_scale, config.min_scale, config.max_scale);
+}
+
+glm::vec4 GPUDynamicResolution::GetRenderArea(uint32_t width,
+                                              uint32_t height) {
+  return glm::vec4(0.0f, 0.0f, std::max(1u, (uint32_t)(width * scale)),
+                   std::max(1u, (uint32_t)(height * scale)));
+}
+
+glm::vec2 GPUDynamicResolution::GetUVScale(uint32_t width, uint32_t height) {
+  glm::vec4 render_area = GetRenderArea(width, height);
+  return glm::vec2(render_area.z / width, render_area.w / height);
+}
\ No newline at end of file
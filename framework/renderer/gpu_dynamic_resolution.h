@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+struct GPUDynamicResolutionConfig {
+  /* GPU frame time to hold, in milliseconds */
+  float target_frame_time = 16.0f;
+  float min_scale = 0.5f;
+  float max_scale = 1.0f;
+  /* relative distance from the target that is left alone, so that the scale
+   * doesn't oscillate around it */
+  float tolerance = 0.05f;
+  /* largest change of the scale per update */
+  float max_step = 0.05f;
+};
+
+/* Picks the resolution scale of the offscreen passes from the measured GPU
+ * frame time. The attachments stay allocated at the full size, and the passes
+ * only render into the corner given by GetRenderArea, so changing the scale
+ * never reallocates anything. The result is upscaled into the window render
+ * target, sampling with GetUVScale */
+class GPUDynamicResolution {
+public:
+  void Create(GPUDynamicResolutionConfig *resolution_config);
+
+  /* frame time as returned by RendererFrontend::GetGPUFrameTime. It lags
+   * behind by the frames in flight, which the smoothing absorbs */
+  void Update(float gpu_frame_time);
+
+  inline float GetScale() const { return scale; }
+  inline float GetAverageFrameTime() const { return average_frame_time; }
+  /* scaled render area of attachments of the given size */
+  glm::vec4 GetRenderArea(uint32_t width, uint32_t height);
+  /* part of the attachments covered by the render area, in uv */
+  glm::vec2 GetUVScale(uint32_t width, uint32_t height);
+
+private:
+  GPUDynamicResolutionConfig config;
+  float scale;
+  float average_frame_time;
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "gpu_attachment.h"
+#include "gpu_render_pass.h"
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+enum GPUPostProcessEffectFlagBits {
+  /* bright parts of the image bleed into their surroundings */
+  GPU_POST_PROCESS_EFFECT_BLOOM = (1 << 0),
+  /* maps the high dynamic range image into the displayable range */
+  GPU_POST_PROCESS_EFFECT_TONEMAP = (1 << 1),
+  GPU_POST_PROCESS_EFFECT_COLOR_GRADING = (1 << 2),
+  GPU_POST_PROCESS_EFFECT_FXAA = (1 << 3),
+};
+
+/* can be changed every frame */
+struct GPUPostProcessSettings {
+  float exposure = 1.0f;
+  /* brightness the bloom starts at */
+  float bloom_threshold = 1.0f;
+  float bloom_intensity = 0.05f;
+  float contrast = 1.0f;
+  float saturation = 1.0f;
+  glm::vec3 color_filter = glm::vec3(1.0f);
+};
+
+struct GPUPostProcessStackConfig {
+  /* GPUPostProcessEffectFlagBits */
+  uint32_t effects;
+  /* render pass the last pass draws in, usually the window render pass */
+  GPURenderPass *render_pass;
+  /* levels of the bloom chain, the first one is at half resolution */
+  uint32_t bloom_level_count = 5;
+};
+
+/* Chain of fullscreen effects applied to the rendered scene. Every fullscreen
+ * pass reads and writes the whole image, so the effects that only need the
+ * pixel they write (bloom composite, exposure, tonemapping and color grading)
+ * are fused into a single pass, with the shader variant of the enabled
+ * effects. Bloom runs as a chain of downsamples and upsamples at half
+ * resolution and below, and FXAA, which needs the neighbours of the tonemapped
+ * image, is the only other full resolution pass. The intermediate attachments
+ * come from the render target pool */
+class GPUPostProcessStack {
+public:
+  virtual ~GPUPostProcessStack() {}
+
+  virtual bool Create(GPUPostProcessStackConfig *config) = 0;
+  virtual void Destroy() = 0;
+
+  /* records the passes before the last one. The source, which has to be
+   * sampled, is read from its top left corner of the given size, as rendered
+   * with a smaller render area. Recorded outside of the render passes */
+  virtual void Prepare(GPUAttachment *source, uint32_t source_width,
+                       uint32_t source_height) = 0;
+  /* draws the last pass into the current render pass, which has to be the
+   * render pass of the config with its render area at the source size */
+  virtual void Draw() = 0;
+
+  inline GPUPostProcessSettings *GetSettings() { return &settings; }
+
+protected:
+  GPUPostProcessSettings settings;
+};
\ No newline at end of file
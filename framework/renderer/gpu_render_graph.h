@@ -0,0 +1,100 @@
+#pragma once
+
+#include "gpu_attachment.h"
+#include "gpu_core.h"
+#include "gpu_render_pass.h"
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+
+/* attachment owned by the graph. It only lives during the passes that use
+ * it, so its memory can be shared with the attachments used before or after
+ * those */
+struct GPURenderGraphAttachmentConfig {
+  GPUFormat format;
+  GPUAttachmentUsage usage;
+  /* 0 for the size set by Resize, usually the window size */
+  uint32_t width;
+  uint32_t height;
+  /* GPUAttachmentFlagBits. Transient attachments are not aliased and can
+   * only be used by the passes of a single render pass, see
+   * GPURenderGraphPassConfig::subpass */
+  uint32_t flags = 0;
+  /* read outside of the graph after Execute, e.g. by the post processing.
+   * It is left in the sampled layout, its memory is not shared and the
+   * passes that write it are never culled */
+  bool exported = false;
+};
+
+/* records the commands of a pass, between the begin and the end of its
+ * render pass */
+typedef void (*GPURenderGraphExecuteCallback)(void *user_data);
+
+struct GPURenderGraphPassConfig {
+  /* attachments rendered to, at most 1 depth attachment. What the earlier
+   * passes wrote is loaded, unless clear_flags clears it */
+  std::vector<uint32_t> outputs;
+  /* attachments sampled by the shaders of the pass */
+  std::vector<uint32_t> inputs;
+  /* attachments written by the earlier passes of the same render pass and
+   * read at the same pixel with "subpassInput". They have to be created
+   * with GPU_ATTACHMENT_FLAG_INPUT */
+  std::vector<uint32_t> subpass_inputs;
+  /* continues the render pass of the pass right before it in the execution
+   * order as its next subpass, instead of beginning a render pass of its
+   * own. The outputs of both have to be of the same size, and the render
+   * pass is cleared with the clear values of its first pass */
+  bool subpass = false;
+  /* renders into the window render target instead of the outputs. The
+   * passes that the window passes don't depend on are culled */
+  bool window_output = false;
+
+  /* unused by the window passes, they clear as the window render pass does */
+  glm::vec4 clear_color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  float clear_depth = 1.0f;
+  float clear_stencil = 0.0f;
+  uint8_t clear_flags = 0;
+
+  GPURenderGraphExecuteCallback execute = 0;
+  void *user_data = 0;
+};
+
+/* Frame graph. The passes declare the attachments they read and write, and
+ * Compile culls the passes that neither the window passes nor the exported
+ * attachments depend on, orders the rest by their dependencies, merges the
+ * subpasses into the render passes they continue, places the attachments
+ * whose lifetimes don't overlap into the same memory and derives the
+ * barriers between the render passes. Execute then records the passes
+ * every frame, outside of other render passes. Out of the passes that are
+ * ready, the earliest added one runs first, so a subpass is added right
+ * after the pass it continues */
+class GPURenderGraph {
+public:
+  virtual ~GPURenderGraph() {}
+
+  /* both return the index used to reference the result */
+  virtual uint32_t AddAttachment(const char *name,
+                                 GPURenderGraphAttachmentConfig *config) = 0;
+  virtual uint32_t AddPass(const char *name,
+                           GPURenderGraphPassConfig *config) = 0;
+
+  virtual bool Compile() = 0;
+  virtual void Destroy() = 0;
+  /* size of the attachments created with a width and height of 0. After
+   * Compile, the attachments and the framebuffers are created again, but
+   * the render passes are kept, so the shaders of the passes stay valid.
+   * The descriptor sets of the attachments have to be written again */
+  virtual void Resize(uint32_t width, uint32_t height) = 0;
+
+  virtual void Execute() = 0;
+
+  /* valid after Compile, until Destroy */
+  virtual GPUAttachment *GetAttachment(uint32_t attachment) = 0;
+  /* render pass to create the shaders of the pass with. The window render
+   * pass for the window passes */
+  virtual GPURenderPass *GetRenderPass(uint32_t pass) = 0;
+  /* subpass of that render pass, see GPUShaderConfig::subpass */
+  virtual uint32_t GetSubpass(uint32_t pass) = 0;
+  virtual bool IsPassCulled(uint32_t pass) = 0;
+};
\ No newline at end of file
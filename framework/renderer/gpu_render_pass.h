@@ -32,6 +32,18 @@ struct GPURenderPassAttachmentConfig {
   bool present_after;
 };
 
+/* attachments used by a subpass, as indices into the attachments of the
+ * render pass. Attachments written by a subpass can be read by the later
+ * subpasses as input attachments, at the same pixel, without leaving the
+ * tile memory */
+struct GPURenderPassSubpassConfig {
+  std::vector<uint32_t> color_attachments;
+  /* created with GPU_ATTACHMENT_FLAG_INPUT, read with "subpassInput" */
+  std::vector<uint32_t> input_attachments;
+  /* -1 if the subpass has no depth attachment */
+  int32_t depth_attachment = -1;
+};
+
 class GPURenderPass {
 public:
   virtual ~GPURenderPass() {}
@@ -41,9 +53,18 @@ public:
   Create(std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
          glm::vec4 pass_render_area, glm::vec4 pass_clear_color,
          float pass_depth, float pass_stencil, uint8_t pass_clear_flags) = 0;
+  /* render pass with several subpasses. The shaders are created for one of
+   * them, see GPUShaderConfig::subpass */
+  virtual bool
+  Create(std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
+         std::vector<GPURenderPassSubpassConfig> pass_subpasses,
+         glm::vec4 pass_render_area, glm::vec4 pass_clear_color,
+         float pass_depth, float pass_stencil, uint8_t pass_clear_flags) = 0;
   virtual void Destroy() = 0;
 
+  /* the first subpass is started by Begin */
   virtual void Begin(GPURenderTarget *target) = 0;
+  virtual void NextSubpass() = 0;
   virtual void End() = 0;
 
   virtual void SetDebugName(const char *name) = 0;
@@ -59,8 +80,11 @@ public:
     clear_color = new_clear_color;
   }
 
+  inline uint32_t GetSubpassCount() const { return subpasses.size(); }
+
 protected:
   std::vector<GPURenderPassAttachmentConfig> attachments;
+  std::vector<GPURenderPassSubpassConfig> subpasses;
   glm::vec4 render_area;
   glm::vec4 clear_color;
   uint8_t clear_flags;
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "gpu_attachment.h"
+#include "gpu_core.h"
+#include "gpu_render_pass.h"
+#include "gpu_render_target.h"
+
+#include <stdint.h>
+#include <vector>
+
+/* attachments matching the same config are interchangeable */
+struct GPURenderTargetPoolAttachmentConfig {
+  GPUFormat format;
+  GPUAttachmentUsage usage;
+  uint32_t width;
+  uint32_t height;
+  /* pooled attachments are single sampled, more samples are rejected */
+  uint32_t samples = 1;
+  /* GPUAttachmentFlagBits */
+  uint32_t flags = 0;
+};
+
+/* Recycles the attachments and the render targets of the offscreen passes,
+ * so that short lived attachments don't allocate memory every frame.
+ * Everything handed out stays owned by the pool, and is destroyed once it
+ * hasn't been used for a few frames. Attachments of a different size are
+ * different attachments, so after a resize only the attachments that are
+ * acquired at the new size are created */
+class GPURenderTargetPool {
+public:
+  virtual ~GPURenderTargetPool() {}
+
+  /* the attachment is not handed out again until it is released. Its
+   * content is undefined when acquired */
+  virtual GPUAttachment *
+  AcquireAttachment(GPURenderTargetPoolAttachmentConfig *config) = 0;
+  /* the attachment can be handed out again, even to the later passes of the
+   * current frame, which may overwrite it */
+  virtual void ReleaseAttachment(GPUAttachment *attachment) = 0;
+  /* render target of the attachments, pooled or not, sized to the smallest
+   * one. The same render target is returned for the same render pass and
+   * attachments until one of them is destroyed */
+  virtual GPURenderTarget *
+  AcquireRenderTarget(GPURenderPass *render_pass,
+                      std::vector<GPUAttachment *> &attachments) = 0;
+
+  /* frames the unused attachments and render targets are kept for */
+  inline uint32_t GetUnusedFrameCount() const { return unused_frame_count; }
+  inline void SetUnusedFrameCount(uint32_t new_unused_frame_count) {
+    unused_frame_count = new_unused_frame_count;
+  }
+
+protected:
+  uint32_t unused_frame_count;
+};
\ No newline at end of file
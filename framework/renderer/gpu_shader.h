@@ -16,6 +16,8 @@ enum GPUShaderStageType {
   GPU_SHADER_STAGE_TYPE_GEOMETRY,
   GPU_SHADER_STAGE_TYPE_TESSELLATION_CONTROL,
   GPU_SHADER_STAGE_TYPE_TESSELLATION_EVALUATION,
+  /* used by GPUComputeShader only */
+  GPU_SHADER_STAGE_TYPE_COMPUTE,
 };
 
 enum GPUShaderTopologyType {
@@ -34,6 +36,113 @@ enum GPUShaderStencilFlag {
   GPU_SHADER_STENCIL_FLAG_STENCIL_TEST_ENABLE = (1 << 0),
 };
 
+enum GPUShaderCullMode {
+  GPU_SHADER_CULL_MODE_NONE,
+  GPU_SHADER_CULL_MODE_FRONT,
+  GPU_SHADER_CULL_MODE_BACK,
+  GPU_SHADER_CULL_MODE_FRONT_AND_BACK,
+};
+
+enum GPUShaderFrontFace {
+  GPU_SHADER_FRONT_FACE_COUNTER_CLOCKWISE,
+  GPU_SHADER_FRONT_FACE_CLOCKWISE,
+};
+
+enum GPUShaderCompareOperation {
+  GPU_SHADER_COMPARE_OPERATION_NEVER,
+  GPU_SHADER_COMPARE_OPERATION_LESS,
+  GPU_SHADER_COMPARE_OPERATION_EQUAL,
+  GPU_SHADER_COMPARE_OPERATION_LESS_OR_EQUAL,
+  GPU_SHADER_COMPARE_OPERATION_GREATER,
+  GPU_SHADER_COMPARE_OPERATION_NOT_EQUAL,
+  GPU_SHADER_COMPARE_OPERATION_GREATER_OR_EQUAL,
+  GPU_SHADER_COMPARE_OPERATION_ALWAYS,
+};
+
+enum GPUShaderStencilOperation {
+  GPU_SHADER_STENCIL_OPERATION_KEEP,
+  GPU_SHADER_STENCIL_OPERATION_ZERO,
+  GPU_SHADER_STENCIL_OPERATION_REPLACE,
+  GPU_SHADER_STENCIL_OPERATION_INCREMENT_AND_CLAMP,
+  GPU_SHADER_STENCIL_OPERATION_DECREMENT_AND_CLAMP,
+  GPU_SHADER_STENCIL_OPERATION_INVERT,
+  GPU_SHADER_STENCIL_OPERATION_INCREMENT_AND_WRAP,
+  GPU_SHADER_STENCIL_OPERATION_DECREMENT_AND_WRAP,
+};
+
+enum GPUShaderBlendFactor {
+  GPU_SHADER_BLEND_FACTOR_ZERO,
+  GPU_SHADER_BLEND_FACTOR_ONE,
+  GPU_SHADER_BLEND_FACTOR_SRC_COLOR,
+  GPU_SHADER_BLEND_FACTOR_ONE_MINUS_SRC_COLOR,
+  GPU_SHADER_BLEND_FACTOR_DST_COLOR,
+  GPU_SHADER_BLEND_FACTOR_ONE_MINUS_DST_COLOR,
+  GPU_SHADER_BLEND_FACTOR_SRC_ALPHA,
+  GPU_SHADER_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+  GPU_SHADER_BLEND_FACTOR_DST_ALPHA,
+  GPU_SHADER_BLEND_FACTOR_ONE_MINUS_DST_ALPHA,
+};
+
+enum GPUShaderBlendOperation {
+  GPU_SHADER_BLEND_OPERATION_ADD,
+  GPU_SHADER_BLEND_OPERATION_SUBTRACT,
+  GPU_SHADER_BLEND_OPERATION_REVERSE_SUBTRACT,
+  GPU_SHADER_BLEND_OPERATION_MIN,
+  GPU_SHADER_BLEND_OPERATION_MAX,
+};
+
+enum GPUShaderColorComponentFlag {
+  GPU_SHADER_COLOR_COMPONENT_FLAG_R = (1 << 0),
+  GPU_SHADER_COLOR_COMPONENT_FLAG_G = (1 << 1),
+  GPU_SHADER_COLOR_COMPONENT_FLAG_B = (1 << 2),
+  GPU_SHADER_COLOR_COMPONENT_FLAG_A = (1 << 3),
+  GPU_SHADER_COLOR_COMPONENT_FLAG_ALL = 0xF,
+};
+
+struct GPUShaderStencilState {
+  GPUShaderStencilOperation fail_operation = GPU_SHADER_STENCIL_OPERATION_KEEP;
+  GPUShaderStencilOperation pass_operation = GPU_SHADER_STENCIL_OPERATION_KEEP;
+  GPUShaderStencilOperation depth_fail_operation =
+      GPU_SHADER_STENCIL_OPERATION_KEEP;
+  GPUShaderCompareOperation compare_operation =
+      GPU_SHADER_COMPARE_OPERATION_ALWAYS;
+  uint32_t compare_mask = 0xFF;
+  uint32_t write_mask = 0xFF;
+  uint32_t reference = 0;
+};
+
+struct GPUShaderBlendState {
+  bool blend_enable = true;
+  GPUShaderBlendFactor src_color_factor = GPU_SHADER_BLEND_FACTOR_SRC_ALPHA;
+  GPUShaderBlendFactor dst_color_factor =
+      GPU_SHADER_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  GPUShaderBlendOperation color_operation = GPU_SHADER_BLEND_OPERATION_ADD;
+  GPUShaderBlendFactor src_alpha_factor = GPU_SHADER_BLEND_FACTOR_SRC_ALPHA;
+  GPUShaderBlendFactor dst_alpha_factor =
+      GPU_SHADER_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  GPUShaderBlendOperation alpha_operation = GPU_SHADER_BLEND_OPERATION_ADD;
+  uint8_t color_write_mask = GPU_SHADER_COLOR_COMPONENT_FLAG_ALL;
+};
+
+/* fixed function state of a shader pipeline. Defaults match the state
+ * pipelines were always created with */
+struct GPUShaderRenderState {
+  GPUShaderCullMode cull_mode = GPU_SHADER_CULL_MODE_NONE;
+  GPUShaderFrontFace front_face = GPU_SHADER_FRONT_FACE_COUNTER_CLOCKWISE;
+  GPUShaderCompareOperation depth_compare_operation =
+      GPU_SHADER_COMPARE_OPERATION_LESS;
+  bool depth_bias_enable = false;
+  float depth_bias_constant_factor = 0.0f;
+  float depth_bias_clamp = 0.0f;
+  float depth_bias_slope_factor = 0.0f;
+  /* used if stencil_flags has GPU_SHADER_STENCIL_FLAG_STENCIL_TEST_ENABLE */
+  GPUShaderStencilState stencil_front;
+  GPUShaderStencilState stencil_back;
+  /* blend state per color target. Targets past the end of the vector use the
+   * last entry, or the default blend state if the vector is empty */
+  std::vector<GPUShaderBlendState> blend_states;
+};
+
 struct GPUShaderStageConfig {
   GPUShaderStageType type;
   const char *file_path;
@@ -41,12 +150,25 @@ struct GPUShaderStageConfig {
 
 struct GPUShaderConfig {
   std::vector<GPUShaderStageConfig> stage_configs;
+  /* keywords of the shader permutations. Keyword i is selected by bit i of the
+   * variant mask passed to SetVariant. Stage files are compiled per keyword
+   * combination by the shaders build target */
+  std::vector<const char *> keywords;
   GPUShaderTopologyType topology_type; 
   uint8_t depth_flags;
   uint8_t stencil_flags;
+  GPUShaderRenderState render_state;
   GPURenderPass *render_pass; 
+  /* subpass of render_pass the shader draws in */
+  uint32_t subpass = 0;
   float viewport_width;
   float viewport_height;
+  /* bit i marks set i as written per draw with PushDescriptorSet */
+  uint32_t push_descriptor_set_mask = 0;
+  /* stride of the bound vertex buffers, 0 for the size of the vertex
+   * attributes. Lets a shader that reads only the leading attributes draw
+   * the vertex buffers of another shader */
+  uint32_t vertex_stride = 0;
 };
 
 class GPUShader {
@@ -56,15 +178,31 @@ public:
   virtual bool Create(GPUShaderConfig * config) = 0;
   virtual void Destroy() = 0;
 
+  /* selects the permutation used by the next Bind. Pipelines of a variant
+   * are created on its first use */
+  virtual void SetVariant(uint32_t variant_mask) = 0;
+  /* replaces the render state used by the next Bind. Pipelines are cached by
+   * variant and render state */
+  virtual void SetRenderState(GPUShaderRenderState *render_state) = 0;
+
   virtual void Bind() = 0;
   virtual void BindUniformBuffer(GPUDescriptorSet *set, uint32_t offset,
                                  int32_t set_index) = 0;
   virtual void BindSampler(GPUDescriptorSet *set, int32_t set_index) = 0;
-  virtual void PushConstant(void *value, uint64_t size, uint32_t offset,
-                            uint8_t stage_flags) = 0;
+  /* writes the set straight into the command buffer, for sets that change
+   * every draw. The set has to be marked in push_descriptor_set_mask.
+   * Uniform buffers are bound at uniform_buffer_offset */
+  virtual void PushDescriptorSet(int32_t set_index,
+                                 std::vector<GPUDescriptorBinding> &bindings,
+                                 uint32_t uniform_buffer_offset) = 0;
+  /* stages are taken from the reflected push constant ranges */
+  virtual void PushConstant(void *value, uint64_t size, uint32_t offset) = 0;
 
   virtual void SetDebugName(const char *name) = 0;
   virtual void SetDebugTag(const void *tag, size_t tag_size) = 0;
 
+  inline uint32_t GetVariant() { return variant_mask; }
+
 protected:
+  uint32_t variant_mask;
 };
\ No newline at end of file
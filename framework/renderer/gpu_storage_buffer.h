@@ -0,0 +1,33 @@
+#pragma once
+
+#include "gpu_core.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* buffer that shaders can read and write, without the size limit of the
+ * uniform buffers. With a texel format, it can also be bound as a texel
+ * buffer */
+class GPUStorageBuffer {
+public:
+  virtual ~GPUStorageBuffer(){};
+
+  virtual bool Create(uint64_t buffer_size,
+                      GPUFormat texel_format = GPU_FORMAT_NONE) = 0;
+  virtual void Destroy() = 0;
+
+  virtual void *Lock(uint64_t offset, uint64_t size) = 0;
+  virtual void Unlock() = 0;
+
+  virtual bool LoadData(uint64_t offset, uint64_t size, void *data) = 0;
+
+  virtual uint64_t GetSize() const = 0;
+
+  virtual void SetDebugName(const char *name) = 0;
+  virtual void SetDebugTag(const void *tag, size_t tag_size) = 0;
+
+  inline GPUFormat GetTexelFormat() const { return texel_format; }
+
+protected:
+  GPUFormat texel_format;
+};
\ No newline at end of file
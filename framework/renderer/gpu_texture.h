@@ -5,18 +5,28 @@
 #include <stdint.h>
 #include <stdio.h>
 
+/* index of a texture that is not in the bindless table */
+#define GPU_BINDLESS_INDEX_NONE UINT32_MAX
+
 enum GPUTextureType {
   GPU_TEXTURE_TYPE_NONE,
   GPU_TEXTURE_TYPE_2D,
   GPU_TEXTURE_TYPE_CUBEMAP,
 };
 
+enum GPUTextureFlagBits {
+  /* the texture can be written by the shaders. It has a single mip level and
+   * needs a storage capable format, like GPU_FORMAT_RGBA32F */
+  GPU_TEXTURE_FLAG_STORAGE = (1 << 0),
+};
+
 class GPUTexture {
 public:
   virtual ~GPUTexture() {}
 
   virtual bool Create(GPUFormat texture_format, GPUTextureType texture_type,
-                      uint32_t texture_width, uint32_t texture_height) = 0;
+                      uint32_t texture_width, uint32_t texture_height,
+                      uint32_t texture_flags = 0) = 0;
   virtual void Destroy() = 0;
 
   virtual void WriteData(void *pixels, uint32_t offset) = 0;
@@ -28,10 +38,17 @@ public:
   inline GPUTextureType GetType() const { return type; }
   inline uint32_t GetWidth() const { return width; }
   inline uint32_t GetHeight() const { return height; }
+  inline uint32_t GetFlags() const { return flags; }
+  /* stable index of the texture in the bindless table, passed to the
+   * shaders through push constants or instance data.
+   * GPU_BINDLESS_INDEX_NONE if bindless textures are not supported */
+  inline uint32_t GetBindlessIndex() const { return bindless_index; }
 
 protected:
   GPUFormat format;
   GPUTextureType type;
   uint32_t width;
   uint32_t height;
+  uint32_t flags;
+  uint32_t bindless_index;
 };
\ No newline at end of file
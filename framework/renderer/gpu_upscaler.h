@@ -0,0 +1,45 @@
+#pragma once
+
+#include "gpu_attachment.h"
+#include "gpu_render_pass.h"
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+struct GPUUpscalerConfig {
+  /* render pass the sharpening pass draws in, usually the window render
+   * pass */
+  GPURenderPass *render_pass;
+  /* in stops, 0 is the sharpest and every stop halves the sharpening */
+  float sharpness = 0.2f;
+};
+
+/* Spatial upscaler for the passes rendered below the output resolution, in
+ * the style of FSR1. The upscaling pass (EASU) reconstructs the edges with a
+ * 12 tap directional kernel, and the sharpening pass (RCAS) restores the
+ * contrast lost in the upscale without ringing. Expects the source in
+ * perceptual space, so it runs after the tonemapping. At 67% of the output
+ * resolution the source has about half of the pixels */
+class GPUUpscaler {
+public:
+  virtual ~GPUUpscaler() {}
+
+  virtual bool Create(GPUUpscalerConfig *config) = 0;
+  virtual void Destroy() = 0;
+
+  /* upscales the render area of the source, which has to be sampled, into
+   * an attachment of the output size. Recorded outside of the render
+   * passes */
+  virtual void Upscale(GPUAttachment *source, glm::vec4 source_area,
+                       uint32_t output_width, uint32_t output_height) = 0;
+  /* sharpens the result of the last Upscale into the current render pass,
+   * which has to be the render pass of the config with its render area at
+   * the output size */
+  virtual void Sharpen() = 0;
+
+  inline float GetSharpness() const { return sharpness; }
+  inline void SetSharpness(float new_sharpness) { sharpness = new_sharpness; }
+
+protected:
+  float sharpness;
+};
\ No newline at end of file
@@ -12,6 +12,12 @@ int GPUUtils::GetGPUFormatSize(GPUFormat format) {
   case GPU_FORMAT_RGB32F: {
     return sizeof(float);
   } break;
+  case GPU_FORMAT_R32F: {
+    return sizeof(float);
+  } break;
+  case GPU_FORMAT_RGBA32F: {
+    return sizeof(float);
+  } break;
   case GPU_FORMAT_RGB8: {
     return sizeof(uint8_t);
   } break;
@@ -38,6 +44,12 @@ int GPUUtils::GetGPUFormatCount(GPUFormat format) {
   case GPU_FORMAT_RGB32F: {
     return 3;
   } break;
+  case GPU_FORMAT_R32F: {
+    return 1;
+  } break;
+  case GPU_FORMAT_RGBA32F: {
+    return 4;
+  } break;
   case GPU_FORMAT_RGB8: {
     return 3;
   } break;
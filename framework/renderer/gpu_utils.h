@@ -2,9 +2,25 @@
 
 #include "gpu_core.h"
 
+#include <stdint.h>
+
 class GPUUtils {
 public:
   static int GetGPUFormatSize(GPUFormat format);
   static int GetGPUFormatCount(GPUFormat format);
   static bool IsDepthFormat(GPUFormat format);
+
+  /* splitmix64 finalizer, so that every input bit affects every output bit */
+  static inline uint64_t HashMix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+  }
+  /* order dependent, so permutations of the same values don't collide */
+  static inline void HashCombine(uint64_t &seed, uint64_t value) {
+    seed = HashMix(seed + 0x9e3779b97f4a7c15ull + HashMix(value));
+  }
 };
\ No newline at end of file
@@ -1,11 +1,17 @@
 #pragma once
 
+#include "gpu_compute_shader.h"
 #include "gpu_descriptor_set.h"
 #include "gpu_index_buffer.h"
+#include "gpu_post_process_stack.h"
+#include "gpu_render_graph.h"
 #include "gpu_render_pass.h"
 #include "gpu_render_target.h"
+#include "gpu_render_target_pool.h"
 #include "gpu_shader.h"
+#include "gpu_storage_buffer.h"
 #include "gpu_uniform_buffer.h"
+#include "gpu_upscaler.h"
 #include "gpu_vertex_buffer.h"
 
 #include <stdint.h>
@@ -19,16 +25,44 @@ public:
   virtual void Shutdown() = 0;
 
   virtual void Resize(uint32_t width, uint32_t height) = 0;
+  virtual void SetPresentMode(GPUPresentMode present_mode) = 0;
+  virtual GPUPresentMode GetPresentMode() = 0;
+  virtual void SetSwapchainImageCount(uint32_t image_count) = 0;
+  virtual uint32_t GetSwapchainImageCount() = 0;
+  virtual void SetMaxFramesInFlight(uint32_t max_frames_in_flight) = 0;
+  virtual void SetFrameRateLimit(uint32_t frames_per_second) = 0;
 
   virtual bool BeginFrame() = 0;
   virtual bool EndFrame() = 0;
   virtual bool Draw(uint32_t element_count) = 0;
   virtual bool DrawIndexed(uint32_t element_count) = 0;
+  virtual bool Dispatch(uint32_t group_count_x, uint32_t group_count_y,
+                        uint32_t group_count_z) = 0;
+  virtual bool DispatchIndirect(GPUStorageBuffer *buffer, uint64_t offset) = 0;
+  virtual void PipelineBarrier(GPUBarrierType type) = 0;
+  virtual bool
+  BeginAsyncCompute(std::vector<GPUAttachment *> &attachments) = 0;
+  virtual bool EndAsyncCompute() = 0;
 
   virtual GPURenderPass *GetWindowRenderPass() = 0;
   virtual GPURenderTarget *GetCurrentWindowRenderTarget() = 0;
+  virtual GPURenderTargetPool *GetRenderTargetPool() = 0;
   virtual uint32_t GetCurrentFrameIndex() = 0;
   virtual uint32_t GetMaxFramesInFlight() = 0;
+  virtual float GetGPUFrameTime() = 0;
+  virtual bool IsBindlessSupported() = 0;
+  virtual bool IsAsyncComputeSupported() = 0;
+
+  virtual void SetCullMode(GPUShaderCullMode cull_mode) = 0;
+  virtual void SetFrontFace(GPUShaderFrontFace front_face) = 0;
+  virtual void SetPrimitiveTopology(GPUShaderTopologyType topology_type) = 0;
+  virtual void SetDepthTestEnable(bool enable) = 0;
+  virtual void SetDepthWriteEnable(bool enable) = 0;
+  virtual void
+  SetDepthCompareOperation(GPUShaderCompareOperation compare_operation) = 0;
+  virtual void SetStencilTestEnable(bool enable) = 0;
+  virtual void SetStencilState(GPUShaderStencilState *front,
+                               GPUShaderStencilState *back) = 0;
 
   virtual void BeginDebugRegion(const char *name, glm::vec4 color) = 0;
   virtual void InsertDebugMarker(const char *name, glm::vec4 color) = 0;
@@ -37,10 +71,15 @@ public:
   virtual GPUVertexBuffer *VertexBufferAllocate() = 0;
   virtual GPUIndexBuffer *IndexBufferAllocate() = 0;
   virtual GPUUniformBuffer *UniformBufferAllocate() = 0;
+  virtual GPUStorageBuffer *StorageBufferAllocate() = 0;
   virtual GPURenderPass *RenderPassAllocate() = 0;
   virtual GPURenderTarget *RenderTargetAllocate() = 0;
   virtual GPUShader *ShaderAllocate() = 0;
+  virtual GPUComputeShader *ComputeShaderAllocate() = 0;
   virtual GPUTexture *TextureAllocate() = 0;
   virtual GPUAttachment *AttachmentAllocate() = 0;
   virtual GPUDescriptorSet *DescriptorSetAllocate() = 0;
+  virtual GPURenderGraph *RenderGraphAllocate() = 0;
+  virtual GPUUpscaler *UpscalerAllocate() = 0;
+  virtual GPUPostProcessStack *PostProcessStackAllocate() = 0;
 };
\ No newline at end of file
@@ -31,6 +31,30 @@ void RendererFrontend::Resize(uint32_t width, uint32_t height) {
   backend->Resize(width, height);
 }
 
+void RendererFrontend::SetPresentMode(GPUPresentMode present_mode) {
+  backend->SetPresentMode(present_mode);
+}
+
+GPUPresentMode RendererFrontend::GetPresentMode() {
+  return backend->GetPresentMode();
+}
+
+void RendererFrontend::SetSwapchainImageCount(uint32_t image_count) {
+  backend->SetSwapchainImageCount(image_count);
+}
+
+uint32_t RendererFrontend::GetSwapchainImageCount() {
+  return backend->GetSwapchainImageCount();
+}
+
+void RendererFrontend::SetMaxFramesInFlight(uint32_t max_frames_in_flight) {
+  backend->SetMaxFramesInFlight(max_frames_in_flight);
+}
+
+void RendererFrontend::SetFrameRateLimit(uint32_t frames_per_second) {
+  backend->SetFrameRateLimit(frames_per_second);
+}
+
 bool RendererFrontend::BeginFrame() { return backend->BeginFrame(); }
 
 bool RendererFrontend::EndFrame() { return backend->EndFrame(); }
@@ -43,6 +67,32 @@ bool RendererFrontend::DrawIndexed(uint32_t element_count) {
   return backend->DrawIndexed(element_count);
 }
 
+bool RendererFrontend::Dispatch(uint32_t group_count_x, uint32_t group_count_y,
+                                uint32_t group_count_z) {
+  return backend->Dispatch(group_count_x, group_count_y, group_count_z);
+}
+
+bool RendererFrontend::DispatchIndirect(GPUStorageBuffer *buffer,
+                                        uint64_t offset) {
+  return backend->DispatchIndirect(buffer, offset);
+}
+
+void RendererFrontend::PipelineBarrier(GPUBarrierType type) {
+  backend->PipelineBarrier(type);
+}
+
+bool RendererFrontend::BeginAsyncCompute() {
+  std::vector<GPUAttachment *> attachments;
+  return backend->BeginAsyncCompute(attachments);
+}
+
+bool RendererFrontend::BeginAsyncCompute(
+    std::vector<GPUAttachment *> &attachments) {
+  return backend->BeginAsyncCompute(attachments);
+}
+
+bool RendererFrontend::EndAsyncCompute() { return backend->EndAsyncCompute(); }
+
 GPURenderPass *RendererFrontend::GetWindowRenderPass() {
   return backend->GetWindowRenderPass();
 }
@@ -51,6 +101,10 @@ GPURenderTarget *RendererFrontend::GetCurrentWindowRenderTarget() {
   return backend->GetCurrentWindowRenderTarget();
 }
 
+GPURenderTargetPool *RendererFrontend::GetRenderTargetPool() {
+  return backend->GetRenderTargetPool();
+}
+
 uint32_t RendererFrontend::GetCurrentFrameIndex() {
   return backend->GetCurrentFrameIndex();
 }
@@ -59,6 +113,53 @@ uint32_t RendererFrontend::GetMaxFramesInFlight() {
   return backend->GetMaxFramesInFlight();
 }
 
+float RendererFrontend::GetGPUFrameTime() {
+  return backend->GetGPUFrameTime();
+}
+
+bool RendererFrontend::IsBindlessSupported() {
+  return backend->IsBindlessSupported();
+}
+
+bool RendererFrontend::IsAsyncComputeSupported() {
+  return backend->IsAsyncComputeSupported();
+}
+
+void RendererFrontend::SetCullMode(GPUShaderCullMode cull_mode) {
+  backend->SetCullMode(cull_mode);
+}
+
+void RendererFrontend::SetFrontFace(GPUShaderFrontFace front_face) {
+  backend->SetFrontFace(front_face);
+}
+
+void RendererFrontend::SetPrimitiveTopology(
+    GPUShaderTopologyType topology_type) {
+  backend->SetPrimitiveTopology(topology_type);
+}
+
+void RendererFrontend::SetDepthTestEnable(bool enable) {
+  backend->SetDepthTestEnable(enable);
+}
+
+void RendererFrontend::SetDepthWriteEnable(bool enable) {
+  backend->SetDepthWriteEnable(enable);
+}
+
+void RendererFrontend::SetDepthCompareOperation(
+    GPUShaderCompareOperation compare_operation) {
+  backend->SetDepthCompareOperation(compare_operation);
+}
+
+void RendererFrontend::SetStencilTestEnable(bool enable) {
+  backend->SetStencilTestEnable(enable);
+}
+
+void RendererFrontend::SetStencilState(GPUShaderStencilState *front,
+                                       GPUShaderStencilState *back) {
+  backend->SetStencilState(front, back);
+}
+
 void RendererFrontend::BeginDebugRegion(const char *name, glm::vec4 color) {
   backend->BeginDebugRegion(name, color);
 }
@@ -81,6 +182,10 @@ GPUUniformBuffer *RendererFrontend::UniformBufferAllocate() {
   return backend->UniformBufferAllocate();
 }
 
+GPUStorageBuffer *RendererFrontend::StorageBufferAllocate() {
+  return backend->StorageBufferAllocate();
+}
+
 GPURenderPass *RendererFrontend::RenderPassAllocate() {
   return backend->RenderPassAllocate();
 }
@@ -93,6 +198,10 @@ GPUShader *RendererFrontend::ShaderAllocate() {
   return backend->ShaderAllocate();
 }
 
+GPUComputeShader *RendererFrontend::ComputeShaderAllocate() {
+  return backend->ComputeShaderAllocate();
+}
+
 GPUTexture *RendererFrontend::TextureAllocate() {
   return backend->TextureAllocate();
 }
@@ -103,4 +212,16 @@ GPUAttachment *RendererFrontend::AttachmentAllocate() {
 
 GPUDescriptorSet *RendererFrontend::DescriptorSetAllocate() {
   return backend->DescriptorSetAllocate();
+}
+
+GPURenderGraph *RendererFrontend::RenderGraphAllocate() {
+  return backend->RenderGraphAllocate();
+}
+
+GPUUpscaler *RendererFrontend::UpscalerAllocate() {
+  return backend->UpscalerAllocate();
+}
+
+GPUPostProcessStack *RendererFrontend::PostProcessStackAllocate() {
+  return backend->PostProcessStackAllocate();
 }
\ No newline at end of file
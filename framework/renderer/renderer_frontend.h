@@ -18,18 +18,87 @@ public:
   void Shutdown();
 
   void Resize(uint32_t width, uint32_t height);
+  /* Latency against throughput. Those are set between the frames. The
+   * present mode and the image count recreate the window swapchain without
+   * waiting for the device. An unsupported present mode falls back to FIFO,
+   * GetPresentMode returns the one in use */
+  void SetPresentMode(GPUPresentMode present_mode);
+  GPUPresentMode GetPresentMode();
+  /* 0 for one more than the minimum of the surface */
+  void SetSwapchainImageCount(uint32_t image_count);
+  uint32_t GetSwapchainImageCount();
+  /* frames recorded while the earlier ones are still rendered. Waits for the
+   * device. It has no effect yet: the uniform buffers are written in place,
+   * so BeginFrame waits for the device to go idle and a frame is never
+   * recorded while an earlier one renders. For the same reason the image
+   * count only sets how many rendered images may wait to be presented */
+  void SetMaxFramesInFlight(uint32_t max_frames_in_flight);
+  /* BeginFrame waits until the next frame is due, 0 for no limit. If the
+   * device can wait for presents, it also waits for the previous frame to be
+   * displayed */
+  void SetFrameRateLimit(uint32_t frames_per_second);
 
   bool BeginFrame();
   bool EndFrame();
   bool Draw(uint32_t element_count);
   bool DrawIndexed(uint32_t element_count);
+  /* dispatches the bound compute shader. Has to be recorded outside of the
+   * render passes */
+  bool Dispatch(uint32_t group_count_x, uint32_t group_count_y,
+                uint32_t group_count_z);
+  /* group counts are read from the buffer at offset, as written by an
+   * earlier dispatch */
+  bool DispatchIndirect(GPUStorageBuffer *buffer, uint64_t offset);
+  /* makes the writes of the earlier work visible to the later work. Has to
+   * be recorded outside of the render passes */
+  void PipelineBarrier(GPUBarrierType type);
+  /* compute shaders bound and dispatched between those two run on the async
+   * compute queue, overlapped with the graphics work recorded after End. The
+   * work recorded before Begin is submitted by it and finishes before the
+   * compute work starts, so it can't render to the window or leave a render
+   * pass or a debug region open. The draws after End wait for the compute
+   * work before reading the results. Once per frame, without graphics
+   * barriers. Falls back to the graphics queue.
+   * attachments are rendered before Begin and sampled by the compute work,
+   * they are handed over to the compute queue until End */
+  bool BeginAsyncCompute();
+  bool BeginAsyncCompute(std::vector<GPUAttachment *> &attachments);
+  bool EndAsyncCompute();
 
   GPURenderPass *GetWindowRenderPass();
   GPURenderTarget *GetCurrentWindowRenderTarget();
+  /* attachments and render targets of the offscreen passes, recycled
+   * across frames */
+  GPURenderTargetPool *GetRenderTargetPool();
   /* TODO: those 2 are unused right now, but if we want a more smooth rendering,
    * all of the writable resources should be arrays and use those 2 methodss */
   uint32_t GetCurrentFrameIndex();
   uint32_t GetMaxFramesInFlight();
+  /* GPU time of the graphics work of a frame, in milliseconds. It lags
+   * behind by the frames in flight, and is 0 until the first frame is
+   * measured or if the device has no timestamps. The wait for the swapchain
+   * image is not included, so that the vsync wait doesn't count as GPU
+   * work, but the vertex work that runs before the image is acquired may
+   * not be included either */
+  float GetGPUFrameTime();
+  /* whether shaders can index every texture through a runtime sized
+   * "sampler2D textures[]" array, see GPUTexture::GetBindlessIndex */
+  bool IsBindlessSupported();
+  /* whether BeginAsyncCompute work runs on a queue of its own */
+  bool IsAsyncComputeSupported();
+
+  /* per draw state of the currently bound shader, until it is bound again.
+   * Uses dynamic state when the device supports it, and switches to a
+   * matching pipeline otherwise */
+  void SetCullMode(GPUShaderCullMode cull_mode);
+  void SetFrontFace(GPUShaderFrontFace front_face);
+  void SetPrimitiveTopology(GPUShaderTopologyType topology_type);
+  void SetDepthTestEnable(bool enable);
+  void SetDepthWriteEnable(bool enable);
+  void SetDepthCompareOperation(GPUShaderCompareOperation compare_operation);
+  void SetStencilTestEnable(bool enable);
+  void SetStencilState(GPUShaderStencilState *front,
+                       GPUShaderStencilState *back);
 
   void BeginDebugRegion(const char *name, glm::vec4 color);
   void InsertDebugMarker(const char *name, glm::vec4 color);
@@ -38,12 +107,17 @@ public:
   GPUVertexBuffer *VertexBufferAllocate();
   GPUIndexBuffer *IndexBufferAllocate();
   GPUUniformBuffer *UniformBufferAllocate();
+  GPUStorageBuffer *StorageBufferAllocate();
   GPURenderPass *RenderPassAllocate();
   GPURenderTarget *RenderTargetAllocate();
   GPUShader *ShaderAllocate();
+  GPUComputeShader *ComputeShaderAllocate();
   GPUTexture *TextureAllocate();
   GPUAttachment *AttachmentAllocate();
   GPUDescriptorSet *DescriptorSetAllocate();
+  GPURenderGraph *RenderGraphAllocate();
+  GPUUpscaler *UpscalerAllocate();
+  GPUPostProcessStack *PostProcessStackAllocate();
 
 private:
   RendererBackend *backend;
@@ -0,0 +1,463 @@
+#include "vulkan_async_compute.h"
+
+#include "../../logger.h"
+#include "../gpu_utils.h"
+#include "vulkan_attachment.h"
+#include "vulkan_backend.h"
+#include "vulkan_utils.h"
+
+/* stages of the graphics work that wait for the async compute work of the
+ * frame, the first ones that can read its results. The earlier work is not
+ * held back */
+static const VkPipelineStageFlags graphics_wait_stage_mask =
+    VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+void VulkanAsyncCompute::Initialize() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  active = context->device->HasAsyncCompute();
+  timeline = context->device->GetOptionalFeatures().timeline_semaphore;
+  recording = false;
+  submitted = false;
+  timeline_semaphore = 0;
+  timeline_value = 0;
+  frame_semaphores.clear();
+  graphics_timeline_semaphore = 0;
+  graphics_timeline_value = 0;
+  graphics_frame_semaphores.clear();
+  graphics_command_buffers.clear();
+  attachments.clear();
+
+  if (!active) {
+    DEBUG("Async compute: 0");
+    return;
+  }
+
+  VkSemaphoreTypeCreateInfo semaphore_type_create_info = {};
+  semaphore_type_create_info.sType =
+      VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  semaphore_type_create_info.pNext = 0;
+  semaphore_type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  semaphore_type_create_info.initialValue = 0;
+
+  VkSemaphoreCreateInfo semaphore_create_info = {};
+  semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphore_create_info.pNext = 0;
+  semaphore_create_info.flags = 0;
+
+  if (timeline) {
+    semaphore_create_info.pNext = &semaphore_type_create_info;
+    VK_CHECK(vkCreateSemaphore(context->device->GetLogicalDevice(),
+                               &semaphore_create_info, context->allocator,
+                               &timeline_semaphore));
+    VK_CHECK(vkCreateSemaphore(context->device->GetLogicalDevice(),
+                               &semaphore_create_info, context->allocator,
+                               &graphics_timeline_semaphore));
+  } else {
+    /* a binary semaphore is waited once per signal, so every frame in
+     * flight needs its own */
+    frame_semaphores.resize(context->max_frames_in_flight);
+    graphics_frame_semaphores.resize(context->max_frames_in_flight);
+    for (uint32_t i = 0; i < frame_semaphores.size(); ++i) {
+      VK_CHECK(vkCreateSemaphore(context->device->GetLogicalDevice(),
+                                 &semaphore_create_info, context->allocator,
+                                 &frame_semaphores[i]));
+      VK_CHECK(vkCreateSemaphore(context->device->GetLogicalDevice(),
+                                 &semaphore_create_info, context->allocator,
+                                 &graphics_frame_semaphores[i]));
+    }
+  }
+
+  DEBUG("Async compute: 1, timeline semaphore: %d", timeline);
+}
+
+void VulkanAsyncCompute::Shutdown() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+
+  if (timeline_semaphore) {
+    vkDestroySemaphore(context->device->GetLogicalDevice(), timeline_semaphore,
+                       context->allocator);
+  }
+  if (graphics_timeline_semaphore) {
+    vkDestroySemaphore(context->device->GetLogicalDevice(),
+                       graphics_timeline_semaphore, context->allocator);
+  }
+  for (uint32_t i = 0; i < frame_semaphores.size(); ++i) {
+    vkDestroySemaphore(context->device->GetLogicalDevice(),
+                       frame_semaphores[i], context->allocator);
+    vkDestroySemaphore(context->device->GetLogicalDevice(),
+                       graphics_frame_semaphores[i], context->allocator);
+  }
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+  for (uint32_t i = 0; i < graphics_command_buffers.size(); ++i) {
+    if (graphics_command_buffers[i].GetHandle()) {
+      graphics_command_buffers[i].Free(info.command_pool);
+    }
+  }
+
+  active = false;
+  timeline_semaphore = 0;
+  frame_semaphores.clear();
+  graphics_timeline_semaphore = 0;
+  graphics_frame_semaphores.clear();
+  graphics_command_buffers.clear();
+  attachments.clear();
+}
+
+bool VulkanAsyncCompute::Begin(std::vector<GPUAttachment *> &attachments) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (recording) {
+    WARN("Async compute is already being recorded!");
+    return false;
+  }
+
+  /* the graphics submit waits for a single batch */
+  if (active && submitted) {
+    WARN("Async compute can be submitted only once per frame!");
+    return false;
+  }
+
+  recording = true;
+  this->attachments = attachments;
+
+  if (!active) {
+    TransferAttachments(0, true, false);
+    return true;
+  }
+
+  if (!SubmitGraphicsWork()) {
+    recording = false;
+    this->attachments.clear();
+    return false;
+  }
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_COMPUTE);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+  command_buffer->Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+  TransferAttachments(command_buffer, true, false);
+
+  context->compute_queue_type = VULKAN_DEVICE_QUEUE_TYPE_COMPUTE;
+  context->bound_compute_shader = 0;
+
+  return true;
+}
+
+bool VulkanAsyncCompute::End() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (!recording) {
+    WARN("Async compute is not being recorded!");
+    return false;
+  }
+  recording = false;
+
+  if (!active) {
+    TransferAttachments(0, false, false);
+    attachments.clear();
+    return true;
+  }
+
+  context->compute_queue_type = VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS;
+  context->bound_compute_shader = 0;
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_COMPUTE);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+  TransferAttachments(command_buffer, false, true);
+  attachments.clear();
+  command_buffer->End();
+
+  /* the graphics work recorded before Begin, submitted by it */
+  VkSemaphore wait_semaphore;
+  uint64_t wait_value = 0;
+  VkPipelineStageFlags wait_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  VkSemaphore signal_semaphore;
+  uint64_t signal_value = 0;
+  if (timeline) {
+    wait_semaphore = graphics_timeline_semaphore;
+    wait_value = graphics_timeline_value;
+    signal_semaphore = timeline_semaphore;
+    signal_value = ++timeline_value;
+  } else {
+    wait_semaphore = graphics_frame_semaphores[context->current_frame];
+    signal_semaphore = frame_semaphores[context->current_frame];
+  }
+
+  VkTimelineSemaphoreSubmitInfo timeline_submit_info = {};
+  timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline_submit_info.pNext = 0;
+  timeline_submit_info.waitSemaphoreValueCount = 1;
+  timeline_submit_info.pWaitSemaphoreValues = &wait_value;
+  timeline_submit_info.signalSemaphoreValueCount = 1;
+  timeline_submit_info.pSignalSemaphoreValues = &signal_value;
+
+  VkSubmitInfo submit_info = {};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = timeline ? &timeline_submit_info : 0;
+  submit_info.waitSemaphoreCount = 1;
+  submit_info.pWaitSemaphores = &wait_semaphore;
+  submit_info.pWaitDstStageMask = &wait_stage_mask;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer->GetHandle();
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &signal_semaphore;
+
+  VkResult result = vkQueueSubmit(info.queue, 1, &submit_info, 0);
+  if (result != VK_SUCCESS) {
+    ERROR("Async compute queue submit failed.");
+    return false;
+  }
+
+  submitted = true;
+
+  return true;
+}
+
+bool VulkanAsyncCompute::ConsumeFrameWait(
+    VkSemaphore *out_semaphore, uint64_t *out_value,
+    VkPipelineStageFlags *out_stage_mask) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (recording) {
+    WARN("Async compute is not ended before the end of the frame!");
+    End();
+  }
+
+  if (!submitted) {
+    return false;
+  }
+  submitted = false;
+
+  if (timeline) {
+    *out_semaphore = timeline_semaphore;
+    *out_value = timeline_value;
+  } else {
+    *out_semaphore = frame_semaphores[context->current_frame];
+    *out_value = 0;
+  }
+  *out_stage_mask = graphics_wait_stage_mask;
+
+  return true;
+}
+
+bool VulkanAsyncCompute::SubmitGraphicsWork() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+  TransferAttachments(command_buffer, true, true);
+  context->frame_timer->EndFrame(command_buffer->GetHandle());
+  command_buffer->End();
+
+  VkSemaphore signal_semaphore;
+  uint64_t signal_value = 0;
+  if (timeline) {
+    signal_semaphore = graphics_timeline_semaphore;
+    signal_value = ++graphics_timeline_value;
+  } else {
+    signal_semaphore = graphics_frame_semaphores[context->current_frame];
+  }
+
+  VkTimelineSemaphoreSubmitInfo timeline_submit_info = {};
+  timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline_submit_info.pNext = 0;
+  timeline_submit_info.waitSemaphoreValueCount = 0;
+  timeline_submit_info.pWaitSemaphoreValues = 0;
+  timeline_submit_info.signalSemaphoreValueCount = 1;
+  timeline_submit_info.pSignalSemaphoreValues = &signal_value;
+
+  /* the swapchain image is waited for by the submit of EndFrame, the work
+   * recorded so far doesn't render to it */
+  VkSubmitInfo submit_info = {};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = timeline ? &timeline_submit_info : 0;
+  submit_info.waitSemaphoreCount = 0;
+  submit_info.pWaitSemaphores = 0;
+  submit_info.pWaitDstStageMask = 0;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer->GetHandle();
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &signal_semaphore;
+
+  VkResult result = vkQueueSubmit(info.queue, 1, &submit_info, 0);
+  if (result != VK_SUCCESS) {
+    ERROR("Graphics queue submit before async compute failed.");
+    return false;
+  }
+
+  /* the frame continues in a command buffer of our own, the submitted one
+   * is recorded again on the next use of the image */
+  if (graphics_command_buffers.size() <= context->image_index) {
+    graphics_command_buffers.resize(context->image_index + 1);
+  }
+  VulkanCommandBuffer *next_command_buffer =
+      &graphics_command_buffers[context->image_index];
+  if (!next_command_buffer->GetHandle()) {
+    next_command_buffer->Allocate(info.command_pool,
+                                  VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+  }
+  next_command_buffer->Begin(0);
+  context->frame_timer->ContinueFrame(next_command_buffer->GetHandle());
+  context->device->SwapCommandBuffer(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS,
+                                     context->image_index,
+                                     next_command_buffer);
+  VulkanBackend::ResetBoundState();
+
+  /* recorded ahead, the graphics submit of the frame waits for the release
+   * of the compute work before running it */
+  info = context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+  TransferAttachments(&info.command_buffers[context->image_index], false,
+                      false);
+
+  return true;
+}
+
+void VulkanAsyncCompute::TransferAttachments(
+    VulkanCommandBuffer *command_buffer, bool to_compute, bool release) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  /* sampled depth attachments are written and read by the graphics stages
+   * below */
+  VkPipelineStageFlags graphics_stage_mask =
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  VkAccessFlags attachment_access_mask =
+      VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  VkAccessFlags attachment_write_mask =
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+  /* same queue family, the compute work is recorded into the graphics
+   * command buffer. Memory barriers give it the ordering of the semaphores
+   * of the async path */
+  if (!active) {
+    VulkanDeviceQueueInfo info =
+        context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+
+    VkPipelineStageFlags src_stage_mask;
+    VkPipelineStageFlags dst_stage_mask;
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = 0;
+    if (to_compute) {
+      src_stage_mask = graphics_stage_mask;
+      dst_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+      barrier.srcAccessMask =
+          attachment_write_mask | VK_ACCESS_SHADER_WRITE_BIT;
+      barrier.dstAccessMask =
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    } else {
+      src_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+      dst_stage_mask = graphics_wait_stage_mask | graphics_stage_mask;
+      barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      barrier.dstAccessMask =
+          VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+          VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+          VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    }
+
+    vkCmdPipelineBarrier(
+        info.command_buffers[context->image_index].GetHandle(),
+        src_stage_mask, dst_stage_mask, 0, 1, &barrier, 0, 0, 0, 0);
+    return;
+  }
+
+  if (attachments.empty()) {
+    return;
+  }
+
+  uint32_t graphics_family_index =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS)
+          .family_index;
+  uint32_t compute_family_index =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_COMPUTE)
+          .family_index;
+
+  /* the release is recorded on the queue that gives the attachments up and
+   * the acquire on the one that takes them, with the same barrier. The
+   * semaphores between the submits order the two */
+  bool on_graphics_queue = to_compute == release;
+  VkPipelineStageFlags src_stage_mask;
+  VkPipelineStageFlags dst_stage_mask;
+  if (release) {
+    src_stage_mask = on_graphics_queue ? graphics_stage_mask
+                                       : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dst_stage_mask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+  } else {
+    src_stage_mask = on_graphics_queue ? graphics_wait_stage_mask
+                                       : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dst_stage_mask = on_graphics_queue
+                         ? graphics_wait_stage_mask | graphics_stage_mask
+                         : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  }
+
+  std::vector<VkImageMemoryBarrier> barriers;
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    VulkanAttachment *native_attachment = (VulkanAttachment *)attachments[i];
+    bool is_depth_attachment =
+        GPUUtils::IsDepthFormat(attachments[i]->GetFormat());
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = 0;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = 0;
+    if (release && to_compute) {
+      barrier.srcAccessMask = attachment_write_mask;
+    } else if (!release) {
+      barrier.dstAccessMask =
+          to_compute ? VK_ACCESS_SHADER_READ_BIT
+                     : VK_ACCESS_SHADER_READ_BIT | attachment_access_mask;
+    }
+    /* attachments stay in the layout they are sampled in, as left by the
+     * render pass */
+    barrier.oldLayout = is_depth_attachment
+                            ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                            : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.newLayout = barrier.oldLayout;
+    barrier.srcQueueFamilyIndex =
+        to_compute ? graphics_family_index : compute_family_index;
+    barrier.dstQueueFamilyIndex =
+        to_compute ? compute_family_index : graphics_family_index;
+    barrier.image = native_attachment->GetHandle();
+    barrier.subresourceRange.aspectMask =
+        is_depth_attachment ? VK_IMAGE_ASPECT_DEPTH_BIT
+                            : VK_IMAGE_ASPECT_COLOR_BIT;
+    if (is_depth_attachment &&
+        VulkanUtils::FormatHasStencil(VulkanUtils::GPUFormatToVulkanFormat(
+            attachments[i]->GetFormat()))) {
+      barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    barriers.emplace_back(barrier);
+  }
+
+  vkCmdPipelineBarrier(command_buffer->GetHandle(), src_stage_mask,
+                       dst_stage_mask, 0, 0, 0, 0, 0, barriers.size(),
+                       barriers.data());
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../gpu_attachment.h"
+#include "vulkan_command_buffer.h"
+
+#include <stdint.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+/* Compute work recorded between Begin and End is submitted to the compute
+ * only queue family, where it runs alongside the graphics work. Begin submits
+ * the graphics work recorded so far and the compute submit waits for it, so
+ * the compute work can read its results. The graphics submit of the frame
+ * waits for the compute work in turn. Both waits are on timeline semaphores
+ * if supported and on binary semaphores per frame otherwise. Without a
+ * compute only family the work is recorded into the graphics command buffer
+ * as usual */
+class VulkanAsyncCompute {
+public:
+  void Initialize();
+  void Shutdown();
+
+  inline bool IsActive() const { return active; }
+
+  /* attachments are written by the graphics work recorded before Begin and
+   * read by the compute work. Their ownership moves to the compute family
+   * until End */
+  bool Begin(std::vector<GPUAttachment *> &attachments);
+  bool End();
+
+  /* semaphore the graphics submit of the frame has to wait for, the value to
+   * wait for if it is a timeline semaphore, and the stages that wait.
+   * Returns false if no work was submitted during the frame */
+  bool ConsumeFrameWait(VkSemaphore *out_semaphore, uint64_t *out_value,
+                        VkPipelineStageFlags *out_stage_mask);
+
+private:
+  /* submits the graphics work recorded so far and continues the frame in
+   * another command buffer */
+  bool SubmitGraphicsWork();
+  /* release or acquire half of the ownership transfers of the attachments
+   * between the graphics and the compute families */
+  void TransferAttachments(VulkanCommandBuffer *command_buffer,
+                           bool to_compute, bool release);
+
+  bool active;
+  bool timeline;
+  bool recording;
+  /* work was submitted during the current frame */
+  bool submitted;
+
+  /* signaled by the compute submits, waited by the graphics ones */
+  VkSemaphore timeline_semaphore;
+  uint64_t timeline_value;
+  std::vector<VkSemaphore> frame_semaphores;
+  /* signaled by the graphics submits of Begin, waited by the compute ones */
+  VkSemaphore graphics_timeline_semaphore;
+  uint64_t graphics_timeline_value;
+  std::vector<VkSemaphore> graphics_frame_semaphores;
+
+  /* per swapchain image, the frame continues in those after Begin */
+  std::vector<VulkanCommandBuffer> graphics_command_buffers;
+  std::vector<GPUAttachment *> attachments;
+};
\ No newline at end of file
@@ -9,24 +9,112 @@
 void VulkanAttachment::Create(GPUFormat attachment_format,
                               GPUAttachmentUsage attachment_usage,
                               uint32_t attachment_width,
-                              uint32_t attachment_height) {
+                              uint32_t attachment_height,
+                              uint32_t attachment_flags) {
   VulkanContext *context = VulkanBackend::GetContext();
 
   format = attachment_format;
   aspect = attachment_usage;
   width = attachment_width;
   height = attachment_height;
+  flags = attachment_flags;
+  aliased = false;
+  sampler = 0;
+
+  VkImageCreateInfo image_create_info = GetImageCreateInfo();
+
+  VmaAllocationCreateInfo vma_allocation_create_info = {};
+  /* vma_allocation_create_info.flags; */
+  vma_allocation_create_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+  vma_allocation_create_info.requiredFlags =
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  /* vma_allocation_create_info.preferredFlags;
+  vma_allocation_create_info.memoryTypeBits;
+  vma_allocation_create_info.pool;
+  vma_allocation_create_info.pUserData;
+  vma_allocation_create_info.priority; */
+
+  VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+  if (flags & GPU_ATTACHMENT_FLAG_TRANSIENT) {
+    /* lazily allocated memory is committed only if the attachment leaves
+     * the tile memory. Only tile based GPUs have it */
+    VmaAllocationCreateInfo lazy_allocation_create_info =
+        vma_allocation_create_info;
+    lazy_allocation_create_info.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+    lazy_allocation_create_info.requiredFlags =
+        VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    result = vmaCreateImage(context->vma_allocator, &image_create_info,
+                            &lazy_allocation_create_info, &handle, &memory, 0);
+  }
+  if (result != VK_SUCCESS) {
+    VK_CHECK(vmaCreateImage(context->vma_allocator, &image_create_info,
+                            &vma_allocation_create_info, &handle, &memory, 0));
+  }
+
+  CreateViewAndSampler();
+}
+
+void VulkanAttachment::CreateAliased(GPUFormat attachment_format,
+                                     GPUAttachmentUsage attachment_usage,
+                                     uint32_t attachment_width,
+                                     uint32_t attachment_height,
+                                     uint32_t attachment_flags) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  format = attachment_format;
+  aspect = attachment_usage;
+  width = attachment_width;
+  height = attachment_height;
+  flags = attachment_flags;
+  aliased = true;
+  memory = 0;
+  view = 0;
+  sampler = 0;
+
+  VkImageCreateInfo image_create_info = GetImageCreateInfo();
+  /* the memory may have been used by another attachment before */
+  image_create_info.flags = VK_IMAGE_CREATE_ALIAS_BIT;
+
+  VK_CHECK(vkCreateImage(context->device->GetLogicalDevice(),
+                         &image_create_info, context->allocator, &handle));
+}
+
+void VulkanAttachment::GetMemoryRequirements(
+    VkMemoryRequirements *out_requirements) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  vkGetImageMemoryRequirements(context->device->GetLogicalDevice(), handle,
+                               out_requirements);
+}
+
+void VulkanAttachment::BindAliasedMemory(VmaAllocation shared_memory,
+                                         VkDeviceSize offset) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VK_CHECK(vmaBindImageMemory2(context->vma_allocator, shared_memory, offset,
+                               handle, 0));
+
+  CreateViewAndSampler();
+}
+
+VkImageCreateInfo VulkanAttachment::GetImageCreateInfo() {
   VkFormat native_format = VulkanUtils::GPUFormatToVulkanFormat(format);
-  VkImageAspectFlags native_aspect_flags =
-      VulkanUtils::GPUTextureUsageToVulkanAspectFlags(aspect);
 
   VkImageUsageFlags usage;
-  /* TODO: all of the attachments are sampled for now */
   if (GPUUtils::IsDepthFormat(format)) {
-    usage = VK_IMAGE_USAGE_SAMPLED_BIT |
-            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
   } else {
-    usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  }
+  /* transient images can only be used as attachments, the others are all
+   * sampled for now */
+  if (flags & GPU_ATTACHMENT_FLAG_TRANSIENT) {
+    usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+  } else {
+    usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+  }
+  if (flags & GPU_ATTACHMENT_FLAG_INPUT) {
+    usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
   }
 
   VkImageCreateInfo image_create_info = {};
@@ -48,19 +136,15 @@ void VulkanAttachment::Create(GPUFormat attachment_format,
   image_create_info.pQueueFamilyIndices = 0;
   image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-  VmaAllocationCreateInfo vma_allocation_create_info = {};
-  /* vma_allocation_create_info.flags; */
-  vma_allocation_create_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-  vma_allocation_create_info.requiredFlags =
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-  /* vma_allocation_create_info.preferredFlags;
-  vma_allocation_create_info.memoryTypeBits;
-  vma_allocation_create_info.pool;
-  vma_allocation_create_info.pUserData;
-  vma_allocation_create_info.priority; */
+  return image_create_info;
+}
 
-  VK_CHECK(vmaCreateImage(context->vma_allocator, &image_create_info,
-                          &vma_allocation_create_info, &handle, &memory, 0));
+void VulkanAttachment::CreateViewAndSampler() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VkFormat native_format = VulkanUtils::GPUFormatToVulkanFormat(format);
+  VkImageAspectFlags native_aspect_flags =
+      VulkanUtils::GPUTextureUsageToVulkanAspectFlags(aspect);
 
   VkImageViewCreateInfo view_create_info = {};
   view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -79,6 +163,12 @@ void VulkanAttachment::Create(GPUFormat attachment_format,
   VK_CHECK(vkCreateImageView(context->device->GetLogicalDevice(),
                              &view_create_info, context->allocator, &view));
 
+  /* transient attachments are never sampled */
+  if (flags & GPU_ATTACHMENT_FLAG_TRANSIENT) {
+    sampler = 0;
+    return;
+  }
+
   /* TODO: create sampler only if needed, and only if it is a color attachment
    */
   VkSamplerCreateInfo sampler_create_info = {};
@@ -106,18 +196,40 @@ void VulkanAttachment::Destroy() {
 
   vkDeviceWaitIdle(context->device->GetLogicalDevice());
 
+  DestroyImmediate();
+}
+
+void VulkanAttachment::DestroyImmediate() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  context->descriptor_set_cache->InvalidateResource((uint64_t)view);
+  context->descriptor_set_cache->InvalidateResource((uint64_t)sampler);
+  /* the pool is shut down before the swapchain */
+  if (context->render_target_pool) {
+    context->render_target_pool->InvalidateAttachment(this);
+  }
+
   vkDestroySampler(context->device->GetLogicalDevice(), sampler,
                    context->allocator);
 
   vkDestroyImageView(context->device->GetLogicalDevice(), view,
                      context->allocator);
-  vmaDestroyImage(context->vma_allocator, handle, memory);
+  if (aliased) {
+    /* the shared memory is owned by whoever bound it */
+    vkDestroyImage(context->device->GetLogicalDevice(), handle,
+                   context->allocator);
+  } else {
+    vmaDestroyImage(context->vma_allocator, handle, memory);
+  }
 
   format = GPU_FORMAT_NONE;
   aspect = GPU_ATTACHMENT_USAGE_NONE;
+  flags = 0;
   handle = 0;
   view = 0;
   memory = 0;
+  sampler = 0;
+  aliased = false;
 }
 
 void VulkanAttachment::SetDebugName(const char *name) {
@@ -135,11 +247,16 @@ void VulkanAttachment::CreateAsSwapchainAttachment(VkImage new_handle,
                                                    VkImageView new_view) {
   handle = new_handle;
   view = new_view;
+  flags = 0;
 }
 
 void VulkanAttachment::DestroyAsSwapchainAttachment() {
   VulkanContext *context = VulkanBackend::GetContext();
 
+  if (context->render_target_pool) {
+    context->render_target_pool->InvalidateAttachment(this);
+  }
+
   vkDestroyImageView(context->device->GetLogicalDevice(), view,
                      context->allocator);
 }
\ No newline at end of file
@@ -8,21 +8,41 @@
 class VulkanAttachment : public GPUAttachment {
 public:
   void Create(GPUFormat attachment_format, GPUAttachmentUsage attachment_usage,
-              uint32_t attachment_width, uint32_t attachment_height) override;
+              uint32_t attachment_width, uint32_t attachment_height,
+              uint32_t attachment_flags = 0) override;
   void Destroy() override;
 
   void SetDebugName(const char *name) override;
   void SetDebugTag(const void *tag, size_t tag_size) override;
 
+  /* the image is created without memory. Attachments that are not used at
+   * the same time can then be bound to the same memory, see
+   * VulkanRenderGraph. The memory stays owned by the caller */
+  void CreateAliased(GPUFormat attachment_format,
+                     GPUAttachmentUsage attachment_usage,
+                     uint32_t attachment_width, uint32_t attachment_height,
+                     uint32_t attachment_flags = 0);
+  void GetMemoryRequirements(VkMemoryRequirements *out_requirements);
+  void BindAliasedMemory(VmaAllocation shared_memory, VkDeviceSize offset);
+
   void CreateAsSwapchainAttachment(VkImage new_handle, VkImageView new_view);
   void DestroyAsSwapchainAttachment();
 
+  /* Destroy without waiting for the device, the caller makes sure that the
+   * device no longer uses the attachment */
+  void DestroyImmediate();
+
   inline VkSampler GetSampler() { return sampler; }
   inline VkImageView GetImageView() const { return view; }
+  inline VkImage GetHandle() const { return handle; }
 
 private:
+  VkImageCreateInfo GetImageCreateInfo();
+  void CreateViewAndSampler();
+
   VkImage handle;
   VkImageView view;
   VmaAllocation memory;
   VkSampler sampler;
+  bool aliased;
 };
\ No newline at end of file
@@ -3,12 +3,19 @@
 #include "../../logger.h"
 #include "../../platform.h"
 #include "../gpu_shader.h"
+#include "vulkan_compute_shader.h"
 #include "vulkan_debug_marker.h"
 #include "vulkan_descriptor_set.h"
+#include "vulkan_dynamic_state.h"
 #include "vulkan_index_buffer.h"
+#include "vulkan_post_process_stack.h"
+#include "vulkan_render_graph.h"
 #include "vulkan_render_pass.h"
+#include "vulkan_storage_buffer.h"
 #include "vulkan_texture.h"
 #include "vulkan_uniform_buffer.h"
+#include "vulkan_upscaler.h"
+#include "vulkan_utils.h"
 #include "vulkan_vertex_buffer.h"
 
 #include <SDL2/SDL.h>
@@ -30,6 +37,18 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vulkanDebugCallback(
     VkDebugUtilsMessageTypeFlagsEXT message_types,
     const VkDebugUtilsMessengerCallbackDataEXT *callback_data, void *user_data);
 
+static void DestroyRetiredFramebuffer(void *object) {
+  VulkanFramebuffer *framebuffer = (VulkanFramebuffer *)object;
+  framebuffer->DestroyImmediate();
+  delete framebuffer;
+}
+
+static void DestroyRetiredSwapchain(void *object) {
+  VulkanSwapchain *swapchain = (VulkanSwapchain *)object;
+  swapchain->Destroy();
+  delete swapchain;
+}
+
 bool VulkanBackend::Initialize(SDL_Window *sdl_window) {
   context = new VulkanContext();
   window = sdl_window;
@@ -69,10 +88,14 @@ bool VulkanBackend::Initialize(SDL_Window *sdl_window) {
   requirements.graphics = true;
   requirements.present = true;
   requirements.transfer = true;
+  requirements.compute = true;
   if (!context->device->Create(&requirements)) {
     return false;
   }
 
+  VulkanDynamicState::Initialize();
+  VulkanRenderPass::Initialize();
+
 #ifndef NDEBUG
   VulkanDebugUtils::Initialize();
 #endif
@@ -92,14 +115,50 @@ bool VulkanBackend::Initialize(SDL_Window *sdl_window) {
   VK_CHECK(
       vmaCreateAllocator(&vma_allocator_create_info, &context->vma_allocator));
 
+  VkPipelineCacheCreateInfo pipeline_cache_create_info = {};
+  pipeline_cache_create_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  pipeline_cache_create_info.pNext = 0;
+  pipeline_cache_create_info.flags = 0;
+  pipeline_cache_create_info.initialDataSize = 0;
+  pipeline_cache_create_info.pInitialData = 0;
+  VK_CHECK(vkCreatePipelineCache(context->device->GetLogicalDevice(),
+                                 &pipeline_cache_create_info,
+                                 context->allocator, &context->pipeline_cache));
+
+  context->pipeline_library = new VulkanPipelineLibrary();
+  context->pipeline_library->Initialize();
+
+#ifdef RF3D_SHADER_HOT_RELOAD
+  context->shader_hot_reload = new VulkanShaderHotReload();
+  if (!context->shader_hot_reload->Initialize(RF3D_SHADER_SOURCE_DIR,
+                                              RF3D_SHADER_OUTPUT_DIR)) {
+    delete context->shader_hot_reload;
+    context->shader_hot_reload = 0;
+  }
+#endif
+
   int width, height;
   SDL_Vulkan_GetDrawableSize(window, &width, &height);
 
+  /* lowest latency without tearing where supported */
+  present_mode = GPU_PRESENT_MODE_MAILBOX;
+  swapchain_image_count = 0;
+  frame_rate_limit = 0;
+  frame_deadline = 0;
+
   context->swapchain = new VulkanSwapchain();
-  if (!context->swapchain->Create(width, height)) {
+  if (!context->swapchain->Create(width, height, present_mode,
+                                  swapchain_image_count)) {
     return false;
   }
 
+  vkWaitForPresent = 0;
+  if (context->device->GetOptionalFeatures().present_wait) {
+    vkWaitForPresent = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(
+        context->device->GetLogicalDevice(), "vkWaitForPresentKHR");
+  }
+
   main_render_pass = RenderPassAllocate();
   main_render_pass->Create(
       std::vector<GPURenderPassAttachmentConfig>{
@@ -118,42 +177,31 @@ bool VulkanBackend::Initialize(SDL_Window *sdl_window) {
       GPU_RENDER_PASS_CLEAR_FLAG_COLOR | GPU_RENDER_PASS_CLEAR_FLAG_DEPTH |
           GPU_RENDER_PASS_CLEAR_FLAG_STENCIL);
 
-  main_framebuffers.resize(context->swapchain->GetImageCount());
   RegenerateFramebuffers();
 
   context->device->UpdateCommandBuffers();
 
-  context->image_available_semaphores.resize(
-      context->swapchain->GetMaxFramesInFlights());
-  context->queue_complete_semaphores.resize(
-      context->swapchain->GetMaxFramesInFlights());
-  context->in_flight_fences.resize(context->swapchain->GetMaxFramesInFlights());
-  for (uint32_t i = 0; i < context->swapchain->GetMaxFramesInFlights(); ++i) {
-    VkSemaphoreCreateInfo semaphore_create_info = {};
-    semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    semaphore_create_info.pNext = 0;
-    semaphore_create_info.flags = 0;
-
-    VK_CHECK(vkCreateSemaphore(context->device->GetLogicalDevice(),
-                               &semaphore_create_info, context->allocator,
-                               &context->image_available_semaphores[i]));
-    VK_CHECK(vkCreateSemaphore(context->device->GetLogicalDevice(),
-                               &semaphore_create_info, context->allocator,
-                               &context->queue_complete_semaphores[i]));
-
-    context->in_flight_fences[i] = new VulkanFence();
-    context->in_flight_fences[i]->Create(true);
-  }
-
-  context->images_in_flight.resize(context->swapchain->GetImageCount());
-  for (uint32_t i = 0; i < context->images_in_flight.size(); ++i) {
-    context->images_in_flight[i] = 0;
-  }
+  context->max_frames_in_flight =
+      glm::max(context->swapchain->GetImageCount() - 1, 1u);
+  CreateFrameObjects();
 
   context->descriptor_pools = new VulkanDescriptorPools();
   context->descriptor_pools->Initialize();
   context->layout_cache = new VulkanDescriptorLayoutCache();
   context->layout_cache->Initialize();
+  context->descriptor_set_cache = new VulkanDescriptorSetCache();
+  context->descriptor_set_cache->Initialize();
+  context->bindless_textures = new VulkanBindlessTextures();
+  context->bindless_textures->Initialize();
+  context->async_compute = new VulkanAsyncCompute();
+  context->async_compute->Initialize();
+  context->render_target_pool = new VulkanRenderTargetPool();
+  context->render_target_pool->Initialize();
+  context->deletion_queue = new VulkanDeletionQueue();
+  context->deletion_queue->Initialize();
+  context->frame_timer = new VulkanFrameTimer();
+  context->frame_timer->Initialize();
+  context->compute_queue_type = VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS;
 
   return true;
 }
@@ -161,21 +209,27 @@ bool VulkanBackend::Initialize(SDL_Window *sdl_window) {
 void VulkanBackend::Shutdown() {
   vkDeviceWaitIdle(context->device->GetLogicalDevice());
 
+  context->frame_timer->Shutdown();
+  delete context->frame_timer;
+  /* retired swapchains invalidate the render targets of the pool */
+  context->deletion_queue->Shutdown();
+  delete context->deletion_queue;
+  context->deletion_queue = 0;
+  context->render_target_pool->Shutdown();
+  delete context->render_target_pool;
+  context->render_target_pool = 0;
+  context->async_compute->Shutdown();
+  delete context->async_compute;
+  context->bindless_textures->Shutdown();
+  delete context->bindless_textures;
+  context->descriptor_set_cache->Shutdown();
+  delete context->descriptor_set_cache;
   context->layout_cache->Shutdown();
   delete context->layout_cache;
   context->descriptor_pools->Shutdown();
   delete context->descriptor_pools;
 
-  for (uint32_t i = 0; i < context->swapchain->GetMaxFramesInFlights(); ++i) {
-    vkDestroySemaphore(context->device->GetLogicalDevice(),
-                       context->image_available_semaphores[i],
-                       context->allocator);
-    vkDestroySemaphore(context->device->GetLogicalDevice(),
-                       context->queue_complete_semaphores[i],
-                       context->allocator);
-    context->in_flight_fences[i]->Destroy();
-    delete context->in_flight_fences[i];
-  }
+  DestroyFrameObjects();
 
   for (uint32_t i = 0; i < main_framebuffers.size(); ++i) {
     main_framebuffers[i]->Destroy();
@@ -187,6 +241,19 @@ void VulkanBackend::Shutdown() {
   delete main_render_pass;
   main_render_pass = 0;
 
+#ifdef RF3D_SHADER_HOT_RELOAD
+  if (context->shader_hot_reload) {
+    context->shader_hot_reload->Shutdown();
+    delete context->shader_hot_reload;
+    context->shader_hot_reload = 0;
+  }
+#endif
+
+  context->pipeline_library->Shutdown();
+  delete context->pipeline_library;
+  vkDestroyPipelineCache(context->device->GetLogicalDevice(),
+                         context->pipeline_cache, context->allocator);
+
   context->swapchain->Destroy();
   delete context->swapchain;
 
@@ -212,41 +279,95 @@ void VulkanBackend::Shutdown() {
 }
 
 void VulkanBackend::Resize(uint32_t width, uint32_t height) {
-  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+  RecreateSwapchain(width, height);
+}
 
-  context->swapchain->Recreate(width, height);
+void VulkanBackend::SetPresentMode(GPUPresentMode new_present_mode) {
+  present_mode = new_present_mode;
+  RecreateSwapchain();
+}
 
-  main_render_pass->SetRenderArea(glm::vec4(0, 0, width, height));
+GPUPresentMode VulkanBackend::GetPresentMode() {
+  return VulkanUtils::VulkanPresentModeToGPUPresentMode(
+      context->swapchain->GetPresentMode());
+}
 
-  RegenerateFramebuffers();
+void VulkanBackend::SetSwapchainImageCount(uint32_t image_count) {
+  swapchain_image_count = image_count;
+  RecreateSwapchain();
+}
 
-  context->device->UpdateCommandBuffers();
+uint32_t VulkanBackend::GetSwapchainImageCount() {
+  return context->swapchain->GetImageCount();
+}
 
-  for (int i = 0; i < context->images_in_flight.size(); ++i) {
-    context->images_in_flight[i] = 0;
-  }
-  context->images_in_flight.resize(context->swapchain->GetMaxFramesInFlights());
-  for (int i = 0; i < context->in_flight_fences.size(); ++i) {
-    context->in_flight_fences[i]->Destroy();
+void VulkanBackend::SetMaxFramesInFlight(uint32_t max_frames_in_flight) {
+  max_frames_in_flight = glm::max(max_frames_in_flight, 1u);
+  if (max_frames_in_flight == context->max_frames_in_flight) {
+    return;
   }
-  context->in_flight_fences.resize(context->swapchain->GetMaxFramesInFlights());
-  for (int i = 0; i < context->in_flight_fences.size(); ++i) {
-    context->in_flight_fences[i]->Create(true);
+
+  /* the per frame objects are recreated, so none of them may be in use */
+  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+
+  for (uint32_t i = 0; i < context->max_frames_in_flight; ++i) {
+    context->descriptor_pools->ResetFrame(i);
   }
+  DestroyFrameObjects();
+  context->async_compute->Shutdown();
+  context->frame_timer->Shutdown();
+
+  context->max_frames_in_flight = max_frames_in_flight;
+  context->current_frame = 0;
+
+  CreateFrameObjects();
+  context->async_compute->Initialize();
+  context->frame_timer->Initialize();
+}
+
+void VulkanBackend::SetFrameRateLimit(uint32_t frames_per_second) {
+  frame_rate_limit = frames_per_second;
+  frame_deadline = 0;
 }
 
 bool VulkanBackend::BeginFrame() {
+  LimitFrameRate();
+
+  /* TODO: the resources written by the frames are not per frame, so the
+   * previous frame has to finish before this one is recorded. Until they
+   * are, the frames in flight are not overlapped */
   vkDeviceWaitIdle(context->device->GetLogicalDevice());
 
+  /* the device is idle, so the pipelines can be swapped safely */
+  context->pipeline_library->Update();
+#ifdef RF3D_SHADER_HOT_RELOAD
+  if (context->shader_hot_reload) {
+    context->shader_hot_reload->Update();
+  }
+#endif
+
   if (!context->in_flight_fences[context->current_frame]->Wait(UINT64_MAX)) {
     return false;
   }
 
-  glm::vec4 render_area = main_render_pass->GetRenderArea();
+  /* the sets of the frame are no longer used by the device */
+  context->descriptor_pools->ResetFrame(context->current_frame);
+  context->deletion_queue->Update(context->max_frames_in_flight);
+  /* pooled attachments unused for a while are destroyed */
+  context->render_target_pool->Update();
+
+  /* also retried while the window is minimized */
+  if (context->swapchain->IsOutOfDate() && !RecreateSwapchain()) {
+    return false;
+  }
+
   if (!context->swapchain->AcquireNextImage(
           UINT64_MAX,
           context->image_available_semaphores[context->current_frame], 0,
-          render_area.z, render_area.w, &context->image_index)) {
+          &context->image_index)) {
+    if (context->swapchain->IsOutOfDate()) {
+      RecreateSwapchain();
+    }
     return false;
   }
 
@@ -256,10 +377,24 @@ bool VulkanBackend::BeginFrame() {
   VulkanCommandBuffer *command_buffer =
       &info.command_buffers[context->image_index];
   command_buffer->Begin(0);
+  context->frame_timer->BeginFrame(command_buffer->GetHandle());
+  ResetBoundState();
+  context->compute_queue_type = VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS;
 
   return true;
 }
 
+void VulkanBackend::ResetBoundState() {
+  context->bound_shader = 0;
+  context->bound_pipeline = 0;
+  VulkanDynamicState::Invalidate();
+  context->bound_compute_shader = 0;
+  for (uint32_t i = 0; i < VULKAN_MAX_BOUND_DESCRIPTOR_SETS; ++i) {
+    context->bound_descriptor_sets[i] = 0;
+    context->bound_descriptor_set_layouts[i] = 0;
+  }
+}
+
 bool VulkanBackend::EndFrame() {
   VulkanDeviceQueueInfo info =
       context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
@@ -267,6 +402,7 @@ bool VulkanBackend::EndFrame() {
   VulkanCommandBuffer *command_buffer =
       &info.command_buffers[context->image_index];
 
+  context->frame_timer->EndFrame(command_buffer->GetHandle());
   command_buffer->End();
 
   /* make sure the previous frame is not using this image (its fence is
@@ -281,23 +417,45 @@ bool VulkanBackend::EndFrame() {
 
   context->in_flight_fences[context->current_frame]->Reset();
 
+  VkSemaphore wait_semaphores[2] = {
+      context->image_available_semaphores[context->current_frame], 0};
+  VkPipelineStageFlags flags[2] = {
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0};
+  /* binary semaphores ignore the value */
+  uint64_t wait_values[2] = {0, 0};
+  uint32_t wait_semaphore_count = 1;
+
+  /* the graphics work may consume the results of the async compute work of
+   * the frame, so it waits for it before the first stage that can read
+   * them */
+  if (context->async_compute->ConsumeFrameWait(
+          &wait_semaphores[1], &wait_values[1], &flags[1])) {
+    wait_semaphore_count = 2;
+  }
+
+  VkTimelineSemaphoreSubmitInfo timeline_submit_info = {};
+  timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline_submit_info.pNext = 0;
+  timeline_submit_info.waitSemaphoreValueCount = wait_semaphore_count;
+  timeline_submit_info.pWaitSemaphoreValues = wait_values;
+  timeline_submit_info.signalSemaphoreValueCount = 0;
+  timeline_submit_info.pSignalSemaphoreValues = 0;
+
   VkSubmitInfo submit_info = {};
   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  submit_info.pNext = 0;
-  submit_info.waitSemaphoreCount = 1;
-  submit_info.pWaitSemaphores =
-      &context->image_available_semaphores[context->current_frame];
-  submit_info.pWaitDstStageMask = 0;
+  submit_info.pNext =
+      context->device->GetOptionalFeatures().timeline_semaphore
+          ? &timeline_submit_info
+          : 0;
+  submit_info.waitSemaphoreCount = wait_semaphore_count;
+  submit_info.pWaitSemaphores = wait_semaphores;
+  submit_info.pWaitDstStageMask = flags;
   submit_info.commandBufferCount = 1;
   submit_info.pCommandBuffers = &command_buffer->GetHandle();
   submit_info.signalSemaphoreCount = 1;
   submit_info.pSignalSemaphores =
       &context->queue_complete_semaphores[context->current_frame];
 
-  VkPipelineStageFlags flags[1] = {
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submit_info.pWaitDstStageMask = flags;
-
   VulkanDeviceQueueInfo graphics_queue_info =
       context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
 
@@ -308,6 +466,7 @@ bool VulkanBackend::EndFrame() {
     ERROR("Vulkan queue submit failed.");
     return false;
   }
+  context->deletion_queue->FrameSubmitted();
 
   VulkanDeviceQueueInfo present_queue_info =
       context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_PRESENT);
@@ -323,17 +482,31 @@ bool VulkanBackend::EndFrame() {
   present_info.pImageIndices = &context->image_index;
   present_info.pResults = 0;
 
-  glm::vec4 render_area = main_render_pass->GetRenderArea();
+  /* lets the frame limiter wait for the image to be displayed */
+  uint64_t present_id = context->swapchain->NextPresentId();
+  VkPresentIdKHR present_id_info = {};
+  present_id_info.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+  present_id_info.pNext = 0;
+  present_id_info.swapchainCount = 1;
+  present_id_info.pPresentIds = &present_id;
+  if (vkWaitForPresent) {
+    present_info.pNext = &present_id_info;
+  }
+
   result = vkQueuePresentKHR(present_queue_info.queue, &present_info);
   if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-    context->swapchain->Recreate(render_area.z, render_area.w);
+    context->swapchain->MarkOutOfDate();
   } else if (result != VK_SUCCESS) {
     ERROR("Failed to present swap chain image!");
     return false;
   }
 
+  if (context->swapchain->IsOutOfDate()) {
+    RecreateSwapchain();
+  }
+
   context->current_frame = (context->current_frame + 1) %
-                           context->swapchain->GetMaxFramesInFlights();
+                           context->max_frames_in_flight;
 
   return true;
 }
@@ -362,18 +535,261 @@ bool VulkanBackend::DrawIndexed(uint32_t element_count) {
   return true;
 }
 
+bool VulkanBackend::Dispatch(uint32_t group_count_x, uint32_t group_count_y,
+                             uint32_t group_count_z) {
+  if (!context->bound_compute_shader) {
+    WARN("Dispatch is called, but no compute shader is bound!");
+    return false;
+  }
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(context->compute_queue_type);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  vkCmdDispatch(command_buffer->GetHandle(), group_count_x, group_count_y,
+                group_count_z);
+
+  return true;
+}
+
+bool VulkanBackend::DispatchIndirect(GPUStorageBuffer *buffer,
+                                     uint64_t offset) {
+  if (!context->bound_compute_shader) {
+    WARN("Dispatch is called, but no compute shader is bound!");
+    return false;
+  }
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(context->compute_queue_type);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  VulkanStorageBuffer *native_buffer = (VulkanStorageBuffer *)buffer;
+  vkCmdDispatchIndirect(command_buffer->GetHandle(),
+                        native_buffer->GetBuffer().GetHandle(), offset);
+
+  return true;
+}
+
+bool VulkanBackend::BeginAsyncCompute(
+    std::vector<GPUAttachment *> &attachments) {
+  return context->async_compute->Begin(attachments);
+}
+
+bool VulkanBackend::EndAsyncCompute() {
+  return context->async_compute->End();
+}
+
+void VulkanBackend::PipelineBarrier(GPUBarrierType type) {
+  VkPipelineStageFlags src_stage_mask = 0;
+  VkPipelineStageFlags dst_stage_mask = 0;
+  VkMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.pNext = 0;
+
+  /* storage textures stay in the general layout, so a global barrier covers
+   * the images too */
+  switch (type) {
+  case GPU_BARRIER_TYPE_COMPUTE_TO_COMPUTE: {
+    src_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dst_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  } break;
+  case GPU_BARRIER_TYPE_COMPUTE_TO_GRAPHICS: {
+    src_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dst_stage_mask = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                     VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+        VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+  } break;
+  case GPU_BARRIER_TYPE_COMPUTE_TO_INDIRECT: {
+    src_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dst_stage_mask = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  } break;
+  case GPU_BARRIER_TYPE_GRAPHICS_TO_COMPUTE: {
+    src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                     VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dst_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                            VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  } break;
+  default: {
+    ERROR("Unsupported barrier type!");
+    return;
+  } break;
+  }
+
+  /* the compute only queue doesn't have the graphics stages */
+  if (context->compute_queue_type == VULKAN_DEVICE_QUEUE_TYPE_COMPUTE &&
+      (type == GPU_BARRIER_TYPE_COMPUTE_TO_GRAPHICS ||
+       type == GPU_BARRIER_TYPE_GRAPHICS_TO_COMPUTE)) {
+    ERROR("Graphics barriers can't be recorded into async compute!");
+    return;
+  }
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(context->compute_queue_type);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  vkCmdPipelineBarrier(command_buffer->GetHandle(), src_stage_mask,
+                       dst_stage_mask, 0, 1, &barrier, 0, 0, 0, 0);
+}
+
 GPURenderPass *VulkanBackend::GetWindowRenderPass() { return main_render_pass; }
 
 GPURenderTarget *VulkanBackend::GetCurrentWindowRenderTarget() {
   return main_framebuffers[context->image_index];
 }
 
+GPURenderTargetPool *VulkanBackend::GetRenderTargetPool() {
+  return context->render_target_pool;
+}
+
 uint32_t VulkanBackend::GetCurrentFrameIndex() {
   return context->current_frame;
 }
 
 uint32_t VulkanBackend::GetMaxFramesInFlight() {
-  return context->swapchain->GetMaxFramesInFlights();
+  return context->max_frames_in_flight;
+}
+
+float VulkanBackend::GetGPUFrameTime() {
+  return context->frame_timer->GetFrameTime();
+}
+
+bool VulkanBackend::IsAsyncComputeSupported() {
+  return context->async_compute->IsActive();
+}
+
+bool VulkanBackend::IsBindlessSupported() {
+  return context->bindless_textures->IsActive();
+}
+
+void VulkanBackend::SetCullMode(GPUShaderCullMode cull_mode) {
+  if (!context->bound_shader) {
+    WARN("Cull mode is set, but no shader is bound!");
+    return;
+  }
+
+  VulkanShader::VulkanShaderPipelineKey state =
+      context->bound_shader->GetState();
+  state.render_state.cull_mode = cull_mode;
+  context->bound_shader->SetState(state);
+}
+
+void VulkanBackend::SetFrontFace(GPUShaderFrontFace front_face) {
+  if (!context->bound_shader) {
+    WARN("Front face is set, but no shader is bound!");
+    return;
+  }
+
+  VulkanShader::VulkanShaderPipelineKey state =
+      context->bound_shader->GetState();
+  state.render_state.front_face = front_face;
+  context->bound_shader->SetState(state);
+}
+
+void VulkanBackend::SetPrimitiveTopology(GPUShaderTopologyType topology_type) {
+  if (!context->bound_shader) {
+    WARN("Primitive topology is set, but no shader is bound!");
+    return;
+  }
+
+  VulkanShader::VulkanShaderPipelineKey state =
+      context->bound_shader->GetState();
+  state.topology_type = topology_type;
+  context->bound_shader->SetState(state);
+}
+
+void VulkanBackend::SetDepthTestEnable(bool enable) {
+  if (!context->bound_shader) {
+    WARN("Depth test is set, but no shader is bound!");
+    return;
+  }
+
+  VulkanShader::VulkanShaderPipelineKey state =
+      context->bound_shader->GetState();
+  if (enable) {
+    state.depth_flags |= GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE;
+  } else {
+    state.depth_flags &= ~GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE;
+  }
+  context->bound_shader->SetState(state);
+}
+
+void VulkanBackend::SetDepthWriteEnable(bool enable) {
+  if (!context->bound_shader) {
+    WARN("Depth write is set, but no shader is bound!");
+    return;
+  }
+
+  VulkanShader::VulkanShaderPipelineKey state =
+      context->bound_shader->GetState();
+  if (enable) {
+    state.depth_flags |= GPU_SHADER_DEPTH_FLAG_DEPTH_WRITE_ENABLE;
+  } else {
+    state.depth_flags &= ~GPU_SHADER_DEPTH_FLAG_DEPTH_WRITE_ENABLE;
+  }
+  context->bound_shader->SetState(state);
+}
+
+void VulkanBackend::SetDepthCompareOperation(
+    GPUShaderCompareOperation compare_operation) {
+  if (!context->bound_shader) {
+    WARN("Depth compare operation is set, but no shader is bound!");
+    return;
+  }
+
+  VulkanShader::VulkanShaderPipelineKey state =
+      context->bound_shader->GetState();
+  state.render_state.depth_compare_operation = compare_operation;
+  context->bound_shader->SetState(state);
+}
+
+void VulkanBackend::SetStencilTestEnable(bool enable) {
+  if (!context->bound_shader) {
+    WARN("Stencil test is set, but no shader is bound!");
+    return;
+  }
+
+  VulkanShader::VulkanShaderPipelineKey state =
+      context->bound_shader->GetState();
+  if (enable) {
+    state.stencil_flags |= GPU_SHADER_STENCIL_FLAG_STENCIL_TEST_ENABLE;
+  } else {
+    state.stencil_flags &= ~GPU_SHADER_STENCIL_FLAG_STENCIL_TEST_ENABLE;
+  }
+  context->bound_shader->SetState(state);
+}
+
+void VulkanBackend::SetStencilState(GPUShaderStencilState *front,
+                                    GPUShaderStencilState *back) {
+  if (!context->bound_shader) {
+    WARN("Stencil state is set, but no shader is bound!");
+    return;
+  }
+
+  VulkanShader::VulkanShaderPipelineKey state =
+      context->bound_shader->GetState();
+  state.render_state.stencil_front = *front;
+  state.render_state.stencil_back = *back;
+  context->bound_shader->SetState(state);
 }
 
 void VulkanBackend::BeginDebugRegion(const char *name, glm::vec4 color) {
@@ -420,6 +836,10 @@ GPUUniformBuffer *VulkanBackend::UniformBufferAllocate() {
   return new VulkanUniformBuffer();
 }
 
+GPUStorageBuffer *VulkanBackend::StorageBufferAllocate() {
+  return new VulkanStorageBuffer();
+}
+
 GPURenderTarget *VulkanBackend::RenderTargetAllocate() {
   return new VulkanFramebuffer();
 }
@@ -430,6 +850,10 @@ GPURenderPass *VulkanBackend::RenderPassAllocate() {
 
 GPUShader *VulkanBackend::ShaderAllocate() { return new VulkanShader(); }
 
+GPUComputeShader *VulkanBackend::ComputeShaderAllocate() {
+  return new VulkanComputeShader();
+}
+
 GPUTexture *VulkanBackend::TextureAllocate() { return new VulkanTexture(); }
 
 GPUAttachment *VulkanBackend::AttachmentAllocate() {
@@ -440,24 +864,168 @@ GPUDescriptorSet *VulkanBackend::DescriptorSetAllocate() {
   return new VulkanDescriptorSet();
 }
 
+GPURenderGraph *VulkanBackend::RenderGraphAllocate() {
+  return new VulkanRenderGraph(this);
+}
+
+GPUUpscaler *VulkanBackend::UpscalerAllocate() {
+  return new VulkanUpscaler(this);
+}
+
+GPUPostProcessStack *VulkanBackend::PostProcessStackAllocate() {
+  return new VulkanPostProcessStack(this);
+}
+
 VulkanContext *VulkanBackend::GetContext() { return context; }
 
+bool VulkanBackend::RecreateSwapchain() {
+  int width, height;
+  SDL_Vulkan_GetDrawableSize(window, &width, &height);
+
+  return RecreateSwapchain(width, height);
+}
+
+bool VulkanBackend::RecreateSwapchain(uint32_t width, uint32_t height) {
+  /* minimized, nothing is presented until the window is restored */
+  if (width == 0 || height == 0) {
+    context->swapchain->MarkOutOfDate();
+    return false;
+  }
+
+  VulkanSwapchain *old_swapchain = context->swapchain;
+  VulkanSwapchain *swapchain = new VulkanSwapchain();
+  if (!swapchain->Create(width, height, present_mode, swapchain_image_count,
+                         old_swapchain)) {
+    delete swapchain;
+    return false;
+  }
+  context->swapchain = swapchain;
+
+  /* the frames in flight may still render to and present the old images, so
+   * those are destroyed once their fences are signaled instead of waiting for
+   * the device. The framebuffers go first, they reference the images */
+  for (uint32_t i = 0; i < main_framebuffers.size(); ++i) {
+    context->deletion_queue->Push(DestroyRetiredFramebuffer,
+                                  main_framebuffers[i]);
+  }
+  main_framebuffers.clear();
+  context->deletion_queue->Push(DestroyRetiredSwapchain, old_swapchain);
+
+  VkExtent2D extent = swapchain->GetExtent();
+  main_render_pass->SetRenderArea(
+      glm::vec4(0, 0, extent.width, extent.height));
+  RegenerateFramebuffers();
+
+  context->device->UpdateCommandBuffers();
+
+  /* the fences and semaphores are per frame in flight, which doesn't depend
+   * on the swapchain. The fences of the images stay, since the command
+   * buffers are indexed by the image and may still be executing */
+  context->images_in_flight.resize(swapchain->GetImageCount(), 0);
+
+  return true;
+}
+
+void VulkanBackend::CreateFrameObjects() {
+  context->image_available_semaphores.resize(context->max_frames_in_flight);
+  context->queue_complete_semaphores.resize(context->max_frames_in_flight);
+  context->in_flight_fences.resize(context->max_frames_in_flight);
+  for (uint32_t i = 0; i < context->max_frames_in_flight; ++i) {
+    VkSemaphoreCreateInfo semaphore_create_info = {};
+    semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_create_info.pNext = 0;
+    semaphore_create_info.flags = 0;
+
+    VK_CHECK(vkCreateSemaphore(context->device->GetLogicalDevice(),
+                               &semaphore_create_info, context->allocator,
+                               &context->image_available_semaphores[i]));
+    VK_CHECK(vkCreateSemaphore(context->device->GetLogicalDevice(),
+                               &semaphore_create_info, context->allocator,
+                               &context->queue_complete_semaphores[i]));
+
+    context->in_flight_fences[i] = new VulkanFence();
+    context->in_flight_fences[i]->Create(true);
+  }
+
+  context->images_in_flight.resize(context->swapchain->GetImageCount());
+  for (uint32_t i = 0; i < context->images_in_flight.size(); ++i) {
+    context->images_in_flight[i] = 0;
+  }
+}
+
+void VulkanBackend::DestroyFrameObjects() {
+  for (uint32_t i = 0; i < context->max_frames_in_flight; ++i) {
+    vkDestroySemaphore(context->device->GetLogicalDevice(),
+                       context->image_available_semaphores[i],
+                       context->allocator);
+    vkDestroySemaphore(context->device->GetLogicalDevice(),
+                       context->queue_complete_semaphores[i],
+                       context->allocator);
+    context->in_flight_fences[i]->Destroy();
+    delete context->in_flight_fences[i];
+  }
+  context->image_available_semaphores.clear();
+  context->queue_complete_semaphores.clear();
+  context->in_flight_fences.clear();
+  context->images_in_flight.clear();
+}
+
+void VulkanBackend::LimitFrameRate() {
+  if (!frame_rate_limit) {
+    return;
+  }
+
+  uint64_t frequency = SDL_GetPerformanceFrequency();
+  uint64_t period = frequency / frame_rate_limit;
+
+  /* the previous frame is displayed before the next one starts, so the input
+   * of the frame is as recent as it can be. Bounded by the period, in case
+   * the image is never displayed */
+  uint64_t present_id = context->swapchain->GetPresentId();
+  if (vkWaitForPresent && present_id) {
+    uint64_t timeout_ns = 1000000000ull / frame_rate_limit;
+    VkResult result =
+        vkWaitForPresent(context->device->GetLogicalDevice(),
+                         context->swapchain->GetHandle(), present_id,
+                         timeout_ns);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+      context->swapchain->MarkOutOfDate();
+    }
+  }
+
+  uint64_t now = SDL_GetPerformanceCounter();
+  if (frame_deadline > now) {
+    /* SDL_Delay is only precise to a few milliseconds, so the rest is spun */
+    uint64_t remaining_ms = (frame_deadline - now) * 1000 / frequency;
+    if (remaining_ms > 2) {
+      SDL_Delay(remaining_ms - 2);
+    }
+    while (SDL_GetPerformanceCounter() < frame_deadline) {
+    }
+    now = frame_deadline;
+  }
+
+  /* a frame that took longer than the period doesn't make the next ones
+   * faster to catch up */
+  if (!frame_deadline || now - frame_deadline >= period) {
+    frame_deadline = now + period;
+  } else {
+    frame_deadline += period;
+  }
+}
+
 void VulkanBackend::RegenerateFramebuffers() {
   std::vector<GPUAttachment *> &color_attachments =
       context->swapchain->GetColorAttachments();
-  VulkanAttachment &depth_attachment = context->swapchain->GetDepthAttachment();
+  VulkanAttachment *depth_attachment = context->swapchain->GetDepthAttachment();
   glm::vec4 &render_area = main_render_pass->GetRenderArea();
+  main_framebuffers.resize(context->swapchain->GetImageCount());
   for (uint32_t i = 0; i < main_framebuffers.size(); ++i) {
     std::vector<GPUAttachment *> attachments;
     attachments.emplace_back(color_attachments[i]);
-    attachments.emplace_back(&depth_attachment);
-
-    if (!main_framebuffers[i]) {
-      main_framebuffers[i] = RenderTargetAllocate();
-    } else {
-      main_framebuffers[i]->Destroy();
-    }
+    attachments.emplace_back(depth_attachment);
 
+    main_framebuffers[i] = RenderTargetAllocate();
     main_framebuffers[i]->Create(main_render_pass, attachments, render_area.z,
                                  render_area.w);
   }
@@ -14,16 +14,43 @@ public:
   void Shutdown() override;
 
   void Resize(uint32_t width, uint32_t height) override;
+  void SetPresentMode(GPUPresentMode new_present_mode) override;
+  GPUPresentMode GetPresentMode() override;
+  void SetSwapchainImageCount(uint32_t image_count) override;
+  uint32_t GetSwapchainImageCount() override;
+  void SetMaxFramesInFlight(uint32_t max_frames_in_flight) override;
+  void SetFrameRateLimit(uint32_t frames_per_second) override;
 
   bool BeginFrame() override;
   bool EndFrame() override;
   bool Draw(uint32_t element_count) override;
   bool DrawIndexed(uint32_t element_count) override;
+  bool Dispatch(uint32_t group_count_x, uint32_t group_count_y,
+                uint32_t group_count_z) override;
+  bool DispatchIndirect(GPUStorageBuffer *buffer, uint64_t offset) override;
+  void PipelineBarrier(GPUBarrierType type) override;
+  bool BeginAsyncCompute(std::vector<GPUAttachment *> &attachments) override;
+  bool EndAsyncCompute() override;
 
   GPURenderPass *GetWindowRenderPass() override;
   GPURenderTarget *GetCurrentWindowRenderTarget() override;
+  GPURenderTargetPool *GetRenderTargetPool() override;
   uint32_t GetCurrentFrameIndex() override;
   uint32_t GetMaxFramesInFlight() override;
+  float GetGPUFrameTime() override;
+  bool IsBindlessSupported() override;
+  bool IsAsyncComputeSupported() override;
+
+  void SetCullMode(GPUShaderCullMode cull_mode) override;
+  void SetFrontFace(GPUShaderFrontFace front_face) override;
+  void SetPrimitiveTopology(GPUShaderTopologyType topology_type) override;
+  void SetDepthTestEnable(bool enable) override;
+  void SetDepthWriteEnable(bool enable) override;
+  void SetDepthCompareOperation(
+      GPUShaderCompareOperation compare_operation) override;
+  void SetStencilTestEnable(bool enable) override;
+  void SetStencilState(GPUShaderStencilState *front,
+                       GPUShaderStencilState *back) override;
 
   void BeginDebugRegion(const char *name, glm::vec4 color) override;
   void InsertDebugMarker(const char *name, glm::vec4 color) override;
@@ -32,14 +59,22 @@ public:
   GPUVertexBuffer *VertexBufferAllocate() override;
   GPUIndexBuffer *IndexBufferAllocate() override;
   GPUUniformBuffer *UniformBufferAllocate() override;
+  GPUStorageBuffer *StorageBufferAllocate() override;
   GPURenderTarget *RenderTargetAllocate() override;
   GPURenderPass *RenderPassAllocate() override;
   GPUShader *ShaderAllocate() override;
+  GPUComputeShader *ComputeShaderAllocate() override;
   GPUTexture *TextureAllocate() override;
   GPUAttachment *AttachmentAllocate() override;
   GPUDescriptorSet *DescriptorSetAllocate() override;
+  GPURenderGraph *RenderGraphAllocate() override;
+  GPUUpscaler *UpscalerAllocate() override;
+  GPUPostProcessStack *PostProcessStackAllocate() override;
 
   static VulkanContext *GetContext();
+  /* forgets the state bound to the graphics command buffer, once recording
+   * starts in a new one */
+  static void ResetBoundState();
 
 private:
   bool CreateInstance(VkApplicationInfo application_info, SDL_Window *window,
@@ -50,11 +85,28 @@ private:
   bool
   RequiredExtensionsAvailable(std::vector<const char *> required_extensions);
 
+  /* to the drawable size of the window */
+  bool RecreateSwapchain();
+  bool RecreateSwapchain(uint32_t width, uint32_t height);
+  /* for the current swapchain images */
   void RegenerateFramebuffers();
+  /* semaphores and fences of the frames in flight */
+  void CreateFrameObjects();
+  void DestroyFrameObjects();
+  /* waits until the next frame is due */
+  void LimitFrameRate();
 
   static VulkanContext *context;
   SDL_Window *window;
 
   GPURenderPass *main_render_pass;
   std::vector<GPURenderTarget *> main_framebuffers;
+
+  /* requested, the swapchain may fall back to others */
+  GPUPresentMode present_mode;
+  uint32_t swapchain_image_count;
+  uint32_t frame_rate_limit;
+  /* performance counter value the next frame is due at */
+  uint64_t frame_deadline;
+  PFN_vkWaitForPresentKHR vkWaitForPresent;
 };
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "vulkan_bindless_textures.h"
+
+#include "../../logger.h"
+#include "../gpu_texture.h"
+#include "vulkan_backend.h"
+
+#include <algorithm>
+
+/* enough for a scene like sponza several times over */
+#define BINDLESS_TEXTURES_MAX_CAPACITY 4096
+
+void VulkanBindlessTextures::Initialize() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  active = false;
+  capacity = 0;
+  layout = 0;
+  pool = 0;
+  set = 0;
+  next_index = 0;
+  free_indices.clear();
+
+  if (!context->device->GetOptionalFeatures().descriptor_indexing) {
+    return;
+  }
+
+  VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties = {};
+  indexing_properties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+  indexing_properties.pNext = 0;
+  VkPhysicalDeviceProperties2 properties = {};
+  properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties.pNext = &indexing_properties;
+  vkGetPhysicalDeviceProperties2(context->device->GetPhysicalDevice(),
+                                 &properties);
+
+  capacity = std::min<uint32_t>(
+      BINDLESS_TEXTURES_MAX_CAPACITY,
+      std::min(
+          indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+          indexing_properties
+              .maxPerStageDescriptorUpdateAfterBindSampledImages));
+  capacity = std::min(
+      capacity,
+      indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers);
+
+  VkDescriptorSetLayoutBinding binding = {};
+  binding.binding = 0;
+  binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  binding.descriptorCount = capacity;
+  binding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+  binding.pImmutableSamplers = 0;
+
+  /* textures are registered while frames using other slots are in flight */
+  VkDescriptorBindingFlagsEXT binding_flags =
+      VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+      VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+      VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+  VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_create_info =
+      {};
+  binding_flags_create_info.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+  binding_flags_create_info.pNext = 0;
+  binding_flags_create_info.bindingCount = 1;
+  binding_flags_create_info.pBindingFlags = &binding_flags;
+
+  VkDescriptorSetLayoutCreateInfo layout_create_info = {};
+  layout_create_info.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_create_info.pNext = &binding_flags_create_info;
+  layout_create_info.flags =
+      VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+  layout_create_info.bindingCount = 1;
+  layout_create_info.pBindings = &binding;
+  VK_CHECK(vkCreateDescriptorSetLayout(context->device->GetLogicalDevice(),
+                                       &layout_create_info, context->allocator,
+                                       &layout));
+
+  VkDescriptorPoolSize pool_size = {};
+  pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  pool_size.descriptorCount = capacity;
+
+  VkDescriptorPoolCreateInfo pool_create_info = {};
+  pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_create_info.pNext = 0;
+  pool_create_info.flags =
+      VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+  pool_create_info.maxSets = 1;
+  pool_create_info.poolSizeCount = 1;
+  pool_create_info.pPoolSizes = &pool_size;
+  VK_CHECK(vkCreateDescriptorPool(context->device->GetLogicalDevice(),
+                                  &pool_create_info, context->allocator,
+                                  &pool));
+
+  VkDescriptorSetAllocateInfo set_allocate_info = {};
+  set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  set_allocate_info.pNext = 0;
+  set_allocate_info.descriptorPool = pool;
+  set_allocate_info.descriptorSetCount = 1;
+  set_allocate_info.pSetLayouts = &layout;
+  VK_CHECK(vkAllocateDescriptorSets(context->device->GetLogicalDevice(),
+                                    &set_allocate_info, &set));
+
+  active = true;
+
+  DEBUG("Bindless texture table holds %u textures", capacity);
+}
+
+void VulkanBindlessTextures::Shutdown() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (pool) {
+    vkDestroyDescriptorPool(context->device->GetLogicalDevice(), pool,
+                            context->allocator);
+  }
+  if (layout) {
+    vkDestroyDescriptorSetLayout(context->device->GetLogicalDevice(), layout,
+                                 context->allocator);
+  }
+
+  active = false;
+  pool = 0;
+  layout = 0;
+  set = 0;
+  free_indices.clear();
+}
+
+uint32_t VulkanBindlessTextures::Register(VkImageView view,
+                                          VkSampler sampler) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (!active) {
+    return GPU_BINDLESS_INDEX_NONE;
+  }
+
+  uint32_t index;
+  if (!free_indices.empty()) {
+    index = free_indices.back();
+    free_indices.pop_back();
+  } else if (next_index < capacity) {
+    index = next_index++;
+  } else {
+    WARN("Bindless texture table is full!");
+    return GPU_BINDLESS_INDEX_NONE;
+  }
+
+  VkDescriptorImageInfo image_info = {};
+  image_info.sampler = sampler;
+  image_info.imageView = view;
+  image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  /* the set may be bound already, which update after bind allows */
+  VkWriteDescriptorSet write_descriptor_set = {};
+  write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write_descriptor_set.pNext = 0;
+  write_descriptor_set.dstSet = set;
+  write_descriptor_set.dstBinding = 0;
+  write_descriptor_set.dstArrayElement = index;
+  write_descriptor_set.descriptorCount = 1;
+  write_descriptor_set.descriptorType =
+      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  write_descriptor_set.pImageInfo = &image_info;
+  write_descriptor_set.pBufferInfo = 0;
+  write_descriptor_set.pTexelBufferView = 0;
+  vkUpdateDescriptorSets(context->device->GetLogicalDevice(), 1,
+                         &write_descriptor_set, 0, 0);
+
+  return index;
+}
+
+void VulkanBindlessTextures::Unregister(uint32_t index) {
+  if (!active || index == GPU_BINDLESS_INDEX_NONE) {
+    return;
+  }
+
+  /* the slot is partially bound, so it may be left stale until reused */
+  free_indices.emplace_back(index);
+}
\ No newline at end of file
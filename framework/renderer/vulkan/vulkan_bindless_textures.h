@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+/* One large, partially bound array of combined image samplers holding every
+ * 2D texture, if VK_EXT_descriptor_indexing is supported. Textures keep their
+ * index for their whole lifetime, and shaders select them by that index
+ * instead of binding a set per material. The set is declared in glsl as a
+ * runtime sized "sampler2D textures[]" array, alone in its set */
+class VulkanBindlessTextures {
+public:
+  void Initialize();
+  void Shutdown();
+
+  inline bool IsActive() const { return active; }
+
+  /* returns the index of the texture in the table */
+  uint32_t Register(VkImageView view, VkSampler sampler);
+  void Unregister(uint32_t index);
+
+  inline VkDescriptorSetLayout GetLayout() const { return layout; }
+  inline VkDescriptorSet GetSet() const { return set; }
+  inline uint32_t GetCapacity() const { return capacity; }
+
+private:
+  bool active;
+  uint32_t capacity;
+  VkDescriptorSetLayout layout;
+  VkDescriptorPool pool;
+  VkDescriptorSet set;
+
+  uint32_t next_index;
+  std::vector<uint32_t> free_indices;
+};
\ No newline at end of file
@@ -20,10 +20,18 @@ bool VulkanBuffer::Create(uint64_t buffer_size, VkBufferUsageFlags usage_flags,
   buffer_create_info.flags = 0;
   buffer_create_info.size = total_size;
   buffer_create_info.usage = usage_flags;
-  /* TODO: only used in one queue. */
-  buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-  buffer_create_info.queueFamilyIndexCount = 0;
-  buffer_create_info.pQueueFamilyIndices = 0;
+  /* buffers may be used by the async compute queue. Concurrent sharing
+   * saves the ownership transfers, and costs next to nothing for buffers */
+  uint32_t queue_family_indices[2];
+  buffer_create_info.queueFamilyIndexCount =
+      context->device->GetConcurrentQueueFamilyIndices(queue_family_indices);
+  if (buffer_create_info.queueFamilyIndexCount) {
+    buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    buffer_create_info.pQueueFamilyIndices = queue_family_indices;
+  } else {
+    buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    buffer_create_info.pQueueFamilyIndices = 0;
+  }
 
   VmaAllocationCreateInfo vma_allocation_create_info = {};
   /* vma_allocation_create_info.flags; */
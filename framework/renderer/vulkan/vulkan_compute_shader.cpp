@@ -0,0 +1,398 @@
+#include "vulkan_compute_shader.h"
+
+#include "../../logger.h"
+#include "vulkan_backend.h"
+#include "vulkan_context.h"
+#include "vulkan_debug_marker.h"
+#include "vulkan_descriptor_builder.h"
+#include "vulkan_descriptor_set.h"
+#include "vulkan_utils.h"
+
+#include <spirv_cross/spirv.hpp>
+#include <spirv_cross/spirv_glsl.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+
+bool VulkanComputeShader::Create(GPUComputeShaderConfig *config) {
+  if (config->keywords.size() > 32) {
+    ERROR("Shader variant mask can hold only 32 keywords!");
+    return false;
+  }
+
+  stage.type = GPU_SHADER_STAGE_TYPE_COMPUTE;
+  stage.file_path = config->file_path;
+  VulkanShader::LoadStageKeywords(stage);
+
+  keywords.clear();
+  for (uint32_t i = 0; i < config->keywords.size(); ++i) {
+    keywords.emplace_back(config->keywords[i]);
+  }
+
+  push_descriptor_set_mask = config->push_descriptor_set_mask;
+  debug_name.clear();
+
+  variant_mask = 0;
+  variants.clear();
+  failed_variants.clear();
+  variant = &variants[0];
+  *variant = {};
+  if (!CreateVariant(0, variant)) {
+    variants.clear();
+    variant = 0;
+    return false;
+  }
+
+#ifdef RF3D_SHADER_HOT_RELOAD
+  VulkanContext *context = VulkanBackend::GetContext();
+  if (context->shader_hot_reload) {
+    context->shader_hot_reload->Register(this);
+  }
+#endif
+
+  return true;
+}
+
+bool VulkanComputeShader::CreateVariant(uint32_t variant_mask,
+                                        VulkanComputeVariant *out_variant) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  std::string file_path =
+      VulkanShader::GetStageVariantPath(stage, keywords, variant_mask);
+  FILE *file = fopen(file_path.c_str(), "rb");
+  if (!file) {
+    ERROR("Failed to open file %s", file_path.c_str());
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  int64_t file_size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  std::vector<uint32_t> file_data;
+  file_data.resize(file_size);
+  fread(&file_data[0], file_size, 1, file);
+  fclose(file);
+
+  /* reflect the spirv binary */
+  spirv_cross::Compiler compiler(file_data.data(),
+                                 file_data.size() / sizeof(uint32_t));
+  spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+  std::vector<VkPushConstantRange> push_constant_ranges;
+  std::vector<VulkanShader::VulkanShaderSet> sets;
+  VulkanShader::ReflectStagePushConstantRanges(
+      compiler, resources, VK_SHADER_STAGE_COMPUTE_BIT, push_constant_ranges);
+  VulkanShader::ReflectStageUniforms(compiler, resources,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, sets);
+  VulkanShader::FinalizeDescriptorSetsReflection(sets);
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    out_variant->workgroup_size[i] =
+        compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, i);
+  }
+
+  std::vector<VkDescriptorSetLayout> descriptor_set_layouts;
+  int32_t bindless_set_index = -1;
+  if (!VulkanShader::CreateDescriptorSetLayouts(
+          sets, push_descriptor_set_mask, descriptor_set_layouts,
+          &bindless_set_index)) {
+    return false;
+  }
+  /* the table is visible to the graphics stages only */
+  if (bindless_set_index != -1) {
+    ERROR("Compute shaders can't use the bindless texture table!");
+    return false;
+  }
+
+  VkShaderModuleCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  create_info.pNext = 0;
+  create_info.flags = 0;
+  create_info.codeSize = file_size;
+  create_info.pCode = &file_data[0];
+
+  VkShaderModule module;
+  VK_CHECK(vkCreateShaderModule(context->device->GetLogicalDevice(),
+                                &create_info, 0, &module));
+
+  VkPipelineShaderStageCreateInfo stage_create_info = {};
+  stage_create_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stage_create_info.pNext = 0;
+  stage_create_info.flags = 0;
+  stage_create_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  stage_create_info.module = module;
+  stage_create_info.pName = "main";
+
+  VulkanPipelineConfig pipeline_config;
+  pipeline_config.stages.emplace_back(stage_create_info);
+  pipeline_config.descriptor_set_layouts = descriptor_set_layouts;
+  pipeline_config.push_constant_ranges = push_constant_ranges;
+
+  VulkanPipeline *out_pipeline = &out_variant->pipeline;
+  bool result = out_pipeline->CreateCompute(&pipeline_config);
+
+  vkDestroyShaderModule(context->device->GetLogicalDevice(), module,
+                        context->allocator);
+
+  if (result && !debug_name.empty()) {
+    out_pipeline->SetDebugName(debug_name.c_str());
+  }
+
+  return result;
+}
+
+void VulkanComputeShader::Destroy() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+
+  for (auto it = variants.begin(); it != variants.end(); ++it) {
+    if (it->second.pipeline.GetHandle()) {
+      it->second.pipeline.Destroy();
+    }
+  }
+  variants.clear();
+  failed_variants.clear();
+  variant = 0;
+
+  if (context->bound_compute_shader == this) {
+    context->bound_compute_shader = 0;
+  }
+
+#ifdef RF3D_SHADER_HOT_RELOAD
+  if (context->shader_hot_reload) {
+    context->shader_hot_reload->Unregister(this);
+  }
+#endif
+}
+
+void VulkanComputeShader::SetVariant(uint32_t variant_mask) {
+  if (variant_mask >> keywords.size()) {
+    WARN("Shader variant mask %u uses undeclared keywords!", variant_mask);
+  }
+
+  this->variant_mask = variant_mask;
+
+  auto it = variants.find(variant_mask);
+  variant = it != variants.end() ? &it->second : 0;
+}
+
+VulkanComputeShader::VulkanComputeVariant *
+VulkanComputeShader::GetCurrentVariant() {
+  if (variant) {
+    return variant;
+  }
+
+  if (failed_variants.count(variant_mask)) {
+    variant = &variants.at(0);
+    return variant;
+  }
+
+  variant = &variants[variant_mask];
+  *variant = {};
+  if (!CreateVariant(variant_mask, variant)) {
+    ERROR("Failed to create shader variant %u, falling back to the base "
+          "variant",
+          variant_mask);
+    variants.erase(variant_mask);
+    failed_variants.insert(variant_mask);
+    variant = &variants.at(0);
+  }
+
+  return variant;
+}
+
+bool VulkanComputeShader::UsesStageSource(const std::string &file_name) {
+  return VulkanShader::IsStageSource(stage, file_name);
+}
+
+bool VulkanComputeShader::Reload() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanShader::LoadStageKeywords(stage);
+
+  /* only the variants that were in use are rebuilt, the rest is created
+   * lazily as usual */
+  std::unordered_map<uint32_t, VulkanComputeVariant> reloaded_variants;
+  for (auto it = variants.begin(); it != variants.end(); ++it) {
+    VulkanComputeVariant *reloaded_variant = &reloaded_variants[it->first];
+    *reloaded_variant = {};
+    if (!CreateVariant(it->first, reloaded_variant)) {
+      ERROR("Failed to reload shader variant %u, keeping the old pipelines",
+            it->first);
+      for (auto &pair : reloaded_variants) {
+        if (pair.second.pipeline.GetHandle()) {
+          pair.second.pipeline.Destroy();
+        }
+      }
+      return false;
+    }
+  }
+
+  for (auto it = variants.begin(); it != variants.end(); ++it) {
+    if (it->second.pipeline.GetHandle()) {
+      it->second.pipeline.Destroy();
+    }
+  }
+  variants.swap(reloaded_variants);
+  /* the source changed, so the broken variants may build now */
+  failed_variants.clear();
+
+  auto it = variants.find(variant_mask);
+  variant = it != variants.end() ? &it->second : 0;
+  if (context->bound_compute_shader == this) {
+    context->bound_compute_shader = 0;
+  }
+
+  return true;
+}
+
+void VulkanComputeShader::Bind() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(context->compute_queue_type);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  /* the compute bind point has a state of its own, so the graphics binds
+   * are left untouched */
+  GetVariantPipeline()->Bind(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+  context->bound_compute_shader = this;
+}
+
+void VulkanComputeShader::BindUniformBuffer(GPUDescriptorSet *set,
+                                            uint32_t offset,
+                                            int32_t set_index) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(context->compute_queue_type);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  VulkanDescriptorSet *native_set = (VulkanDescriptorSet *)set;
+
+  vkCmdBindDescriptorSets(command_buffer->GetHandle(),
+                          VK_PIPELINE_BIND_POINT_COMPUTE,
+                          GetVariantPipeline()->GetLayout(), set_index, 1,
+                          &native_set->GetSet(), 1, &offset);
+}
+
+void VulkanComputeShader::BindDescriptorSet(GPUDescriptorSet *set,
+                                            int32_t set_index) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(context->compute_queue_type);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  VulkanDescriptorSet *native_set = (VulkanDescriptorSet *)set;
+
+  vkCmdBindDescriptorSets(command_buffer->GetHandle(),
+                          VK_PIPELINE_BIND_POINT_COMPUTE,
+                          GetVariantPipeline()->GetLayout(), set_index, 1,
+                          &native_set->GetSet(), 0, 0);
+}
+
+void VulkanComputeShader::PushDescriptorSet(
+    int32_t set_index, std::vector<GPUDescriptorBinding> &bindings,
+    uint32_t uniform_buffer_offset) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(context->compute_queue_type);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  VkDescriptorSetLayout set_layout = GetDescriptorSetLayout(set_index);
+  if (!set_layout) {
+    ERROR("Shader has no descriptor set %d!", set_index);
+    return;
+  }
+  VkPipelineLayout layout = GetVariantPipeline()->GetLayout();
+
+  VulkanDescriptorBuilder builder = VulkanDescriptorBuilder::Begin();
+  VulkanDescriptorSetCache::DescriptorSetInfo set_info;
+  set_info.layout = set_layout;
+
+  if (context->layout_cache->IsPushDescriptorLayout(set_layout)) {
+    VulkanDescriptorSet::GatherBindings(bindings, uniform_buffer_offset,
+                                        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                        builder, set_info);
+    builder.Push(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout,
+                 set_index, set_layout);
+    return;
+  }
+
+  if (!(push_descriptor_set_mask & (1 << set_index))) {
+    WARN("Descriptor set %d is not marked for push descriptors!", set_index);
+  }
+
+  VulkanDescriptorSet::GatherBindings(bindings, 0,
+                                      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                                      builder, set_info);
+  VkDescriptorSet set;
+  if (!builder.BuildTransient(set_layout, &set)) {
+    return;
+  }
+
+  std::vector<uint32_t> offsets;
+  for (uint32_t i = 0; i < set_info.resources.size(); ++i) {
+    if (set_info.resources[i].type ==
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+      offsets.emplace_back(uniform_buffer_offset);
+    }
+  }
+
+  vkCmdBindDescriptorSets(command_buffer->GetHandle(),
+                          VK_PIPELINE_BIND_POINT_COMPUTE, layout, set_index, 1,
+                          &set, offsets.size(), offsets.data());
+}
+
+void VulkanComputeShader::PushConstant(void *value, uint64_t size,
+                                       uint32_t offset) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(context->compute_queue_type);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  if (!GetVariantPipeline()->PushConstants(command_buffer, value, offset,
+                                           size)) {
+    WARN("Push constant range %u-%u isn't used by the shader!", offset,
+         offset + size);
+  }
+}
+
+void VulkanComputeShader::GetWorkgroupSize(uint32_t *out_x, uint32_t *out_y,
+                                           uint32_t *out_z) {
+  VulkanComputeVariant *current_variant = GetCurrentVariant();
+  *out_x = current_variant->workgroup_size[0];
+  *out_y = current_variant->workgroup_size[1];
+  *out_z = current_variant->workgroup_size[2];
+}
+
+void VulkanComputeShader::SetDebugName(const char *name) {
+  debug_name = name;
+
+  for (auto it = variants.begin(); it != variants.end(); ++it) {
+    it->second.pipeline.SetDebugName(name);
+  }
+}
+
+void VulkanComputeShader::SetDebugTag(const void *tag, size_t tag_size) {
+  for (auto it = variants.begin(); it != variants.end(); ++it) {
+    VulkanDebugUtils::SetObjectTag(tag,
+                                   (uint64_t)it->second.pipeline.GetHandle(),
+                                   VK_OBJECT_TYPE_PIPELINE, 0, tag_size);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../gpu_compute_shader.h"
+#include "vulkan_pipeline.h"
+#include "vulkan_shader.h"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+class VulkanComputeShader : public GPUComputeShader {
+public:
+  bool Create(GPUComputeShaderConfig *config) override;
+  void Destroy() override;
+
+  void SetVariant(uint32_t variant_mask) override;
+
+  void Bind() override;
+  void BindUniformBuffer(GPUDescriptorSet *set, uint32_t offset,
+                         int32_t set_index) override;
+  void BindDescriptorSet(GPUDescriptorSet *set, int32_t set_index) override;
+  void PushDescriptorSet(int32_t set_index,
+                         std::vector<GPUDescriptorBinding> &bindings,
+                         uint32_t uniform_buffer_offset) override;
+  void PushConstant(void *value, uint64_t size, uint32_t offset) override;
+
+  void GetWorkgroupSize(uint32_t *out_x, uint32_t *out_y,
+                        uint32_t *out_z) override;
+
+  void SetDebugName(const char *name) override;
+  void SetDebugTag(const void *tag, size_t tag_size) override;
+
+  /* file_name is the name of a glsl source, like "particle_update.comp" */
+  bool UsesStageSource(const std::string &file_name);
+  /* recreates every variant of the shader from the stage file. The old
+   * pipelines are kept if any of them fails */
+  bool Reload();
+
+  /* layout of the set in the current variant */
+  inline VkDescriptorSetLayout GetDescriptorSetLayout(uint32_t set_index) {
+    return GetVariantPipeline()->GetDescriptorSetLayout(set_index);
+  }
+
+private:
+  struct VulkanComputeVariant {
+    VulkanPipeline pipeline;
+    /* local_size, which may depend on the keywords */
+    uint32_t workgroup_size[3];
+  };
+
+  bool CreateVariant(uint32_t variant_mask, VulkanComputeVariant *out_variant);
+  VulkanComputeVariant *GetCurrentVariant();
+  inline VulkanPipeline *GetVariantPipeline() {
+    return &GetCurrentVariant()->pipeline;
+  }
+
+  VulkanShader::VulkanShaderStage stage;
+  std::vector<std::string> keywords;
+  uint32_t push_descriptor_set_mask;
+  std::string debug_name;
+
+  std::unordered_map<uint32_t, VulkanComputeVariant> variants;
+  /* variant masks that failed to build. They fall back to the base variant
+   * without being built again, until the shader is reloaded */
+  std::unordered_set<uint32_t> failed_variants;
+  /* 0 until the current variant is first used */
+  VulkanComputeVariant *variant;
+};
\ No newline at end of file
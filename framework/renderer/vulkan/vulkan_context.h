@@ -1,21 +1,36 @@
 #pragma once
 
+#include "vulkan_async_compute.h"
+#include "vulkan_bindless_textures.h"
 #include "vulkan_command_buffer.h"
+#include "vulkan_deletion_queue.h"
 #include "vulkan_descriptor_layout_cache.h"
 #include "vulkan_descriptor_pools.h"
+#include "vulkan_descriptor_set_cache.h"
 #include "vulkan_device.h"
 #include "vulkan_fence.h"
+#include "vulkan_frame_timer.h"
+#include "vulkan_pipeline_library.h"
+#include "vulkan_render_target_pool.h"
 #include "vulkan_swapchain.h"
+#ifdef RF3D_SHADER_HOT_RELOAD
+#include "vulkan_shader_hot_reload.h"
+#endif
 
 #include "vk_mem_alloc.h"
 #include <assert.h>
 #include <vector>
 #include <vulkan/vulkan.h>
 
+class VulkanShader;
+class VulkanComputeShader;
+
 /* TODO: get rid of that macro and handle errors by our own */
 #define VK_CHECK(result)                                                       \
   { assert(result == VK_SUCCESS); }
 
+#define VULKAN_MAX_BOUND_DESCRIPTOR_SETS 8
+
 class VulkanContext {
 public:
   VkInstance instance;
@@ -34,8 +49,35 @@ public:
 
   uint32_t image_index;
   uint32_t current_frame;
+  /* count of the per frame objects, current_frame cycles through them */
+  uint32_t max_frames_in_flight;
 
-  /* TODO: VkPipelineCache */
+  /* state of the current command buffer, used to change the draw state of the
+   * bound shader and to skip redundant pipeline binds */
+  VulkanShader *bound_shader;
+  VkPipeline bound_pipeline;
+  /* descriptor sets bound without dynamic offsets, with the layout they were
+   * bound with */
+  VkDescriptorSet bound_descriptor_sets[VULKAN_MAX_BOUND_DESCRIPTOR_SETS];
+  VkPipelineLayout bound_descriptor_set_layouts
+      [VULKAN_MAX_BOUND_DESCRIPTOR_SETS];
+  /* the compute bind point has a state of its own */
+  VulkanComputeShader *bound_compute_shader;
+  /* queue the compute commands are recorded for, the compute queue while
+   * async compute is recorded */
+  VulkanDeviceQueueType compute_queue_type;
+
+  VkPipelineCache pipeline_cache;
+  VulkanPipelineLibrary *pipeline_library;
   VulkanDescriptorPools *descriptor_pools;
   VulkanDescriptorLayoutCache *layout_cache;
+  VulkanDescriptorSetCache *descriptor_set_cache;
+  VulkanBindlessTextures *bindless_textures;
+  VulkanAsyncCompute *async_compute;
+  VulkanRenderTargetPool *render_target_pool;
+  VulkanDeletionQueue *deletion_queue;
+  VulkanFrameTimer *frame_timer;
+#ifdef RF3D_SHADER_HOT_RELOAD
+  VulkanShaderHotReload *shader_hot_reload;
+#endif
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "vulkan_deletion_queue.h"
+
+void VulkanDeletionQueue::Initialize() {
+  entries.clear();
+  submitted_frame_count = 0;
+}
+
+void VulkanDeletionQueue::Shutdown() {
+  for (uint32_t i = 0; i < entries.size(); ++i) {
+    entries[i].callback(entries[i].object);
+  }
+  entries.clear();
+}
+
+void VulkanDeletionQueue::Push(VulkanDeletionCallback callback,
+                               void *object) {
+  VulkanDeletionQueueEntry entry;
+  entry.callback = callback;
+  entry.object = object;
+  entry.submitted_frame = submitted_frame_count;
+  entries.emplace_back(entry);
+}
+
+void VulkanDeletionQueue::Update(uint32_t frames_in_flight) {
+  /* the frame about to be recorded reuses the fence of the frame submitted
+   * frames_in_flight frames ago, so that one and all the frames before it
+   * are completed */
+  if (submitted_frame_count + 1 < frames_in_flight) {
+    return;
+  }
+  uint64_t completed_frame = submitted_frame_count + 1 - frames_in_flight;
+
+  /* the objects are destroyed in the order they were pushed */
+  uint32_t destroyed_count = 0;
+  while (destroyed_count < entries.size() &&
+         entries[destroyed_count].submitted_frame <= completed_frame) {
+    entries[destroyed_count].callback(entries[destroyed_count].object);
+    ++destroyed_count;
+  }
+  entries.erase(entries.begin(), entries.begin() + destroyed_count);
+}
+
+void VulkanDeletionQueue::FrameSubmitted() { ++submitted_frame_count; }
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+/* destroys the object, once the device no longer uses it */
+typedef void (*VulkanDeletionCallback)(void *object);
+
+/* Defers the destruction of the objects that may still be used by the frames
+ * in flight, until the fences of those frames are signaled. Unlike the
+ * Destroy of the resources, it never waits for the device to go idle */
+class VulkanDeletionQueue {
+public:
+  void Initialize();
+  /* destroys everything left, the device has to be idle */
+  void Shutdown();
+
+  void Push(VulkanDeletionCallback callback, void *object);
+
+  /* once per frame, after the fence of the frame is waited for */
+  void Update(uint32_t frames_in_flight);
+  /* after the submit of the frame */
+  void FrameSubmitted();
+
+private:
+  struct VulkanDeletionQueueEntry {
+    VulkanDeletionCallback callback;
+    void *object;
+    /* frames submitted when it was pushed, the last of them may use it */
+    uint64_t submitted_frame;
+  };
+
+  std::vector<VulkanDeletionQueueEntry> entries;
+  uint64_t submitted_frame_count;
+};
\ No newline at end of file
@@ -10,16 +10,7 @@ VulkanDescriptorBuilder VulkanDescriptorBuilder::Begin() {
 
 VulkanDescriptorBuilder &VulkanDescriptorBuilder::BindBuffer(
     uint32_t binding, VkDescriptorBufferInfo *buffer_info,
-    VkDescriptorType type, VkShaderStageFlags stage_flags) {
-  VkDescriptorSetLayoutBinding layout_binding = {};
-  layout_binding.binding = binding;
-  layout_binding.descriptorType = type;
-  layout_binding.descriptorCount = 1;
-  layout_binding.stageFlags = stage_flags;
-  layout_binding.pImmutableSamplers = nullptr;
-
-  bindings.emplace_back(layout_binding);
-
+    VkDescriptorType type) {
   VkWriteDescriptorSet write_descriptor_set = {};
   write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
   write_descriptor_set.pNext = nullptr;
@@ -28,26 +19,43 @@ VulkanDescriptorBuilder &VulkanDescriptorBuilder::BindBuffer(
   write_descriptor_set.dstArrayElement = 0;
   write_descriptor_set.descriptorCount = 1;
   write_descriptor_set.descriptorType = type;
-  write_descriptor_set.pImageInfo = 0;
-  write_descriptor_set.pBufferInfo = buffer_info;
+  /* write_descriptor_set.pImageInfo; set later */
+  /* write_descriptor_set.pBufferInfo; set later */
   write_descriptor_set.pTexelBufferView = 0;
 
+  VulkanDescriptorInfo info = {};
+  info.buffer = *buffer_info;
+
   writes.emplace_back(write_descriptor_set);
+  infos.emplace_back(info);
   return *this;
 }
 
 VulkanDescriptorBuilder &VulkanDescriptorBuilder::BindImage(
-    uint32_t binding, VkDescriptorImageInfo *image_info, VkDescriptorType type,
-    VkShaderStageFlags stage_flags) {
-  VkDescriptorSetLayoutBinding layout_binding = {};
-  layout_binding.binding = binding;
-  layout_binding.descriptorType = type;
-  layout_binding.descriptorCount = 1;
-  layout_binding.stageFlags = stage_flags;
-  layout_binding.pImmutableSamplers = nullptr;
+    uint32_t binding, VkDescriptorImageInfo *image_info,
+    VkDescriptorType type) {
+  VkWriteDescriptorSet write_descriptor_set = {};
+  write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write_descriptor_set.pNext = nullptr;
+  /* write_descriptor_set.dstSet; set later */
+  write_descriptor_set.dstBinding = binding;
+  write_descriptor_set.dstArrayElement = 0;
+  write_descriptor_set.descriptorCount = 1;
+  write_descriptor_set.descriptorType = type;
+  /* write_descriptor_set.pImageInfo; set later */
+  /* write_descriptor_set.pBufferInfo; set later */
+  write_descriptor_set.pTexelBufferView = 0;
 
-  bindings.emplace_back(layout_binding);
+  VulkanDescriptorInfo info = {};
+  info.image = *image_info;
 
+  writes.emplace_back(write_descriptor_set);
+  infos.emplace_back(info);
+  return *this;
+}
+
+VulkanDescriptorBuilder &VulkanDescriptorBuilder::BindTexelBuffer(
+    uint32_t binding, VkBufferView *buffer_view, VkDescriptorType type) {
   VkWriteDescriptorSet write_descriptor_set = {};
   write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
   write_descriptor_set.pNext = nullptr;
@@ -56,38 +64,130 @@ VulkanDescriptorBuilder &VulkanDescriptorBuilder::BindImage(
   write_descriptor_set.dstArrayElement = 0;
   write_descriptor_set.descriptorCount = 1;
   write_descriptor_set.descriptorType = type;
-  write_descriptor_set.pImageInfo = image_info;
+  write_descriptor_set.pImageInfo = 0;
   write_descriptor_set.pBufferInfo = 0;
-  write_descriptor_set.pTexelBufferView = 0;
+  /* write_descriptor_set.pTexelBufferView; set later */
+
+  VulkanDescriptorInfo info = {};
+  info.texel_buffer = *buffer_view;
 
   writes.emplace_back(write_descriptor_set);
+  infos.emplace_back(info);
   return *this;
 }
 
-bool VulkanDescriptorBuilder::Build(VkDescriptorSet *out_set,
-                                    VkDescriptorSetLayout *out_layout) {
+bool VulkanDescriptorBuilder::Build(VkDescriptorSetLayout layout,
+                                    VkDescriptorSet *out_set) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  VkDescriptorSetLayoutCreateInfo layout_info = {};
-  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-  layout_info.pNext = 0;
-  layout_info.flags = 0;
-  layout_info.pBindings = bindings.data();
-  layout_info.bindingCount = bindings.size();
+  *out_set = context->descriptor_pools->Allocate(layout);
+  if (!(*out_set)) {
+    return false;
+  }
+
+  Write(layout, *out_set);
+
+  return true;
+}
 
-  *out_layout = context->layout_cache->CreateDescriptorLayout(&layout_info);
+bool VulkanDescriptorBuilder::BuildTransient(VkDescriptorSetLayout layout,
+                                             VkDescriptorSet *out_set) {
+  VulkanContext *context = VulkanBackend::GetContext();
 
-  *out_set = context->descriptor_pools->Allocate(*out_layout);
+  *out_set = context->descriptor_pools->AllocateTransient(layout);
   if (!(*out_set)) {
     return false;
   }
 
-  for (VkWriteDescriptorSet &w : writes) {
-    w.dstSet = *out_set;
+  Write(layout, *out_set);
+
+  return true;
+}
+
+bool VulkanDescriptorBuilder::Push(VulkanCommandBuffer *command_buffer,
+                                   VkPipelineBindPoint bind_point,
+                                   VkPipelineLayout pipeline_layout,
+                                   uint32_t set_index,
+                                   VkDescriptorSetLayout layout) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanDescriptorUpdateTemplate *update_template =
+      context->layout_cache->GetPushUpdateTemplate(layout, pipeline_layout,
+                                                   set_index, bind_point);
+  std::vector<VulkanDescriptorInfo> packed_infos;
+  if (!update_template || !Pack(update_template, packed_infos)) {
+    ERROR("Failed to push descriptor set %u!", set_index);
+    return false;
+  }
+
+  context->layout_cache->GetPushDescriptorSetWithTemplate()(
+      command_buffer->GetHandle(), update_template->handle, pipeline_layout,
+      set_index, packed_infos.data());
+
+  return true;
+}
+
+void VulkanDescriptorBuilder::Write(VkDescriptorSetLayout layout,
+                                    VkDescriptorSet set) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  std::vector<VulkanDescriptorInfo> packed_infos;
+  VulkanDescriptorUpdateTemplate *update_template =
+      context->layout_cache->GetUpdateTemplate(layout);
+  if (update_template && Pack(update_template, packed_infos)) {
+    vkUpdateDescriptorSetWithTemplate(context->device->GetLogicalDevice(), set,
+                                      update_template->handle,
+                                      packed_infos.data());
+    return;
+  }
+
+  /* some bindings are left unwritten, which a template can't do */
+  for (uint32_t i = 0; i < writes.size(); ++i) {
+    writes[i].dstSet = set;
+    writes[i].pImageInfo = &infos[i].image;
+    writes[i].pBufferInfo = &infos[i].buffer;
+    writes[i].pTexelBufferView = &infos[i].texel_buffer;
   }
 
   vkUpdateDescriptorSets(context->device->GetLogicalDevice(), writes.size(),
                          writes.data(), 0, 0);
+}
+
+bool VulkanDescriptorBuilder::Pack(
+    VulkanDescriptorUpdateTemplate *update_template,
+    std::vector<VulkanDescriptorInfo> &out_infos) {
+  out_infos.clear();
+  out_infos.resize(update_template->info_count);
+  std::vector<bool> written(update_template->info_count, false);
+
+  for (uint32_t i = 0; i < writes.size(); ++i) {
+    bool found = false;
+    for (uint32_t j = 0; j < update_template->bindings.size(); ++j) {
+      VkDescriptorSetLayoutBinding &binding = update_template->bindings[j];
+      if (binding.binding != writes[i].dstBinding ||
+          writes[i].dstArrayElement >= binding.descriptorCount) {
+        continue;
+      }
+
+      uint32_t index =
+          update_template->offsets[j] + writes[i].dstArrayElement;
+      out_infos[index] = infos[i];
+      written[index] = true;
+      found = true;
+      break;
+    }
+
+    if (!found) {
+      WARN("Descriptor binding %u is not in the set layout!",
+           writes[i].dstBinding);
+    }
+  }
+
+  for (uint32_t i = 0; i < written.size(); ++i) {
+    if (!written[i]) {
+      return false;
+    }
+  }
 
   return true;
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "vulkan_command_buffer.h"
+#include "vulkan_descriptor_layout_cache.h"
+
 #include <vector>
 #include <vulkan/vulkan.h>
 
@@ -7,18 +10,35 @@ class VulkanDescriptorBuilder {
 public:
   static VulkanDescriptorBuilder Begin();
 
+  /* infos are copied */
   VulkanDescriptorBuilder &BindBuffer(uint32_t binding,
                                       VkDescriptorBufferInfo *buffer_info,
-                                      VkDescriptorType type,
-                                      VkShaderStageFlags stage_flags);
+                                      VkDescriptorType type);
   VulkanDescriptorBuilder &BindImage(uint32_t binding,
                                      VkDescriptorImageInfo *image_info,
-                                     VkDescriptorType type,
-                                     VkShaderStageFlags stage_flags);
+                                     VkDescriptorType type);
+  VulkanDescriptorBuilder &BindTexelBuffer(uint32_t binding,
+                                           VkBufferView *buffer_view,
+                                           VkDescriptorType type);
 
-  bool Build(VkDescriptorSet *out_set, VkDescriptorSetLayout *out_layout);
+  /* layout is taken from the shader reflection, so that it matches the
+   * pipeline layout. The set is written with the update template of the
+   * layout if every binding of it is bound */
+  bool Build(VkDescriptorSetLayout layout, VkDescriptorSet *out_set);
+  /* same as Build, but the set is valid only for the current frame */
+  bool BuildTransient(VkDescriptorSetLayout layout, VkDescriptorSet *out_set);
+  /* pushes the descriptors into the command buffer instead of writing a set.
+   * The layout has to be created with the push descriptor flag */
+  bool Push(VulkanCommandBuffer *command_buffer,
+            VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout,
+            uint32_t set_index, VkDescriptorSetLayout layout);
 
 private:
+  void Write(VkDescriptorSetLayout layout, VkDescriptorSet set);
+  /* packs the infos in the order of the template */
+  bool Pack(VulkanDescriptorUpdateTemplate *update_template,
+            std::vector<VulkanDescriptorInfo> &out_infos);
+
   std::vector<VkWriteDescriptorSet> writes;
-  std::vector<VkDescriptorSetLayoutBinding> bindings;
+  std::vector<VulkanDescriptorInfo> infos;
 };
\ No newline at end of file
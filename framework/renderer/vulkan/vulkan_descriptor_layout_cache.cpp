@@ -1,13 +1,50 @@
 #include "vulkan_descriptor_layout_cache.h"
 
 #include "../../logger.h"
+#include "../gpu_utils.h"
 #include "vulkan_backend.h"
 
-void VulkanDescriptorLayoutCache::Initialize() {}
+#include <algorithm>
+#include <mutex>
+
+void VulkanDescriptorLayoutCache::Initialize() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  hit_count = 0;
+  miss_count = 0;
+
+  vkPushDescriptorSetWithTemplate = 0;
+  if (context->device->GetOptionalFeatures().push_descriptor) {
+    vkPushDescriptorSetWithTemplate =
+        (PFN_vkCmdPushDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(
+            context->device->GetLogicalDevice(),
+            "vkCmdPushDescriptorSetWithTemplateKHR");
+  }
+}
 
 void VulkanDescriptorLayoutCache::Shutdown() {
   VulkanContext *context = VulkanBackend::GetContext();
 
+  DEBUG("Descriptor layout cache: %llu hits, %llu misses",
+        (unsigned long long)hit_count, (unsigned long long)miss_count);
+
+  for (auto &pair : update_templates) {
+    if (pair.second.handle) {
+      vkDestroyDescriptorUpdateTemplate(context->device->GetLogicalDevice(),
+                                        pair.second.handle,
+                                        context->allocator);
+    }
+  }
+  update_templates.clear();
+  for (auto &pair : push_update_templates) {
+    if (pair.second.handle) {
+      vkDestroyDescriptorUpdateTemplate(context->device->GetLogicalDevice(),
+                                        pair.second.handle,
+                                        context->allocator);
+    }
+  }
+  push_update_templates.clear();
+
   for (auto pair : layout_cache) {
     vkDestroyDescriptorSetLayout(context->device->GetLogicalDevice(),
                                  pair.second, context->allocator);
@@ -18,33 +55,69 @@ VkDescriptorSetLayout VulkanDescriptorLayoutCache::CreateDescriptorLayout(
     VkDescriptorSetLayoutCreateInfo *layout_create_info) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  DescriptorLayoutInfo layout_info;
-  layout_info.bindings.reserve(layout_create_info->bindingCount);
-  bool is_sorted = true;
-  int32_t last_binding = -1;
+  const VkDescriptorBindingFlags *binding_flags = 0;
+  const VkBaseInStructure *next =
+      (const VkBaseInStructure *)layout_create_info->pNext;
+  while (next) {
+    if (next->sType ==
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO) {
+      const VkDescriptorSetLayoutBindingFlagsCreateInfo *flags_create_info =
+          (const VkDescriptorSetLayoutBindingFlagsCreateInfo *)next;
+      if (flags_create_info->bindingCount) {
+        binding_flags = flags_create_info->pBindingFlags;
+      }
+    }
+    next = next->pNext;
+  }
+
+  /* bindings are sorted, so that the same bindings in another order make the
+   * same layout */
+  std::vector<uint32_t> order(layout_create_info->bindingCount);
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  const VkDescriptorSetLayoutBinding *bindings = layout_create_info->pBindings;
+  std::sort(order.begin(), order.end(), [bindings](uint32_t a, uint32_t b) {
+    return bindings[a].binding < bindings[b].binding;
+  });
 
-  for (uint32_t i = 0; i < layout_create_info->bindingCount; i++) {
-    layout_info.bindings.push_back(layout_create_info->pBindings[i]);
+  DescriptorLayoutInfo layout_info;
+  layout_info.flags = layout_create_info->flags;
+  layout_info.bindings.reserve(order.size());
+  layout_info.immutable_samplers.resize(order.size());
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    VkDescriptorSetLayoutBinding binding = bindings[order[i]];
+    if (binding.pImmutableSamplers) {
+      layout_info.immutable_samplers[i].assign(
+          binding.pImmutableSamplers,
+          binding.pImmutableSamplers + binding.descriptorCount);
+    }
+    binding.pImmutableSamplers = 0;
+    layout_info.bindings.push_back(binding);
 
-    if (layout_create_info->pBindings[i].binding > last_binding) {
-      last_binding = layout_create_info->pBindings[i].binding;
-    } else {
-      is_sorted = false;
+    if (binding_flags) {
+      layout_info.binding_flags.push_back(binding_flags[order[i]]);
     }
   }
 
-  if (!is_sorted) {
-    std::sort(
-        layout_info.bindings.begin(), layout_info.bindings.end(),
-        [](VkDescriptorSetLayoutBinding &a, VkDescriptorSetLayoutBinding &b) {
-          return a.binding < b.binding;
-        });
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = layout_cache.find(layout_info);
+    if (it != layout_cache.end()) {
+      hit_count++;
+      return (*it).second;
+    }
   }
 
+  std::unique_lock<std::shared_mutex> lock(mutex);
+
+  /* another thread may have created it in the meantime */
   auto it = layout_cache.find(layout_info);
   if (it != layout_cache.end()) {
+    hit_count++;
     return (*it).second;
   }
+  miss_count++;
 
   VkDescriptorSetLayout layout;
   VK_CHECK(vkCreateDescriptorSetLayout(context->device->GetLogicalDevice(),
@@ -52,12 +125,149 @@ VkDescriptorSetLayout VulkanDescriptorLayoutCache::CreateDescriptorLayout(
                                        &layout));
 
   layout_cache[layout_info] = layout;
+  layout_flags[layout] = layout_info.flags;
+
+  VulkanDescriptorUpdateTemplate update_template = {};
+  update_template.bindings = layout_info.bindings;
+  update_template.info_count = 0;
+  for (uint32_t i = 0; i < update_template.bindings.size(); ++i) {
+    update_template.offsets.emplace_back(update_template.info_count);
+    update_template.info_count += update_template.bindings[i].descriptorCount;
+  }
+  if (!(layout_info.flags &
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)) {
+    update_template.handle =
+        CreateUpdateTemplate(&update_template, layout, 0, 0,
+                             VK_PIPELINE_BIND_POINT_GRAPHICS);
+  }
+  update_templates[layout] = update_template;
+
   return layout;
 }
 
+VulkanDescriptorUpdateTemplate *
+VulkanDescriptorLayoutCache::GetUpdateTemplate(VkDescriptorSetLayout layout) {
+  std::shared_lock<std::shared_mutex> lock(mutex);
+
+  auto it = update_templates.find(layout);
+  if (it == update_templates.end() || !it->second.handle) {
+    return 0;
+  }
+
+  return &it->second;
+}
+
+VulkanDescriptorUpdateTemplate *VulkanDescriptorLayoutCache::
+    GetPushUpdateTemplate(VkDescriptorSetLayout layout,
+                          VkPipelineLayout pipeline_layout,
+                          uint32_t set_index, VkPipelineBindPoint bind_point) {
+  if (!IsPushDescriptorLayout(layout) || !vkPushDescriptorSetWithTemplate) {
+    return 0;
+  }
+
+  PushTemplateKey key = {layout, pipeline_layout, set_index, bind_point};
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = push_update_templates.find(key);
+    if (it != push_update_templates.end()) {
+      return it->second.handle ? &it->second : 0;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(mutex);
+
+  auto it = push_update_templates.find(key);
+  if (it != push_update_templates.end()) {
+    return it->second.handle ? &it->second : 0;
+  }
+
+  VulkanDescriptorUpdateTemplate update_template = update_templates[layout];
+  update_template.handle = CreateUpdateTemplate(
+      &update_template, layout, pipeline_layout, set_index, bind_point);
+  push_update_templates[key] = update_template;
+
+  return update_template.handle ? &push_update_templates[key] : 0;
+}
+
+bool VulkanDescriptorLayoutCache::IsPushDescriptorLayout(
+    VkDescriptorSetLayout layout) {
+  std::shared_lock<std::shared_mutex> lock(mutex);
+
+  auto it = layout_flags.find(layout);
+  if (it == layout_flags.end()) {
+    return false;
+  }
+
+  return it->second & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+}
+
+const std::vector<VkDescriptorSetLayoutBinding> *
+VulkanDescriptorLayoutCache::GetBindings(VkDescriptorSetLayout layout) {
+  std::shared_lock<std::shared_mutex> lock(mutex);
+
+  auto it = update_templates.find(layout);
+  if (it == update_templates.end()) {
+    return 0;
+  }
+
+  return &it->second.bindings;
+}
+
+VkDescriptorUpdateTemplate VulkanDescriptorLayoutCache::CreateUpdateTemplate(
+    VulkanDescriptorUpdateTemplate *update_template,
+    VkDescriptorSetLayout layout, VkPipelineLayout pipeline_layout,
+    uint32_t set_index, VkPipelineBindPoint bind_point) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  std::vector<VkDescriptorUpdateTemplateEntry> entries;
+  for (uint32_t i = 0; i < update_template->bindings.size(); ++i) {
+    VkDescriptorSetLayoutBinding &binding = update_template->bindings[i];
+    if (!binding.descriptorCount) {
+      continue;
+    }
+
+    VkDescriptorUpdateTemplateEntry entry = {};
+    entry.dstBinding = binding.binding;
+    entry.dstArrayElement = 0;
+    entry.descriptorCount = binding.descriptorCount;
+    entry.descriptorType = binding.descriptorType;
+    entry.offset = update_template->offsets[i] * sizeof(VulkanDescriptorInfo);
+    entry.stride = sizeof(VulkanDescriptorInfo);
+    entries.emplace_back(entry);
+  }
+
+  /* templates of empty sets are not allowed */
+  if (entries.empty()) {
+    return 0;
+  }
+
+  VkDescriptorUpdateTemplateCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+  create_info.pNext = 0;
+  create_info.flags = 0;
+  create_info.descriptorUpdateEntryCount = entries.size();
+  create_info.pDescriptorUpdateEntries = entries.data();
+  create_info.templateType =
+      pipeline_layout ? VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR
+                      : VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+  create_info.descriptorSetLayout = layout;
+  create_info.pipelineBindPoint = bind_point;
+  create_info.pipelineLayout = pipeline_layout;
+  create_info.set = set_index;
+
+  VkDescriptorUpdateTemplate handle;
+  VK_CHECK(vkCreateDescriptorUpdateTemplate(context->device->GetLogicalDevice(),
+                                            &create_info, context->allocator,
+                                            &handle));
+
+  return handle;
+}
+
 bool VulkanDescriptorLayoutCache::DescriptorLayoutInfo::operator==(
     const DescriptorLayoutInfo &other) const {
-  if (other.bindings.size() != bindings.size()) {
+  if (other.flags != flags || other.bindings.size() != bindings.size() ||
+      other.immutable_samplers != immutable_samplers ||
+      other.binding_flags != binding_flags) {
     return false;
   }
 
@@ -80,16 +290,22 @@ bool VulkanDescriptorLayoutCache::DescriptorLayoutInfo::operator==(
 }
 
 size_t VulkanDescriptorLayoutCache::DescriptorLayoutInfo::hash() const {
-  using std::hash;
-  using std::size_t;
-
-  size_t result = hash<size_t>()(bindings.size());
+  uint64_t result = GPUUtils::HashMix(flags);
 
-  for (const VkDescriptorSetLayoutBinding &b : bindings) {
-    size_t binding_hash = b.binding | b.descriptorType << 8 |
-                          b.descriptorCount << 16 | b.stageFlags << 24;
+  GPUUtils::HashCombine(result, bindings.size());
+  for (uint32_t i = 0; i < bindings.size(); ++i) {
+    GPUUtils::HashCombine(result, bindings[i].binding);
+    GPUUtils::HashCombine(result, bindings[i].descriptorType);
+    GPUUtils::HashCombine(result, bindings[i].descriptorCount);
+    GPUUtils::HashCombine(result, bindings[i].stageFlags);
 
-    result ^= hash<size_t>()(binding_hash);
+    GPUUtils::HashCombine(result, immutable_samplers[i].size());
+    for (VkSampler sampler : immutable_samplers[i]) {
+      GPUUtils::HashCombine(result, (uint64_t)sampler);
+    }
+  }
+  for (VkDescriptorBindingFlags binding_flag : binding_flags) {
+    GPUUtils::HashCombine(result, binding_flag);
   }
 
   return result;
@@ -1,9 +1,29 @@
 #pragma once
 
+#include <atomic>
+#include <shared_mutex>
 #include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan.h>
 
+/* element of the packed data the update templates read from */
+union VulkanDescriptorInfo {
+  VkDescriptorImageInfo image;
+  VkDescriptorBufferInfo buffer;
+  VkBufferView texel_buffer;
+};
+
+/* writes a whole set from an array of VulkanDescriptorInfo in one call.
+ * Binding i starts at element offsets[i] of the array */
+struct VulkanDescriptorUpdateTemplate {
+  VkDescriptorUpdateTemplate handle;
+  std::vector<VkDescriptorSetLayoutBinding> bindings;
+  std::vector<uint32_t> offsets;
+  uint32_t info_count;
+};
+
+/* Layouts are looked up far more often than they are created, so lookups
+ * only take a shared lock, and shaders can be created from several threads */
 class VulkanDescriptorLayoutCache {
 public:
   void Initialize();
@@ -12,8 +32,38 @@ public:
   VkDescriptorSetLayout
   CreateDescriptorLayout(VkDescriptorSetLayoutCreateInfo *layout_create_info);
 
+  /* template of a layout created by the cache, 0 for push descriptor
+   * layouts */
+  VulkanDescriptorUpdateTemplate *
+  GetUpdateTemplate(VkDescriptorSetLayout layout);
+  /* push descriptor templates are specific to the pipeline layout, the set
+   * index and the bind point, so they are created on the first use */
+  VulkanDescriptorUpdateTemplate *
+  GetPushUpdateTemplate(VkDescriptorSetLayout layout,
+                        VkPipelineLayout pipeline_layout, uint32_t set_index,
+                        VkPipelineBindPoint bind_point);
+  bool IsPushDescriptorLayout(VkDescriptorSetLayout layout);
+  /* bindings of a layout created by the cache, 0 for the other layouts */
+  const std::vector<VkDescriptorSetLayoutBinding> *
+  GetBindings(VkDescriptorSetLayout layout);
+
+  inline PFN_vkCmdPushDescriptorSetWithTemplateKHR
+  GetPushDescriptorSetWithTemplate() {
+    return vkPushDescriptorSetWithTemplate;
+  }
+
+  inline uint64_t GetHitCount() const { return hit_count; }
+  inline uint64_t GetMissCount() const { return miss_count; }
+
+  /* bindings are sorted, the other vectors follow their order */
   struct DescriptorLayoutInfo {
+    VkDescriptorSetLayoutCreateFlags flags;
+    /* pImmutableSamplers is always 0, the samplers are stored apart */
     std::vector<VkDescriptorSetLayoutBinding> bindings;
+    /* empty if the binding has no immutable samplers */
+    std::vector<std::vector<VkSampler>> immutable_samplers;
+    /* empty if the layout has no binding flags */
+    std::vector<VkDescriptorBindingFlags> binding_flags;
 
     bool operator==(const DescriptorLayoutInfo &other) const;
     size_t hash() const;
@@ -26,7 +76,47 @@ private:
     }
   };
 
+  struct PushTemplateKey {
+    VkDescriptorSetLayout layout;
+    VkPipelineLayout pipeline_layout;
+    uint32_t set_index;
+    VkPipelineBindPoint bind_point;
+
+    bool operator==(const PushTemplateKey &other) const {
+      return layout == other.layout &&
+             pipeline_layout == other.pipeline_layout &&
+             set_index == other.set_index && bind_point == other.bind_point;
+    }
+  };
+
+  struct PushTemplateHash {
+    std::size_t operator()(const PushTemplateKey &key) const {
+      return std::hash<uint64_t>()((uint64_t)key.layout) ^
+             std::hash<uint64_t>()((uint64_t)key.pipeline_layout) << 1 ^
+             key.set_index ^ (uint64_t)key.bind_point << 8;
+    }
+  };
+
+  VkDescriptorUpdateTemplate
+  CreateUpdateTemplate(VulkanDescriptorUpdateTemplate *update_template,
+                       VkDescriptorSetLayout layout,
+                       VkPipelineLayout pipeline_layout, uint32_t set_index,
+                       VkPipelineBindPoint bind_point);
+
+  /* guards the maps below */
+  std::shared_mutex mutex;
   std::unordered_map<DescriptorLayoutInfo, VkDescriptorSetLayout,
                      DescriptorLayoutHash>
       layout_cache;
+  std::unordered_map<VkDescriptorSetLayout, VkDescriptorSetLayoutCreateFlags>
+      layout_flags;
+  std::unordered_map<VkDescriptorSetLayout, VulkanDescriptorUpdateTemplate>
+      update_templates;
+  std::unordered_map<PushTemplateKey, VulkanDescriptorUpdateTemplate,
+                     PushTemplateHash>
+      push_update_templates;
+  PFN_vkCmdPushDescriptorSetWithTemplateKHR vkPushDescriptorSetWithTemplate;
+
+  std::atomic<uint64_t> hit_count;
+  std::atomic<uint64_t> miss_count;
 };
\ No newline at end of file
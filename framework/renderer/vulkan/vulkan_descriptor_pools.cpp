@@ -3,109 +3,305 @@
 #include "../../logger.h"
 #include "vulkan_backend.h"
 
-void VulkanDescriptorPools::Initialize() { current_pool = VK_NULL_HANDLE; }
+#include <algorithm>
+#include <math.h>
+
+#define DESCRIPTOR_POOL_SET_COUNT 1000
+#define TRANSIENT_DESCRIPTOR_POOL_SET_COUNT 256
+/* sets to allocate before the pools are sized by the statistics */
+#define DESCRIPTOR_POOL_STATISTICS_MIN_SET_COUNT 64
+/* headroom over the average descriptor counts */
+#define DESCRIPTOR_POOL_STATISTICS_HEADROOM 1.25f
+
+void VulkanDescriptorPools::Initialize() {
+  current_pool = VK_NULL_HANDLE;
+  allocated_set_count = 0;
+  allocated_descriptor_counts.clear();
+}
 
 void VulkanDescriptorPools::Shutdown() {
   VulkanContext *context = VulkanBackend::GetContext();
 
+  for (auto &pair : pool_set_counts) {
+    vkDestroyDescriptorPool(context->device->GetLogicalDevice(), pair.first,
+                            context->allocator);
+  }
   for (uint32_t i = 0; i < free_pools.size(); ++i) {
     vkDestroyDescriptorPool(context->device->GetLogicalDevice(), free_pools[i],
                             context->allocator);
   }
-  for (uint32_t i = 0; i < used_pools.size(); ++i) {
-    vkDestroyDescriptorPool(context->device->GetLogicalDevice(), used_pools[i],
-                            context->allocator);
+  for (uint32_t i = 0; i < frame_pools.size(); ++i) {
+    for (uint32_t j = 0; j < frame_pools[i].used_pools.size(); ++j) {
+      vkDestroyDescriptorPool(context->device->GetLogicalDevice(),
+                              frame_pools[i].used_pools[j],
+                              context->allocator);
+    }
+  }
+  for (uint32_t i = 0; i < free_transient_pools.size(); ++i) {
+    vkDestroyDescriptorPool(context->device->GetLogicalDevice(),
+                            free_transient_pools[i], context->allocator);
   }
+
+  current_pool = VK_NULL_HANDLE;
+  pool_set_counts.clear();
+  set_pools.clear();
+  free_pools.clear();
+  frame_pools.clear();
+  free_transient_pools.clear();
 }
 
-void VulkanDescriptorPools::Reset() {
+void VulkanDescriptorPools::ResetFrame(uint32_t frame_index) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  for (uint32_t i = 0; i < used_pools.size(); ++i) {
-    vkResetDescriptorPool(context->device->GetLogicalDevice(), used_pools[i],
-                          0);
-    free_pools.emplace_back(used_pools[i]);
+  FramePools &pools = GetFramePools(frame_index);
+
+  for (uint32_t i = 0; i < pools.pending_frees.size(); ++i) {
+    FreeNow(pools.pending_frees[i]);
   }
+  pools.pending_frees.clear();
 
-  used_pools.clear();
-  current_pool = VK_NULL_HANDLE;
+  for (uint32_t i = 0; i < pools.used_pools.size(); ++i) {
+    vkResetDescriptorPool(context->device->GetLogicalDevice(),
+                          pools.used_pools[i], 0);
+    free_transient_pools.emplace_back(pools.used_pools[i]);
+  }
+  pools.used_pools.clear();
+  pools.current_pool = VK_NULL_HANDLE;
 }
 
 VkDescriptorSet VulkanDescriptorPools::Allocate(VkDescriptorSetLayout layout) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  if (current_pool == VK_NULL_HANDLE) {
-    current_pool = GrabPool();
-    used_pools.emplace_back(current_pool);
+  RecordAllocation(layout);
+
+  VkDescriptorSet set = 0;
+  VkResult result = VK_ERROR_OUT_OF_POOL_MEMORY;
+  if (current_pool != VK_NULL_HANDLE) {
+    result = AllocateFromPool(current_pool, layout, &set);
+  }
+
+  /* a recycled pool may be sized for other sets, while a new one always fits
+   * the layout */
+  for (uint32_t i = 0; i < 2 && result != VK_SUCCESS; ++i) {
+    if (result != VK_ERROR_OUT_OF_POOL_MEMORY &&
+        result != VK_ERROR_FRAGMENTED_POOL) {
+      break;
+    }
+
+    /* the old pool is recycled once its sets are freed. An empty one just
+     * doesn't fit the layout */
+    if (current_pool != VK_NULL_HANDLE && pool_set_counts[current_pool] == 0) {
+      vkDestroyDescriptorPool(context->device->GetLogicalDevice(),
+                              current_pool, context->allocator);
+      pool_set_counts.erase(current_pool);
+    }
+
+    current_pool = i == 0 ? GrabPool(layout, false) : CreatePool(layout, false);
+    pool_set_counts.emplace(current_pool, 0);
+    result = AllocateFromPool(current_pool, layout, &set);
+  }
+
+  if (result != VK_SUCCESS) {
+    FATAL("Unrecoverable error encountered while allocating descriptor set!");
+    return 0;
+  }
+
+  pool_set_counts[current_pool]++;
+  set_pools[set] = current_pool;
+
+  return set;
+}
+
+void VulkanDescriptorPools::Free(VkDescriptorSet descriptor_set) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (!set_pools.count(descriptor_set)) {
+    WARN("Freeing a descriptor set that is not allocated from the pools!");
+    return;
+  }
+
+  /* the set may still be used by the frames in flight, which are all rendered
+   * by the time this frame is reset */
+  GetFramePools(context->current_frame)
+      .pending_frees.emplace_back(descriptor_set);
+}
+
+VkDescriptorSet
+VulkanDescriptorPools::AllocateTransient(VkDescriptorSetLayout layout) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  RecordAllocation(layout);
+
+  FramePools &pools = GetFramePools(context->current_frame);
+
+  VkDescriptorSet set = 0;
+  VkResult result = VK_ERROR_OUT_OF_POOL_MEMORY;
+  if (pools.current_pool != VK_NULL_HANDLE) {
+    result = AllocateFromPool(pools.current_pool, layout, &set);
   }
 
+  for (uint32_t i = 0; i < 2 && result != VK_SUCCESS; ++i) {
+    if (result != VK_ERROR_OUT_OF_POOL_MEMORY &&
+        result != VK_ERROR_FRAGMENTED_POOL) {
+      break;
+    }
+
+    pools.current_pool =
+        i == 0 ? GrabPool(layout, true) : CreatePool(layout, true);
+    pools.used_pools.emplace_back(pools.current_pool);
+    result = AllocateFromPool(pools.current_pool, layout, &set);
+  }
+
+  if (result != VK_SUCCESS) {
+    FATAL("Unrecoverable error encountered while allocating descriptor set!");
+    return 0;
+  }
+
+  return set;
+}
+
+VkResult VulkanDescriptorPools::AllocateFromPool(VkDescriptorPool pool,
+                                                 VkDescriptorSetLayout layout,
+                                                 VkDescriptorSet *out_set) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
   VkDescriptorSetAllocateInfo set_allocate_info = {};
   set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
   set_allocate_info.pNext = 0;
-  set_allocate_info.descriptorPool = current_pool;
+  set_allocate_info.descriptorPool = pool;
   set_allocate_info.descriptorSetCount = 1;
   set_allocate_info.pSetLayouts = &layout;
 
-  VkDescriptorSet set;
-
-  VkResult result = vkAllocateDescriptorSets(
-      context->device->GetLogicalDevice(), &set_allocate_info, &set);
-  switch (result) {
-  case VK_SUCCESS: {
-    return set;
-  } break;
-  case VK_ERROR_FRAGMENTED_POOL:
-  case VK_ERROR_OUT_OF_POOL_MEMORY: {
-    /* reallocate */
-    current_pool = GrabPool();
-    used_pools.emplace_back(current_pool);
-    VK_CHECK(vkAllocateDescriptorSets(context->device->GetLogicalDevice(),
-                                      &set_allocate_info, &set));
-    return set;
-  } break;
-  default: {
-    FATAL("Unrecoverable error encountered while allocating descriptor set!");
-    return 0;
-  } break;
+  return vkAllocateDescriptorSets(context->device->GetLogicalDevice(),
+                                  &set_allocate_info, out_set);
+}
+
+void VulkanDescriptorPools::RecordAllocation(VkDescriptorSetLayout layout) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  const std::vector<VkDescriptorSetLayoutBinding> *bindings =
+      context->layout_cache->GetBindings(layout);
+  if (!bindings) {
+    return;
   }
 
-  return 0;
+  allocated_set_count++;
+  for (uint32_t i = 0; i < bindings->size(); ++i) {
+    allocated_descriptor_counts[(*bindings)[i].descriptorType] +=
+        (*bindings)[i].descriptorCount;
+  }
 }
 
-void VulkanDescriptorPools::Free(VkDescriptorSet descriptor_set) {}
+VulkanDescriptorPools::FramePools &
+VulkanDescriptorPools::GetFramePools(uint32_t frame_index) {
+  if (frame_index >= frame_pools.size()) {
+    FramePools pools = {};
+    pools.current_pool = VK_NULL_HANDLE;
+    frame_pools.resize(frame_index + 1, pools);
+  }
 
-VkDescriptorPool VulkanDescriptorPools::GrabPool() {
+  return frame_pools[frame_index];
+}
+
+void VulkanDescriptorPools::FreeNow(VkDescriptorSet descriptor_set) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  if (free_pools.size() > 0) {
-    VkDescriptorPool pool = free_pools.back();
-    free_pools.pop_back();
+  auto it = set_pools.find(descriptor_set);
+  if (it == set_pools.end()) {
+    return;
+  }
+  VkDescriptorPool pool = it->second;
+  set_pools.erase(it);
+
+  VK_CHECK(vkFreeDescriptorSets(context->device->GetLogicalDevice(), pool, 1,
+                                &descriptor_set));
+
+  /* an empty pool is reset, which also undoes its fragmentation */
+  if (--pool_set_counts[pool] == 0 && pool != current_pool) {
+    vkResetDescriptorPool(context->device->GetLogicalDevice(), pool, 0);
+    pool_set_counts.erase(pool);
+    free_pools.emplace_back(pool);
+  }
+}
+
+VkDescriptorPool VulkanDescriptorPools::GrabPool(VkDescriptorSetLayout layout,
+                                                 bool transient) {
+  std::vector<VkDescriptorPool> &pools =
+      transient ? free_transient_pools : free_pools;
+  if (pools.size() > 0) {
+    VkDescriptorPool pool = pools.back();
+    pools.pop_back();
     return pool;
   }
 
-  const uint32_t size_count = 1000;
-  const std::vector<std::pair<VkDescriptorType, float>> pool_sizes = {
-      {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
-      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
-      {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.f},
-      {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f},
-      {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1.f},
-      {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1.f},
-      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
-      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
-      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
-      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f},
-      {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f}};
+  return CreatePool(layout, transient);
+}
+
+VkDescriptorPool VulkanDescriptorPools::CreatePool(VkDescriptorSetLayout layout,
+                                                   bool transient) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  const uint32_t size_count = transient ? TRANSIENT_DESCRIPTOR_POOL_SET_COUNT
+                                        : DESCRIPTOR_POOL_SET_COUNT;
+
+  std::unordered_map<VkDescriptorType, uint32_t> descriptor_counts;
+  if (allocated_set_count >= DESCRIPTOR_POOL_STATISTICS_MIN_SET_COUNT) {
+    for (auto &pair : allocated_descriptor_counts) {
+      float ratio = (float)pair.second / allocated_set_count;
+      descriptor_counts[pair.first] = (uint32_t)ceilf(
+          ratio * DESCRIPTOR_POOL_STATISTICS_HEADROOM * size_count);
+    }
+  } else {
+    /* nothing is known about the sets yet */
+    const std::vector<std::pair<VkDescriptorType, float>> pool_sizes = {
+        {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1.f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f},
+        {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f}};
+    for (auto size : pool_sizes) {
+      descriptor_counts[size.first] = uint32_t(size.second * size_count);
+    }
+  }
+
+  /* the set the pool is created for always fits */
+  const std::vector<VkDescriptorSetLayoutBinding> *bindings =
+      context->layout_cache->GetBindings(layout);
+  if (bindings) {
+    std::unordered_map<VkDescriptorType, uint32_t> layout_counts;
+    for (uint32_t i = 0; i < bindings->size(); ++i) {
+      layout_counts[(*bindings)[i].descriptorType] +=
+          (*bindings)[i].descriptorCount;
+    }
+    for (auto &pair : layout_counts) {
+      descriptor_counts[pair.first] =
+          std::max(descriptor_counts[pair.first], pair.second);
+    }
+  }
 
   std::vector<VkDescriptorPoolSize> sizes;
-  sizes.reserve(pool_sizes.size());
-  for (auto size : pool_sizes) {
-    sizes.push_back({size.first, uint32_t(size.second * size_count)});
+  sizes.reserve(descriptor_counts.size());
+  for (auto &pair : descriptor_counts) {
+    if (pair.second > 0) {
+      sizes.push_back({pair.first, pair.second});
+    }
   }
+  /* pools of empty sets still need a size */
+  if (sizes.empty()) {
+    sizes.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1});
+  }
+
   VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
   descriptor_pool_create_info.sType =
       VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-  descriptor_pool_create_info.flags = 0;
+  descriptor_pool_create_info.flags =
+      transient ? 0 : VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
   descriptor_pool_create_info.maxSets = size_count;
   descriptor_pool_create_info.poolSizeCount = sizes.size();
   descriptor_pool_create_info.pPoolSizes = sizes.data();
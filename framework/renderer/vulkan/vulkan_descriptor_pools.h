@@ -1,21 +1,58 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan.h>
 
+/* Two kinds of pools. Long-lived sets come from pools created with the free
+ * descriptor set flag and are freed one by one, once the frame they were freed
+ * in is rendered. Such a pool is recycled when all of its sets are freed.
+ * Transient sets live for a single frame and come from per-frame pools, which
+ * are reset as a whole once the frame fence is signaled. New pools are sized
+ * by the descriptor counts allocated so far */
 class VulkanDescriptorPools {
 public:
   void Initialize();
   void Shutdown();
 
-  void Reset();
+  /* the frame fence has to be signaled. Frees the sets freed during the
+   * frame */
+  void ResetFrame(uint32_t frame_index);
 
   VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
   void Free(VkDescriptorSet descriptor_set);
+  /* the set is valid until the current frame is rendered */
+  VkDescriptorSet AllocateTransient(VkDescriptorSetLayout layout);
 
 private:
-  VkDescriptorPool GrabPool();
+  struct FramePools {
+    VkDescriptorPool current_pool;
+    std::vector<VkDescriptorPool> used_pools;
+    /* long-lived sets, that may still be used by the frame */
+    std::vector<VkDescriptorSet> pending_frees;
+  };
+
+  VkResult AllocateFromPool(VkDescriptorPool pool,
+                            VkDescriptorSetLayout layout,
+                            VkDescriptorSet *out_set);
+  void RecordAllocation(VkDescriptorSetLayout layout);
+  FramePools &GetFramePools(uint32_t frame_index);
+  void FreeNow(VkDescriptorSet descriptor_set);
+  VkDescriptorPool GrabPool(VkDescriptorSetLayout layout, bool transient);
+  VkDescriptorPool CreatePool(VkDescriptorSetLayout layout, bool transient);
+
+  /* long-lived pools */
   VkDescriptorPool current_pool;
-  std::vector<VkDescriptorPool> used_pools;
+  /* number of sets allocated from the pool that are not freed yet */
+  std::unordered_map<VkDescriptorPool, uint32_t> pool_set_counts;
+  std::unordered_map<VkDescriptorSet, VkDescriptorPool> set_pools;
   std::vector<VkDescriptorPool> free_pools;
+
+  /* transient pools */
+  std::vector<FramePools> frame_pools;
+  std::vector<VkDescriptorPool> free_transient_pools;
+
+  /* allocation statistics, used for the pool sizes */
+  uint64_t allocated_set_count;
+  std::unordered_map<VkDescriptorType, uint64_t> allocated_descriptor_counts;
 };
\ No newline at end of file
@@ -3,32 +3,91 @@
 #include "../../logger.h"
 #include "../gpu_utils.h"
 #include "vulkan_backend.h"
+#include "vulkan_compute_shader.h"
 #include "vulkan_debug_marker.h"
 #include "vulkan_descriptor_builder.h"
+#include "vulkan_descriptor_set_cache.h"
+#include "vulkan_shader.h"
+#include "vulkan_storage_buffer.h"
 #include "vulkan_texture.h"
 #include "vulkan_uniform_buffer.h"
 
+#include <algorithm>
 #include <vector>
 
+static void
+AddResource(VulkanDescriptorSetCache::DescriptorSetInfo &set_info,
+            uint32_t binding, VkDescriptorType type, uint64_t handle,
+            VkSampler sampler, VkDeviceSize offset, VkDeviceSize range,
+            VkImageLayout image_layout) {
+  VulkanDescriptorSetCache::DescriptorSetResource resource = {};
+  resource.binding = binding;
+  resource.type = type;
+  resource.handle = handle;
+  resource.sampler = sampler;
+  resource.offset = offset;
+  resource.range = range;
+  resource.image_layout = image_layout;
+
+  set_info.resources.emplace_back(resource);
+}
+
 void VulkanDescriptorSet::Create(
+    GPUShader *shader, uint32_t set_index,
+    std::vector<GPUDescriptorBinding> &set_bindings) {
+  VulkanShader *native_shader = (VulkanShader *)shader;
+  CreateWithLayout(native_shader->GetDescriptorSetLayout(set_index),
+                   set_index, set_bindings);
+}
+
+void VulkanDescriptorSet::Create(
+    GPUComputeShader *shader, uint32_t set_index,
+    std::vector<GPUDescriptorBinding> &set_bindings) {
+  VulkanComputeShader *native_shader = (VulkanComputeShader *)shader;
+  CreateWithLayout(native_shader->GetDescriptorSetLayout(set_index),
+                   set_index, set_bindings);
+}
+
+void VulkanDescriptorSet::CreateWithLayout(
+    VkDescriptorSetLayout set_layout, uint32_t set_index,
     std::vector<GPUDescriptorBinding> &set_bindings) {
   VulkanContext *context = VulkanBackend::GetContext();
 
   bindings = set_bindings;
+  set = 0;
+
+  layout = set_layout;
+  if (!layout) {
+    ERROR("Shader has no descriptor set %u!", set_index);
+    return;
+  }
+  if (context->layout_cache->IsPushDescriptorLayout(layout)) {
+    ERROR("Descriptor set %u is pushed, it can't be allocated!", set_index);
+    return;
+  }
 
   VulkanDescriptorBuilder builder = VulkanDescriptorBuilder::Begin();
+  VulkanDescriptorSetCache::DescriptorSetInfo set_info;
+  set_info.layout = layout;
+  GatherBindings(bindings, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                 builder, set_info);
 
-  /* TODO: seriosly? */
-  std::vector<VkDescriptorBufferInfo> uniform_buffers_info;
-  uniform_buffers_info.resize(bindings.size());
-  uint32_t uniform_buffer_count = 0;
-  std::vector<VkDescriptorImageInfo> texture_infos;
-  texture_infos.resize(bindings.size());
-  uint32_t texture_count = 0;
-  std::vector<VkDescriptorImageInfo> attachment_infos;
-  attachment_infos.resize(bindings.size());
-  uint32_t attachment_count = 0;
+  /* sets with the same content are shared */
+  set = context->descriptor_set_cache->Acquire(set_info);
+  if (set) {
+    return;
+  }
+
+  if (builder.Build(layout, &set)) {
+    context->descriptor_set_cache->Insert(set_info, set);
+  }
+}
 
+void VulkanDescriptorSet::GatherBindings(
+    std::vector<GPUDescriptorBinding> &bindings,
+    uint32_t uniform_buffer_offset, VkDescriptorType uniform_buffer_type,
+    VulkanDescriptorBuilder &builder,
+    VulkanDescriptorSetCache::DescriptorSetInfo &set_info) {
   for (uint32_t i = 0; i < bindings.size(); ++i) {
     GPUDescriptorBinding &binding = bindings[i];
     switch (binding.type) {
@@ -36,65 +95,157 @@ void VulkanDescriptorSet::Create(
       VulkanUniformBuffer *native_uniform_buffer =
           (VulkanUniformBuffer *)binding.uniform_buffer;
 
-      uniform_buffers_info[uniform_buffer_count].buffer =
-          native_uniform_buffer->GetBuffer().GetHandle();
-      uniform_buffers_info[uniform_buffer_count].offset = 0;
-      uniform_buffers_info[uniform_buffer_count].range =
-          native_uniform_buffer->GetDynamicAlignment();
-
-      // VK_CHECK(vkBindBufferMemory(
-      //     context->device->GetLogicalDevice(),
-      //     native_uniform_buffer->GetBuffer().GetHandle(),
-      //     native_uniform_buffer->GetBuffer().GetMemory(), 0));
-
-      builder = builder.BindBuffer(binding.binding,
-                                   &uniform_buffers_info[uniform_buffer_count],
-                                   VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
-                                   VK_SHADER_STAGE_ALL_GRAPHICS);
-      ++uniform_buffer_count;
+      VkDescriptorBufferInfo buffer_info = {};
+      buffer_info.buffer = native_uniform_buffer->GetBuffer().GetHandle();
+      buffer_info.offset = uniform_buffer_offset;
+      buffer_info.range = native_uniform_buffer->GetDynamicAlignment();
+
+      builder.BindBuffer(binding.binding, &buffer_info, uniform_buffer_type);
+      AddResource(set_info, binding.binding, uniform_buffer_type,
+                  (uint64_t)buffer_info.buffer, 0, buffer_info.offset,
+                  buffer_info.range, VK_IMAGE_LAYOUT_UNDEFINED);
     } break;
     case GPU_DESCRIPTOR_BINDING_TYPE_TEXTURE: {
       VulkanTexture *native_texture = (VulkanTexture *)binding.texture;
 
-      texture_infos[texture_count].sampler = native_texture->GetSampler();
-      texture_infos[texture_count].imageView = native_texture->GetImageView();
-      texture_infos[texture_count].imageLayout =
-          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      VkDescriptorImageInfo image_info = {};
+      image_info.sampler = native_texture->GetSampler();
+      image_info.imageView = native_texture->GetImageView();
+      image_info.imageLayout = native_texture->GetShaderLayout();
 
-      builder =
-          builder.BindImage(binding.binding, &texture_infos[texture_count],
-                            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                            VK_SHADER_STAGE_ALL_GRAPHICS);
-      texture_count++;
+      builder.BindImage(binding.binding, &image_info,
+                        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+      AddResource(set_info, binding.binding,
+                  VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                  (uint64_t)image_info.imageView, image_info.sampler, 0, 0,
+                  image_info.imageLayout);
     } break;
     case GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT: {
       VulkanAttachment *native_attachment =
           (VulkanAttachment *)binding.attachment;
+      if (native_attachment->GetFlags() & GPU_ATTACHMENT_FLAG_TRANSIENT) {
+        ERROR("Attachment of binding %u is transient, it can't be sampled!",
+              binding.binding);
+        continue;
+      }
+
+      bool is_depth_attachment =
+          GPUUtils::IsDepthFormat(binding.attachment->GetFormat());
+
+      VkDescriptorImageInfo image_info = {};
+      image_info.sampler = native_attachment->GetSampler();
+      image_info.imageView = native_attachment->GetImageView();
+      image_info.imageLayout =
+          is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                              : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+      builder.BindImage(binding.binding, &image_info,
+                        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+      AddResource(set_info, binding.binding,
+                  VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                  (uint64_t)image_info.imageView, image_info.sampler, 0, 0,
+                  image_info.imageLayout);
+    } break;
+    case GPU_DESCRIPTOR_BINDING_TYPE_INPUT_ATTACHMENT: {
+      VulkanAttachment *native_attachment =
+          (VulkanAttachment *)binding.attachment;
+      if (!(native_attachment->GetFlags() & GPU_ATTACHMENT_FLAG_INPUT)) {
+        ERROR("Attachment of binding %u is not an input attachment!",
+              binding.binding);
+        continue;
+      }
 
       bool is_depth_attachment =
           GPUUtils::IsDepthFormat(binding.attachment->GetFormat());
 
-      attachment_infos[attachment_count].sampler =
-          native_attachment->GetSampler();
-      attachment_infos[attachment_count].imageView =
-          native_attachment->GetImageView();
-      attachment_infos[attachment_count].imageLayout =
+      /* same layouts as the input attachment references of the subpasses */
+      VkDescriptorImageInfo image_info = {};
+      image_info.sampler = 0;
+      image_info.imageView = native_attachment->GetImageView();
+      image_info.imageLayout =
           is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
                               : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-      builder = builder.BindImage(binding.binding,
-                                  &attachment_infos[attachment_count],
-                                  VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                  VK_SHADER_STAGE_ALL_GRAPHICS);
-      attachment_count++;
+      builder.BindImage(binding.binding, &image_info,
+                        VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT);
+      AddResource(set_info, binding.binding,
+                  VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+                  (uint64_t)image_info.imageView, 0, 0, 0,
+                  image_info.imageLayout);
+    } break;
+    case GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_BUFFER: {
+      VulkanStorageBuffer *native_storage_buffer =
+          (VulkanStorageBuffer *)binding.storage_buffer;
+
+      VkDescriptorBufferInfo buffer_info = {};
+      buffer_info.buffer = native_storage_buffer->GetBuffer().GetHandle();
+      buffer_info.offset = 0;
+      buffer_info.range = VK_WHOLE_SIZE;
+
+      builder.BindBuffer(binding.binding, &buffer_info,
+                         VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+      AddResource(set_info, binding.binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                  (uint64_t)buffer_info.buffer, 0, buffer_info.offset,
+                  buffer_info.range, VK_IMAGE_LAYOUT_UNDEFINED);
+    } break;
+    case GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_TEXTURE: {
+      VulkanTexture *native_texture = (VulkanTexture *)binding.texture;
+      if (!(native_texture->GetFlags() & GPU_TEXTURE_FLAG_STORAGE)) {
+        ERROR("Texture of binding %u is not a storage texture!",
+              binding.binding);
+        continue;
+      }
+
+      VkDescriptorImageInfo image_info = {};
+      image_info.sampler = 0;
+      image_info.imageView = native_texture->GetImageView();
+      image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+      builder.BindImage(binding.binding, &image_info,
+                        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+      AddResource(set_info, binding.binding, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                  (uint64_t)image_info.imageView, 0, 0, 0,
+                  image_info.imageLayout);
+    } break;
+    case GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_TEXEL_BUFFER:
+    case GPU_DESCRIPTOR_BINDING_TYPE_STORAGE_TEXEL_BUFFER: {
+      VulkanStorageBuffer *native_storage_buffer =
+          (VulkanStorageBuffer *)binding.storage_buffer;
+      if (!native_storage_buffer->GetView()) {
+        ERROR("Storage buffer of binding %u has no texel format!",
+              binding.binding);
+        continue;
+      }
+
+      VkDescriptorType type =
+          binding.type == GPU_DESCRIPTOR_BINDING_TYPE_UNIFORM_TEXEL_BUFFER
+              ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+              : VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+      VkBufferView buffer_view = native_storage_buffer->GetView();
+
+      builder.BindTexelBuffer(binding.binding, &buffer_view, type);
+      AddResource(set_info, binding.binding, type, (uint64_t)buffer_view, 0, 0,
+                  0, VK_IMAGE_LAYOUT_UNDEFINED);
     } break;
     }
   }
 
-  builder.Build(&set, &layout);
+  std::sort(set_info.resources.begin(), set_info.resources.end(),
+            [](VulkanDescriptorSetCache::DescriptorSetResource &a,
+               VulkanDescriptorSetCache::DescriptorSetResource &b) {
+              return a.binding < b.binding;
+            });
 }
 
-void VulkanDescriptorSet::Destroy() { bindings.clear(); }
+void VulkanDescriptorSet::Destroy() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (set) {
+    context->descriptor_set_cache->Release(set);
+    set = 0;
+  }
+  bindings.clear();
+}
 
 void VulkanDescriptorSet::SetDebugName(const char *name) {
   VulkanDebugUtils::SetObjectName(name, (uint64_t)set,
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "../gpu_descriptor_set.h"
+#include "vulkan_descriptor_builder.h"
+#include "vulkan_descriptor_set_cache.h"
 
 #include <vulkan/vulkan.h>
 
 class VulkanDescriptorSet : public GPUDescriptorSet {
 public:
-  void Create(std::vector<GPUDescriptorBinding> &set_bindings) override;
+  void Create(GPUShader *shader, uint32_t set_index,
+              std::vector<GPUDescriptorBinding> &set_bindings) override;
+  void Create(GPUComputeShader *shader, uint32_t set_index,
+              std::vector<GPUDescriptorBinding> &set_bindings) override;
   void Destroy() override;
 
   void SetDebugName(const char *name) override;
@@ -15,7 +20,19 @@ public:
   inline VkDescriptorSet &GetSet() { return set; }
   inline VkDescriptorSetLayout GetLayout() { return layout; }
 
+  /* adds the bindings to the builder and to the cache key. Uniform buffers
+   * are bound at uniform_buffer_offset with uniform_buffer_type */
+  static void
+  GatherBindings(std::vector<GPUDescriptorBinding> &bindings,
+                 uint32_t uniform_buffer_offset,
+                 VkDescriptorType uniform_buffer_type,
+                 VulkanDescriptorBuilder &builder,
+                 VulkanDescriptorSetCache::DescriptorSetInfo &set_info);
+
 private:
+  void CreateWithLayout(VkDescriptorSetLayout set_layout, uint32_t set_index,
+                        std::vector<GPUDescriptorBinding> &set_bindings);
+
   VkDescriptorSet set;
   VkDescriptorSetLayout layout;
 };
\ No newline at end of file
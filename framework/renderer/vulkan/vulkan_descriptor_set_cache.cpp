@@ -0,0 +1,118 @@
+#include "vulkan_descriptor_set_cache.h"
+
+#include "../../logger.h"
+#include "vulkan_backend.h"
+
+void VulkanDescriptorSetCache::Initialize() {}
+
+void VulkanDescriptorSetCache::Shutdown() {
+  /* the sets themselves are freed with their pools */
+  set_cache.clear();
+  entries.clear();
+}
+
+VkDescriptorSet VulkanDescriptorSetCache::Acquire(DescriptorSetInfo &info) {
+  auto it = set_cache.find(info);
+  if (it == set_cache.end()) {
+    return 0;
+  }
+
+  entries[it->second].reference_count++;
+
+  return it->second;
+}
+
+void VulkanDescriptorSetCache::Insert(DescriptorSetInfo &info,
+                                      VkDescriptorSet set) {
+  DescriptorSetEntry entry;
+  entry.info = info;
+  entry.reference_count = 1;
+  entry.cached = true;
+
+  set_cache[info] = set;
+  entries[set] = entry;
+}
+
+void VulkanDescriptorSetCache::Release(VkDescriptorSet set) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  auto it = entries.find(set);
+  if (it == entries.end()) {
+    WARN("Releasing a descriptor set that is not in the cache!");
+    return;
+  }
+
+  if (--it->second.reference_count > 0) {
+    return;
+  }
+
+  if (it->second.cached) {
+    set_cache.erase(it->second.info);
+  }
+  entries.erase(it);
+
+  context->descriptor_pools->Free(set);
+}
+
+void VulkanDescriptorSetCache::InvalidateResource(uint64_t handle) {
+  if (!handle) {
+    return;
+  }
+
+  /* the handle may be reused by a new resource, so the sets can't be found
+   * by it anymore. Those still referenced are freed on release */
+  for (auto &pair : entries) {
+    DescriptorSetEntry &entry = pair.second;
+    if (!entry.cached) {
+      continue;
+    }
+
+    for (uint32_t i = 0; i < entry.info.resources.size(); ++i) {
+      DescriptorSetResource &resource = entry.info.resources[i];
+      if (resource.handle == handle || (uint64_t)resource.sampler == handle) {
+        set_cache.erase(entry.info);
+        entry.cached = false;
+        break;
+      }
+    }
+  }
+}
+
+bool VulkanDescriptorSetCache::DescriptorSetInfo::operator==(
+    const DescriptorSetInfo &other) const {
+  if (other.layout != layout ||
+      other.resources.size() != resources.size()) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < resources.size(); ++i) {
+    const DescriptorSetResource &a = resources[i];
+    const DescriptorSetResource &b = other.resources[i];
+    if (a.binding != b.binding || a.type != b.type || a.handle != b.handle ||
+        a.sampler != b.sampler || a.offset != b.offset || a.range != b.range ||
+        a.image_layout != b.image_layout) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+size_t VulkanDescriptorSetCache::DescriptorSetInfo::hash() const {
+  using std::hash;
+  using std::size_t;
+
+  size_t result = hash<uint64_t>()((uint64_t)layout);
+
+  for (const DescriptorSetResource &resource : resources) {
+    size_t resource_hash = hash<uint64_t>()(resource.handle) ^
+                           hash<uint64_t>()((uint64_t)resource.sampler) << 1;
+    resource_hash ^= (resource.binding | resource.type << 8 |
+                      resource.image_layout << 16) +
+                     resource.range;
+
+    result = result * 31 + resource_hash;
+  }
+
+  return result;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+/* Deduplicates descriptor sets by their content: sets with the same layout
+ * and the same resources share one VkDescriptorSet. The sets are reference
+ * counted, and the cached sets that use a destroyed resource are not handed
+ * out anymore */
+class VulkanDescriptorSetCache {
+public:
+  void Initialize();
+  void Shutdown();
+
+  struct DescriptorSetResource {
+    uint32_t binding;
+    VkDescriptorType type;
+    /* buffer or image view */
+    uint64_t handle;
+    VkSampler sampler;
+    VkDeviceSize offset;
+    VkDeviceSize range;
+    VkImageLayout image_layout;
+  };
+
+  struct DescriptorSetInfo {
+    VkDescriptorSetLayout layout;
+    /* ordered by the binding */
+    std::vector<DescriptorSetResource> resources;
+
+    bool operator==(const DescriptorSetInfo &other) const;
+    size_t hash() const;
+  };
+
+  /* returns the cached set and references it, 0 if there is none */
+  VkDescriptorSet Acquire(DescriptorSetInfo &info);
+  /* caches a newly written set, with a single reference */
+  void Insert(DescriptorSetInfo &info, VkDescriptorSet set);
+  void Release(VkDescriptorSet set);
+  /* should be called when a buffer, an image view or a sampler is destroyed */
+  void InvalidateResource(uint64_t handle);
+
+private:
+  struct DescriptorSetHash {
+    std::size_t operator()(const DescriptorSetInfo &info) const {
+      return info.hash();
+    }
+  };
+
+  struct DescriptorSetEntry {
+    DescriptorSetInfo info;
+    uint32_t reference_count;
+    /* false once a resource of the set is destroyed */
+    bool cached;
+  };
+
+  std::unordered_map<DescriptorSetInfo, VkDescriptorSet, DescriptorSetHash>
+      set_cache;
+  std::unordered_map<VkDescriptorSet, DescriptorSetEntry> entries;
+};
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include <set>
 #include <string.h>
+#include <utility>
 
 bool VulkanDevice::Create(VulkanPhysicalDeviceRequirements *requirements) {
   VulkanContext *context = VulkanBackend::GetContext();
@@ -26,6 +27,9 @@ bool VulkanDevice::Create(VulkanPhysicalDeviceRequirements *requirements) {
     case VULKAN_DEVICE_QUEUE_TYPE_TRANSFER: {
       DEBUG("Transfer family index: %d", it->second.family_index);
     } break;
+    case VULKAN_DEVICE_QUEUE_TYPE_COMPUTE: {
+      DEBUG("Compute family index: %d", it->second.family_index);
+    } break;
     }
   }
 
@@ -68,9 +72,276 @@ bool VulkanDevice::Create(VulkanPhysicalDeviceRequirements *requirements) {
   device_features.geometryShader = features.geometryShader;
   device_features.tessellationShader = features.tessellationShader;
 
+  /* query the optional features. Feature structures may be chained only for
+   * the extensions the device exposes */
+  VkPhysicalDeviceExtendedDynamicStateFeaturesEXT
+      supported_extended_dynamic_state = {};
+  supported_extended_dynamic_state.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+  supported_extended_dynamic_state.pNext = 0;
+  VkPhysicalDeviceExtendedDynamicState2FeaturesEXT
+      supported_extended_dynamic_state2 = {};
+  supported_extended_dynamic_state2.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+  supported_extended_dynamic_state2.pNext = 0;
+  VkPhysicalDeviceExtendedDynamicState3FeaturesEXT
+      supported_extended_dynamic_state3 = {};
+  supported_extended_dynamic_state3.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+  supported_extended_dynamic_state3.pNext = 0;
+  VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT
+      supported_graphics_pipeline_library = {};
+  supported_graphics_pipeline_library.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+  supported_graphics_pipeline_library.pNext = 0;
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported_descriptor_indexing =
+      {};
+  supported_descriptor_indexing.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+  supported_descriptor_indexing.pNext = 0;
+  VkPhysicalDeviceTimelineSemaphoreFeatures supported_timeline_semaphore = {};
+  supported_timeline_semaphore.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  supported_timeline_semaphore.pNext = 0;
+  VkPhysicalDeviceDynamicRenderingFeatures supported_dynamic_rendering = {};
+  supported_dynamic_rendering.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+  supported_dynamic_rendering.pNext = 0;
+  VkPhysicalDevicePresentIdFeaturesKHR supported_present_id = {};
+  supported_present_id.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+  supported_present_id.pNext = 0;
+  VkPhysicalDevicePresentWaitFeaturesKHR supported_present_wait = {};
+  supported_present_wait.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+  supported_present_wait.pNext = 0;
+
+  VkPhysicalDeviceFeatures2 supported_features = {};
+  supported_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supported_features.pNext = 0;
+  if (DeviceExtensionAvailable(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+    supported_extended_dynamic_state.pNext = supported_features.pNext;
+    supported_features.pNext = &supported_extended_dynamic_state;
+  }
+  if (DeviceExtensionAvailable(
+          VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+    supported_extended_dynamic_state2.pNext = supported_features.pNext;
+    supported_features.pNext = &supported_extended_dynamic_state2;
+  }
+  if (DeviceExtensionAvailable(
+          VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+    supported_extended_dynamic_state3.pNext = supported_features.pNext;
+    supported_features.pNext = &supported_extended_dynamic_state3;
+  }
+  /* depends on VK_KHR_pipeline_library */
+  if (DeviceExtensionAvailable(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+      DeviceExtensionAvailable(
+          VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+    supported_graphics_pipeline_library.pNext = supported_features.pNext;
+    supported_features.pNext = &supported_graphics_pipeline_library;
+  }
+  if (DeviceExtensionAvailable(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+    supported_descriptor_indexing.pNext = supported_features.pNext;
+    supported_features.pNext = &supported_descriptor_indexing;
+  }
+  bool timeline_semaphore_core =
+      properties.apiVersion >= VK_API_VERSION_1_2;
+  if (timeline_semaphore_core ||
+      DeviceExtensionAvailable(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) {
+    supported_timeline_semaphore.pNext = supported_features.pNext;
+    supported_features.pNext = &supported_timeline_semaphore;
+  }
+  bool dynamic_rendering_core = properties.apiVersion >= VK_API_VERSION_1_3;
+  if (dynamic_rendering_core ||
+      DeviceExtensionAvailable(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+    supported_dynamic_rendering.pNext = supported_features.pNext;
+    supported_features.pNext = &supported_dynamic_rendering;
+  }
+  /* present wait depends on present id */
+  if (DeviceExtensionAvailable(VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+      DeviceExtensionAvailable(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+    supported_present_id.pNext = supported_features.pNext;
+    supported_features.pNext = &supported_present_id;
+    supported_present_wait.pNext = supported_features.pNext;
+    supported_features.pNext = &supported_present_wait;
+  }
+  vkGetPhysicalDeviceFeatures2(physical_device, &supported_features);
+
+  /* enable only what we are going to use */
+  void *enabled_features = 0;
+  optional_features = {};
+
+  VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extended_dynamic_state = {};
+  extended_dynamic_state.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+  extended_dynamic_state.pNext = 0;
+  if (supported_extended_dynamic_state.extendedDynamicState) {
+    extended_dynamic_state.extendedDynamicState = VK_TRUE;
+    extended_dynamic_state.pNext = enabled_features;
+    enabled_features = &extended_dynamic_state;
+    required_extension_names.emplace_back(
+        VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+    optional_features.extended_dynamic_state = true;
+  }
+
+  VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extended_dynamic_state2 =
+      {};
+  extended_dynamic_state2.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+  extended_dynamic_state2.pNext = 0;
+  if (supported_extended_dynamic_state2.extendedDynamicState2) {
+    extended_dynamic_state2.extendedDynamicState2 = VK_TRUE;
+    extended_dynamic_state2.pNext = enabled_features;
+    enabled_features = &extended_dynamic_state2;
+    required_extension_names.emplace_back(
+        VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+    optional_features.extended_dynamic_state2 = true;
+  }
+
+  VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extended_dynamic_state3 =
+      {};
+  extended_dynamic_state3.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+  extended_dynamic_state3.pNext = 0;
+  if (supported_extended_dynamic_state3
+          .extendedDynamicState3ColorBlendEnable &&
+      supported_extended_dynamic_state3
+          .extendedDynamicState3ColorBlendEquation &&
+      supported_extended_dynamic_state3.extendedDynamicState3ColorWriteMask) {
+    extended_dynamic_state3.extendedDynamicState3ColorBlendEnable = VK_TRUE;
+    extended_dynamic_state3.extendedDynamicState3ColorBlendEquation = VK_TRUE;
+    extended_dynamic_state3.extendedDynamicState3ColorWriteMask = VK_TRUE;
+    extended_dynamic_state3.pNext = enabled_features;
+    enabled_features = &extended_dynamic_state3;
+    required_extension_names.emplace_back(
+        VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+    optional_features.extended_dynamic_state3 = true;
+  }
+
+  VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT
+      graphics_pipeline_library = {};
+  graphics_pipeline_library.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+  graphics_pipeline_library.pNext = 0;
+  if (supported_graphics_pipeline_library.graphicsPipelineLibrary) {
+    graphics_pipeline_library.graphicsPipelineLibrary = VK_TRUE;
+    graphics_pipeline_library.pNext = enabled_features;
+    enabled_features = &graphics_pipeline_library;
+    required_extension_names.emplace_back(
+        VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+    required_extension_names.emplace_back(
+        VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    optional_features.graphics_pipeline_library = true;
+  }
+
+  /* the bindless texture table is a partially bound, update after bind
+   * array of combined image samplers, indexed dynamically by the shaders */
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing = {};
+  descriptor_indexing.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+  descriptor_indexing.pNext = 0;
+  if (supported_descriptor_indexing.runtimeDescriptorArray &&
+      supported_descriptor_indexing.descriptorBindingPartiallyBound &&
+      supported_descriptor_indexing
+          .descriptorBindingSampledImageUpdateAfterBind &&
+      supported_descriptor_indexing
+          .descriptorBindingUpdateUnusedWhilePending &&
+      supported_descriptor_indexing
+          .shaderSampledImageArrayNonUniformIndexing) {
+    if (!supported_features.features.shaderSampledImageArrayDynamicIndexing) {
+      ERROR("Descriptor indexing is supported without dynamic indexing of "
+            "sampled image arrays!");
+      return false;
+    }
+    device_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+    descriptor_indexing.runtimeDescriptorArray = VK_TRUE;
+    descriptor_indexing.descriptorBindingPartiallyBound = VK_TRUE;
+    descriptor_indexing.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    descriptor_indexing.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    descriptor_indexing.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    descriptor_indexing.pNext = enabled_features;
+    enabled_features = &descriptor_indexing;
+    required_extension_names.emplace_back(
+        VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    optional_features.descriptor_indexing = true;
+  }
+
+  VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore = {};
+  timeline_semaphore.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  timeline_semaphore.pNext = 0;
+  if (supported_timeline_semaphore.timelineSemaphore) {
+    timeline_semaphore.timelineSemaphore = VK_TRUE;
+    timeline_semaphore.pNext = enabled_features;
+    enabled_features = &timeline_semaphore;
+    if (!timeline_semaphore_core) {
+      required_extension_names.emplace_back(
+          VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+    optional_features.timeline_semaphore = true;
+  }
+
+  VkPhysicalDeviceDynamicRenderingFeatures dynamic_rendering = {};
+  dynamic_rendering.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+  dynamic_rendering.pNext = 0;
+  if (supported_dynamic_rendering.dynamicRendering) {
+    dynamic_rendering.dynamicRendering = VK_TRUE;
+    dynamic_rendering.pNext = enabled_features;
+    enabled_features = &dynamic_rendering;
+    if (!dynamic_rendering_core) {
+      /* depends on VK_KHR_depth_stencil_resolve and
+       * VK_KHR_create_renderpass2 */
+      required_extension_names.emplace_back(
+          VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+      required_extension_names.emplace_back(
+          VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+      required_extension_names.emplace_back(
+          VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    }
+    optional_features.dynamic_rendering = true;
+  }
+
+  VkPhysicalDevicePresentIdFeaturesKHR present_id = {};
+  present_id.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+  present_id.pNext = 0;
+  VkPhysicalDevicePresentWaitFeaturesKHR present_wait = {};
+  present_wait.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+  present_wait.pNext = 0;
+  if (supported_present_id.presentId && supported_present_wait.presentWait) {
+    present_id.presentId = VK_TRUE;
+    present_id.pNext = enabled_features;
+    enabled_features = &present_id;
+    present_wait.presentWait = VK_TRUE;
+    present_wait.pNext = enabled_features;
+    enabled_features = &present_wait;
+    required_extension_names.emplace_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+    required_extension_names.emplace_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    optional_features.present_wait = true;
+  }
+
+  if (DeviceExtensionAvailable(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)) {
+    required_extension_names.emplace_back(
+        VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    optional_features.push_descriptor = true;
+  }
+
+  DEBUG("Push descriptor: %d", optional_features.push_descriptor);
+  DEBUG("Descriptor indexing: %d", optional_features.descriptor_indexing);
+  DEBUG("Timeline semaphore: %d", optional_features.timeline_semaphore);
+  DEBUG("Dynamic rendering: %d", optional_features.dynamic_rendering);
+  DEBUG("Present wait: %d", optional_features.present_wait);
+  DEBUG("Graphics pipeline library: %d",
+        optional_features.graphics_pipeline_library);
+  DEBUG("Extended dynamic state: %d, 2: %d, 3: %d",
+        optional_features.extended_dynamic_state,
+        optional_features.extended_dynamic_state2,
+        optional_features.extended_dynamic_state3);
+
   VkDeviceCreateInfo device_create_info = {};
   device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-  device_create_info.pNext = 0;
+  device_create_info.pNext = enabled_features;
   device_create_info.flags = 0;
   device_create_info.queueCreateInfoCount = queue_create_infos.size();
   device_create_info.pQueueCreateInfos = queue_create_infos.data();
@@ -131,6 +402,7 @@ void VulkanDevice::Destroy() {
   queue_infos.clear();
   swapchain_support_info = {};
   depth_format = VK_FORMAT_UNDEFINED;
+  optional_features = {};
 }
 
 void VulkanDevice::UpdateSwapchainSupport() {
@@ -188,18 +460,31 @@ void VulkanDevice::UpdateDepthFormat() {
 void VulkanDevice::UpdateCommandBuffers() {
   VulkanContext *context = VulkanBackend::GetContext();
 
+  /* the existing command buffers may still be executing when the swapchain
+   * is recreated, so only the missing ones are allocated. The extra ones of a
+   * swapchain with less images are kept until the device is destroyed */
   for (auto it = queue_infos.begin(); it != queue_infos.end(); ++it) {
+    if (it->second.command_buffers.size() >=
+        context->swapchain->GetImageCount()) {
+      continue;
+    }
     it->second.command_buffers.resize(context->swapchain->GetImageCount());
     for (uint32_t i = 0; i < it->second.command_buffers.size(); ++i) {
-      if (it->second.command_buffers[i].GetHandle()) {
-        it->second.command_buffers[i].Free(it->second.command_pool);
+      if (!it->second.command_buffers[i].GetHandle()) {
+        it->second.command_buffers[i].Allocate(
+            it->second.command_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
       }
-      it->second.command_buffers[i].Allocate(it->second.command_pool,
-                                             VK_COMMAND_BUFFER_LEVEL_PRIMARY);
     }
   }
 }
 
+void VulkanDevice::SwapCommandBuffer(VulkanDeviceQueueType type,
+                                     uint32_t image_index,
+                                     VulkanCommandBuffer *command_buffer) {
+  std::swap(queue_infos.at(type).command_buffers[image_index],
+            *command_buffer);
+}
+
 bool VulkanDevice::SupportsDeviceLocalHostVisible() const {
   for (uint32_t i = 0; i < memory.memoryTypeCount; ++i) {
     if (((memory.memoryTypes[i].propertyFlags &
@@ -227,6 +512,26 @@ bool VulkanDevice::TransferQueueIsOnly() const {
   return transfer_only;
 }
 
+bool VulkanDevice::HasAsyncCompute() const {
+  if (!queue_infos.count(VULKAN_DEVICE_QUEUE_TYPE_COMPUTE)) {
+    return false;
+  }
+
+  return GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_COMPUTE).family_index !=
+         GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS).family_index;
+}
+
+uint32_t
+VulkanDevice::GetConcurrentQueueFamilyIndices(uint32_t *out_indices) const {
+  if (!HasAsyncCompute()) {
+    return 0;
+  }
+
+  out_indices[0] = GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS).family_index;
+  out_indices[1] = GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_COMPUTE).family_index;
+  return 2;
+}
+
 bool VulkanDevice::SelectPhysicalDevice(
     VulkanPhysicalDeviceRequirements *requirements) {
   VulkanContext *context = VulkanBackend::GetContext();
@@ -246,6 +551,10 @@ bool VulkanDevice::SelectPhysicalDevice(
     temp_queue_infos.emplace(VULKAN_DEVICE_QUEUE_TYPE_TRANSFER,
                              temp_queue_info);
   }
+  if (requirements->compute) {
+    temp_queue_infos.emplace(VULKAN_DEVICE_QUEUE_TYPE_COMPUTE,
+                             temp_queue_info);
+  }
 
   /* Select physical device */
   std::vector<VkPhysicalDevice> physical_devices;
@@ -284,7 +593,9 @@ bool VulkanDevice::SelectPhysicalDevice(
     for (uint32_t j = 0; j < queue_family_count; ++j) {
       VkQueueFamilyProperties queue_properties = queue_family_properties[j];
 
+      /* dispatches are recorded into the graphics command buffers */
       if ((queue_properties.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+          (queue_properties.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
           temp_queue_infos.count(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS)) {
         temp_queue_infos[VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS].family_index = j;
 
@@ -304,6 +615,27 @@ bool VulkanDevice::SelectPhysicalDevice(
       }
     }
 
+    /* a compute family without graphics runs its work alongside the
+     * graphics queue. Fall back to the graphics family if there is none */
+    if (temp_queue_infos.count(VULKAN_DEVICE_QUEUE_TYPE_COMPUTE)) {
+      for (uint32_t k = 0; k < queue_family_count; ++k) {
+        VkQueueFamilyProperties queue_properties = queue_family_properties[k];
+
+        if ((queue_properties.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+            !(queue_properties.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+          temp_queue_infos[VULKAN_DEVICE_QUEUE_TYPE_COMPUTE].family_index = k;
+          break;
+        }
+      }
+
+      if (temp_queue_infos[VULKAN_DEVICE_QUEUE_TYPE_COMPUTE].family_index ==
+              -1 &&
+          temp_queue_infos.count(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS)) {
+        temp_queue_infos[VULKAN_DEVICE_QUEUE_TYPE_COMPUTE].family_index =
+            temp_queue_infos[VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS].family_index;
+      }
+    }
+
     /* attempting to find a transfer-only queue (can be used for multithreaded
      * transfer operations) */
     if (temp_queue_infos.count(VULKAN_DEVICE_QUEUE_TYPE_TRANSFER)) {
@@ -334,6 +666,10 @@ bool VulkanDevice::SelectPhysicalDevice(
         (!requirements->transfer ||
          (requirements->transfer &&
           temp_queue_infos[VULKAN_DEVICE_QUEUE_TYPE_TRANSFER].family_index !=
+              -1)) &&
+        (!requirements->compute ||
+         (requirements->compute &&
+          temp_queue_infos[VULKAN_DEVICE_QUEUE_TYPE_COMPUTE].family_index !=
               -1))) {
       if (!DeviceExtensionsAvailable(
               current_physical_device,
@@ -416,8 +752,8 @@ bool VulkanDevice::DeviceExtensionsAvailable(VkPhysicalDevice physical_device,
     for (uint32_t i = 0; i < required_extension_count; ++i) {
       bool found = false;
       for (uint32_t j = 0; j < available_extension_count; ++j) {
-        if (strcmp(required_extensions[i],
-                   available_extensions[j].extensionName)) {
+        if (!strcmp(required_extensions[i],
+                    available_extensions[j].extensionName)) {
           DEBUG("Required device extension found: %s", required_extensions[i]);
           found = true;
           break;
@@ -433,4 +769,25 @@ bool VulkanDevice::DeviceExtensionsAvailable(VkPhysicalDevice physical_device,
   }
 
   return true;
+}
+bool VulkanDevice::DeviceExtensionAvailable(const char *extension_name) {
+  uint32_t available_extension_count = 0;
+  std::vector<VkExtensionProperties> available_extensions;
+
+  VK_CHECK(vkEnumerateDeviceExtensionProperties(physical_device, 0,
+                                                &available_extension_count, 0));
+  available_extensions.resize(available_extension_count);
+  if (available_extension_count != 0) {
+    VK_CHECK(vkEnumerateDeviceExtensionProperties(physical_device, 0,
+                                                  &available_extension_count,
+                                                  &available_extensions[0]));
+  }
+
+  for (uint32_t i = 0; i < available_extension_count; ++i) {
+    if (!strcmp(extension_name, available_extensions[i].extensionName)) {
+      return true;
+    }
+  }
+
+  return false;
 }
\ No newline at end of file
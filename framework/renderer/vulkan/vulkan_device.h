@@ -10,6 +10,9 @@ enum VulkanDeviceQueueType {
   VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS,
   VULKAN_DEVICE_QUEUE_TYPE_PRESENT,
   VULKAN_DEVICE_QUEUE_TYPE_TRANSFER,
+  /* a compute only family if the device has one, the graphics family
+   * otherwise */
+  VULKAN_DEVICE_QUEUE_TYPE_COMPUTE,
 };
 
 struct VulkanPhysicalDeviceRequirements {
@@ -17,6 +20,7 @@ struct VulkanPhysicalDeviceRequirements {
   bool graphics;
   bool present;
   bool transfer;
+  bool compute;
 };
 
 struct VulkanSwapchainSupportInfo {
@@ -25,6 +29,35 @@ struct VulkanSwapchainSupportInfo {
   std::vector<VkPresentModeKHR> present_modes;
 };
 
+/* optional device features, enabled only when the physical device supports
+ * them */
+struct VulkanDeviceOptionalFeatures {
+  /* VK_EXT_extended_dynamic_state: cull mode, front face, depth and stencil
+   * test state */
+  bool extended_dynamic_state;
+  /* VK_EXT_extended_dynamic_state2: depth bias enable */
+  bool extended_dynamic_state2;
+  /* VK_EXT_extended_dynamic_state3: color blend enable, equation and write
+   * mask */
+  bool extended_dynamic_state3;
+  /* VK_EXT_graphics_pipeline_library: pipelines are linked from cached
+   * parts */
+  bool graphics_pipeline_library;
+  /* VK_KHR_push_descriptor: per draw sets are pushed into the command
+   * buffer */
+  bool push_descriptor;
+  /* VK_EXT_descriptor_indexing: the bindless texture table */
+  bool descriptor_indexing;
+  /* VK_KHR_timeline_semaphore, core in 1.2: async compute synchronization */
+  bool timeline_semaphore;
+  /* VK_KHR_dynamic_rendering, core in 1.3: render passes are recorded
+   * without render pass and framebuffer objects */
+  bool dynamic_rendering;
+  /* VK_KHR_present_id and VK_KHR_present_wait: the frame limiter waits for
+   * the previous frame to be displayed */
+  bool present_wait;
+};
+
 /* queue family specific info */
 struct VulkanDeviceQueueInfo {
   uint32_t family_index;
@@ -41,6 +74,11 @@ public:
   void UpdateSwapchainSupport();
   void UpdateDepthFormat();
   void UpdateCommandBuffers();
+  /* exchanges the command buffer of the queue for the image index with
+   * another one allocated from the queue pool. Lets the frame continue
+   * recording after a part of it is submitted */
+  void SwapCommandBuffer(VulkanDeviceQueueType type, uint32_t image_index,
+                         VulkanCommandBuffer *command_buffer);
 
   inline VkPhysicalDevice GetPhysicalDevice() const { return physical_device; }
   inline VkDevice GetLogicalDevice() const { return logical_device; }
@@ -51,9 +89,18 @@ public:
     return swapchain_support_info;
   }
   inline VkFormat GetDepthFormat() const { return depth_format; }
+  inline VulkanDeviceOptionalFeatures GetOptionalFeatures() const {
+    return optional_features;
+  }
 
   bool SupportsDeviceLocalHostVisible() const;
   bool TransferQueueIsOnly() const;
+  /* the compute queue is in a family of its own, so its work can overlap
+   * the graphics work */
+  bool HasAsyncCompute() const;
+  /* families a resource shared with the async compute queue is used from.
+   * Returns 0 if the resource can be exclusive */
+  uint32_t GetConcurrentQueueFamilyIndices(uint32_t *out_indices) const;
 
   inline VkPhysicalDeviceProperties GetProperties() const { return properties; }
   inline VkPhysicalDeviceFeatures GetFeatures() const { return features; }
@@ -66,6 +113,7 @@ private:
   bool DeviceExtensionsAvailable(VkPhysicalDevice physical_device,
                                  uint32_t required_extension_count,
                                  const char **required_extensions);
+  bool DeviceExtensionAvailable(const char *extension_name);
 
   VkPhysicalDevice physical_device;
   VkDevice logical_device;
@@ -77,4 +125,5 @@ private:
   std::unordered_map<VulkanDeviceQueueType, VulkanDeviceQueueInfo> queue_infos;
   VulkanSwapchainSupportInfo swapchain_support_info;
   VkFormat depth_format;
+  VulkanDeviceOptionalFeatures optional_features;
 };
\ No newline at end of file
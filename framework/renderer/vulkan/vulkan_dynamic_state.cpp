@@ -0,0 +1,344 @@
+#include "vulkan_dynamic_state.h"
+
+#include "vulkan_backend.h"
+#include "vulkan_context.h"
+#include "vulkan_utils.h"
+
+#include <algorithm>
+
+PFN_vkCmdSetCullModeEXT VulkanDynamicState::vkDynamicStateSetCullMode;
+PFN_vkCmdSetFrontFaceEXT VulkanDynamicState::vkDynamicStateSetFrontFace;
+PFN_vkCmdSetDepthTestEnableEXT
+    VulkanDynamicState::vkDynamicStateSetDepthTestEnable;
+PFN_vkCmdSetDepthWriteEnableEXT
+    VulkanDynamicState::vkDynamicStateSetDepthWriteEnable;
+PFN_vkCmdSetDepthCompareOpEXT
+    VulkanDynamicState::vkDynamicStateSetDepthCompareOp;
+PFN_vkCmdSetStencilTestEnableEXT
+    VulkanDynamicState::vkDynamicStateSetStencilTestEnable;
+PFN_vkCmdSetStencilOpEXT VulkanDynamicState::vkDynamicStateSetStencilOp;
+PFN_vkCmdSetDepthBiasEnableEXT
+    VulkanDynamicState::vkDynamicStateSetDepthBiasEnable;
+PFN_vkCmdSetColorBlendEnableEXT
+    VulkanDynamicState::vkDynamicStateSetColorBlendEnable;
+PFN_vkCmdSetColorBlendEquationEXT
+    VulkanDynamicState::vkDynamicStateSetColorBlendEquation;
+PFN_vkCmdSetColorWriteMaskEXT
+    VulkanDynamicState::vkDynamicStateSetColorWriteMask;
+VulkanDeviceOptionalFeatures VulkanDynamicState::features;
+VulkanDynamicState::VulkanDynamicStateValues VulkanDynamicState::bound_values;
+bool VulkanDynamicState::bound_values_valid = false;
+
+static bool StencilOperationsEqual(const VkStencilOpState &a,
+                                   const VkStencilOpState &b) {
+  return a.failOp == b.failOp && a.passOp == b.passOp &&
+         a.depthFailOp == b.depthFailOp && a.compareOp == b.compareOp;
+}
+
+static bool BlendEquationsEqual(const VkColorBlendEquationEXT &a,
+                                const VkColorBlendEquationEXT &b) {
+  return a.srcColorBlendFactor == b.srcColorBlendFactor &&
+         a.dstColorBlendFactor == b.dstColorBlendFactor &&
+         a.colorBlendOp == b.colorBlendOp &&
+         a.srcAlphaBlendFactor == b.srcAlphaBlendFactor &&
+         a.dstAlphaBlendFactor == b.dstAlphaBlendFactor &&
+         a.alphaBlendOp == b.alphaBlendOp;
+}
+
+void VulkanDynamicState::Initialize() {
+  VulkanContext *context = VulkanBackend::GetContext();
+  VkDevice device = context->device->GetLogicalDevice();
+
+  features = context->device->GetOptionalFeatures();
+
+  if (features.extended_dynamic_state) {
+    vkDynamicStateSetCullMode = (PFN_vkCmdSetCullModeEXT)vkGetDeviceProcAddr(
+        device, "vkCmdSetCullModeEXT");
+    vkDynamicStateSetFrontFace = (PFN_vkCmdSetFrontFaceEXT)vkGetDeviceProcAddr(
+        device, "vkCmdSetFrontFaceEXT");
+    vkDynamicStateSetDepthTestEnable =
+        (PFN_vkCmdSetDepthTestEnableEXT)vkGetDeviceProcAddr(
+            device, "vkCmdSetDepthTestEnableEXT");
+    vkDynamicStateSetDepthWriteEnable =
+        (PFN_vkCmdSetDepthWriteEnableEXT)vkGetDeviceProcAddr(
+            device, "vkCmdSetDepthWriteEnableEXT");
+    vkDynamicStateSetDepthCompareOp =
+        (PFN_vkCmdSetDepthCompareOpEXT)vkGetDeviceProcAddr(
+            device, "vkCmdSetDepthCompareOpEXT");
+    vkDynamicStateSetStencilTestEnable =
+        (PFN_vkCmdSetStencilTestEnableEXT)vkGetDeviceProcAddr(
+            device, "vkCmdSetStencilTestEnableEXT");
+    vkDynamicStateSetStencilOp = (PFN_vkCmdSetStencilOpEXT)vkGetDeviceProcAddr(
+        device, "vkCmdSetStencilOpEXT");
+
+    features.extended_dynamic_state =
+        vkDynamicStateSetCullMode && vkDynamicStateSetFrontFace &&
+        vkDynamicStateSetDepthTestEnable && vkDynamicStateSetDepthWriteEnable &&
+        vkDynamicStateSetDepthCompareOp && vkDynamicStateSetStencilTestEnable &&
+        vkDynamicStateSetStencilOp;
+  }
+
+  if (features.extended_dynamic_state2) {
+    vkDynamicStateSetDepthBiasEnable =
+        (PFN_vkCmdSetDepthBiasEnableEXT)vkGetDeviceProcAddr(
+            device, "vkCmdSetDepthBiasEnableEXT");
+
+    features.extended_dynamic_state2 = vkDynamicStateSetDepthBiasEnable != 0;
+  }
+
+  if (features.extended_dynamic_state3) {
+    vkDynamicStateSetColorBlendEnable =
+        (PFN_vkCmdSetColorBlendEnableEXT)vkGetDeviceProcAddr(
+            device, "vkCmdSetColorBlendEnableEXT");
+    vkDynamicStateSetColorBlendEquation =
+        (PFN_vkCmdSetColorBlendEquationEXT)vkGetDeviceProcAddr(
+            device, "vkCmdSetColorBlendEquationEXT");
+    vkDynamicStateSetColorWriteMask =
+        (PFN_vkCmdSetColorWriteMaskEXT)vkGetDeviceProcAddr(
+            device, "vkCmdSetColorWriteMaskEXT");
+
+    features.extended_dynamic_state3 = vkDynamicStateSetColorBlendEnable &&
+                                       vkDynamicStateSetColorBlendEquation &&
+                                       vkDynamicStateSetColorWriteMask;
+  }
+}
+
+void VulkanDynamicState::GetDynamicStates(
+    std::vector<VkDynamicState> &dynamic_states) {
+  dynamic_states.emplace_back(VK_DYNAMIC_STATE_VIEWPORT);
+  dynamic_states.emplace_back(VK_DYNAMIC_STATE_SCISSOR);
+  /* core since 1.0 */
+  dynamic_states.emplace_back(VK_DYNAMIC_STATE_DEPTH_BIAS);
+  dynamic_states.emplace_back(VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK);
+  dynamic_states.emplace_back(VK_DYNAMIC_STATE_STENCIL_WRITE_MASK);
+  dynamic_states.emplace_back(VK_DYNAMIC_STATE_STENCIL_REFERENCE);
+
+  /* NOTE: VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY is not used, since every
+   * topology we support belongs to its own topology class, and pipelines
+   * can't switch between those dynamically */
+  if (features.extended_dynamic_state) {
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_FRONT_FACE_EXT);
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT);
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT);
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT);
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT);
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_STENCIL_OP_EXT);
+  }
+
+  if (features.extended_dynamic_state2) {
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT);
+  }
+
+  if (features.extended_dynamic_state3) {
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT);
+    dynamic_states.emplace_back(VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT);
+  }
+}
+
+void VulkanDynamicState::ClearDynamicState(GPUShaderRenderState *render_state,
+                                           uint8_t *depth_flags,
+                                           uint8_t *stencil_flags) {
+  GPUShaderRenderState defaults;
+
+  render_state->depth_bias_constant_factor =
+      defaults.depth_bias_constant_factor;
+  render_state->depth_bias_clamp = defaults.depth_bias_clamp;
+  render_state->depth_bias_slope_factor = defaults.depth_bias_slope_factor;
+  render_state->stencil_front.compare_mask =
+      defaults.stencil_front.compare_mask;
+  render_state->stencil_front.write_mask = defaults.stencil_front.write_mask;
+  render_state->stencil_front.reference = defaults.stencil_front.reference;
+  render_state->stencil_back.compare_mask = defaults.stencil_back.compare_mask;
+  render_state->stencil_back.write_mask = defaults.stencil_back.write_mask;
+  render_state->stencil_back.reference = defaults.stencil_back.reference;
+
+  if (features.extended_dynamic_state) {
+    render_state->cull_mode = defaults.cull_mode;
+    render_state->front_face = defaults.front_face;
+    render_state->depth_compare_operation = defaults.depth_compare_operation;
+    render_state->stencil_front = defaults.stencil_front;
+    render_state->stencil_back = defaults.stencil_back;
+    *depth_flags = 0;
+    *stencil_flags = 0;
+  }
+
+  if (features.extended_dynamic_state2) {
+    render_state->depth_bias_enable = defaults.depth_bias_enable;
+  }
+
+  if (features.extended_dynamic_state3) {
+    render_state->blend_states.clear();
+  }
+}
+
+void VulkanDynamicState::Set(VulkanCommandBuffer *command_buffer,
+                             GPUShaderRenderState *render_state,
+                             uint8_t depth_flags, uint8_t stencil_flags,
+                             uint32_t color_attachment_count) {
+  VkCommandBuffer handle = command_buffer->GetHandle();
+  VulkanDynamicStateValues *bound = &bound_values;
+  bool valid = bound_values_valid;
+  bound_values_valid = true;
+
+  if (!valid ||
+      bound->depth_bias[0] != render_state->depth_bias_constant_factor ||
+      bound->depth_bias[1] != render_state->depth_bias_clamp ||
+      bound->depth_bias[2] != render_state->depth_bias_slope_factor) {
+    vkCmdSetDepthBias(handle, render_state->depth_bias_constant_factor,
+                      render_state->depth_bias_clamp,
+                      render_state->depth_bias_slope_factor);
+    bound->depth_bias[0] = render_state->depth_bias_constant_factor;
+    bound->depth_bias[1] = render_state->depth_bias_clamp;
+    bound->depth_bias[2] = render_state->depth_bias_slope_factor;
+  }
+
+  GPUShaderStencilState *stencil_states[2] = {&render_state->stencil_front,
+                                              &render_state->stencil_back};
+  const VkStencilFaceFlags faces[2] = {VK_STENCIL_FACE_FRONT_BIT,
+                                       VK_STENCIL_FACE_BACK_BIT};
+  for (uint32_t i = 0; i < 2; ++i) {
+    GPUShaderStencilState *stencil_state = stencil_states[i];
+    if (!valid || bound->compare_masks[i] != stencil_state->compare_mask) {
+      vkCmdSetStencilCompareMask(handle, faces[i],
+                                 stencil_state->compare_mask);
+      bound->compare_masks[i] = stencil_state->compare_mask;
+    }
+    if (!valid || bound->write_masks[i] != stencil_state->write_mask) {
+      vkCmdSetStencilWriteMask(handle, faces[i], stencil_state->write_mask);
+      bound->write_masks[i] = stencil_state->write_mask;
+    }
+    if (!valid || bound->references[i] != stencil_state->reference) {
+      vkCmdSetStencilReference(handle, faces[i], stencil_state->reference);
+      bound->references[i] = stencil_state->reference;
+    }
+  }
+
+  if (features.extended_dynamic_state) {
+    VkCullModeFlags cull_mode =
+        VulkanUtils::GPUShaderCullModeToVulkanCullMode(render_state->cull_mode);
+    if (!valid || bound->cull_mode != cull_mode) {
+      vkDynamicStateSetCullMode(handle, cull_mode);
+      bound->cull_mode = cull_mode;
+    }
+
+    VkFrontFace front_face = VulkanUtils::GPUShaderFrontFaceToVulkanFrontFace(
+        render_state->front_face);
+    if (!valid || bound->front_face != front_face) {
+      vkDynamicStateSetFrontFace(handle, front_face);
+      bound->front_face = front_face;
+    }
+
+    VkBool32 depth_test_enable =
+        (depth_flags & GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE) ? VK_TRUE
+                                                               : VK_FALSE;
+    if (!valid || bound->depth_test_enable != depth_test_enable) {
+      vkDynamicStateSetDepthTestEnable(handle, depth_test_enable);
+      bound->depth_test_enable = depth_test_enable;
+    }
+
+    VkBool32 depth_write_enable =
+        (depth_flags & GPU_SHADER_DEPTH_FLAG_DEPTH_WRITE_ENABLE) ? VK_TRUE
+                                                                : VK_FALSE;
+    if (!valid || bound->depth_write_enable != depth_write_enable) {
+      vkDynamicStateSetDepthWriteEnable(handle, depth_write_enable);
+      bound->depth_write_enable = depth_write_enable;
+    }
+
+    VkCompareOp depth_compare_operation =
+        VulkanUtils::GPUShaderCompareOperationToVulkanCompareOp(
+            render_state->depth_compare_operation);
+    if (!valid || bound->depth_compare_operation != depth_compare_operation) {
+      vkDynamicStateSetDepthCompareOp(handle, depth_compare_operation);
+      bound->depth_compare_operation = depth_compare_operation;
+    }
+
+    VkBool32 stencil_test_enable =
+        (stencil_flags & GPU_SHADER_STENCIL_FLAG_STENCIL_TEST_ENABLE)
+            ? VK_TRUE
+            : VK_FALSE;
+    if (!valid || bound->stencil_test_enable != stencil_test_enable) {
+      vkDynamicStateSetStencilTestEnable(handle, stencil_test_enable);
+      bound->stencil_test_enable = stencil_test_enable;
+    }
+
+    for (uint32_t i = 0; i < 2; ++i) {
+      VkStencilOpState stencil_operation =
+          VulkanUtils::GPUShaderStencilStateToVulkanStencilOpState(
+              stencil_states[i]);
+      if (valid && StencilOperationsEqual(bound->stencil_operations[i],
+                                          stencil_operation)) {
+        continue;
+      }
+
+      vkDynamicStateSetStencilOp(handle, faces[i], stencil_operation.failOp,
+                                 stencil_operation.passOp,
+                                 stencil_operation.depthFailOp,
+                                 stencil_operation.compareOp);
+      bound->stencil_operations[i] = stencil_operation;
+    }
+  }
+
+  if (features.extended_dynamic_state2) {
+    VkBool32 depth_bias_enable =
+        render_state->depth_bias_enable ? VK_TRUE : VK_FALSE;
+    if (!valid || bound->depth_bias_enable != depth_bias_enable) {
+      vkDynamicStateSetDepthBiasEnable(handle, depth_bias_enable);
+      bound->depth_bias_enable = depth_bias_enable;
+    }
+  }
+
+  if (features.extended_dynamic_state3 && color_attachment_count > 0) {
+    std::vector<VkBool32> blend_enables;
+    std::vector<VkColorBlendEquationEXT> blend_equations;
+    std::vector<VkColorComponentFlags> write_masks;
+
+    GPUShaderBlendState default_blend_state;
+    for (uint32_t i = 0; i < color_attachment_count; ++i) {
+      GPUShaderBlendState *blend_state = &default_blend_state;
+      if (!render_state->blend_states.empty()) {
+        blend_state = &render_state->blend_states[std::min<size_t>(
+            i, render_state->blend_states.size() - 1)];
+      }
+
+      VkPipelineColorBlendAttachmentState attachment_state =
+          VulkanUtils::GPUShaderBlendStateToVulkanBlendAttachmentState(
+              blend_state);
+
+      VkColorBlendEquationEXT blend_equation = {};
+      blend_equation.srcColorBlendFactor = attachment_state.srcColorBlendFactor;
+      blend_equation.dstColorBlendFactor = attachment_state.dstColorBlendFactor;
+      blend_equation.colorBlendOp = attachment_state.colorBlendOp;
+      blend_equation.srcAlphaBlendFactor = attachment_state.srcAlphaBlendFactor;
+      blend_equation.dstAlphaBlendFactor = attachment_state.dstAlphaBlendFactor;
+      blend_equation.alphaBlendOp = attachment_state.alphaBlendOp;
+
+      blend_enables.emplace_back(attachment_state.blendEnable);
+      blend_equations.emplace_back(blend_equation);
+      write_masks.emplace_back(attachment_state.colorWriteMask);
+    }
+
+    bool blend_bound = valid && bound->blend_enables == blend_enables &&
+                       bound->color_write_masks == write_masks &&
+                       bound->blend_equations.size() == blend_equations.size();
+    for (uint32_t i = 0; blend_bound && i < blend_equations.size(); ++i) {
+      blend_bound =
+          BlendEquationsEqual(bound->blend_equations[i], blend_equations[i]);
+    }
+
+    if (!blend_bound) {
+      vkDynamicStateSetColorBlendEnable(handle, 0, color_attachment_count,
+                                        blend_enables.data());
+      vkDynamicStateSetColorBlendEquation(handle, 0, color_attachment_count,
+                                          blend_equations.data());
+      vkDynamicStateSetColorWriteMask(handle, 0, color_attachment_count,
+                                      write_masks.data());
+      bound->blend_enables = blend_enables;
+      bound->blend_equations = blend_equations;
+      bound->color_write_masks = write_masks;
+    }
+  }
+}
+
+void VulkanDynamicState::Invalidate() { bound_values_valid = false; }
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../gpu_shader.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_device.h"
+
+#include <stdint.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+/* render state, which is set per draw instead of being baked into the
+ * pipeline. What is dynamic depends on the extended dynamic state extensions
+ * the device supports */
+class VulkanDynamicState {
+public:
+  static void Initialize();
+
+  static void GetDynamicStates(std::vector<VkDynamicState> &dynamic_states);
+  /* resets the values that are set dynamically, so the pipelines that differ
+   * only by them are shared */
+  static void ClearDynamicState(GPUShaderRenderState *render_state,
+                                uint8_t *depth_flags, uint8_t *stencil_flags);
+  /* records only the state that differs from what was set last */
+  static void Set(VulkanCommandBuffer *command_buffer,
+                  GPUShaderRenderState *render_state, uint8_t depth_flags,
+                  uint8_t stencil_flags, uint32_t color_attachment_count);
+  /* forgets the state set so far, when a new command buffer is recorded */
+  static void Invalidate();
+
+private:
+  /* state set last into the command buffer. Every graphics pipeline uses
+   * the same dynamic states, so binding a pipeline keeps it */
+  struct VulkanDynamicStateValues {
+    float depth_bias[3];
+    uint32_t compare_masks[2];
+    uint32_t write_masks[2];
+    uint32_t references[2];
+    VkCullModeFlags cull_mode;
+    VkFrontFace front_face;
+    VkBool32 depth_test_enable;
+    VkBool32 depth_write_enable;
+    VkCompareOp depth_compare_operation;
+    VkBool32 stencil_test_enable;
+    VkStencilOpState stencil_operations[2];
+    VkBool32 depth_bias_enable;
+    std::vector<VkBool32> blend_enables;
+    std::vector<VkColorBlendEquationEXT> blend_equations;
+    std::vector<VkColorComponentFlags> color_write_masks;
+  };
+
+  static PFN_vkCmdSetCullModeEXT vkDynamicStateSetCullMode;
+  static PFN_vkCmdSetFrontFaceEXT vkDynamicStateSetFrontFace;
+  static PFN_vkCmdSetDepthTestEnableEXT vkDynamicStateSetDepthTestEnable;
+  static PFN_vkCmdSetDepthWriteEnableEXT vkDynamicStateSetDepthWriteEnable;
+  static PFN_vkCmdSetDepthCompareOpEXT vkDynamicStateSetDepthCompareOp;
+  static PFN_vkCmdSetStencilTestEnableEXT vkDynamicStateSetStencilTestEnable;
+  static PFN_vkCmdSetStencilOpEXT vkDynamicStateSetStencilOp;
+  static PFN_vkCmdSetDepthBiasEnableEXT vkDynamicStateSetDepthBiasEnable;
+  static PFN_vkCmdSetColorBlendEnableEXT vkDynamicStateSetColorBlendEnable;
+  static PFN_vkCmdSetColorBlendEquationEXT vkDynamicStateSetColorBlendEquation;
+  static PFN_vkCmdSetColorWriteMaskEXT vkDynamicStateSetColorWriteMask;
+  static VulkanDeviceOptionalFeatures features;
+  static VulkanDynamicStateValues bound_values;
+  static bool bound_values_valid;
+};
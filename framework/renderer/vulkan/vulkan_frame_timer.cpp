@@ -0,0 +1,143 @@
+#include "vulkan_frame_timer.h"
+
+#include "../../logger.h"
+#include "vulkan_backend.h"
+#include "vulkan_context.h"
+#include "vulkan_device.h"
+
+/* start and end of the 2 command buffers a frame is split into at most */
+static const uint32_t VULKAN_FRAME_TIMER_QUERY_COUNT = 4;
+
+void VulkanFrameTimer::Initialize() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  query_pool = 0;
+  segment_counts.clear();
+  frame_time = 0.0f;
+
+  /* timestamps are supported by the queue families with valid bits */
+  uint32_t family_count = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(context->device->GetPhysicalDevice(),
+                                           &family_count, 0);
+  std::vector<VkQueueFamilyProperties> family_properties(family_count);
+  vkGetPhysicalDeviceQueueFamilyProperties(context->device->GetPhysicalDevice(),
+                                           &family_count,
+                                           family_properties.data());
+  uint32_t family_index =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS)
+          .family_index;
+  uint32_t valid_bits = family_properties[family_index].timestampValidBits;
+
+  timestamp_period = context->device->GetProperties().limits.timestampPeriod;
+  supported = valid_bits > 0 && timestamp_period > 0.0f;
+  DEBUG("GPU frame timer: %d", supported);
+  if (!supported) {
+    return;
+  }
+  timestamp_mask = valid_bits >= 64 ? UINT64_MAX : (1ull << valid_bits) - 1;
+
+  VkQueryPoolCreateInfo query_pool_create_info = {};
+  query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  query_pool_create_info.pNext = 0;
+  query_pool_create_info.flags = 0;
+  query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  /* the start and the end of both command buffers of every frame in
+   * flight */
+  query_pool_create_info.queryCount =
+      context->max_frames_in_flight * VULKAN_FRAME_TIMER_QUERY_COUNT;
+  query_pool_create_info.pipelineStatistics = 0;
+  VK_CHECK(vkCreateQueryPool(context->device->GetLogicalDevice(),
+                             &query_pool_create_info, context->allocator,
+                             &query_pool));
+
+  segment_counts.resize(context->max_frames_in_flight, 0);
+}
+
+void VulkanFrameTimer::Shutdown() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (query_pool) {
+    vkDestroyQueryPool(context->device->GetLogicalDevice(), query_pool,
+                       context->allocator);
+  }
+
+  query_pool = 0;
+  segment_counts.clear();
+  frame_time = 0.0f;
+}
+
+void VulkanFrameTimer::BeginFrame(VkCommandBuffer command_buffer) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (!supported) {
+    return;
+  }
+
+  uint32_t first_query =
+      context->current_frame * VULKAN_FRAME_TIMER_QUERY_COUNT;
+  uint32_t segment_count = segment_counts[context->current_frame];
+
+  /* the fence of the frame is signaled, so the results are available
+   * without waiting */
+  if (segment_count) {
+    uint64_t timestamps[VULKAN_FRAME_TIMER_QUERY_COUNT] = {};
+    VkResult result = vkGetQueryPoolResults(
+        context->device->GetLogicalDevice(), query_pool, first_query,
+        segment_count * 2, sizeof(timestamps), timestamps,
+        sizeof(timestamps[0]), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS) {
+      uint64_t ticks = 0;
+      for (uint32_t i = 0; i < segment_count; ++i) {
+        ticks += (timestamps[i * 2 + 1] - timestamps[i * 2]) & timestamp_mask;
+      }
+      frame_time = (float)((double)ticks * timestamp_period / 1000000.0);
+    }
+    segment_counts[context->current_frame] = 0;
+  }
+
+  vkCmdResetQueryPool(command_buffer, query_pool, first_query,
+                      VULKAN_FRAME_TIMER_QUERY_COUNT);
+  vkCmdWriteTimestamp(command_buffer,
+                      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                      query_pool, first_query);
+}
+
+void VulkanFrameTimer::EndFrame(VkCommandBuffer command_buffer) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (!supported) {
+    return;
+  }
+
+  uint32_t segment_count = segment_counts[context->current_frame];
+  if (segment_count * 2 >= VULKAN_FRAME_TIMER_QUERY_COUNT) {
+    return;
+  }
+
+  uint32_t query = context->current_frame * VULKAN_FRAME_TIMER_QUERY_COUNT +
+                   segment_count * 2 + 1;
+  vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      query_pool, query);
+  ++segment_counts[context->current_frame];
+}
+
+void VulkanFrameTimer::ContinueFrame(VkCommandBuffer command_buffer) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (!supported) {
+    return;
+  }
+
+  /* async compute splits a frame once */
+  uint32_t segment_count = segment_counts[context->current_frame];
+  if (segment_count * 2 >= VULKAN_FRAME_TIMER_QUERY_COUNT) {
+    WARN("GPU frame timer can't measure more command buffers per frame!");
+    return;
+  }
+
+  uint32_t query = context->current_frame * VULKAN_FRAME_TIMER_QUERY_COUNT +
+                   segment_count * 2;
+  vkCmdWriteTimestamp(command_buffer,
+                      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                      query_pool, query);
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+/* GPU time of the frames, from timestamps written at the start and at the
+ * end of the graphics command buffers of the frame. The graphics submit
+ * waits for the swapchain image at the color attachment output stage, so
+ * the start is written at that stage: the wait, which is the vsync wait
+ * with FIFO, is not measured, but neither is the vertex work that runs
+ * before the image is acquired. When the frame is split around async
+ * compute, the time of both command buffers is summed, without the gap
+ * between them. The timestamps of a frame are read once its fence is waited
+ * for, so the time lags behind by the frames in flight. Async compute work
+ * is not included */
+class VulkanFrameTimer {
+public:
+  void Initialize();
+  void Shutdown();
+
+  /* after the command buffer of the frame is begun */
+  void BeginFrame(VkCommandBuffer command_buffer);
+  /* before the command buffer of the frame is ended, also before the
+   * graphics work is submitted ahead of async compute */
+  void EndFrame(VkCommandBuffer command_buffer);
+  /* after the command buffer the frame continues in after that is begun */
+  void ContinueFrame(VkCommandBuffer command_buffer);
+
+  inline bool IsSupported() const { return supported; }
+  /* in milliseconds, 0 until the first frame is measured */
+  inline float GetFrameTime() const { return frame_time; }
+
+private:
+  bool supported;
+  VkQueryPool query_pool;
+  /* nanoseconds per timestamp tick */
+  float timestamp_period;
+  uint64_t timestamp_mask;
+  /* command buffers of the frame measured and not read yet, their start and
+   * end timestamps follow each other in the queries of the frame */
+  std::vector<uint32_t> segment_counts;
+  float frame_time;
+};
\ No newline at end of file
@@ -13,9 +13,16 @@ bool VulkanFramebuffer::Create(GPURenderPass *target_render_pass,
                                uint32_t target_width, uint32_t target_height) {
   VulkanContext *context = VulkanBackend::GetContext();
 
+  render_pass = target_render_pass;
   attachments = target_attachments;
   width = target_width;
   height = target_height;
+  handle = 0;
+
+  /* dynamic rendering uses the attachments directly */
+  if (((VulkanRenderPass *)target_render_pass)->IsDynamic()) {
+    return true;
+  }
 
   std::vector<VkImageView> attachment_views;
   for (uint32_t i = 0; i < target_attachments.size(); ++i) {
@@ -46,28 +53,64 @@ bool VulkanFramebuffer::Create(GPURenderPass *target_render_pass,
 void VulkanFramebuffer::Destroy() {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+  /* nothing to wait for with dynamic rendering */
+  if (handle) {
+    vkDeviceWaitIdle(context->device->GetLogicalDevice());
+  }
 
-  vkDestroyFramebuffer(context->device->GetLogicalDevice(), handle,
-                       context->allocator);
+  DestroyImmediate();
+}
+
+void VulkanFramebuffer::DestroyImmediate() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (handle) {
+    vkDestroyFramebuffer(context->device->GetLogicalDevice(), handle,
+                         context->allocator);
+  }
 
   handle = 0;
+  render_pass = 0;
   attachments.clear();
   width = 0;
   height = 0;
 }
 
 bool VulkanFramebuffer::Resize(uint32_t new_width, uint32_t new_height) {
-  /* TODO: */
-  return true;
+  /* the attachments are kept, so they have to be resized first */
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    if (attachments[i]->GetWidth() < new_width ||
+        attachments[i]->GetHeight() < new_height) {
+      ERROR("Render target attachment %u is smaller than %ux%u!", i,
+            new_width, new_height);
+      return false;
+    }
+  }
+
+  if (new_width == width && new_height == height) {
+    return true;
+  }
+
+  GPURenderPass *target_render_pass = render_pass;
+  std::vector<GPUAttachment *> target_attachments = attachments;
+  Destroy();
+
+  return Create(target_render_pass, target_attachments, new_width,
+                new_height);
 }
 
 void VulkanFramebuffer::SetDebugName(const char *name) {
+  if (!handle) {
+    return;
+  }
   VulkanDebugUtils::SetObjectName(name, (uint64_t)handle,
                                   VK_OBJECT_TYPE_FRAMEBUFFER);
 }
 
 void VulkanFramebuffer::SetDebugTag(const void *tag, size_t tag_size) {
+  if (!handle) {
+    return;
+  }
   VulkanDebugUtils::SetObjectTag(tag, (uint64_t)handle,
                                  VK_OBJECT_TYPE_FRAMEBUFFER, 0, tag_size);
 }
@@ -16,6 +16,10 @@ public:
 
   bool Resize(uint32_t new_width, uint32_t new_height) override;
 
+  /* Destroy without waiting for the device, the caller makes sure that the
+   * device no longer uses the framebuffer */
+  void DestroyImmediate();
+
   void SetDebugName(const char *name) override;
   void SetDebugTag(const void *tag, size_t tag_size) override;
 
@@ -23,4 +27,5 @@ public:
 
 private:
   VkFramebuffer handle;
+  GPURenderPass *render_pass;
 };
\ No newline at end of file
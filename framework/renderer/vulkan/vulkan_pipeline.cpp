@@ -3,6 +3,38 @@
 #include "../../logger.h"
 #include "vulkan_backend.h"
 #include "vulkan_context.h"
+#include "vulkan_debug_marker.h"
+#include "vulkan_deletion_queue.h"
+#include "vulkan_render_pass.h"
+#include "vulkan_utils.h"
+
+#include <algorithm>
+
+static void DestroyRetiredPipeline(void *object) {
+  VulkanContext *context = VulkanBackend::GetContext();
+  VkPipeline *pipeline = (VkPipeline *)object;
+  vkDestroyPipeline(context->device->GetLogicalDevice(), *pipeline,
+                    context->allocator);
+  delete pipeline;
+}
+
+/* the frames in flight may still draw with the pipeline */
+static void RetirePipeline(VkPipeline pipeline) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (!pipeline) {
+    return;
+  }
+
+  if (!context->deletion_queue) {
+    vkDestroyPipeline(context->device->GetLogicalDevice(), pipeline,
+                      context->allocator);
+    return;
+  }
+
+  context->deletion_queue->Push(DestroyRetiredPipeline,
+                                new VkPipeline(pipeline));
+}
 
 bool VulkanPipeline::Create(VulkanPipelineConfig *config,
                             VulkanRenderPass *render_pass) {
@@ -20,6 +52,23 @@ bool VulkanPipeline::Create(VulkanPipelineConfig *config,
     case VK_DYNAMIC_STATE_SCISSOR: {
       dynamic_scissor = true;
     } break;
+    /* the pipeline values of those are ignored, nothing to do here */
+    case VK_DYNAMIC_STATE_DEPTH_BIAS:
+    case VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK:
+    case VK_DYNAMIC_STATE_STENCIL_WRITE_MASK:
+    case VK_DYNAMIC_STATE_STENCIL_REFERENCE:
+    case VK_DYNAMIC_STATE_CULL_MODE_EXT:
+    case VK_DYNAMIC_STATE_FRONT_FACE_EXT:
+    case VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT:
+    case VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT:
+    case VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT:
+    case VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT:
+    case VK_DYNAMIC_STATE_STENCIL_OP_EXT:
+    case VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT:
+    case VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT:
+    case VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT:
+    case VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT: {
+    } break;
     default: {
       ERROR("Unsupported dynamic state!");
     } break;
@@ -44,12 +93,15 @@ bool VulkanPipeline::Create(VulkanPipelineConfig *config,
   rasterizer_create_info.depthClampEnable = VK_FALSE;
   rasterizer_create_info.rasterizerDiscardEnable = VK_FALSE;
   rasterizer_create_info.polygonMode = VK_POLYGON_MODE_FILL;
-  rasterizer_create_info.cullMode = VK_CULL_MODE_NONE;
-  rasterizer_create_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-  rasterizer_create_info.depthBiasEnable = VK_FALSE;
-  rasterizer_create_info.depthBiasConstantFactor = 0.0f;
-  rasterizer_create_info.depthBiasClamp = 0.0f;
-  rasterizer_create_info.depthBiasSlopeFactor = 0.0f;
+  rasterizer_create_info.cullMode = config->cull_mode;
+  rasterizer_create_info.frontFace = config->front_face;
+  rasterizer_create_info.depthBiasEnable =
+      config->depth_bias_enable ? VK_TRUE : VK_FALSE;
+  rasterizer_create_info.depthBiasConstantFactor =
+      config->depth_bias_constant_factor;
+  rasterizer_create_info.depthBiasClamp = config->depth_bias_clamp;
+  rasterizer_create_info.depthBiasSlopeFactor =
+      config->depth_bias_slope_factor;
   rasterizer_create_info.lineWidth = 1.0f;
 
   VkPipelineMultisampleStateCreateInfo multisampling_create_info = {};
@@ -73,32 +125,18 @@ bool VulkanPipeline::Create(VulkanPipelineConfig *config,
       config->depth_test_enable ? VK_TRUE : VK_FALSE;
   depth_stencil.depthWriteEnable =
       config->depth_write_enable ? VK_TRUE : VK_FALSE;
-  depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
+  depth_stencil.depthCompareOp = config->depth_compare_operation;
   depth_stencil.depthBoundsTestEnable = VK_FALSE;
-  depth_stencil.stencilTestEnable = VK_FALSE;
-  depth_stencil.front = {};
-  depth_stencil.back = {};
+  depth_stencil.stencilTestEnable =
+      config->stencil_test_enable ? VK_TRUE : VK_FALSE;
+  depth_stencil.front = config->stencil_front;
+  depth_stencil.back = config->stencil_back;
   depth_stencil.minDepthBounds = 0.0f;
   depth_stencil.maxDepthBounds = 1.0f;
 
-  std::vector<VkPipelineColorBlendAttachmentState>
-      color_blend_attachment_states;
-  color_blend_attachment_states.resize(config->fragment_output_count);
-  for (uint32_t i = 0; i < config->fragment_output_count; ++i) {
-    color_blend_attachment_states[i].blendEnable = VK_TRUE;
-    color_blend_attachment_states[i].srcColorBlendFactor =
-        VK_BLEND_FACTOR_SRC_ALPHA;
-    color_blend_attachment_states[i].dstColorBlendFactor =
-        VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    color_blend_attachment_states[i].colorBlendOp = VK_BLEND_OP_ADD;
-    color_blend_attachment_states[i].srcAlphaBlendFactor =
-        VK_BLEND_FACTOR_SRC_ALPHA;
-    color_blend_attachment_states[i].dstAlphaBlendFactor =
-        VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    color_blend_attachment_states[i].alphaBlendOp = VK_BLEND_OP_ADD;
-    color_blend_attachment_states[i].colorWriteMask =
-        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-        VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+  if (config->color_blend_states.size() != config->fragment_output_count) {
+    ERROR("Pipeline blend state count doesn't match fragment output count!");
+    return false;
   }
 
   VkPipelineColorBlendStateCreateInfo color_blend_state_create_info = {};
@@ -109,9 +147,9 @@ bool VulkanPipeline::Create(VulkanPipelineConfig *config,
   color_blend_state_create_info.logicOpEnable = VK_FALSE;
   color_blend_state_create_info.logicOp = VK_LOGIC_OP_COPY;
   color_blend_state_create_info.attachmentCount =
-      color_blend_attachment_states.size();
+      config->color_blend_states.size();
   color_blend_state_create_info.pAttachments =
-      color_blend_attachment_states.data();
+      config->color_blend_states.data();
   /* color_blend_state_create_info.blendConstants[4]; */
 
   VkPipelineDynamicStateCreateInfo dynamic_state_create_info = {};
@@ -159,9 +197,9 @@ bool VulkanPipeline::Create(VulkanPipelineConfig *config,
   pipeline_layout_create_info.pPushConstantRanges =
       config->push_constant_ranges.data();
 
-  VK_CHECK(vkCreatePipelineLayout(context->device->GetLogicalDevice(),
-                                  &pipeline_layout_create_info,
-                                  context->allocator, &layout));
+  /* layouts are shared between the pipelines, and owned by the library */
+  layout = context->pipeline_library->CreatePipelineLayout(
+      &pipeline_layout_create_info);
 
   VkPipelineTessellationStateCreateInfo tesselation_state_create_info = {};
   tesselation_state_create_info.sType =
@@ -171,9 +209,26 @@ bool VulkanPipeline::Create(VulkanPipelineConfig *config,
   tesselation_state_create_info.patchControlPoints =
       config->control_point_count;
 
+  /* without a render pass object only the attachment formats are known */
+  VkPipelineRenderingCreateInfo rendering_create_info = {};
+  rendering_create_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+  rendering_create_info.pNext = 0;
+  rendering_create_info.viewMask = 0;
+  rendering_create_info.colorAttachmentCount =
+      render_pass->GetColorFormats().size();
+  rendering_create_info.pColorAttachmentFormats =
+      render_pass->GetColorFormats().data();
+  rendering_create_info.depthAttachmentFormat = render_pass->GetDepthFormat();
+  rendering_create_info.stencilAttachmentFormat =
+      VulkanUtils::FormatHasStencil(render_pass->GetDepthFormat())
+          ? render_pass->GetDepthFormat()
+          : VK_FORMAT_UNDEFINED;
+
   VkGraphicsPipelineCreateInfo pipeline_create_info = {};
   pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-  pipeline_create_info.pNext = 0;
+  pipeline_create_info.pNext =
+      render_pass->IsDynamic() ? &rendering_create_info : 0;
   pipeline_create_info.flags = 0;
   pipeline_create_info.stageCount = config->stages.size();
   pipeline_create_info.pStages = &config->stages[0];
@@ -189,29 +244,176 @@ bool VulkanPipeline::Create(VulkanPipelineConfig *config,
   pipeline_create_info.pDynamicState = &dynamic_state_create_info;
   pipeline_create_info.layout = layout;
   pipeline_create_info.renderPass = render_pass->GetHandle();
-  pipeline_create_info.subpass = 0;
+  pipeline_create_info.subpass = config->subpass;
   pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
   pipeline_create_info.basePipelineIndex = -1;
 
-  VK_CHECK(vkCreateGraphicsPipelines(context->device->GetLogicalDevice(),
-                                     VK_NULL_HANDLE, 1, &pipeline_create_info,
-                                     0, &handle));
+  if (context->pipeline_library->IsActive()) {
+    if (!context->pipeline_library->CreatePipeline(
+            &pipeline_create_info, config->stage_hashes, this, &handle)) {
+      return false;
+    }
+  } else {
+    VK_CHECK(vkCreateGraphicsPipelines(context->device->GetLogicalDevice(),
+                                       context->pipeline_cache, 1,
+                                       &pipeline_create_info, 0, &handle));
+  }
+
+  color_attachment_count = config->fragment_output_count;
+  bindless_set_index = config->bindless_set_index;
+  descriptor_set_layouts = config->descriptor_set_layouts;
+  push_constant_ranges = config->push_constant_ranges;
 
   return true;
 }
 
-void VulkanPipeline::Destroy() {
+bool VulkanPipeline::CreateCompute(VulkanPipelineConfig *config) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+  VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+  pipeline_layout_create_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_create_info.pNext = 0;
+  pipeline_layout_create_info.flags = 0;
+  pipeline_layout_create_info.setLayoutCount =
+      config->descriptor_set_layouts.size();
+  pipeline_layout_create_info.pSetLayouts =
+      config->descriptor_set_layouts.data();
+  pipeline_layout_create_info.pushConstantRangeCount =
+      config->push_constant_ranges.size();
+  pipeline_layout_create_info.pPushConstantRanges =
+      config->push_constant_ranges.data();
 
-  vkDestroyPipeline(context->device->GetLogicalDevice(), handle,
-                    context->allocator);
-  vkDestroyPipelineLayout(context->device->GetLogicalDevice(), layout,
-                          context->allocator);
+  layout = context->pipeline_library->CreatePipelineLayout(
+      &pipeline_layout_create_info);
+
+  VkComputePipelineCreateInfo pipeline_create_info = {};
+  pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_create_info.pNext = 0;
+  pipeline_create_info.flags = 0;
+  pipeline_create_info.stage = config->stages[0];
+  pipeline_create_info.layout = layout;
+  pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+  pipeline_create_info.basePipelineIndex = -1;
+
+  /* the pipeline library is for graphics pipelines only */
+  VkResult result = vkCreateComputePipelines(
+      context->device->GetLogicalDevice(), context->pipeline_cache, 1,
+      &pipeline_create_info, context->allocator, &handle);
+  if (result != VK_SUCCESS) {
+    ERROR("Failed to create compute pipeline!");
+    handle = 0;
+    return false;
+  }
+
+  color_attachment_count = 0;
+  bindless_set_index = -1;
+  descriptor_set_layouts = config->descriptor_set_layouts;
+  push_constant_ranges = config->push_constant_ranges;
+
+  return true;
+}
+
+void VulkanPipeline::Destroy() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  context->pipeline_library->CancelOptimization(this);
+  RetirePipeline(handle);
 
   handle = 0;
   layout = 0;
+  color_attachment_count = 0;
+  bindless_set_index = -1;
+  descriptor_set_layouts.clear();
+  push_constant_ranges.clear();
+  debug_name.clear();
+}
+
+void VulkanPipeline::ReplaceHandle(VkPipeline new_handle) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  /* the fast linked handle may be bound already, so the cached bind is
+   * forgotten along with it */
+  if (context->bound_pipeline == handle) {
+    context->bound_pipeline = 0;
+  }
+  RetirePipeline(handle);
+  handle = new_handle;
+
+  if (!debug_name.empty()) {
+    VulkanDebugUtils::SetObjectName(debug_name.c_str(), (uint64_t)handle,
+                                    VK_OBJECT_TYPE_PIPELINE);
+  }
+}
+
+void VulkanPipeline::SetDebugName(const char *name) {
+  debug_name = name;
+  VulkanDebugUtils::SetObjectName(name, (uint64_t)handle,
+                                  VK_OBJECT_TYPE_PIPELINE);
+}
+
+VkDescriptorSetLayout
+VulkanPipeline::GetDescriptorSetLayout(uint32_t set_index) {
+  if (set_index >= descriptor_set_layouts.size()) {
+    return 0;
+  }
+
+  return descriptor_set_layouts[set_index];
+}
+
+bool VulkanPipeline::PushConstants(VulkanCommandBuffer *command_buffer,
+                                   const void *value, uint32_t offset,
+                                   uint32_t size) {
+  /* every stage of a range has to be given the pushed bytes of the range,
+   * and no other stage may be given them, so the bytes are split at the
+   * range boundaries */
+  uint32_t end = offset + size;
+  std::vector<uint32_t> bounds = {offset, end};
+  for (uint32_t i = 0; i < push_constant_ranges.size(); ++i) {
+    VkPushConstantRange &range = push_constant_ranges[i];
+    if (range.offset > offset && range.offset < end) {
+      bounds.emplace_back(range.offset);
+    }
+    if (range.offset + range.size > offset && range.offset + range.size < end) {
+      bounds.emplace_back(range.offset + range.size);
+    }
+  }
+  std::sort(bounds.begin(), bounds.end());
+  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+  bool pushed = false;
+  uint32_t push_offset = offset;
+  VkShaderStageFlags push_stages = 0;
+  for (uint32_t i = 0; i + 1 < bounds.size(); ++i) {
+    VkShaderStageFlags stages = 0;
+    for (uint32_t j = 0; j < push_constant_ranges.size(); ++j) {
+      VkPushConstantRange &range = push_constant_ranges[j];
+      if (range.offset <= bounds[i] &&
+          bounds[i + 1] <= range.offset + range.size) {
+        stages |= range.stageFlags;
+      }
+    }
+
+    /* neighbouring pieces with the same stages are pushed at once */
+    if (stages != push_stages) {
+      if (push_stages) {
+        vkCmdPushConstants(command_buffer->GetHandle(), layout, push_stages,
+                           push_offset, bounds[i] - push_offset,
+                           (const uint8_t *)value + (push_offset - offset));
+        pushed = true;
+      }
+      push_offset = bounds[i];
+      push_stages = stages;
+    }
+  }
+  if (push_stages) {
+    vkCmdPushConstants(command_buffer->GetHandle(), layout, push_stages,
+                       push_offset, end - push_offset,
+                       (const uint8_t *)value + (push_offset - offset));
+    pushed = true;
+  }
+
+  return pushed;
 }
 
 void VulkanPipeline::Bind(VulkanCommandBuffer *command_buffer,
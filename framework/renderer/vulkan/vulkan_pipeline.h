@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
 
@@ -12,30 +13,70 @@ struct VulkanPipelineConfig {
   std::vector<VkVertexInputAttributeDescription> attributes;
   std::vector<VkDescriptorSetLayout> descriptor_set_layouts;
   std::vector<VkPipelineShaderStageCreateInfo> stages;
+  /* hashes of the stages code, used to find the cached pipeline library
+   * parts */
+  std::vector<uint64_t> stage_hashes;
   std::vector<VkDynamicState> dynamic_states;
   std::vector<VkPushConstantRange> push_constant_ranges;
+  /* set the bindless texture table is bound to, -1 if it is not used */
+  int32_t bindless_set_index;
   VkPrimitiveTopology topology;
   VkViewport viewport;
   VkRect2D scissor;
+  VkCullModeFlags cull_mode;
+  VkFrontFace front_face;
   bool depth_test_enable;
   bool depth_write_enable;
+  VkCompareOp depth_compare_operation;
+  bool depth_bias_enable;
+  float depth_bias_constant_factor;
+  float depth_bias_clamp;
+  float depth_bias_slope_factor;
+  bool stencil_test_enable;
+  VkStencilOpState stencil_front;
+  VkStencilOpState stencil_back;
+  /* one per fragment output */
+  std::vector<VkPipelineColorBlendAttachmentState> color_blend_states;
   uint32_t fragment_output_count;
   /* used for tessellation. 0 if no tessellation is needed */
   uint32_t control_point_count;
+  /* subpass of the render pass the pipeline is used in */
+  uint32_t subpass;
 };
 
 class VulkanPipeline {
 public:
   bool Create(VulkanPipelineConfig *config, VulkanRenderPass *render_pass);
+  /* only the single stage, the set layouts and the push constant ranges of
+   * the config are used */
+  bool CreateCompute(VulkanPipelineConfig *config);
+  /* the handle is destroyed once the frames in flight are done with it */
   void Destroy();
 
   void Bind(VulkanCommandBuffer *command_buffer,
             VkPipelineBindPoint bind_point);
+  /* retires the current handle and takes the ownership of the new one */
+  void ReplaceHandle(VkPipeline new_handle);
+  /* kept for the handles that replace the current one */
+  void SetDebugName(const char *name);
 
   inline VkPipeline GetHandle() { return handle; }
   inline VkPipelineLayout GetLayout() { return layout; }
+  inline uint32_t GetColorAttachmentCount() { return color_attachment_count; }
+  inline int32_t GetBindlessSetIndex() { return bindless_set_index; }
+  VkDescriptorSetLayout GetDescriptorSetLayout(uint32_t set_index);
+  /* pushes the bytes covered by the push constant ranges, each with the
+   * stages of the ranges that contain it. Returns false if none of the bytes
+   * is covered */
+  bool PushConstants(VulkanCommandBuffer *command_buffer, const void *value,
+                     uint32_t offset, uint32_t size);
 
 private:
   VkPipeline handle;
   VkPipelineLayout layout;
+  uint32_t color_attachment_count;
+  int32_t bindless_set_index;
+  std::vector<VkDescriptorSetLayout> descriptor_set_layouts;
+  std::vector<VkPushConstantRange> push_constant_ranges;
+  std::string debug_name;
 };
\ No newline at end of file
@@ -0,0 +1,490 @@
+#include "vulkan_pipeline_library.h"
+
+#include "../../logger.h"
+#include "vulkan_backend.h"
+#include "vulkan_context.h"
+#include "vulkan_pipeline.h"
+
+#include <algorithm>
+
+static void AppendBytes(std::string &key, const void *data, size_t size) {
+  key.append((const char *)data, size);
+}
+
+template <typename T> static void AppendValue(std::string &key, T value) {
+  AppendBytes(key, &value, sizeof(T));
+}
+
+static void
+AppendDynamicState(std::string &key,
+                   const VkPipelineDynamicStateCreateInfo *dynamic_state) {
+  if (!dynamic_state) {
+    AppendValue<uint32_t>(key, 0);
+    return;
+  }
+
+  AppendValue(key, dynamic_state->dynamicStateCount);
+  AppendBytes(key, dynamic_state->pDynamicStates,
+              dynamic_state->dynamicStateCount * sizeof(VkDynamicState));
+}
+
+static void
+AppendMultisampleState(std::string &key,
+                       const VkPipelineMultisampleStateCreateInfo *state) {
+  AppendValue(key, state->rasterizationSamples);
+  AppendValue(key, state->sampleShadingEnable);
+  AppendValue(key, state->minSampleShading);
+  AppendValue(key, state->alphaToCoverageEnable);
+  AppendValue(key, state->alphaToOneEnable);
+}
+
+static bool IsFragmentStage(const VkPipelineShaderStageCreateInfo &stage) {
+  return stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT;
+}
+
+void VulkanPipelineLibrary::Initialize() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  active = context->device->GetOptionalFeatures().graphics_pipeline_library;
+  running = true;
+  linking_pipeline = 0;
+  linking_cancelled = false;
+
+  if (active) {
+    worker = std::thread(&VulkanPipelineLibrary::ProcessJobs, this);
+  }
+}
+
+void VulkanPipelineLibrary::Shutdown() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (worker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running = false;
+    }
+    condition.notify_all();
+    worker.join();
+  }
+
+  pending_jobs.clear();
+  for (uint32_t i = 0; i < completed_jobs.size(); ++i) {
+    vkDestroyPipeline(context->device->GetLogicalDevice(),
+                      completed_jobs[i].result, context->allocator);
+  }
+  completed_jobs.clear();
+
+  for (uint32_t i = 0; i < VULKAN_PIPELINE_LIBRARY_PART_MAX; ++i) {
+    for (auto &pair : parts[i]) {
+      vkDestroyPipeline(context->device->GetLogicalDevice(),
+                        pair.second.handle, context->allocator);
+    }
+    parts[i].clear();
+  }
+
+  for (auto &pair : layouts) {
+    vkDestroyPipelineLayout(context->device->GetLogicalDevice(), pair.second,
+                            context->allocator);
+  }
+  layouts.clear();
+}
+
+VkPipelineLayout VulkanPipelineLibrary::CreatePipelineLayout(
+    VkPipelineLayoutCreateInfo *layout_create_info) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  /* set layouts are already deduplicated by the descriptor layout cache, so
+   * the handles can be used as a key */
+  std::string key;
+  AppendValue(key, layout_create_info->flags);
+  AppendValue(key, layout_create_info->setLayoutCount);
+  AppendBytes(key, layout_create_info->pSetLayouts,
+              layout_create_info->setLayoutCount *
+                  sizeof(VkDescriptorSetLayout));
+  AppendValue(key, layout_create_info->pushConstantRangeCount);
+  AppendBytes(key, layout_create_info->pPushConstantRanges,
+              layout_create_info->pushConstantRangeCount *
+                  sizeof(VkPushConstantRange));
+
+  auto it = layouts.find(key);
+  if (it != layouts.end()) {
+    return it->second;
+  }
+
+  VkPipelineLayout layout;
+  VK_CHECK(vkCreatePipelineLayout(context->device->GetLogicalDevice(),
+                                  layout_create_info, context->allocator,
+                                  &layout));
+  layouts[key] = layout;
+
+  return layout;
+}
+
+bool VulkanPipelineLibrary::CreatePipeline(
+    VkGraphicsPipelineCreateInfo *create_info,
+    std::vector<uint64_t> &stage_hashes, VulkanPipeline *pipeline,
+    VkPipeline *out_pipeline) {
+  if (stage_hashes.size() != create_info->stageCount) {
+    ERROR("Pipeline stage hashes don't match the stages!");
+    return false;
+  }
+
+  VulkanPipelineLibraryJob job = {};
+  job.pipeline = pipeline;
+  job.layout = create_info->layout;
+  for (uint32_t i = 0; i < VULKAN_PIPELINE_LIBRARY_PART_MAX; ++i) {
+    job.libraries[i] =
+        GetPart((VulkanPipelineLibraryPart)i, create_info, stage_hashes);
+    if (!job.libraries[i]) {
+      return false;
+    }
+  }
+
+  *out_pipeline = Link(job.libraries, job.layout, false);
+  if (!*out_pipeline) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending_jobs.emplace_back(job);
+  }
+  condition.notify_one();
+
+  return true;
+}
+
+void VulkanPipelineLibrary::Update() {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for (uint32_t i = 0; i < completed_jobs.size(); ++i) {
+    completed_jobs[i].pipeline->ReplaceHandle(completed_jobs[i].result);
+  }
+  completed_jobs.clear();
+}
+
+void VulkanPipelineLibrary::CancelOptimization(VulkanPipeline *pipeline) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  pending_jobs.erase(std::remove_if(pending_jobs.begin(), pending_jobs.end(),
+                                    [pipeline](VulkanPipelineLibraryJob &job) {
+                                      return job.pipeline == pipeline;
+                                    }),
+                     pending_jobs.end());
+
+  for (uint32_t i = 0; i < completed_jobs.size();) {
+    if (completed_jobs[i].pipeline == pipeline) {
+      vkDestroyPipeline(context->device->GetLogicalDevice(),
+                        completed_jobs[i].result, context->allocator);
+      completed_jobs.erase(completed_jobs.begin() + i);
+    } else {
+      ++i;
+    }
+  }
+
+  if (linking_pipeline == pipeline) {
+    linking_cancelled = true;
+  }
+}
+
+void VulkanPipelineLibrary::ReleaseRenderPass(VkRenderPass render_pass) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  std::vector<VkPipeline> released;
+  for (uint32_t i = 0; i < VULKAN_PIPELINE_LIBRARY_PART_MAX; ++i) {
+    for (auto it = parts[i].begin(); it != parts[i].end();) {
+      if (it->second.render_pass == render_pass) {
+        released.emplace_back(it->second.handle);
+        it = parts[i].erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  if (released.empty()) {
+    return;
+  }
+
+  {
+    /* jobs, which use the released parts, will never be optimized */
+    std::unique_lock<std::mutex> lock(mutex);
+    pending_jobs.erase(
+        std::remove_if(pending_jobs.begin(), pending_jobs.end(),
+                       [&released](VulkanPipelineLibraryJob &job) {
+                         for (uint32_t i = 0;
+                              i < VULKAN_PIPELINE_LIBRARY_PART_MAX; ++i) {
+                           if (std::find(released.begin(), released.end(),
+                                         job.libraries[i]) != released.end()) {
+                             return true;
+                           }
+                         }
+                         return false;
+                       }),
+        pending_jobs.end());
+    condition.wait(lock, [this]() { return linking_pipeline == 0; });
+  }
+
+  for (uint32_t i = 0; i < released.size(); ++i) {
+    vkDestroyPipeline(context->device->GetLogicalDevice(), released[i],
+                      context->allocator);
+  }
+}
+
+VkPipeline
+VulkanPipelineLibrary::GetPart(VulkanPipelineLibraryPart part,
+                               VkGraphicsPipelineCreateInfo *create_info,
+                               std::vector<uint64_t> &stage_hashes) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VkGraphicsPipelineLibraryCreateInfoEXT library_create_info = {};
+  library_create_info.sType =
+      VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+  library_create_info.pNext = 0;
+
+  VkGraphicsPipelineCreateInfo part_create_info = {};
+  part_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  part_create_info.pNext = &library_create_info;
+  part_create_info.flags =
+      VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+      VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+  part_create_info.pDynamicState = create_info->pDynamicState;
+  part_create_info.basePipelineHandle = VK_NULL_HANDLE;
+  part_create_info.basePipelineIndex = -1;
+
+  std::vector<VkPipelineShaderStageCreateInfo> stages;
+  std::string key;
+  AppendDynamicState(key, create_info->pDynamicState);
+
+  /* with dynamic rendering the attachment formats take the place of the
+   * render pass in every part but the vertex input one */
+  const VkPipelineRenderingCreateInfo *rendering =
+      (const VkPipelineRenderingCreateInfo *)create_info->pNext;
+  if (rendering &&
+      rendering->sType == VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO &&
+      part != VULKAN_PIPELINE_LIBRARY_PART_VERTEX_INPUT) {
+    library_create_info.pNext = (void *)rendering;
+    AppendValue(key, rendering->viewMask);
+    AppendValue(key, rendering->colorAttachmentCount);
+    AppendBytes(key, rendering->pColorAttachmentFormats,
+                rendering->colorAttachmentCount * sizeof(VkFormat));
+    AppendValue(key, rendering->depthAttachmentFormat);
+    AppendValue(key, rendering->stencilAttachmentFormat);
+  }
+
+  switch (part) {
+  case VULKAN_PIPELINE_LIBRARY_PART_VERTEX_INPUT: {
+    library_create_info.flags =
+        VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+    part_create_info.pVertexInputState = create_info->pVertexInputState;
+    part_create_info.pInputAssemblyState = create_info->pInputAssemblyState;
+
+    const VkPipelineVertexInputStateCreateInfo *vertex_input =
+        create_info->pVertexInputState;
+    AppendValue(key, vertex_input->vertexBindingDescriptionCount);
+    AppendBytes(key, vertex_input->pVertexBindingDescriptions,
+                vertex_input->vertexBindingDescriptionCount *
+                    sizeof(VkVertexInputBindingDescription));
+    AppendValue(key, vertex_input->vertexAttributeDescriptionCount);
+    AppendBytes(key, vertex_input->pVertexAttributeDescriptions,
+                vertex_input->vertexAttributeDescriptionCount *
+                    sizeof(VkVertexInputAttributeDescription));
+    AppendValue(key, create_info->pInputAssemblyState->topology);
+    AppendValue(key, create_info->pInputAssemblyState->primitiveRestartEnable);
+  } break;
+  case VULKAN_PIPELINE_LIBRARY_PART_PRE_RASTERIZATION: {
+    library_create_info.flags =
+        VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+    part_create_info.pViewportState = create_info->pViewportState;
+    part_create_info.pRasterizationState = create_info->pRasterizationState;
+    part_create_info.pTessellationState = create_info->pTessellationState;
+    part_create_info.layout = create_info->layout;
+    part_create_info.renderPass = create_info->renderPass;
+    part_create_info.subpass = create_info->subpass;
+
+    AppendValue(key, create_info->layout);
+    AppendValue(key, create_info->renderPass);
+    AppendValue(key, create_info->subpass);
+    for (uint32_t i = 0; i < create_info->stageCount; ++i) {
+      if (!IsFragmentStage(create_info->pStages[i])) {
+        stages.emplace_back(create_info->pStages[i]);
+        AppendValue(key, create_info->pStages[i].stage);
+        AppendValue(key, stage_hashes[i]);
+      }
+    }
+
+    /* viewports and scissors are dynamic state, so only their counts are
+     * part of the library */
+    const VkPipelineViewportStateCreateInfo *viewport =
+        create_info->pViewportState;
+    AppendValue(key, viewport->viewportCount);
+    AppendValue(key, viewport->scissorCount);
+
+    const VkPipelineRasterizationStateCreateInfo *rasterization =
+        create_info->pRasterizationState;
+    AppendValue(key, rasterization->depthClampEnable);
+    AppendValue(key, rasterization->rasterizerDiscardEnable);
+    AppendValue(key, rasterization->polygonMode);
+    AppendValue(key, rasterization->cullMode);
+    AppendValue(key, rasterization->frontFace);
+    AppendValue(key, rasterization->depthBiasEnable);
+    AppendValue(key, rasterization->depthBiasConstantFactor);
+    AppendValue(key, rasterization->depthBiasClamp);
+    AppendValue(key, rasterization->depthBiasSlopeFactor);
+    AppendValue(key, rasterization->lineWidth);
+
+    AppendValue<uint32_t>(key,
+                          create_info->pTessellationState
+                              ? create_info->pTessellationState
+                                    ->patchControlPoints
+                              : 0);
+  } break;
+  case VULKAN_PIPELINE_LIBRARY_PART_FRAGMENT_SHADER: {
+    library_create_info.flags =
+        VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+    part_create_info.pDepthStencilState = create_info->pDepthStencilState;
+    part_create_info.pMultisampleState = create_info->pMultisampleState;
+    part_create_info.layout = create_info->layout;
+    part_create_info.renderPass = create_info->renderPass;
+    part_create_info.subpass = create_info->subpass;
+
+    AppendValue(key, create_info->layout);
+    AppendValue(key, create_info->renderPass);
+    AppendValue(key, create_info->subpass);
+    for (uint32_t i = 0; i < create_info->stageCount; ++i) {
+      if (IsFragmentStage(create_info->pStages[i])) {
+        stages.emplace_back(create_info->pStages[i]);
+        AppendValue(key, stage_hashes[i]);
+      }
+    }
+
+    const VkPipelineDepthStencilStateCreateInfo *depth_stencil =
+        create_info->pDepthStencilState;
+    AppendValue(key, depth_stencil->depthTestEnable);
+    AppendValue(key, depth_stencil->depthWriteEnable);
+    AppendValue(key, depth_stencil->depthCompareOp);
+    AppendValue(key, depth_stencil->depthBoundsTestEnable);
+    AppendValue(key, depth_stencil->stencilTestEnable);
+    AppendValue(key, depth_stencil->front);
+    AppendValue(key, depth_stencil->back);
+    AppendValue(key, depth_stencil->minDepthBounds);
+    AppendValue(key, depth_stencil->maxDepthBounds);
+    AppendMultisampleState(key, create_info->pMultisampleState);
+  } break;
+  case VULKAN_PIPELINE_LIBRARY_PART_FRAGMENT_OUTPUT: {
+    library_create_info.flags =
+        VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+    part_create_info.pColorBlendState = create_info->pColorBlendState;
+    part_create_info.pMultisampleState = create_info->pMultisampleState;
+    part_create_info.renderPass = create_info->renderPass;
+    part_create_info.subpass = create_info->subpass;
+
+    AppendValue(key, create_info->renderPass);
+    AppendValue(key, create_info->subpass);
+
+    const VkPipelineColorBlendStateCreateInfo *color_blend =
+        create_info->pColorBlendState;
+    AppendValue(key, color_blend->logicOpEnable);
+    AppendValue(key, color_blend->logicOp);
+    AppendValue(key, color_blend->attachmentCount);
+    AppendBytes(key, color_blend->pAttachments,
+                color_blend->attachmentCount *
+                    sizeof(VkPipelineColorBlendAttachmentState));
+    AppendBytes(key, color_blend->blendConstants,
+                sizeof(color_blend->blendConstants));
+    AppendMultisampleState(key, create_info->pMultisampleState);
+  } break;
+  default: {
+    ERROR("Unsupported pipeline library part!");
+    return 0;
+  } break;
+  }
+
+  auto it = parts[part].find(key);
+  if (it != parts[part].end()) {
+    return it->second.handle;
+  }
+
+  part_create_info.stageCount = stages.size();
+  part_create_info.pStages = stages.data();
+
+  VulkanPipelineLibraryEntry entry = {};
+  entry.render_pass = create_info->renderPass;
+  if (vkCreateGraphicsPipelines(
+          context->device->GetLogicalDevice(), context->pipeline_cache, 1,
+          &part_create_info, context->allocator, &entry.handle) != VK_SUCCESS) {
+    ERROR("Failed to create pipeline library part %d!", part);
+    return 0;
+  }
+  parts[part][key] = entry;
+
+  return entry.handle;
+}
+
+VkPipeline VulkanPipelineLibrary::Link(VkPipeline *libraries,
+                                       VkPipelineLayout layout,
+                                       bool optimized) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VkPipelineLibraryCreateInfoKHR library_create_info = {};
+  library_create_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+  library_create_info.pNext = 0;
+  library_create_info.libraryCount = VULKAN_PIPELINE_LIBRARY_PART_MAX;
+  library_create_info.pLibraries = libraries;
+
+  VkGraphicsPipelineCreateInfo pipeline_create_info = {};
+  pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipeline_create_info.pNext = &library_create_info;
+  pipeline_create_info.flags =
+      optimized ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+  pipeline_create_info.layout = layout;
+  pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+  pipeline_create_info.basePipelineIndex = -1;
+
+  VkPipeline pipeline = 0;
+  if (vkCreateGraphicsPipelines(context->device->GetLogicalDevice(),
+                                context->pipeline_cache, 1,
+                                &pipeline_create_info, context->allocator,
+                                &pipeline) != VK_SUCCESS) {
+    ERROR("Failed to link pipeline libraries!");
+    return 0;
+  }
+
+  return pipeline;
+}
+
+void VulkanPipelineLibrary::ProcessJobs() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    condition.wait(lock,
+                   [this]() { return !running || !pending_jobs.empty(); });
+    if (!running) {
+      break;
+    }
+
+    VulkanPipelineLibraryJob job = pending_jobs.front();
+    pending_jobs.pop_front();
+    linking_pipeline = job.pipeline;
+    linking_cancelled = false;
+
+    lock.unlock();
+    job.result = Link(job.libraries, job.layout, true);
+    lock.lock();
+
+    linking_pipeline = 0;
+    if (job.result) {
+      if (linking_cancelled) {
+        vkDestroyPipeline(context->device->GetLogicalDevice(), job.result,
+                          context->allocator);
+      } else {
+        completed_jobs.emplace_back(job);
+      }
+    }
+    condition.notify_all();
+  }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+class VulkanPipeline;
+
+enum VulkanPipelineLibraryPart {
+  VULKAN_PIPELINE_LIBRARY_PART_VERTEX_INPUT,
+  VULKAN_PIPELINE_LIBRARY_PART_PRE_RASTERIZATION,
+  VULKAN_PIPELINE_LIBRARY_PART_FRAGMENT_SHADER,
+  VULKAN_PIPELINE_LIBRARY_PART_FRAGMENT_OUTPUT,
+  VULKAN_PIPELINE_LIBRARY_PART_MAX,
+};
+
+/* Caches pipeline layouts and, if VK_EXT_graphics_pipeline_library is
+ * supported, the 4 parts of the graphics pipelines. New pipelines are fast
+ * linked from the cached parts, and the optimized link is done on a worker
+ * thread */
+class VulkanPipelineLibrary {
+public:
+  void Initialize();
+  void Shutdown();
+
+  VkPipelineLayout
+  CreatePipelineLayout(VkPipelineLayoutCreateInfo *layout_create_info);
+
+  inline bool IsActive() const { return active; }
+  /* stage_hashes identify the code of create_info->pStages */
+  bool CreatePipeline(VkGraphicsPipelineCreateInfo *create_info,
+                      std::vector<uint64_t> &stage_hashes,
+                      VulkanPipeline *pipeline, VkPipeline *out_pipeline);
+  /* swaps the fast linked pipelines with the optimized ones. The device
+   * should not be using the pipelines at this point */
+  void Update();
+  /* should be called before the pipeline is destroyed */
+  void CancelOptimization(VulkanPipeline *pipeline);
+  /* destroys the parts that were created with this render pass. The parts
+   * created for dynamic rendering depend only on the attachment formats and
+   * are kept until Shutdown */
+  void ReleaseRenderPass(VkRenderPass render_pass);
+
+private:
+  struct VulkanPipelineLibraryEntry {
+    VkPipeline handle;
+    VkRenderPass render_pass;
+  };
+
+  struct VulkanPipelineLibraryJob {
+    VulkanPipeline *pipeline;
+    VkPipeline libraries[VULKAN_PIPELINE_LIBRARY_PART_MAX];
+    VkPipelineLayout layout;
+    VkPipeline result;
+  };
+
+  VkPipeline GetPart(VulkanPipelineLibraryPart part,
+                     VkGraphicsPipelineCreateInfo *create_info,
+                     std::vector<uint64_t> &stage_hashes);
+  VkPipeline Link(VkPipeline *libraries, VkPipelineLayout layout,
+                  bool optimized);
+  void ProcessJobs();
+
+  std::unordered_map<std::string, VkPipelineLayout> layouts;
+  /* keyed by the serialized state of the part */
+  std::unordered_map<std::string, VulkanPipelineLibraryEntry>
+      parts[VULKAN_PIPELINE_LIBRARY_PART_MAX];
+  bool active;
+
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool running;
+  std::deque<VulkanPipelineLibraryJob> pending_jobs;
+  std::vector<VulkanPipelineLibraryJob> completed_jobs;
+  /* pipeline the worker is linking right now */
+  VulkanPipeline *linking_pipeline;
+  bool linking_cancelled;
+};
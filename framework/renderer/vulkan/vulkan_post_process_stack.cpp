@@ -0,0 +1,426 @@
+#include "vulkan_post_process_stack.h"
+
+#include "../../logger.h"
+
+#include <algorithm>
+
+/* keyword bits of the shaders */
+static const uint32_t BLOOM_DOWNSAMPLE_VARIANT_PREFILTER = (1 << 0);
+/* keyword i of the uber shader is effect bit i */
+static const uint32_t UBER_EFFECT_MASK = GPU_POST_PROCESS_EFFECT_BLOOM |
+                                         GPU_POST_PROCESS_EFFECT_TONEMAP |
+                                         GPU_POST_PROCESS_EFFECT_COLOR_GRADING;
+
+VulkanPostProcessStack::VulkanPostProcessStack(
+    RendererBackend *stack_backend) {
+  backend = stack_backend;
+  effects = 0;
+  bloom_level_count = 0;
+  bloom_render_pass = 0;
+  uber_render_pass = 0;
+  bloom_downsample_shader = 0;
+  bloom_upsample_shader = 0;
+  uber_shader = 0;
+  fxaa_shader = 0;
+  uber_set.set = 0;
+  fxaa_set.set = 0;
+  source_attachment = 0;
+  source_area = glm::vec2(0.0f);
+  bloom_attachment = 0;
+  bloom_area = glm::vec2(0.0f);
+  uber_attachment = 0;
+}
+
+bool VulkanPostProcessStack::Create(GPUPostProcessStackConfig *config) {
+  if (!config->render_pass) {
+    ERROR("Post process stack has no render pass!");
+    return false;
+  }
+
+  effects = config->effects;
+  bloom_level_count = std::max(config->bloom_level_count, 1u);
+
+  if (effects & GPU_POST_PROCESS_EFFECT_BLOOM) {
+    bloom_render_pass =
+        CreatePass(GPU_FORMAT_R16G16B16A16F, "Bloom render pass");
+    if (!bloom_render_pass) {
+      return false;
+    }
+
+    bloom_downsample_shader = CreateShader(
+        "assets/shaders/post_process.vert.spv",
+        "assets/shaders/bloom_downsample.frag.spv",
+        std::vector<const char *>{"PREFILTER"}, bloom_render_pass,
+        "Bloom downsample shader");
+    bloom_upsample_shader = CreateShader(
+        "assets/shaders/post_process.vert.spv",
+        "assets/shaders/bloom_upsample.frag.spv",
+        std::vector<const char *>{}, bloom_render_pass,
+        "Bloom upsample shader");
+    if (!bloom_downsample_shader || !bloom_upsample_shader) {
+      return false;
+    }
+
+    bloom_downsample_sets.resize(bloom_level_count);
+    for (uint32_t i = 0; i < bloom_downsample_sets.size(); ++i) {
+      bloom_downsample_sets[i].set = 0;
+    }
+    bloom_upsample_sets.resize(bloom_level_count - 1);
+    for (uint32_t i = 0; i < bloom_upsample_sets.size(); ++i) {
+      bloom_upsample_sets[i].set = 0;
+    }
+  }
+
+  /* FXAA needs the neighbours of the tonemapped image, so the uber pass
+   * writes an attachment instead of the output */
+  GPURenderPass *uber_output = config->render_pass;
+  if (effects & GPU_POST_PROCESS_EFFECT_FXAA) {
+    uber_render_pass =
+        CreatePass(GPU_FORMAT_DEVICE_COLOR_OPTIMAL, "Uber render pass");
+    if (!uber_render_pass) {
+      return false;
+    }
+    uber_output = uber_render_pass;
+
+    fxaa_shader = CreateShader("assets/shaders/fxaa.vert.spv",
+                               "assets/shaders/fxaa.frag.spv",
+                               std::vector<const char *>{},
+                               config->render_pass, "FXAA shader");
+    if (!fxaa_shader) {
+      return false;
+    }
+  }
+
+  uber_shader = CreateShader(
+      "assets/shaders/post_process.vert.spv",
+      "assets/shaders/post_process.frag.spv",
+      std::vector<const char *>{"BLOOM", "TONEMAP", "COLOR_GRADING"},
+      uber_output, "Uber shader");
+  if (!uber_shader) {
+    return false;
+  }
+  uber_shader->SetVariant(effects & UBER_EFFECT_MASK);
+
+  return true;
+}
+
+void VulkanPostProcessStack::Destroy() {
+  ReleaseFrame();
+
+  for (uint32_t i = 0; i < bloom_downsample_sets.size(); ++i) {
+    DestroySamplerSet(&bloom_downsample_sets[i]);
+  }
+  for (uint32_t i = 0; i < bloom_upsample_sets.size(); ++i) {
+    DestroySamplerSet(&bloom_upsample_sets[i]);
+  }
+  bloom_downsample_sets.clear();
+  bloom_upsample_sets.clear();
+  DestroySamplerSet(&uber_set);
+  DestroySamplerSet(&fxaa_set);
+
+  GPUShader *shaders[] = {bloom_downsample_shader, bloom_upsample_shader,
+                          uber_shader, fxaa_shader};
+  for (uint32_t i = 0; i < 4; ++i) {
+    if (shaders[i]) {
+      shaders[i]->Destroy();
+      delete shaders[i];
+    }
+  }
+  bloom_downsample_shader = 0;
+  bloom_upsample_shader = 0;
+  uber_shader = 0;
+  fxaa_shader = 0;
+
+  if (bloom_render_pass) {
+    bloom_render_pass->Destroy();
+    delete bloom_render_pass;
+  }
+  if (uber_render_pass) {
+    uber_render_pass->Destroy();
+    delete uber_render_pass;
+  }
+  bloom_render_pass = 0;
+  uber_render_pass = 0;
+}
+
+void VulkanPostProcessStack::Prepare(GPUAttachment *source,
+                                     uint32_t source_width,
+                                     uint32_t source_height) {
+  GPURenderTargetPool *pool = backend->GetRenderTargetPool();
+
+  if (source_attachment) {
+    WARN("Prepare is called twice without Draw!");
+    ReleaseFrame();
+  }
+
+  source_attachment = source;
+  source_area = glm::vec2(source_width, source_height);
+
+  GPURenderTargetPoolAttachmentConfig config;
+  config.usage = GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT;
+  config.flags = 0;
+
+  if (effects & GPU_POST_PROCESS_EFFECT_BLOOM) {
+    backend->BeginDebugRegion("Bloom", glm::vec4(1.0, 0.8, 0.2, 1.0));
+
+    /* every level halves the previous one. The attachments are sized from
+     * the source attachment, so that they don't change with the area */
+    std::vector<GPUAttachment *> downsampled(bloom_level_count);
+    std::vector<GPUAttachment *> upsampled(bloom_level_count);
+    std::vector<glm::vec2> level_areas(bloom_level_count);
+    config.format = GPU_FORMAT_R16G16B16A16F;
+    config.width = source->GetWidth();
+    config.height = source->GetHeight();
+    glm::vec2 area = source_area;
+    for (uint32_t i = 0; i < bloom_level_count; ++i) {
+      config.width = std::max(config.width / 2, 1u);
+      config.height = std::max(config.height / 2, 1u);
+      area = glm::max(glm::floor(area * 0.5f), glm::vec2(1.0f));
+      level_areas[i] = area;
+
+      downsampled[i] = pool->AcquireAttachment(&config);
+      bloom_attachments.emplace_back(downsampled[i]);
+      /* the last level is not upsampled into */
+      upsampled[i] = downsampled[i];
+      if (i + 1 < bloom_level_count) {
+        upsampled[i] = pool->AcquireAttachment(&config);
+        bloom_attachments.emplace_back(upsampled[i]);
+      }
+    }
+
+    /* the first downsample keeps only the bright parts */
+    bloom_downsample_shader->SetVariant(BLOOM_DOWNSAMPLE_VARIANT_PREFILTER);
+    RecordBloomPass(bloom_downsample_shader, &bloom_downsample_sets[0],
+                    std::vector<GPUAttachment *>{source}, source_area,
+                    downsampled[0], level_areas[0]);
+    bloom_downsample_shader->SetVariant(0);
+    for (uint32_t i = 1; i < bloom_level_count; ++i) {
+      RecordBloomPass(bloom_downsample_shader, &bloom_downsample_sets[i],
+                      std::vector<GPUAttachment *>{downsampled[i - 1]},
+                      level_areas[i - 1], downsampled[i], level_areas[i]);
+    }
+
+    /* every level adds the upsampled level below it to its downsample */
+    for (int32_t i = bloom_level_count - 2; i >= 0; --i) {
+      RecordBloomPass(
+          bloom_upsample_shader, &bloom_upsample_sets[i],
+          std::vector<GPUAttachment *>{upsampled[i + 1], downsampled[i]},
+          level_areas[i + 1], upsampled[i], level_areas[i]);
+    }
+
+    backend->EndDebugRegion();
+
+    bloom_attachment = upsampled[0];
+    bloom_area = level_areas[0];
+  }
+
+  if (effects & GPU_POST_PROCESS_EFFECT_FXAA) {
+    config.format = GPU_FORMAT_DEVICE_COLOR_OPTIMAL;
+    config.width = source->GetWidth();
+    config.height = source->GetHeight();
+    uber_attachment = pool->AcquireAttachment(&config);
+
+    std::vector<GPUAttachment *> attachments = {uber_attachment};
+    GPURenderTarget *render_target =
+        pool->AcquireRenderTarget(uber_render_pass, attachments);
+
+    uber_render_pass->SetRenderArea(glm::vec4(0.0f, 0.0f, source_area));
+    uber_render_pass->Begin(render_target);
+    DrawUber();
+    uber_render_pass->End();
+  }
+}
+
+void VulkanPostProcessStack::Draw() {
+  if (!source_attachment) {
+    WARN("Draw is called without Prepare!");
+    return;
+  }
+
+  if (effects & GPU_POST_PROCESS_EFFECT_FXAA) {
+    glm::vec2 size =
+        glm::vec2(uber_attachment->GetWidth(), uber_attachment->GetHeight());
+
+    VulkanPostProcessFXAAParams params = {};
+    params.uv_scale = source_area / size;
+    params.uv_max = (source_area - 0.5f) / size;
+
+    backend->BeginDebugRegion("FXAA", glm::vec4(0.2, 0.8, 1.0, 1.0));
+    fxaa_shader->Bind();
+    fxaa_shader->BindSampler(
+        GetSamplerSet(&fxaa_set, fxaa_shader,
+                      std::vector<GPUAttachment *>{uber_attachment}),
+        0);
+    fxaa_shader->PushConstant(&params, sizeof(VulkanPostProcessFXAAParams),
+                              0);
+    backend->Draw(3);
+    backend->EndDebugRegion();
+  } else {
+    DrawUber();
+  }
+
+  ReleaseFrame();
+}
+
+GPUDescriptorSet *VulkanPostProcessStack::GetSamplerSet(
+    VulkanPostProcessSamplerSet *sampler_set, GPUShader *shader,
+    std::vector<GPUAttachment *> attachments) {
+  if (sampler_set->set && sampler_set->attachments == attachments) {
+    return sampler_set->set;
+  }
+
+  DestroySamplerSet(sampler_set);
+
+  std::vector<GPUDescriptorBinding> bindings;
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    bindings.emplace_back(GPUDescriptorBinding{
+        i, GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT, 0, 0, attachments[i]});
+  }
+  sampler_set->set = backend->DescriptorSetAllocate();
+  sampler_set->set->Create(shader, 0, bindings);
+  sampler_set->set->SetDebugName("Post process descriptor set");
+  sampler_set->attachments = attachments;
+
+  return sampler_set->set;
+}
+
+void VulkanPostProcessStack::DestroySamplerSet(
+    VulkanPostProcessSamplerSet *sampler_set) {
+  if (sampler_set->set) {
+    sampler_set->set->Destroy();
+    delete sampler_set->set;
+  }
+
+  sampler_set->set = 0;
+  sampler_set->attachments.clear();
+}
+
+GPURenderPass *VulkanPostProcessStack::CreatePass(GPUFormat format,
+                                                  const char *name) {
+  /* every pass writes all of its pixels, so nothing is loaded */
+  std::vector<GPURenderPassAttachmentConfig> attachment_configs;
+  attachment_configs.emplace_back(GPURenderPassAttachmentConfig{
+      format, GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT,
+      GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_DONT_CARE,
+      GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_STORE, false});
+
+  GPURenderPass *render_pass = backend->RenderPassAllocate();
+  if (!render_pass->Create(attachment_configs, glm::vec4(0, 0, 1, 1),
+                           glm::vec4(0, 0, 0, 1), 1.0f, 0.0f, 0)) {
+    ERROR("Failed to create the %s!", name);
+    delete render_pass;
+    return 0;
+  }
+  render_pass->SetDebugName(name);
+
+  return render_pass;
+}
+
+GPUShader *VulkanPostProcessStack::CreateShader(
+    const char *vertex_path, const char *fragment_path,
+    std::vector<const char *> keywords, GPURenderPass *render_pass,
+    const char *name) {
+  std::vector<GPUShaderStageConfig> stage_configs;
+  stage_configs.emplace_back(
+      GPUShaderStageConfig{GPU_SHADER_STAGE_TYPE_VERTEX, vertex_path});
+  stage_configs.emplace_back(
+      GPUShaderStageConfig{GPU_SHADER_STAGE_TYPE_FRAGMENT, fragment_path});
+
+  GPUShaderConfig shader_config;
+  shader_config.stage_configs = stage_configs;
+  shader_config.keywords = keywords;
+  shader_config.topology_type = GPU_SHADER_TOPOLOGY_TYPE_TRIANGLE_LIST;
+  shader_config.depth_flags = 0;
+  shader_config.stencil_flags = 0;
+  shader_config.render_pass = render_pass;
+  shader_config.subpass = 0;
+  /* the viewport is set by the render passes */
+  shader_config.viewport_width = 0.0f;
+  shader_config.viewport_height = 0.0f;
+
+  GPUShader *shader = backend->ShaderAllocate();
+  if (!shader->Create(&shader_config)) {
+    ERROR("Failed to create the %s!", name);
+    delete shader;
+    return 0;
+  }
+  shader->SetDebugName(name);
+
+  return shader;
+}
+
+void VulkanPostProcessStack::RecordBloomPass(
+    GPUShader *shader, VulkanPostProcessSamplerSet *sampler_set,
+    std::vector<GPUAttachment *> sources, glm::vec2 source_area,
+    GPUAttachment *target, glm::vec2 target_area) {
+  GPURenderTargetPool *pool = backend->GetRenderTargetPool();
+
+  std::vector<GPUAttachment *> attachments = {target};
+  GPURenderTarget *render_target =
+      pool->AcquireRenderTarget(bloom_render_pass, attachments);
+
+  /* the render area maps onto the area of the first source, and the second
+   * one has the area of the target */
+  glm::vec2 size = glm::vec2(sources[0]->GetWidth(), sources[0]->GetHeight());
+  VulkanPostProcessBloomParams params = {};
+  params.source_uv =
+      glm::vec4(source_area / size, (source_area - 0.5f) / size);
+  params.source_texel =
+      glm::vec4(1.0f / size, settings.bloom_threshold, 0.0f);
+  if (sources.size() > 1) {
+    size = glm::vec2(sources[1]->GetWidth(), sources[1]->GetHeight());
+    params.base_uv =
+        glm::vec4(target_area / size, (target_area - 0.5f) / size);
+  }
+
+  bloom_render_pass->SetRenderArea(glm::vec4(0.0f, 0.0f, target_area));
+  bloom_render_pass->Begin(render_target);
+  shader->Bind();
+  shader->BindSampler(GetSamplerSet(sampler_set, shader, sources), 0);
+  shader->PushConstant(&params, sizeof(VulkanPostProcessBloomParams), 0);
+  backend->Draw(3);
+  bloom_render_pass->End();
+}
+
+void VulkanPostProcessStack::DrawUber() {
+  glm::vec2 size = glm::vec2(source_attachment->GetWidth(),
+                             source_attachment->GetHeight());
+
+  VulkanPostProcessUberParams params = {};
+  params.scene_uv = glm::vec4(source_area / size, 0.0f, 0.0f);
+  std::vector<GPUAttachment *> attachments = {source_attachment};
+  if (bloom_attachment) {
+    size = glm::vec2(bloom_attachment->GetWidth(),
+                     bloom_attachment->GetHeight());
+    params.bloom_uv =
+        glm::vec4(bloom_area / size, (bloom_area - 0.5f) / size);
+    attachments.emplace_back(bloom_attachment);
+  }
+  params.color_filter = glm::vec4(settings.color_filter, settings.exposure);
+  params.grading = glm::vec4(settings.bloom_intensity, settings.contrast,
+                             settings.saturation, 0.0f);
+
+  backend->BeginDebugRegion("Uber pass", glm::vec4(1.0, 0.4, 0.2, 1.0));
+  uber_shader->Bind();
+  uber_shader->BindSampler(GetSamplerSet(&uber_set, uber_shader, attachments),
+                           0);
+  uber_shader->PushConstant(&params, sizeof(VulkanPostProcessUberParams), 0);
+  backend->Draw(3);
+  backend->EndDebugRegion();
+}
+
+void VulkanPostProcessStack::ReleaseFrame() {
+  GPURenderTargetPool *pool = backend->GetRenderTargetPool();
+
+  for (uint32_t i = 0; i < bloom_attachments.size(); ++i) {
+    pool->ReleaseAttachment(bloom_attachments[i]);
+  }
+  if (uber_attachment) {
+    pool->ReleaseAttachment(uber_attachment);
+  }
+
+  bloom_attachments.clear();
+  source_attachment = 0;
+  bloom_attachment = 0;
+  uber_attachment = 0;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../gpu_post_process_stack.h"
+#include "../renderer_backend.h"
+
+#include <vector>
+
+class VulkanPostProcessStack : public GPUPostProcessStack {
+public:
+  VulkanPostProcessStack(RendererBackend *stack_backend);
+
+  bool Create(GPUPostProcessStackConfig *config) override;
+  void Destroy() override;
+
+  void Prepare(GPUAttachment *source, uint32_t source_width,
+               uint32_t source_height) override;
+  void Draw() override;
+
+private:
+  /* sampler set of a pass, recreated when the attachments it samples
+   * change */
+  struct VulkanPostProcessSamplerSet {
+    std::vector<GPUAttachment *> attachments;
+    GPUDescriptorSet *set;
+  };
+
+  /* push constants of the shaders */
+  struct VulkanPostProcessBloomParams {
+    glm::vec4 source_uv;
+    glm::vec4 source_texel;
+    glm::vec4 base_uv;
+  };
+  struct VulkanPostProcessUberParams {
+    glm::vec4 scene_uv;
+    glm::vec4 bloom_uv;
+    glm::vec4 color_filter;
+    glm::vec4 grading;
+  };
+  struct VulkanPostProcessFXAAParams {
+    glm::vec2 uv_scale;
+    glm::vec2 uv_max;
+  };
+
+  GPUDescriptorSet *GetSamplerSet(VulkanPostProcessSamplerSet *sampler_set,
+                                  GPUShader *shader,
+                                  std::vector<GPUAttachment *> attachments);
+  void DestroySamplerSet(VulkanPostProcessSamplerSet *sampler_set);
+  GPURenderPass *CreatePass(GPUFormat format, const char *name);
+  GPUShader *CreateShader(const char *vertex_path, const char *fragment_path,
+                          std::vector<const char *> keywords,
+                          GPURenderPass *render_pass, const char *name);
+  void RecordBloomPass(GPUShader *shader,
+                       VulkanPostProcessSamplerSet *sampler_set,
+                       std::vector<GPUAttachment *> sources,
+                       glm::vec2 source_area, GPUAttachment *target,
+                       glm::vec2 target_area);
+  void DrawUber();
+  void ReleaseFrame();
+
+  RendererBackend *backend;
+  uint32_t effects;
+  uint32_t bloom_level_count;
+
+  GPURenderPass *bloom_render_pass;
+  GPURenderPass *uber_render_pass;
+  GPUShader *bloom_downsample_shader;
+  GPUShader *bloom_upsample_shader;
+  GPUShader *uber_shader;
+  GPUShader *fxaa_shader;
+
+  std::vector<VulkanPostProcessSamplerSet> bloom_downsample_sets;
+  std::vector<VulkanPostProcessSamplerSet> bloom_upsample_sets;
+  VulkanPostProcessSamplerSet uber_set;
+  VulkanPostProcessSamplerSet fxaa_set;
+
+  /* state of the frame between Prepare and Draw. The attachments are
+   * acquired from the render target pool until Draw */
+  GPUAttachment *source_attachment;
+  glm::vec2 source_area;
+  std::vector<GPUAttachment *> bloom_attachments;
+  GPUAttachment *bloom_attachment;
+  glm::vec2 bloom_area;
+  GPUAttachment *uber_attachment;
+};
\ No newline at end of file
@@ -0,0 +1,1043 @@
+#include "vulkan_render_graph.h"
+
+#include "../../logger.h"
+#include "../gpu_utils.h"
+#include "vulkan_attachment.h"
+#include "vulkan_backend.h"
+#include "vulkan_debug_marker.h"
+#include "vulkan_framebuffer.h"
+#include "vulkan_render_pass.h"
+#include "vulkan_utils.h"
+
+#include <algorithm>
+
+/* accesses that have to be made available before the memory is reused */
+static const VkAccessFlags VULKAN_RENDER_GRAPH_WRITE_ACCESS_MASK =
+    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT;
+
+VulkanRenderGraph::VulkanRenderGraph(RendererBackend *graph_backend) {
+  backend = graph_backend;
+  compiled = false;
+  width = 0;
+  height = 0;
+  export_src_stage_mask = 0;
+  export_dst_stage_mask = 0;
+}
+
+uint32_t
+VulkanRenderGraph::AddAttachment(const char *name,
+                                 GPURenderGraphAttachmentConfig *config) {
+  if (compiled) {
+    WARN("Attachment \"%s\" is added to a compiled render graph!", name);
+  }
+
+  VulkanRenderGraphAttachment attachment = {};
+  attachment.name = name;
+  attachment.config = *config;
+  attachment.attachment = 0;
+  attachment.first_use = -1;
+  attachment.last_use = -1;
+  attachment.block = -1;
+  attachment.previous_alias = -1;
+  attachments.emplace_back(attachment);
+
+  return attachments.size() - 1;
+}
+
+uint32_t VulkanRenderGraph::AddPass(const char *name,
+                                    GPURenderGraphPassConfig *config) {
+  if (compiled) {
+    WARN("Pass \"%s\" is added to a compiled render graph!", name);
+  }
+
+  VulkanRenderGraphPass pass = {};
+  pass.name = name;
+  pass.config = *config;
+  pass.culled = true;
+  pass.first_position = -1;
+  pass.subpass = 0;
+  pass.render_pass = 0;
+  pass.framebuffer = 0;
+  pass.src_stage_mask = 0;
+  pass.dst_stage_mask = 0;
+  passes.emplace_back(pass);
+
+  return passes.size() - 1;
+}
+
+bool VulkanRenderGraph::Compile() {
+  if (compiled) {
+    WARN("Render graph is already compiled!");
+    return false;
+  }
+
+  for (uint32_t i = 0; i < passes.size(); ++i) {
+    GPURenderGraphPassConfig *config = &passes[i].config;
+    const char *name = passes[i].name.c_str();
+
+    std::vector<uint32_t> used = config->outputs;
+    used.insert(used.end(), config->inputs.begin(), config->inputs.end());
+    used.insert(used.end(), config->subpass_inputs.begin(),
+                config->subpass_inputs.end());
+    for (uint32_t j = 0; j < used.size(); ++j) {
+      if (used[j] >= attachments.size()) {
+        ERROR("Render graph pass \"%s\" uses an unknown attachment!", name);
+        return false;
+      }
+    }
+
+    for (uint32_t j = 0; j < config->inputs.size(); ++j) {
+      GPURenderGraphAttachmentConfig *input =
+          &attachments[config->inputs[j]].config;
+      if (input->flags & GPU_ATTACHMENT_FLAG_TRANSIENT) {
+        ERROR("Render graph pass \"%s\" samples a transient attachment!",
+              name);
+        return false;
+      }
+    }
+    for (uint32_t j = 0; j < config->subpass_inputs.size(); ++j) {
+      GPURenderGraphAttachmentConfig *input =
+          &attachments[config->subpass_inputs[j]].config;
+      if (!(input->flags & GPU_ATTACHMENT_FLAG_INPUT)) {
+        ERROR("Render graph pass \"%s\" reads a subpass input created "
+              "without GPU_ATTACHMENT_FLAG_INPUT!",
+              name);
+        return false;
+      }
+    }
+    if (config->subpass_inputs.size() && !config->subpass) {
+      ERROR("Render graph pass \"%s\" reads subpass inputs, but is not a "
+            "subpass!",
+            name);
+      return false;
+    }
+
+    if (config->window_output) {
+      if (config->outputs.size()) {
+        ERROR("Render graph pass \"%s\" renders into the window and into "
+              "attachments!",
+              name);
+        return false;
+      }
+      /* the window render pass has a single subpass */
+      if (config->subpass) {
+        ERROR("Render graph window pass \"%s\" can't be a subpass!", name);
+        return false;
+      }
+      continue;
+    }
+
+    if (!config->outputs.size()) {
+      ERROR("Render graph pass \"%s\" has no outputs!", name);
+      return false;
+    }
+
+    uint32_t first_width, first_height;
+    GetSize(config->outputs[0], &first_width, &first_height);
+    uint32_t depth_count = 0;
+    for (uint32_t j = 0; j < config->outputs.size(); ++j) {
+      uint32_t output_width, output_height;
+      GetSize(config->outputs[j], &output_width, &output_height);
+      if (output_width != first_width || output_height != first_height) {
+        ERROR("Outputs of the render graph pass \"%s\" differ in size!", name);
+        return false;
+      }
+      if (!output_width || !output_height) {
+        ERROR("Outputs of the render graph pass \"%s\" have no size, see "
+              "Resize!",
+              name);
+        return false;
+      }
+      if (GPUUtils::IsDepthFormat(
+              attachments[config->outputs[j]].config.format)) {
+        ++depth_count;
+      }
+    }
+    if (depth_count > 1) {
+      ERROR("Render graph pass \"%s\" has more than 1 depth output!", name);
+      return false;
+    }
+  }
+
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    GPURenderGraphAttachmentConfig *config = &attachments[i].config;
+    if (config->exported && (config->flags & GPU_ATTACHMENT_FLAG_TRANSIENT)) {
+      ERROR("Render graph attachment \"%s\" is exported, but transient!",
+            attachments[i].name.c_str());
+      return false;
+    }
+  }
+
+  if (!SortPasses()) {
+    return false;
+  }
+  ComputeLifetimes();
+
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    VulkanRenderGraphAttachment *attachment = &attachments[i];
+    if (!(attachment->config.flags & GPU_ATTACHMENT_FLAG_TRANSIENT) ||
+        attachment->first_use < 0) {
+      continue;
+    }
+
+    if (passes[order[attachment->first_use]].first_position !=
+        passes[order[attachment->last_use]].first_position) {
+      ERROR("Transient render graph attachment \"%s\" is used by several "
+            "render passes!",
+            attachment->name.c_str());
+      return false;
+    }
+  }
+
+  CreateRenderPasses();
+  AliasAttachments();
+  CreateFramebuffers();
+  ComputeBarriers();
+
+  compiled = true;
+
+  return true;
+}
+
+void VulkanRenderGraph::Destroy() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+
+  DestroyAttachments();
+
+  for (uint32_t i = 0; i < passes.size(); ++i) {
+    if (passes[i].render_pass && !passes[i].subpass) {
+      passes[i].render_pass->Destroy();
+      delete passes[i].render_pass;
+    }
+  }
+
+  attachments.clear();
+  passes.clear();
+  order.clear();
+  compiled = false;
+}
+
+void VulkanRenderGraph::Resize(uint32_t new_width, uint32_t new_height) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  width = new_width;
+  height = new_height;
+  if (!compiled) {
+    return;
+  }
+
+  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+
+  /* the lifetimes don't change, but the memory requirements do */
+  DestroyAttachments();
+  AliasAttachments();
+  CreateFramebuffers();
+  ComputeBarriers();
+}
+
+void VulkanRenderGraph::Execute() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (!compiled) {
+    WARN("Render graph is executed before it is compiled!");
+    return;
+  }
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    VulkanRenderGraphPass *pass = &passes[order[i]];
+
+    GPURenderPass *render_pass = pass->config.window_output
+                                     ? backend->GetWindowRenderPass()
+                                     : pass->render_pass;
+    if (pass->subpass) {
+      render_pass->NextSubpass();
+    } else {
+      if (pass->barriers.size()) {
+        vkCmdPipelineBarrier(command_buffer->GetHandle(),
+                             pass->src_stage_mask, pass->dst_stage_mask, 0, 0,
+                             0, 0, 0, pass->barriers.size(),
+                             pass->barriers.data());
+      }
+
+      if (pass->config.window_output) {
+        render_pass->Begin(backend->GetCurrentWindowRenderTarget());
+      } else {
+        render_pass->Begin(pass->framebuffer);
+      }
+    }
+
+    /* inside of the subpass, labels can't span several of them */
+    VulkanDebugUtils::BeginRegion(pass->name.c_str(), command_buffer,
+                                  glm::vec4(1.0f));
+
+    if (pass->config.execute) {
+      pass->config.execute(pass->config.user_data);
+    }
+
+    VulkanDebugUtils::EndRegion(command_buffer);
+
+    /* the render pass ends after its last subpass */
+    if (i + 1 == order.size() || !passes[order[i + 1]].subpass) {
+      render_pass->End();
+    }
+  }
+
+  if (export_barriers.size()) {
+    vkCmdPipelineBarrier(command_buffer->GetHandle(), export_src_stage_mask,
+                         export_dst_stage_mask, 0, 0, 0, 0, 0,
+                         export_barriers.size(), export_barriers.data());
+  }
+}
+
+GPUAttachment *VulkanRenderGraph::GetAttachment(uint32_t attachment) {
+  if (attachment >= attachments.size()) {
+    ERROR("Render graph has no attachment %u!", attachment);
+    return 0;
+  }
+
+  return attachments[attachment].attachment;
+}
+
+GPURenderPass *VulkanRenderGraph::GetRenderPass(uint32_t pass) {
+  if (pass >= passes.size()) {
+    ERROR("Render graph has no pass %u!", pass);
+    return 0;
+  }
+
+  if (passes[pass].config.window_output) {
+    return backend->GetWindowRenderPass();
+  }
+
+  return passes[pass].render_pass;
+}
+
+uint32_t VulkanRenderGraph::GetSubpass(uint32_t pass) {
+  if (pass >= passes.size()) {
+    ERROR("Render graph has no pass %u!", pass);
+    return 0;
+  }
+
+  return passes[pass].subpass;
+}
+
+bool VulkanRenderGraph::IsPassCulled(uint32_t pass) {
+  if (pass >= passes.size()) {
+    ERROR("Render graph has no pass %u!", pass);
+    return true;
+  }
+
+  return passes[pass].culled;
+}
+
+bool VulkanRenderGraph::SortPasses() {
+  std::vector<std::vector<uint32_t>> writers(attachments.size());
+  for (uint32_t i = 0; i < passes.size(); ++i) {
+    std::vector<uint32_t> &outputs = passes[i].config.outputs;
+    for (uint32_t j = 0; j < outputs.size(); ++j) {
+      writers[outputs[j]].emplace_back(i);
+    }
+  }
+
+  /* an input is read once every pass writing it is done, and the writers of
+   * an attachment follow each other in the order they were added */
+  std::vector<std::vector<uint32_t>> dependencies(passes.size());
+  for (uint32_t i = 0; i < passes.size(); ++i) {
+    std::vector<uint32_t> inputs = passes[i].config.inputs;
+    inputs.insert(inputs.end(), passes[i].config.subpass_inputs.begin(),
+                  passes[i].config.subpass_inputs.end());
+    for (uint32_t j = 0; j < inputs.size(); ++j) {
+      std::vector<uint32_t> &input_writers = writers[inputs[j]];
+      for (uint32_t k = 0; k < input_writers.size(); ++k) {
+        if (input_writers[k] == i) {
+          ERROR("Render graph pass \"%s\" reads and writes \"%s\"!",
+                passes[i].name.c_str(), attachments[inputs[j]].name.c_str());
+          return false;
+        }
+        dependencies[i].emplace_back(input_writers[k]);
+      }
+    }
+
+    std::vector<uint32_t> &outputs = passes[i].config.outputs;
+    for (uint32_t j = 0; j < outputs.size(); ++j) {
+      std::vector<uint32_t> &output_writers = writers[outputs[j]];
+      for (uint32_t k = 0; k < output_writers.size(); ++k) {
+        if (output_writers[k] < i) {
+          dependencies[i].emplace_back(output_writers[k]);
+        }
+      }
+    }
+  }
+
+  /* only the passes the window passes and the exported attachments depend
+   * on are kept */
+  std::vector<uint32_t> stack;
+  for (uint32_t i = 0; i < passes.size(); ++i) {
+    passes[i].culled = true;
+    if (passes[i].config.window_output) {
+      stack.emplace_back(i);
+    }
+  }
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    if (attachments[i].config.exported) {
+      stack.insert(stack.end(), writers[i].begin(), writers[i].end());
+    }
+  }
+  if (!stack.size()) {
+    ERROR("Render graph has no window passes and no exported attachments!");
+    return false;
+  }
+
+  uint32_t live_count = 0;
+  while (stack.size()) {
+    uint32_t pass = stack.back();
+    stack.pop_back();
+    if (!passes[pass].culled) {
+      continue;
+    }
+
+    passes[pass].culled = false;
+    ++live_count;
+    for (uint32_t i = 0; i < dependencies[pass].size(); ++i) {
+      if (passes[dependencies[pass][i]].culled) {
+        stack.emplace_back(dependencies[pass][i]);
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < passes.size(); ++i) {
+    if (passes[i].culled) {
+      DEBUG("Render graph pass \"%s\" is culled", passes[i].name.c_str());
+    }
+  }
+
+  /* topological sort. Out of the passes that are ready, the earliest added
+   * one goes first */
+  std::vector<uint32_t> remaining(passes.size(), 0);
+  std::vector<std::vector<uint32_t>> dependents(passes.size());
+  for (uint32_t i = 0; i < passes.size(); ++i) {
+    if (passes[i].culled) {
+      continue;
+    }
+    for (uint32_t j = 0; j < dependencies[i].size(); ++j) {
+      ++remaining[i];
+      dependents[dependencies[i][j]].emplace_back(i);
+    }
+  }
+
+  std::vector<bool> sorted(passes.size(), false);
+  order.clear();
+  while (order.size() < live_count) {
+    int32_t next = -1;
+    for (uint32_t i = 0; i < passes.size(); ++i) {
+      if (!passes[i].culled && !sorted[i] && !remaining[i]) {
+        next = i;
+        break;
+      }
+    }
+    if (next < 0) {
+      ERROR("Render graph passes depend on each other!");
+      order.clear();
+      return false;
+    }
+
+    order.emplace_back(next);
+    sorted[next] = true;
+    for (uint32_t i = 0; i < dependents[next].size(); ++i) {
+      --remaining[dependents[next][i]];
+    }
+  }
+
+  /* subpasses join the render pass of the pass before them */
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    VulkanRenderGraphPass *pass = &passes[order[i]];
+    pass->first_position = i;
+    pass->subpass = 0;
+    if (!pass->config.subpass) {
+      continue;
+    }
+
+    if (!i || passes[order[i - 1]].config.window_output) {
+      ERROR("Render graph pass \"%s\" has no render pass to continue!",
+            pass->name.c_str());
+      order.clear();
+      return false;
+    }
+    VulkanRenderGraphPass *previous = &passes[order[i - 1]];
+    pass->first_position = previous->first_position;
+    pass->subpass = previous->subpass + 1;
+
+    uint32_t pass_width, pass_height, previous_width, previous_height;
+    GetSize(pass->config.outputs[0], &pass_width, &pass_height);
+    GetSize(previous->config.outputs[0], &previous_width, &previous_height);
+    if (pass_width != previous_width || pass_height != previous_height) {
+      ERROR("Render graph pass \"%s\" differs in size from the render pass "
+            "it continues!",
+            pass->name.c_str());
+      order.clear();
+      return false;
+    }
+
+    /* what the render pass writes can only be read at the same pixel */
+    std::vector<uint32_t> written;
+    for (uint32_t j = pass->first_position; j < i; ++j) {
+      std::vector<uint32_t> &outputs = passes[order[j]].config.outputs;
+      written.insert(written.end(), outputs.begin(), outputs.end());
+    }
+    for (uint32_t j = 0; j < pass->config.inputs.size(); ++j) {
+      if (std::find(written.begin(), written.end(), pass->config.inputs[j]) !=
+          written.end()) {
+        ERROR("Render graph pass \"%s\" samples \"%s\", which is written "
+              "by the render pass it continues!",
+              pass->name.c_str(),
+              attachments[pass->config.inputs[j]].name.c_str());
+        order.clear();
+        return false;
+      }
+    }
+    for (uint32_t j = 0; j < pass->config.subpass_inputs.size(); ++j) {
+      if (std::find(written.begin(), written.end(),
+                    pass->config.subpass_inputs[j]) == written.end()) {
+        ERROR("Subpass input \"%s\" of the render graph pass \"%s\" is not "
+              "written by the render pass it continues!",
+              attachments[pass->config.subpass_inputs[j]].name.c_str(),
+              pass->name.c_str());
+        order.clear();
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void VulkanRenderGraph::ComputeLifetimes() {
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    attachments[i].first_use = -1;
+    attachments[i].last_use = -1;
+  }
+
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    GPURenderGraphPassConfig *config = &passes[order[i]].config;
+
+    for (uint32_t j = 0; j < config->outputs.size(); ++j) {
+      VulkanRenderGraphAttachment *attachment =
+          &attachments[config->outputs[j]];
+      if (attachment->first_use < 0) {
+        attachment->first_use = i;
+      }
+      attachment->last_use = i;
+      attachment->last_access = GetAccess(config->outputs[j], true);
+    }
+    for (uint32_t j = 0; j < config->inputs.size(); ++j) {
+      VulkanRenderGraphAttachment *attachment = &attachments[config->inputs[j]];
+      if (attachment->first_use < 0) {
+        attachment->first_use = i;
+      }
+      attachment->last_use = i;
+      attachment->last_access = GetAccess(config->inputs[j], false);
+    }
+    /* the render pass leaves them in the attachment layout */
+    for (uint32_t j = 0; j < config->subpass_inputs.size(); ++j) {
+      VulkanRenderGraphAttachment *attachment =
+          &attachments[config->subpass_inputs[j]];
+      attachment->last_use = i;
+      attachment->last_access.stage_mask |=
+          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+  }
+
+  /* the exported attachments are read after the graph, by the fragment or
+   * the compute shaders */
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    if (attachments[i].config.exported && attachments[i].first_use >= 0) {
+      attachments[i].last_access = GetAccess(i, false);
+      attachments[i].last_access.stage_mask |=
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+  }
+}
+
+void VulkanRenderGraph::AliasAttachments() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  std::vector<uint32_t> used;
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    if (attachments[i].first_use >= 0) {
+      used.emplace_back(i);
+    } else {
+      DEBUG("Render graph attachment \"%s\" is unused",
+            attachments[i].name.c_str());
+    }
+  }
+  std::stable_sort(used.begin(), used.end(), [&](uint32_t a, uint32_t b) {
+    return attachments[a].first_use < attachments[b].first_use;
+  });
+
+  VkDeviceSize unaliased_size = 0;
+  uint32_t aliased_count = 0;
+  for (uint32_t i = 0; i < used.size(); ++i) {
+    VulkanRenderGraphAttachment *attachment = &attachments[used[i]];
+    GPURenderGraphAttachmentConfig *config = &attachment->config;
+    uint32_t attachment_width, attachment_height;
+    GetSize(used[i], &attachment_width, &attachment_height);
+
+    /* transient attachments may not be backed by memory at all, and the
+     * exported ones are read after the graph */
+    attachment->attachment = new VulkanAttachment();
+    if ((config->flags & GPU_ATTACHMENT_FLAG_TRANSIENT) || config->exported) {
+      attachment->attachment->Create(config->format, config->usage,
+                                     attachment_width, attachment_height,
+                                     config->flags);
+      attachment->attachment->SetDebugName(attachment->name.c_str());
+      attachment->block = -1;
+      attachment->previous_alias = used[i];
+      continue;
+    }
+
+    attachment->attachment->CreateAliased(config->format, config->usage,
+                                          attachment_width, attachment_height,
+                                          config->flags);
+    ++aliased_count;
+
+    VkMemoryRequirements requirements;
+    attachment->attachment->GetMemoryRequirements(&requirements);
+    unaliased_size += requirements.size;
+
+    /* out of the blocks free by the first use, the one that grows the
+     * least */
+    int32_t best_block = -1;
+    VkDeviceSize best_growth = 0;
+    for (uint32_t j = 0; j < blocks.size(); ++j) {
+      VulkanRenderGraphBlock *block = &blocks[j];
+      if (block->last_use >= attachment->first_use ||
+          !(block->requirements.memoryTypeBits &
+            requirements.memoryTypeBits)) {
+        continue;
+      }
+
+      VkDeviceSize growth = 0;
+      if (requirements.size > block->requirements.size) {
+        growth = requirements.size - block->requirements.size;
+      }
+      if (best_block < 0 || growth < best_growth) {
+        best_block = j;
+        best_growth = growth;
+      }
+    }
+
+    if (best_block < 0) {
+      VulkanRenderGraphBlock block = {};
+      block.memory = 0;
+      block.requirements = requirements;
+      block.last_use = -1;
+      block.last_attachment = -1;
+      blocks.emplace_back(block);
+      best_block = blocks.size() - 1;
+    } else {
+      VkMemoryRequirements *block_requirements =
+          &blocks[best_block].requirements;
+      block_requirements->size =
+          std::max(block_requirements->size, requirements.size);
+      block_requirements->alignment =
+          std::max(block_requirements->alignment, requirements.alignment);
+      block_requirements->memoryTypeBits &= requirements.memoryTypeBits;
+    }
+
+    attachment->block = best_block;
+    attachment->previous_alias = blocks[best_block].last_attachment;
+    blocks[best_block].last_use = attachment->last_use;
+    blocks[best_block].last_attachment = used[i];
+  }
+
+  /* the first attachment of a block reuses the memory of the last one of the
+   * previous frame */
+  for (uint32_t i = 0; i < used.size(); ++i) {
+    VulkanRenderGraphAttachment *attachment = &attachments[used[i]];
+    if (attachment->previous_alias < 0) {
+      attachment->previous_alias = blocks[attachment->block].last_attachment;
+    }
+  }
+
+  VkDeviceSize aliased_size = 0;
+  for (uint32_t i = 0; i < blocks.size(); ++i) {
+    VmaAllocationCreateInfo vma_allocation_create_info = {};
+    vma_allocation_create_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    vma_allocation_create_info.requiredFlags =
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    VK_CHECK(vmaAllocateMemory(context->vma_allocator, &blocks[i].requirements,
+                               &vma_allocation_create_info, &blocks[i].memory,
+                               0));
+    aliased_size += blocks[i].requirements.size;
+  }
+
+  for (uint32_t i = 0; i < used.size(); ++i) {
+    VulkanRenderGraphAttachment *attachment = &attachments[used[i]];
+    if (attachment->block < 0) {
+      continue;
+    }
+    attachment->attachment->BindAliasedMemory(
+        blocks[attachment->block].memory, 0);
+    attachment->attachment->SetDebugName(attachment->name.c_str());
+  }
+
+  DEBUG("Render graph: %u attachments in %u memory blocks, %llu bytes "
+        "instead of %llu",
+        aliased_count, (uint32_t)blocks.size(),
+        (unsigned long long)aliased_size, (unsigned long long)unaliased_size);
+}
+
+void VulkanRenderGraph::CreateRenderPasses() {
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    VulkanRenderGraphPass *pass = &passes[order[i]];
+    if (pass->config.window_output) {
+      continue;
+    }
+    if (pass->subpass) {
+      pass->render_pass = passes[order[pass->first_position]].render_pass;
+      continue;
+    }
+
+    /* the passes of the render pass, and the attachments they render to */
+    uint32_t last_position = i;
+    while (last_position + 1 < order.size() &&
+           passes[order[last_position + 1]].subpass) {
+      ++last_position;
+    }
+
+    std::vector<uint32_t> used;
+    uint8_t clear_flags = 0;
+    for (uint32_t j = i; j <= last_position; ++j) {
+      std::vector<uint32_t> &outputs = passes[order[j]].config.outputs;
+      for (uint32_t k = 0; k < outputs.size(); ++k) {
+        if (std::find(used.begin(), used.end(), outputs[k]) == used.end()) {
+          used.emplace_back(outputs[k]);
+        }
+      }
+      clear_flags |= passes[order[j]].config.clear_flags;
+    }
+
+    std::vector<GPURenderPassAttachmentConfig> attachment_configs;
+    for (uint32_t j = 0; j < used.size(); ++j) {
+      uint32_t output = used[j];
+
+      /* the contents are kept only as long as a later pass needs them */
+      GPURenderPassAttachmentConfig attachment_config;
+      attachment_config.format = attachments[output].config.format;
+      attachment_config.usage = attachments[output].config.usage;
+      attachment_config.load_operation =
+          IsWrittenBefore(output, i)
+              ? GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_LOAD
+              : GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_DONT_CARE;
+      attachment_config.store_operation =
+          IsUsedAfter(output, last_position) ||
+                  attachments[output].config.exported
+              ? GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_STORE
+              : GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_DONT_CARE;
+      attachment_config.present_after = false;
+
+      attachment_configs.emplace_back(attachment_config);
+    }
+
+    /* a single pass renders to all of its outputs */
+    std::vector<GPURenderPassSubpassConfig> subpass_configs;
+    for (uint32_t j = i; j <= last_position && last_position > i; ++j) {
+      GPURenderGraphPassConfig *config = &passes[order[j]].config;
+
+      GPURenderPassSubpassConfig subpass_config;
+      for (uint32_t k = 0; k < config->outputs.size(); ++k) {
+        uint32_t output = config->outputs[k];
+        uint32_t index =
+            std::find(used.begin(), used.end(), output) - used.begin();
+        if (GPUUtils::IsDepthFormat(attachments[output].config.format)) {
+          subpass_config.depth_attachment = index;
+        } else {
+          subpass_config.color_attachments.emplace_back(index);
+        }
+      }
+      for (uint32_t k = 0; k < config->subpass_inputs.size(); ++k) {
+        uint32_t input = config->subpass_inputs[k];
+        uint32_t index =
+            std::find(used.begin(), used.end(), input) - used.begin();
+        subpass_config.input_attachments.emplace_back(index);
+      }
+
+      subpass_configs.emplace_back(subpass_config);
+    }
+
+    GPURenderGraphPassConfig *config = &pass->config;
+    pass->render_pass = new VulkanRenderPass();
+    pass->render_pass->CreateWithExplicitBarriers(
+        attachment_configs, subpass_configs, glm::vec4(0.0f),
+        config->clear_color, config->clear_depth, config->clear_stencil,
+        clear_flags);
+    pass->render_pass->SetDebugName(pass->name.c_str());
+  }
+}
+
+void VulkanRenderGraph::CreateFramebuffers() {
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    VulkanRenderGraphPass *pass = &passes[order[i]];
+    if (pass->config.window_output || pass->subpass) {
+      continue;
+    }
+
+    /* in the order of the render pass attachments */
+    std::vector<uint32_t> used;
+    for (uint32_t j = i; j < order.size(); ++j) {
+      if (j > i && !passes[order[j]].subpass) {
+        break;
+      }
+      std::vector<uint32_t> &outputs = passes[order[j]].config.outputs;
+      for (uint32_t k = 0; k < outputs.size(); ++k) {
+        if (std::find(used.begin(), used.end(), outputs[k]) == used.end()) {
+          used.emplace_back(outputs[k]);
+        }
+      }
+    }
+
+    std::vector<GPUAttachment *> targets;
+    for (uint32_t j = 0; j < used.size(); ++j) {
+      targets.emplace_back(attachments[used[j]].attachment);
+    }
+
+    uint32_t target_width, target_height;
+    GetSize(used[0], &target_width, &target_height);
+
+    pass->render_pass->SetRenderArea(
+        glm::vec4(0, 0, target_width, target_height));
+
+    pass->framebuffer = new VulkanFramebuffer();
+    pass->framebuffer->Create(pass->render_pass, targets, target_width,
+                              target_height);
+    pass->framebuffer->SetDebugName(pass->name.c_str());
+  }
+}
+
+void VulkanRenderGraph::ComputeBarriers() {
+  std::vector<VulkanRenderGraphAccess> states(attachments.size());
+  /* position of the last pass that used the attachment */
+  std::vector<int32_t> positions(attachments.size(), -1);
+
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    VulkanRenderGraphPass *pass = &passes[order[i]];
+    /* the barriers of the whole render pass are recorded before it
+     * begins */
+    VulkanRenderGraphPass *first = &passes[order[pass->first_position]];
+    if (!pass->subpass) {
+      pass->barriers.clear();
+      pass->src_stage_mask = 0;
+      pass->dst_stage_mask = 0;
+    }
+
+    std::vector<std::pair<uint32_t, bool>> uses;
+    for (uint32_t j = 0; j < pass->config.outputs.size(); ++j) {
+      uses.emplace_back(pass->config.outputs[j], true);
+    }
+    for (uint32_t j = 0; j < pass->config.inputs.size(); ++j) {
+      uses.emplace_back(pass->config.inputs[j], false);
+    }
+
+    for (uint32_t j = 0; j < uses.size(); ++j) {
+      uint32_t index = uses[j].first;
+      VulkanRenderGraphAttachment *attachment = &attachments[index];
+      VulkanRenderGraphAccess access = GetAccess(index, uses[j].second);
+
+      /* the subpass dependencies order the uses inside of the render pass */
+      bool used_by_render_pass = positions[index] >= pass->first_position;
+      positions[index] = i;
+      if (used_by_render_pass) {
+        states[index].stage_mask |= access.stage_mask;
+        continue;
+      }
+
+      VkImageLayout old_layout;
+      VkPipelineStageFlags src_stage_mask;
+      VkAccessFlags src_access_mask;
+      if (attachment->first_use == (int32_t)i) {
+        /* the contents are discarded, but the previous user of the memory
+         * has to be done with it */
+        VulkanRenderGraphAccess *previous =
+            &attachments[attachment->previous_alias].last_access;
+        old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        src_stage_mask = previous->stage_mask;
+        src_access_mask =
+            previous->access_mask & VULKAN_RENDER_GRAPH_WRITE_ACCESS_MASK;
+      } else {
+        VulkanRenderGraphAccess *previous = &states[index];
+        /* reads after reads in the same layout need no barrier */
+        if (previous->layout == access.layout &&
+            !(previous->access_mask & VULKAN_RENDER_GRAPH_WRITE_ACCESS_MASK) &&
+            !(access.access_mask & VULKAN_RENDER_GRAPH_WRITE_ACCESS_MASK)) {
+          previous->stage_mask |= access.stage_mask;
+          continue;
+        }
+        old_layout = previous->layout;
+        src_stage_mask = previous->stage_mask;
+        src_access_mask =
+            previous->access_mask & VULKAN_RENDER_GRAPH_WRITE_ACCESS_MASK;
+      }
+
+      first->barriers.emplace_back(
+          GetBarrier(index, old_layout, src_access_mask, &access));
+      first->src_stage_mask |= src_stage_mask;
+      first->dst_stage_mask |= access.stage_mask;
+      states[index] = access;
+    }
+
+    /* read in the attachment layout, that the render pass leaves them in */
+    for (uint32_t j = 0; j < pass->config.subpass_inputs.size(); ++j) {
+      uint32_t index = pass->config.subpass_inputs[j];
+      positions[index] = i;
+      states[index].stage_mask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+  }
+
+  export_barriers.clear();
+  export_src_stage_mask = 0;
+  export_dst_stage_mask = 0;
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    VulkanRenderGraphAttachment *attachment = &attachments[i];
+    if (!attachment->config.exported || attachment->first_use < 0) {
+      continue;
+    }
+
+    VulkanRenderGraphAccess *previous = &states[i];
+    VulkanRenderGraphAccess *access = &attachment->last_access;
+    if (previous->layout == access->layout &&
+        !(previous->access_mask & VULKAN_RENDER_GRAPH_WRITE_ACCESS_MASK)) {
+      continue;
+    }
+
+    export_barriers.emplace_back(GetBarrier(
+        i, previous->layout,
+        previous->access_mask & VULKAN_RENDER_GRAPH_WRITE_ACCESS_MASK,
+        access));
+    export_src_stage_mask |= previous->stage_mask;
+    export_dst_stage_mask |= access->stage_mask;
+  }
+}
+
+void VulkanRenderGraph::DestroyAttachments() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  for (uint32_t i = 0; i < passes.size(); ++i) {
+    if (passes[i].framebuffer) {
+      passes[i].framebuffer->Destroy();
+      delete passes[i].framebuffer;
+      passes[i].framebuffer = 0;
+    }
+  }
+
+  /* the images have to go before the memory they are bound to */
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    if (attachments[i].attachment) {
+      attachments[i].attachment->Destroy();
+      delete attachments[i].attachment;
+      attachments[i].attachment = 0;
+    }
+    attachments[i].block = -1;
+    attachments[i].previous_alias = -1;
+  }
+
+  for (uint32_t i = 0; i < blocks.size(); ++i) {
+    if (blocks[i].memory) {
+      vmaFreeMemory(context->vma_allocator, blocks[i].memory);
+    }
+  }
+  blocks.clear();
+}
+
+void VulkanRenderGraph::GetSize(uint32_t attachment, uint32_t *out_width,
+                                uint32_t *out_height) {
+  GPURenderGraphAttachmentConfig *config = &attachments[attachment].config;
+
+  if (!config->width && !config->height) {
+    *out_width = width;
+    *out_height = height;
+    return;
+  }
+
+  *out_width = config->width;
+  *out_height = config->height;
+}
+
+VkImageMemoryBarrier
+VulkanRenderGraph::GetBarrier(uint32_t attachment, VkImageLayout old_layout,
+                              VkAccessFlags src_access_mask,
+                              VulkanRenderGraphAccess *access) {
+  VkImageMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.pNext = 0;
+  barrier.srcAccessMask = src_access_mask;
+  barrier.dstAccessMask = access->access_mask;
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = access->layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = attachments[attachment].attachment->GetHandle();
+  barrier.subresourceRange.aspectMask =
+      VulkanUtils::GPUTextureUsageToVulkanAspectFlags(
+          attachments[attachment].config.usage);
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+
+  return barrier;
+}
+
+VulkanRenderGraph::VulkanRenderGraphAccess
+VulkanRenderGraph::GetAccess(uint32_t attachment, bool output) {
+  bool is_depth_attachment =
+      GPUUtils::IsDepthFormat(attachments[attachment].config.format);
+
+  VulkanRenderGraphAccess access;
+  if (output && is_depth_attachment) {
+    access.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    access.stage_mask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                        VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    access.access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                         VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  } else if (output) {
+    access.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    access.stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    access.access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                         VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  } else {
+    /* same layouts as the attachment descriptors are written with */
+    access.layout = is_depth_attachment
+                        ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                        : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    access.stage_mask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    access.access_mask = VK_ACCESS_SHADER_READ_BIT;
+  }
+
+  return access;
+}
+
+bool VulkanRenderGraph::IsWrittenBefore(uint32_t attachment,
+                                        int32_t position) {
+  for (int32_t i = 0; i < position; ++i) {
+    std::vector<uint32_t> &outputs = passes[order[i]].config.outputs;
+    if (std::find(outputs.begin(), outputs.end(), attachment) !=
+        outputs.end()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool VulkanRenderGraph::IsUsedAfter(uint32_t attachment, int32_t position) {
+  return attachments[attachment].last_use > position;
+}
\ No newline at end of file
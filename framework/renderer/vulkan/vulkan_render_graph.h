@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../gpu_render_graph.h"
+#include "../renderer_backend.h"
+
+#include "vk_mem_alloc.h"
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+class VulkanAttachment;
+class VulkanRenderPass;
+class VulkanFramebuffer;
+
+class VulkanRenderGraph : public GPURenderGraph {
+public:
+  VulkanRenderGraph(RendererBackend *graph_backend);
+
+  uint32_t AddAttachment(const char *name,
+                         GPURenderGraphAttachmentConfig *config) override;
+  uint32_t AddPass(const char *name, GPURenderGraphPassConfig *config) override;
+
+  bool Compile() override;
+  void Destroy() override;
+  void Resize(uint32_t width, uint32_t height) override;
+
+  void Execute() override;
+
+  GPUAttachment *GetAttachment(uint32_t attachment) override;
+  GPURenderPass *GetRenderPass(uint32_t pass) override;
+  uint32_t GetSubpass(uint32_t pass) override;
+  bool IsPassCulled(uint32_t pass) override;
+
+private:
+  /* layout, stages and accesses of an attachment during a pass */
+  struct VulkanRenderGraphAccess {
+    VkImageLayout layout;
+    VkPipelineStageFlags stage_mask;
+    VkAccessFlags access_mask;
+  };
+
+  struct VulkanRenderGraphAttachment {
+    std::string name;
+    GPURenderGraphAttachmentConfig config;
+    VulkanAttachment *attachment;
+    /* positions in the execution order, -1 if no pass uses it */
+    int32_t first_use;
+    int32_t last_use;
+    VulkanRenderGraphAccess last_access;
+    /* -1 for the transient and exported attachments, which have memory of
+     * their own */
+    int32_t block;
+    /* attachment that used the memory before this one, the last one of the
+     * previous frame for the first attachment of a block */
+    int32_t previous_alias;
+  };
+
+  struct VulkanRenderGraphPass {
+    std::string name;
+    GPURenderGraphPassConfig config;
+    bool culled;
+    /* position in the execution order of the pass that begins the render
+     * pass, and the subpass of this pass in it */
+    int32_t first_position;
+    uint32_t subpass;
+    /* shared by the passes of the render pass, owned by the first one */
+    VulkanRenderPass *render_pass;
+    VulkanFramebuffer *framebuffer;
+    /* transitions recorded right before the render pass, as a single
+     * barrier. Only the first pass of a render pass records them */
+    std::vector<VkImageMemoryBarrier> barriers;
+    VkPipelineStageFlags src_stage_mask;
+    VkPipelineStageFlags dst_stage_mask;
+  };
+
+  /* memory shared by the attachments with disjoint lifetimes */
+  struct VulkanRenderGraphBlock {
+    VmaAllocation memory;
+    VkMemoryRequirements requirements;
+    int32_t last_use;
+    int32_t last_attachment;
+  };
+
+  bool SortPasses();
+  void ComputeLifetimes();
+  void AliasAttachments();
+  void CreateRenderPasses();
+  void CreateFramebuffers();
+  void ComputeBarriers();
+  /* framebuffers, attachments and their memory */
+  void DestroyAttachments();
+
+  void GetSize(uint32_t attachment, uint32_t *out_width,
+               uint32_t *out_height);
+  VulkanRenderGraphAccess GetAccess(uint32_t attachment, bool output);
+  VkImageMemoryBarrier GetBarrier(uint32_t attachment,
+                                  VkImageLayout old_layout,
+                                  VkAccessFlags src_access_mask,
+                                  VulkanRenderGraphAccess *access);
+  bool IsWrittenBefore(uint32_t attachment, int32_t position);
+  bool IsUsedAfter(uint32_t attachment, int32_t position);
+
+  RendererBackend *backend;
+  bool compiled;
+  uint32_t width;
+  uint32_t height;
+
+  std::vector<VulkanRenderGraphAttachment> attachments;
+  std::vector<VulkanRenderGraphPass> passes;
+  std::vector<VulkanRenderGraphBlock> blocks;
+  /* indices of the passes that are not culled, in the execution order */
+  std::vector<uint32_t> order;
+  /* transitions of the exported attachments, recorded after the passes */
+  std::vector<VkImageMemoryBarrier> export_barriers;
+  VkPipelineStageFlags export_src_stage_mask;
+  VkPipelineStageFlags export_dst_stage_mask;
+};
\ No newline at end of file
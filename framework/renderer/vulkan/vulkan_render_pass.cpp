@@ -2,6 +2,7 @@
 
 #include "../../logger.h"
 #include "../gpu_utils.h"
+#include "vulkan_attachment.h"
 #include "vulkan_backend.h"
 #include "vulkan_command_buffer.h"
 #include "vulkan_context.h"
@@ -12,23 +13,105 @@
 
 #include <array>
 
+PFN_vkCmdBeginRenderingKHR VulkanRenderPass::vkRenderPassBeginRendering;
+PFN_vkCmdEndRenderingKHR VulkanRenderPass::vkRenderPassEndRendering;
+bool VulkanRenderPass::dynamic_rendering;
+
+void VulkanRenderPass::Initialize() {
+  VulkanContext *context = VulkanBackend::GetContext();
+  VkDevice device = context->device->GetLogicalDevice();
+
+  dynamic_rendering = context->device->GetOptionalFeatures().dynamic_rendering;
+  if (!dynamic_rendering) {
+    return;
+  }
+
+  /* the core entry points are missing if the device is older than 1.3 */
+  vkRenderPassBeginRendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(
+      device, "vkCmdBeginRendering");
+  vkRenderPassEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(
+      device, "vkCmdEndRendering");
+  if (!vkRenderPassBeginRendering || !vkRenderPassEndRendering) {
+    vkRenderPassBeginRendering =
+        (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(
+            device, "vkCmdBeginRenderingKHR");
+    vkRenderPassEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(
+        device, "vkCmdEndRenderingKHR");
+  }
+
+  dynamic_rendering = vkRenderPassBeginRendering && vkRenderPassEndRendering;
+}
+
+bool VulkanRenderPass::Create(
+    std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
+    glm::vec4 pass_render_area, glm::vec4 pass_clear_color, float pass_depth,
+    float pass_stencil, uint8_t pass_clear_flags) {
+  return CreateNative(pass_render_attachments,
+                      std::vector<GPURenderPassSubpassConfig>{},
+                      pass_render_area, pass_clear_color, pass_depth,
+                      pass_stencil, pass_clear_flags, false);
+}
+
 bool VulkanRenderPass::Create(
     std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
+    std::vector<GPURenderPassSubpassConfig> pass_subpasses,
+    glm::vec4 pass_render_area, glm::vec4 pass_clear_color, float pass_depth,
+    float pass_stencil, uint8_t pass_clear_flags) {
+  if (pass_subpasses.empty()) {
+    ERROR("Render pass has no subpasses!");
+    return false;
+  }
+
+  return CreateNative(pass_render_attachments, pass_subpasses,
+                      pass_render_area, pass_clear_color, pass_depth,
+                      pass_stencil, pass_clear_flags, false);
+}
+
+bool VulkanRenderPass::CreateWithExplicitBarriers(
+    std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
+    std::vector<GPURenderPassSubpassConfig> pass_subpasses,
     glm::vec4 pass_render_area, glm::vec4 pass_clear_color, float pass_depth,
     float pass_stencil, uint8_t pass_clear_flags) {
+  return CreateNative(pass_render_attachments, pass_subpasses,
+                      pass_render_area, pass_clear_color, pass_depth,
+                      pass_stencil, pass_clear_flags, true);
+}
+
+bool VulkanRenderPass::CreateNative(
+    std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
+    std::vector<GPURenderPassSubpassConfig> pass_subpasses,
+    glm::vec4 pass_render_area, glm::vec4 pass_clear_color, float pass_depth,
+    float pass_stencil, uint8_t pass_clear_flags, bool explicit_barriers) {
   VulkanContext *context = VulkanBackend::GetContext();
 
   attachments = pass_render_attachments;
+  subpasses = pass_subpasses;
   render_area = pass_render_area;
   clear_color = pass_clear_color;
   depth = pass_depth;
   stencil = pass_stencil;
   clear_flags = pass_clear_flags;
 
-  std::vector<VkAttachmentDescription> attachment_descriptions;
-  std::vector<VkAttachmentReference> color_attachment_references;
-  VkAttachmentReference depth_attachment_reference;
+  /* without subpasses, a single one renders to all of the attachments */
+  bool default_subpass = subpasses.empty();
+  if (default_subpass) {
+    GPURenderPassSubpassConfig subpass;
+    for (uint32_t i = 0; i < attachments.size(); ++i) {
+      if (GPUUtils::IsDepthFormat(attachments[i].format)) {
+        /* only 1 depth attachment */
+        subpass.depth_attachment = i;
+      } else {
+        subpass.color_attachments.emplace_back(i);
+      }
+    }
+    subpasses.emplace_back(subpass);
+  }
 
+  if (!ValidateSubpasses()) {
+    return false;
+  }
+
+  std::vector<VkAttachmentDescription> attachment_descriptions;
   for (uint32_t i = 0; i < attachments.size(); ++i) {
     GPURenderPassAttachmentConfig *attachment_config = &attachments[i];
     bool is_depth_attachment = GPUUtils::IsDepthFormat(attachments[i].format);
@@ -77,6 +160,10 @@ bool VulkanRenderPass::Create(
       attachment.finalLayout = attachment_config->present_after
                                    ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
                                    : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      if (explicit_barriers) {
+        attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      }
     } else { /* depth attachment */
       bool do_clear_depth = clear_flags & GPU_RENDER_PASS_CLEAR_FLAG_DEPTH;
 
@@ -116,53 +203,197 @@ bool VulkanRenderPass::Create(
               ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
               : VK_IMAGE_LAYOUT_UNDEFINED;
       attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+      if (explicit_barriers) {
+        attachment.initialLayout =
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        attachment.finalLayout =
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+      }
     }
 
     attachment_descriptions.emplace_back(attachment);
+  }
 
-    VkAttachmentReference attachment_reference;
-    attachment_reference.attachment = i; /* array index */
-    attachment_reference.layout =
-        is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-                            : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    if (is_depth_attachment) {
-      /* only 1 depth attachment */
-      depth_attachment_reference = attachment_reference;
+  /* dynamic rendering has no subpasses */
+  dynamic = dynamic_rendering && default_subpass;
+  record_transitions = !explicit_barriers;
+  current_target = 0;
+  current_subpass = 0;
+  descriptions = attachment_descriptions;
+  color_formats.clear();
+  depth_format = VK_FORMAT_UNDEFINED;
+  for (uint32_t i = 0; i < attachment_descriptions.size(); ++i) {
+    if (GPUUtils::IsDepthFormat(attachments[i].format)) {
+      depth_format = attachment_descriptions[i].format;
     } else {
-      color_attachment_references.emplace_back(attachment_reference);
+      color_formats.emplace_back(attachment_descriptions[i].format);
     }
   }
 
-  /* TODO: other attachment types (input, resolve, preserve) */
-  VkSubpassDescription subpass_description = {};
-  subpass_description.flags = 0;
-  subpass_description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-  subpass_description.inputAttachmentCount = 0;
-  subpass_description.pInputAttachments = 0;
-  subpass_description.colorAttachmentCount = color_attachment_references.size();
-  subpass_description.pColorAttachments = color_attachment_references.data();
-  subpass_description.pResolveAttachments = 0;
-  subpass_description.pDepthStencilAttachment = &depth_attachment_reference;
-  subpass_description.preserveAttachmentCount = 0;
-  subpass_description.pPreserveAttachments = 0;
-
-  /* TODO: make this configurable */
-  std::array<VkSubpassDependency, 2> dependencies;
-  dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-  dependencies[0].dstSubpass = 0;
-  dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-  dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-  dependencies[1].srcSubpass = 0;
-  dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-  dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-  dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+  if (dynamic) {
+    /* Begin renders directly into the attachments of the target, and the
+     * layout transitions of the descriptions are recorded around it */
+    handle = 0;
+    return true;
+  }
+
+  /* the references are pointed to by the descriptions, so they are all
+   * gathered first */
+  std::vector<std::vector<VkAttachmentReference>> color_references(
+      subpasses.size());
+  std::vector<std::vector<VkAttachmentReference>> input_references(
+      subpasses.size());
+  std::vector<VkAttachmentReference> depth_references(subpasses.size());
+  std::vector<std::vector<uint32_t>> preserve_attachments(subpasses.size());
+  for (uint32_t i = 0; i < subpasses.size(); ++i) {
+    GPURenderPassSubpassConfig *subpass = &subpasses[i];
+
+    for (uint32_t j = 0; j < subpass->color_attachments.size(); ++j) {
+      VkAttachmentReference attachment_reference;
+      attachment_reference.attachment = subpass->color_attachments[j];
+      attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      color_references[i].emplace_back(attachment_reference);
+    }
+
+    for (uint32_t j = 0; j < subpass->input_attachments.size(); ++j) {
+      uint32_t attachment = subpass->input_attachments[j];
+
+      VkAttachmentReference attachment_reference;
+      attachment_reference.attachment = attachment;
+      attachment_reference.layout =
+          GPUUtils::IsDepthFormat(attachments[attachment].format)
+              ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+              : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      input_references[i].emplace_back(attachment_reference);
+    }
+
+    if (subpass->depth_attachment >= 0) {
+      depth_references[i].attachment = subpass->depth_attachment;
+      depth_references[i].layout =
+          VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    }
+
+    /* attachments that pass through this subpass keep their contents */
+    for (uint32_t j = 0; j < attachments.size(); ++j) {
+      if (UsesAttachment(i, j)) {
+        continue;
+      }
+
+      bool used_before = false;
+      for (uint32_t k = 0; k < i; ++k) {
+        used_before |= UsesAttachment(k, j);
+      }
+      bool used_after = false;
+      for (uint32_t k = i + 1; k < subpasses.size(); ++k) {
+        used_after |= UsesAttachment(k, j);
+      }
+
+      if (used_before && used_after) {
+        preserve_attachments[i].emplace_back(j);
+      }
+    }
+  }
+
+  /* TODO: resolve attachments */
+  std::vector<VkSubpassDescription> subpass_descriptions;
+  for (uint32_t i = 0; i < subpasses.size(); ++i) {
+    VkSubpassDescription subpass_description = {};
+    subpass_description.flags = 0;
+    subpass_description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass_description.inputAttachmentCount = input_references[i].size();
+    subpass_description.pInputAttachments = input_references[i].data();
+    subpass_description.colorAttachmentCount = color_references[i].size();
+    subpass_description.pColorAttachments = color_references[i].data();
+    subpass_description.pResolveAttachments = 0;
+    subpass_description.pDepthStencilAttachment =
+        subpasses[i].depth_attachment >= 0 ? &depth_references[i] : 0;
+    subpass_description.preserveAttachmentCount =
+        preserve_attachments[i].size();
+    subpass_description.pPreserveAttachments = preserve_attachments[i].data();
+
+    subpass_descriptions.emplace_back(subpass_description);
+  }
+
+  std::vector<VkSubpassDependency> dependencies;
+  /* with explicit barriers the attachments are not transitioned inside of
+   * the pass, so the implicit external dependencies are enough */
+  for (uint32_t i = 0; i < subpasses.size() && !explicit_barriers; ++i) {
+    /* TODO: make this configurable */
+    VkSubpassDependency dependency;
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = i;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+    dependencies.emplace_back(dependency);
+
+    dependency.srcSubpass = i;
+    dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+    dependencies.emplace_back(dependency);
+  }
+
+  /* input attachments are read at the same pixel they were written, so
+   * the dependencies are by region and the data never leaves the tile */
+  for (uint32_t i = 0; i < subpasses.size(); ++i) {
+    for (uint32_t j = 0; j < i; ++j) {
+      bool reads_output = false;
+      for (uint32_t k = 0; k < subpasses[i].input_attachments.size(); ++k) {
+        uint32_t attachment = subpasses[i].input_attachments[k];
+        reads_output |= subpasses[j].depth_attachment == (int32_t)attachment;
+        for (uint32_t l = 0; l < subpasses[j].color_attachments.size(); ++l) {
+          reads_output |= subpasses[j].color_attachments[l] == attachment;
+        }
+      }
+      if (!reads_output) {
+        continue;
+      }
+
+      VkSubpassDependency dependency;
+      dependency.srcSubpass = j;
+      dependency.dstSubpass = i;
+      dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      dependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+      dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      dependency.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+      dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+      dependencies.emplace_back(dependency);
+    }
+  }
+
+  /* depth written by a subpass and tested again by a later one, as after a
+   * depth prepass. The later tests have to see the earlier writes */
+  for (uint32_t i = 0; i < subpasses.size(); ++i) {
+    if (subpasses[i].depth_attachment < 0) {
+      continue;
+    }
+
+    for (uint32_t j = 0; j < i; ++j) {
+      if (subpasses[j].depth_attachment != subpasses[i].depth_attachment) {
+        continue;
+      }
+
+      VkSubpassDependency dependency;
+      dependency.srcSubpass = j;
+      dependency.dstSubpass = i;
+      dependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      dependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+      dependencies.emplace_back(dependency);
+    }
+  }
 
   VkRenderPassCreateInfo render_pass_create_info = {};
   render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -170,8 +401,8 @@ bool VulkanRenderPass::Create(
   render_pass_create_info.flags = 0;
   render_pass_create_info.attachmentCount = attachment_descriptions.size();
   render_pass_create_info.pAttachments = attachment_descriptions.data();
-  render_pass_create_info.subpassCount = 1;
-  render_pass_create_info.pSubpasses = &subpass_description;
+  render_pass_create_info.subpassCount = subpass_descriptions.size();
+  render_pass_create_info.pSubpasses = subpass_descriptions.data();
   render_pass_create_info.dependencyCount = dependencies.size();
   render_pass_create_info.pDependencies = dependencies.data();
 
@@ -182,14 +413,82 @@ bool VulkanRenderPass::Create(
   return true;
 }
 
+bool VulkanRenderPass::ValidateSubpasses() {
+  for (uint32_t i = 0; i < subpasses.size(); ++i) {
+    GPURenderPassSubpassConfig *subpass = &subpasses[i];
+
+    for (uint32_t j = 0; j < subpass->color_attachments.size(); ++j) {
+      uint32_t attachment = subpass->color_attachments[j];
+      if (attachment >= attachments.size() ||
+          GPUUtils::IsDepthFormat(attachments[attachment].format)) {
+        ERROR("Subpass %u has an invalid color attachment %u!", i,
+              attachment);
+        return false;
+      }
+    }
+
+    for (uint32_t j = 0; j < subpass->input_attachments.size(); ++j) {
+      uint32_t attachment = subpass->input_attachments[j];
+      if (attachment >= attachments.size()) {
+        ERROR("Subpass %u has an invalid input attachment %u!", i, attachment);
+        return false;
+      }
+    }
+
+    int32_t depth_attachment = subpass->depth_attachment;
+    if (depth_attachment >= (int32_t)attachments.size() ||
+        (depth_attachment >= 0 &&
+         !GPUUtils::IsDepthFormat(attachments[depth_attachment].format))) {
+      ERROR("Subpass %u has an invalid depth attachment %d!", i,
+            depth_attachment);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool VulkanRenderPass::UsesAttachment(uint32_t subpass, uint32_t attachment) {
+  GPURenderPassSubpassConfig *config = &subpasses[subpass];
+
+  if (config->depth_attachment == (int32_t)attachment) {
+    return true;
+  }
+  for (uint32_t i = 0; i < config->color_attachments.size(); ++i) {
+    if (config->color_attachments[i] == attachment) {
+      return true;
+    }
+  }
+  for (uint32_t i = 0; i < config->input_attachments.size(); ++i) {
+    if (config->input_attachments[i] == attachment) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 void VulkanRenderPass::Destroy() {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  vkDestroyRenderPass(context->device->GetLogicalDevice(), handle,
-                      context->allocator);
+  if (context->render_target_pool) {
+    context->render_target_pool->InvalidateRenderPass(this);
+  }
+  if (handle) {
+    context->pipeline_library->ReleaseRenderPass(handle);
+    vkDestroyRenderPass(context->device->GetLogicalDevice(), handle,
+                        context->allocator);
+  }
 
   handle = 0;
+  dynamic = false;
+  current_subpass = 0;
+  descriptions.clear();
+  color_formats.clear();
+  depth_format = VK_FORMAT_UNDEFINED;
+  current_target = 0;
   attachments.clear();
+  subpasses.clear();
   render_area = glm::vec4(0.0f);
   clear_color = glm::vec4(0.0f);
   depth = 0;
@@ -200,31 +499,94 @@ void VulkanRenderPass::Destroy() {
 void VulkanRenderPass::Begin(GPURenderTarget *target) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
 
-  std::vector<VkClearValue> clear_values;
-  if (clear_flags & GPU_RENDER_PASS_CLEAR_FLAG_COLOR) {
-    for (int i = 0; i < attachments.size(); ++i) {
-      bool is_depth_attachment = GPUUtils::IsDepthFormat(attachments[i].format);
-      if (!is_depth_attachment) {
-        VkClearValue value = {};
-        value.color.float32[0] = clear_color.r;
-        value.color.float32[1] = clear_color.g;
-        value.color.float32[2] = clear_color.b;
-        value.color.float32[3] = clear_color.a;
-
-        clear_values.emplace_back(value);
-      }
+  current_target = target;
+  current_subpass = 0;
+  if (dynamic) {
+    BeginRendering(target, command_buffer);
+  } else {
+    BeginRenderPass(target, command_buffer);
+  }
+
+  /* covers the render area only, so that a pass rendering at a lower
+   * resolution uses the corner of its attachments */
+  VkViewport viewport;
+  viewport.x = render_area.x;
+  viewport.y = render_area.y + render_area.w;
+  viewport.width = render_area.z;
+  viewport.height = -render_area.w;
+  viewport.minDepth = 0.0f;
+  viewport.maxDepth = 1.0f;
+
+  VkRect2D scissor;
+  scissor.offset.x = render_area.x;
+  scissor.offset.y = render_area.y;
+  scissor.extent.width = render_area.z;
+  scissor.extent.height = render_area.w;
+
+  vkCmdSetViewport(command_buffer->GetHandle(), 0, 1, &viewport);
+  vkCmdSetScissor(command_buffer->GetHandle(), 0, 1, &scissor);
+}
+
+void VulkanRenderPass::NextSubpass() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  if (current_subpass + 1 >= subpasses.size()) {
+    WARN("Render pass has no more subpasses!");
+    return;
+  }
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  /* viewport and scissor are kept, but the pipeline of the previous subpass
+   * can't be used anymore */
+  vkCmdNextSubpass(command_buffer->GetHandle(), VK_SUBPASS_CONTENTS_INLINE);
+  context->bound_shader = 0;
+  context->bound_pipeline = 0;
+  ++current_subpass;
+}
+
+void VulkanRenderPass::End() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  if (dynamic) {
+    vkRenderPassEndRendering(command_buffer->GetHandle());
+    if (record_transitions) {
+      RecordTransitions(command_buffer, false);
     }
+  } else {
+    vkCmdEndRenderPass(command_buffer->GetHandle());
   }
-  if (clear_flags & GPU_RENDER_PASS_CLEAR_FLAG_DEPTH ||
-      clear_flags & GPU_RENDER_PASS_CLEAR_FLAG_STENCIL) {
+
+  current_target = 0;
+}
+
+void VulkanRenderPass::BeginRenderPass(GPURenderTarget *target,
+                                       VulkanCommandBuffer *command_buffer) {
+  /* clear values are indexed by the attachment index */
+  std::vector<VkClearValue> clear_values;
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
     VkClearValue value = {};
-    if (clear_flags & GPU_RENDER_PASS_CLEAR_FLAG_DEPTH) {
+    if (GPUUtils::IsDepthFormat(attachments[i].format)) {
       value.depthStencil.depth = depth;
-    }
-    if (clear_flags & GPU_RENDER_PASS_CLEAR_FLAG_STENCIL) {
       value.depthStencil.stencil = stencil;
+    } else {
+      value.color.float32[0] = clear_color.r;
+      value.color.float32[1] = clear_color.g;
+      value.color.float32[2] = clear_color.b;
+      value.color.float32[3] = clear_color.a;
     }
 
     clear_values.emplace_back(value);
@@ -242,48 +604,174 @@ void VulkanRenderPass::Begin(GPURenderTarget *target) {
   begin_info.clearValueCount = clear_values.size();
   begin_info.pClearValues = clear_values.data();
 
-  VulkanDeviceQueueInfo info =
-      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
-  VulkanCommandBuffer *command_buffer =
-      &info.command_buffers[context->image_index];
-
   vkCmdBeginRenderPass(command_buffer->GetHandle(), &begin_info,
                        VK_SUBPASS_CONTENTS_INLINE);
+}
 
-  VkViewport viewport;
-  viewport.x = 0.0f;
-  viewport.y = render_area.w;
-  viewport.width = render_area.z;
-  viewport.height = -render_area.w;
-  viewport.minDepth = 0.0f;
-  viewport.maxDepth = 1.0f;
+void VulkanRenderPass::BeginRendering(GPURenderTarget *target,
+                                      VulkanCommandBuffer *command_buffer) {
+  std::vector<GPUAttachment *> &target_attachments = target->GetAttachments();
 
-  VkRect2D scissor;
-  scissor.offset.x = scissor.offset.y = 0;
-  scissor.extent.width = render_area.z;
-  scissor.extent.height = render_area.w;
+  if (record_transitions) {
+    RecordTransitions(command_buffer, true);
+  }
 
-  vkCmdSetViewport(command_buffer->GetHandle(), 0, 1, &viewport);
-  vkCmdSetScissor(command_buffer->GetHandle(), 0, 1, &scissor);
+  std::vector<VkRenderingAttachmentInfo> color_attachments;
+  VkRenderingAttachmentInfo depth_attachment = {};
+  VkRenderingAttachmentInfo stencil_attachment = {};
+  bool has_depth_attachment = false;
+  for (uint32_t i = 0; i < descriptions.size(); ++i) {
+    VkRenderingAttachmentInfo attachment_info = {};
+    attachment_info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    attachment_info.pNext = 0;
+    attachment_info.imageView =
+        ((VulkanAttachment *)target_attachments[i])->GetImageView();
+    attachment_info.resolveMode = VK_RESOLVE_MODE_NONE;
+    attachment_info.resolveImageView = 0;
+    attachment_info.resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment_info.loadOp = descriptions[i].loadOp;
+    attachment_info.storeOp = descriptions[i].storeOp;
+
+    if (GPUUtils::IsDepthFormat(attachments[i].format)) {
+      attachment_info.imageLayout =
+          VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+      attachment_info.clearValue.depthStencil.depth = depth;
+      attachment_info.clearValue.depthStencil.stencil = stencil;
+      depth_attachment = attachment_info;
+      has_depth_attachment = true;
+
+      stencil_attachment = attachment_info;
+      stencil_attachment.loadOp = descriptions[i].stencilLoadOp;
+      stencil_attachment.storeOp = descriptions[i].stencilStoreOp;
+    } else {
+      attachment_info.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      attachment_info.clearValue.color.float32[0] = clear_color.r;
+      attachment_info.clearValue.color.float32[1] = clear_color.g;
+      attachment_info.clearValue.color.float32[2] = clear_color.b;
+      attachment_info.clearValue.color.float32[3] = clear_color.a;
+      color_attachments.emplace_back(attachment_info);
+    }
+  }
+
+  VkRenderingInfo rendering_info = {};
+  rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+  rendering_info.pNext = 0;
+  rendering_info.flags = 0;
+  rendering_info.renderArea.offset.x = render_area.x;
+  rendering_info.renderArea.offset.y = render_area.y;
+  rendering_info.renderArea.extent.width = render_area.z;
+  rendering_info.renderArea.extent.height = render_area.w;
+  rendering_info.layerCount = 1;
+  rendering_info.viewMask = 0;
+  rendering_info.colorAttachmentCount = color_attachments.size();
+  rendering_info.pColorAttachments = color_attachments.data();
+  rendering_info.pDepthAttachment =
+      has_depth_attachment ? &depth_attachment : 0;
+  rendering_info.pStencilAttachment =
+      has_depth_attachment && VulkanUtils::FormatHasStencil(depth_format)
+          ? &stencil_attachment
+          : 0;
+
+  vkRenderPassBeginRendering(command_buffer->GetHandle(), &rendering_info);
 }
 
-void VulkanRenderPass::End() {
-  VulkanContext *context = VulkanBackend::GetContext();
+void VulkanRenderPass::RecordTransitions(VulkanCommandBuffer *command_buffer,
+                                         bool begin) {
+  std::vector<GPUAttachment *> &target_attachments =
+      current_target->GetAttachments();
+
+  /* same synchronization as the external dependencies of the render pass
+   * objects. The acquired swapchain images are waited for at the color
+   * attachment output stage */
+  VkPipelineStageFlags src_stage_mask;
+  VkPipelineStageFlags dst_stage_mask;
+  if (begin) {
+    src_stage_mask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                     VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dst_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                     VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                     VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  } else {
+    src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                     VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dst_stage_mask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  }
 
-  VulkanDeviceQueueInfo info =
-      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
-  VulkanCommandBuffer *command_buffer =
-      &info.command_buffers[context->image_index];
+  std::vector<VkImageMemoryBarrier> barriers;
+  for (uint32_t i = 0; i < descriptions.size(); ++i) {
+    bool is_depth_attachment = GPUUtils::IsDepthFormat(attachments[i].format);
+    VkImageLayout attachment_layout =
+        is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+                            : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    VkAccessFlags attachment_access =
+        is_depth_attachment
+            ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+            : VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    VkAccessFlags attachment_write_access =
+        is_depth_attachment ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+                            : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = 0;
+    if (begin) {
+      barrier.srcAccessMask = attachment_write_access;
+      barrier.dstAccessMask = attachment_access;
+      barrier.oldLayout = descriptions[i].initialLayout;
+      barrier.newLayout = attachment_layout;
+    } else {
+      barrier.srcAccessMask = attachment_write_access;
+      barrier.dstAccessMask =
+          descriptions[i].finalLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+              ? 0
+              : VK_ACCESS_SHADER_READ_BIT;
+      barrier.oldLayout = attachment_layout;
+      barrier.newLayout = descriptions[i].finalLayout;
+    }
+    if (barrier.oldLayout == barrier.newLayout) {
+      continue;
+    }
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = ((VulkanAttachment *)target_attachments[i])->GetHandle();
+    barrier.subresourceRange.aspectMask =
+        is_depth_attachment ? VK_IMAGE_ASPECT_DEPTH_BIT
+                            : VK_IMAGE_ASPECT_COLOR_BIT;
+    if (is_depth_attachment && VulkanUtils::FormatHasStencil(depth_format)) {
+      barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
 
-  vkCmdEndRenderPass(command_buffer->GetHandle());
+    barriers.emplace_back(barrier);
+  }
+
+  if (barriers.empty()) {
+    return;
+  }
+
+  vkCmdPipelineBarrier(command_buffer->GetHandle(), src_stage_mask,
+                       dst_stage_mask, 0, 0, 0, 0, 0, barriers.size(),
+                       barriers.data());
 }
 
 void VulkanRenderPass::SetDebugName(const char *name) {
+  if (!handle) {
+    return;
+  }
   VulkanDebugUtils::SetObjectName(name, (uint64_t)handle,
                                   VK_OBJECT_TYPE_RENDER_PASS);
 }
 
 void VulkanRenderPass::SetDebugTag(const void *tag, size_t tag_size) {
+  if (!handle) {
+    return;
+  }
   VulkanDebugUtils::SetObjectTag(tag, (uint64_t)handle,
                                  VK_OBJECT_TYPE_RENDER_PASS, 0, tag_size);
 }
\ No newline at end of file
@@ -2,30 +2,86 @@
 
 #include "../gpu_render_pass.h"
 
+#include <vector>
 #include <vulkan/vulkan.h>
 
 class VulkanContext;
 class VulkanCommandBuffer;
 
+/* With VK_KHR_dynamic_rendering no render pass object is created: Begin
+ * renders into the attachments of the target directly and records the
+ * layout transitions of the attachment descriptions around the pass, and
+ * the pipelines are created against the attachment formats. Render passes
+ * with subpasses always use the render pass objects */
 class VulkanRenderPass : public GPURenderPass {
 public:
+  static void Initialize();
+
+  bool
+  Create(std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
+         glm::vec4 pass_render_area, glm::vec4 pass_clear_color,
+         float pass_depth, float pass_stencil,
+         uint8_t pass_clear_flags) override;
   bool
   Create(std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
+         std::vector<GPURenderPassSubpassConfig> pass_subpasses,
          glm::vec4 pass_render_area, glm::vec4 pass_clear_color,
          float pass_depth, float pass_stencil,
          uint8_t pass_clear_flags) override;
   void Destroy() override;
 
+  /* attachments are expected to be in the attachment layouts when the pass
+   * begins and are left in them, the caller records the transitions and
+   * dependencies around the pass. Used by the VulkanRenderGraph. Without
+   * subpasses, a single one renders to all of the attachments */
+  bool CreateWithExplicitBarriers(
+      std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
+      std::vector<GPURenderPassSubpassConfig> pass_subpasses,
+      glm::vec4 pass_render_area, glm::vec4 pass_clear_color, float pass_depth,
+      float pass_stencil, uint8_t pass_clear_flags);
+
   void Begin(GPURenderTarget *target) override;
+  void NextSubpass() override;
   void End() override;
 
   void SetDebugName(const char *name) override;
   void SetDebugTag(const void *tag, size_t tag_size) override;
 
+  /* 0 with dynamic rendering */
   inline VkRenderPass GetHandle() const { return handle; }
+  inline bool IsDynamic() const { return dynamic; }
+  inline std::vector<VkFormat> &GetColorFormats() { return color_formats; }
+  /* VK_FORMAT_UNDEFINED without a depth attachment */
+  inline VkFormat GetDepthFormat() const { return depth_format; }
 
 private:
+  bool CreateNative(
+      std::vector<GPURenderPassAttachmentConfig> pass_render_attachments,
+      std::vector<GPURenderPassSubpassConfig> pass_subpasses,
+      glm::vec4 pass_render_area, glm::vec4 pass_clear_color, float pass_depth,
+      float pass_stencil, uint8_t pass_clear_flags, bool explicit_barriers);
+  bool ValidateSubpasses();
+  bool UsesAttachment(uint32_t subpass, uint32_t attachment);
+  void BeginRenderPass(GPURenderTarget *target,
+                       VulkanCommandBuffer *command_buffer);
+  void BeginRendering(GPURenderTarget *target,
+                      VulkanCommandBuffer *command_buffer);
+  void RecordTransitions(VulkanCommandBuffer *command_buffer, bool begin);
+
+  static PFN_vkCmdBeginRenderingKHR vkRenderPassBeginRendering;
+  static PFN_vkCmdEndRenderingKHR vkRenderPassEndRendering;
+  static bool dynamic_rendering;
+
   VkRenderPass handle;
   float depth;
   float stencil;
+
+  bool dynamic;
+  /* false if the caller records the transitions */
+  bool record_transitions;
+  std::vector<VkAttachmentDescription> descriptions;
+  std::vector<VkFormat> color_formats;
+  VkFormat depth_format;
+  GPURenderTarget *current_target;
+  uint32_t current_subpass;
 };
\ No newline at end of file
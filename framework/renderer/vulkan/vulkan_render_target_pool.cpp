@@ -0,0 +1,198 @@
+#include "vulkan_render_target_pool.h"
+
+#include "../../logger.h"
+#include "vulkan_attachment.h"
+#include "vulkan_backend.h"
+#include "vulkan_context.h"
+#include "vulkan_framebuffer.h"
+
+#include <algorithm>
+
+void VulkanRenderTargetPool::Initialize() {
+  /* long enough for the attachments of a pass that is skipped for a few
+   * frames to survive */
+  unused_frame_count = 8;
+  frame = 0;
+  pooled_attachments.clear();
+  render_targets.clear();
+}
+
+void VulkanRenderTargetPool::Shutdown() {
+  while (!render_targets.empty()) {
+    DestroyRenderTarget(render_targets.size() - 1);
+  }
+
+  for (uint32_t i = 0; i < pooled_attachments.size(); ++i) {
+    if (pooled_attachments[i].acquired) {
+      WARN("Pooled attachment is destroyed while being acquired!");
+    }
+    pooled_attachments[i].attachment->Destroy();
+    delete pooled_attachments[i].attachment;
+  }
+  pooled_attachments.clear();
+}
+
+void VulkanRenderTargetPool::Update() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  ++frame;
+
+  /* the frames in flight may still use what was used during the last frames,
+   * past those it is destroyed without waiting for the device */
+  uint64_t expire_frame_count =
+      std::max<uint64_t>(unused_frame_count,
+                         context->max_frames_in_flight);
+
+  /* the attachments kept across frames are still in use */
+  for (uint32_t i = 0; i < pooled_attachments.size(); ++i) {
+    if (pooled_attachments[i].acquired) {
+      pooled_attachments[i].last_used_frame = frame;
+    }
+  }
+
+  for (uint32_t i = 0; i < render_targets.size();) {
+    if (frame - render_targets[i].last_used_frame > expire_frame_count) {
+      DestroyRenderTarget(i);
+    } else {
+      ++i;
+    }
+  }
+
+  /* destroying the attachment also destroys the render targets created with
+   * it */
+  for (uint32_t i = 0; i < pooled_attachments.size();) {
+    VulkanRenderTargetPoolAttachment *pooled = &pooled_attachments[i];
+    if (frame - pooled->last_used_frame > expire_frame_count) {
+      VulkanAttachment *attachment = pooled->attachment;
+      pooled_attachments.erase(pooled_attachments.begin() + i);
+
+      attachment->DestroyImmediate();
+      delete attachment;
+    } else {
+      ++i;
+    }
+  }
+}
+
+GPUAttachment *VulkanRenderTargetPool::AcquireAttachment(
+    GPURenderTargetPoolAttachmentConfig *config) {
+  if (config->samples != 1) {
+    ERROR("Multisampled attachments are not supported!");
+    return 0;
+  }
+
+  for (uint32_t i = 0; i < pooled_attachments.size(); ++i) {
+    VulkanRenderTargetPoolAttachment *pooled = &pooled_attachments[i];
+    if (!pooled->acquired && IsSameConfig(&pooled->config, config)) {
+      pooled->acquired = true;
+      pooled->last_used_frame = frame;
+      return pooled->attachment;
+    }
+  }
+
+  VulkanRenderTargetPoolAttachment pooled;
+  pooled.config = *config;
+  pooled.attachment = new VulkanAttachment();
+  pooled.attachment->Create(config->format, config->usage, config->width,
+                            config->height, config->flags);
+  pooled.attachment->SetDebugName("Pooled attachment");
+  pooled.acquired = true;
+  pooled.last_used_frame = frame;
+  pooled_attachments.emplace_back(pooled);
+
+  return pooled.attachment;
+}
+
+void VulkanRenderTargetPool::ReleaseAttachment(GPUAttachment *attachment) {
+  for (uint32_t i = 0; i < pooled_attachments.size(); ++i) {
+    VulkanRenderTargetPoolAttachment *pooled = &pooled_attachments[i];
+    if (pooled->attachment == attachment) {
+      if (!pooled->acquired) {
+        WARN("Pooled attachment is released twice!");
+      }
+      pooled->acquired = false;
+      pooled->last_used_frame = frame;
+      return;
+    }
+  }
+
+  WARN("Attachment is not owned by the render target pool!");
+}
+
+GPURenderTarget *VulkanRenderTargetPool::AcquireRenderTarget(
+    GPURenderPass *render_pass, std::vector<GPUAttachment *> &attachments) {
+  for (uint32_t i = 0; i < render_targets.size(); ++i) {
+    VulkanRenderTargetPoolTarget *target = &render_targets[i];
+    if (target->render_pass == render_pass &&
+        target->attachments == attachments) {
+      target->last_used_frame = frame;
+      return target->framebuffer;
+    }
+  }
+
+  if (attachments.empty()) {
+    ERROR("Render target has no attachments!");
+    return 0;
+  }
+
+  uint32_t width = UINT32_MAX;
+  uint32_t height = UINT32_MAX;
+  for (uint32_t i = 0; i < attachments.size(); ++i) {
+    width = std::min<uint32_t>(width, attachments[i]->GetWidth());
+    height = std::min<uint32_t>(height, attachments[i]->GetHeight());
+  }
+
+  VulkanRenderTargetPoolTarget target;
+  target.render_pass = render_pass;
+  target.attachments = attachments;
+  target.framebuffer = new VulkanFramebuffer();
+  if (!target.framebuffer->Create(render_pass, attachments, width, height)) {
+    delete target.framebuffer;
+    return 0;
+  }
+  target.framebuffer->SetDebugName("Pooled render target");
+  target.last_used_frame = frame;
+  render_targets.emplace_back(target);
+
+  return target.framebuffer;
+}
+
+void VulkanRenderTargetPool::InvalidateAttachment(GPUAttachment *attachment) {
+  for (uint32_t i = 0; i < render_targets.size();) {
+    std::vector<GPUAttachment *> &attachments = render_targets[i].attachments;
+    if (std::find(attachments.begin(), attachments.end(), attachment) !=
+        attachments.end()) {
+      DestroyRenderTarget(i);
+    } else {
+      ++i;
+    }
+  }
+}
+
+void VulkanRenderTargetPool::InvalidateRenderPass(GPURenderPass *render_pass) {
+  for (uint32_t i = 0; i < render_targets.size();) {
+    if (render_targets[i].render_pass == render_pass) {
+      DestroyRenderTarget(i);
+    } else {
+      ++i;
+    }
+  }
+}
+
+bool VulkanRenderTargetPool::IsSameConfig(
+    GPURenderTargetPoolAttachmentConfig *a,
+    GPURenderTargetPoolAttachmentConfig *b) {
+  return a->format == b->format && a->usage == b->usage &&
+         a->width == b->width && a->height == b->height &&
+         a->samples == b->samples && a->flags == b->flags;
+}
+
+void VulkanRenderTargetPool::DestroyRenderTarget(uint32_t index) {
+  VulkanFramebuffer *framebuffer = render_targets[index].framebuffer;
+  render_targets.erase(render_targets.begin() + index);
+
+  /* either expired or invalidated by a destroy that already waited for the
+   * device */
+  framebuffer->DestroyImmediate();
+  delete framebuffer;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../gpu_render_target_pool.h"
+
+#include <stdint.h>
+#include <vector>
+
+class VulkanAttachment;
+class VulkanFramebuffer;
+
+class VulkanRenderTargetPool : public GPURenderTargetPool {
+public:
+  void Initialize();
+  void Shutdown();
+
+  /* once per frame, after the fence of the frame is waited for */
+  void Update();
+
+  GPUAttachment *
+  AcquireAttachment(GPURenderTargetPoolAttachmentConfig *config) override;
+  void ReleaseAttachment(GPUAttachment *attachment) override;
+  GPURenderTarget *
+  AcquireRenderTarget(GPURenderPass *render_pass,
+                      std::vector<GPUAttachment *> &attachments) override;
+
+  /* destroys the cached render targets created with them. Called when the
+   * attachment or the render pass is destroyed */
+  void InvalidateAttachment(GPUAttachment *attachment);
+  void InvalidateRenderPass(GPURenderPass *render_pass);
+
+private:
+  struct VulkanRenderTargetPoolAttachment {
+    GPURenderTargetPoolAttachmentConfig config;
+    VulkanAttachment *attachment;
+    bool acquired;
+    uint64_t last_used_frame;
+  };
+
+  struct VulkanRenderTargetPoolTarget {
+    GPURenderPass *render_pass;
+    std::vector<GPUAttachment *> attachments;
+    VulkanFramebuffer *framebuffer;
+    uint64_t last_used_frame;
+  };
+
+  bool IsSameConfig(GPURenderTargetPoolAttachmentConfig *a,
+                    GPURenderTargetPoolAttachmentConfig *b);
+  void DestroyRenderTarget(uint32_t index);
+
+  std::vector<VulkanRenderTargetPoolAttachment> pooled_attachments;
+  std::vector<VulkanRenderTargetPoolTarget> render_targets;
+  uint64_t frame;
+};
\ No newline at end of file
@@ -7,32 +7,122 @@
 #include "vulkan_debug_marker.h"
 #include "vulkan_descriptor_builder.h"
 #include "vulkan_descriptor_set.h"
+#include "vulkan_dynamic_state.h"
 #include "vulkan_texture.h"
 #include "vulkan_utils.h"
 
+#include <algorithm>
 #include <map>
 #include <spirv_cross/spirv.hpp>
 #include <spirv_cross/spirv_glsl.hpp>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unordered_set>
 #include <vulkan/vulkan_beta.h>
 
+/* FNV-1a */
+static uint64_t HashStageCode(const uint32_t *code, int64_t size) {
+  const uint8_t *bytes = (const uint8_t *)code;
+  uint64_t hash = 14695981039346656037ull;
+  for (int64_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+/* sets bound with other pipeline layouts may be disturbed by the bind, so
+ * they are forgotten */
+static void TrackBoundDescriptorSet(VulkanContext *context, int32_t set_index,
+                                    VkDescriptorSet set,
+                                    VkPipelineLayout layout) {
+  for (int32_t i = 0; i < VULKAN_MAX_BOUND_DESCRIPTOR_SETS; ++i) {
+    if (i != set_index && context->bound_descriptor_set_layouts[i] != layout) {
+      context->bound_descriptor_sets[i] = 0;
+      context->bound_descriptor_set_layouts[i] = 0;
+    }
+  }
+
+  if (set_index < VULKAN_MAX_BOUND_DESCRIPTOR_SETS) {
+    context->bound_descriptor_sets[set_index] = set;
+    context->bound_descriptor_set_layouts[set_index] = layout;
+  }
+}
+
 bool VulkanShader::Create(GPUShaderConfig * config) {
+  if (config->keywords.size() > 32) {
+    ERROR("Shader variant mask can hold only 32 keywords!");
+    return false;
+  }
+
+  stages.clear();
+  for (uint32_t i = 0; i < config->stage_configs.size(); ++i) {
+    VulkanShaderStage stage;
+    stage.type = config->stage_configs[i].type;
+    stage.file_path = config->stage_configs[i].file_path;
+    LoadStageKeywords(stage);
+
+    stages.emplace_back(stage);
+  }
+
+  keywords.clear();
+  for (uint32_t i = 0; i < config->keywords.size(); ++i) {
+    keywords.emplace_back(config->keywords[i]);
+  }
+
+  push_descriptor_set_mask = config->push_descriptor_set_mask;
+  vertex_stride = config->vertex_stride;
+
+  render_pass = (VulkanRenderPass *)config->render_pass;
+  viewport_width = config->viewport_width;
+  viewport_height = config->viewport_height;
+  subpass = config->subpass;
+  debug_name.clear();
+
+  /* the base variant is created right away, so that broken shaders are
+   * reported on creation */
+  variant_mask = 0;
+  current_key.variant_mask = 0;
+  current_key.render_state = config->render_state;
+  current_key.depth_flags = config->depth_flags;
+  current_key.stencil_flags = config->stencil_flags;
+  current_key.topology_type = config->topology_type;
+  shader_key = current_key;
+  state_overridden = false;
+  base_key = GetPipelineKey(current_key);
+
+  pipelines.clear();
+  failed_keys.clear();
+  pipeline = &pipelines[base_key];
+  *pipeline = {};
+  if (!CreateVariant(base_key, pipeline)) {
+    pipelines.clear();
+    pipeline = 0;
+    return false;
+  }
+
+#ifdef RF3D_SHADER_HOT_RELOAD
   VulkanContext *context = VulkanBackend::GetContext();
+  if (context->shader_hot_reload) {
+    context->shader_hot_reload->Register(this);
+  }
+#endif
 
-  std::vector<GPUShaderStageConfig> &stage_configs = config->stage_configs;
-  GPUShaderTopologyType topology_type = config->topology_type;
-  uint8_t depth_flags = config->depth_flags; 
-  GPURenderPass *render_pass = config->render_pass;
-  float viewport_width = config->viewport_width;
-  float viewport_height = config->viewport_height;
+  return true;
+}
 
-  VulkanRenderPass *native_pass = (VulkanRenderPass *)render_pass;
+bool VulkanShader::CreateVariant(VulkanShaderPipelineKey &key,
+                                 VulkanPipeline *out_pipeline) {
+  VulkanContext *context = VulkanBackend::GetContext();
 
-  std::vector<VkShaderModule> stages;
-  stages.resize(stage_configs.size());
+  std::vector<VkShaderModule> stage_modules;
+  stage_modules.resize(stages.size());
   std::vector<VkPipelineShaderStageCreateInfo> pipeline_stage_create_infos;
-  pipeline_stage_create_infos.resize(stage_configs.size());
+  pipeline_stage_create_infos.resize(stages.size());
+
+  std::vector<uint64_t> stage_hashes;
+  stage_hashes.resize(stages.size());
 
   std::vector<VkPushConstantRange> push_constant_ranges;
   std::vector<VulkanShaderSet> sets;
@@ -41,11 +131,17 @@ bool VulkanShader::Create(GPUShaderConfig * config) {
   uint32_t fragment_output_count = 0;
   uint32_t tesselation_control_points = 0;
 
-  for (uint32_t i = 0; i < stages.size(); ++i) {
-    GPUShaderStageConfig *stage_config = &stage_configs[i];
-    FILE *file = fopen(stage_config->file_path, "rb");
+  for (uint32_t i = 0; i < stage_modules.size(); ++i) {
+    VulkanShaderStage *stage = &stages[i];
+    std::string file_path =
+        GetStageVariantPath(*stage, keywords, key.variant_mask);
+    FILE *file = fopen(file_path.c_str(), "rb");
     if (!file) {
-      ERROR("Failed to open file %s", stage_config->file_path);
+      ERROR("Failed to open file %s", file_path.c_str());
+      for (uint32_t j = 0; j < i; ++j) {
+        vkDestroyShaderModule(context->device->GetLogicalDevice(),
+                              stage_modules[j], context->allocator);
+      }
       return false;
     }
 
@@ -65,21 +161,29 @@ bool VulkanShader::Create(GPUShaderConfig * config) {
     create_info.codeSize = file_size;
     create_info.pCode = &file_data[0];
 
+    stage_hashes[i] = HashStageCode(file_data.data(), file_size);
+
     /* reflect the spirv binary */
     spirv_cross::Compiler compiler(file_data.data(),
                                    file_data.size() / sizeof(uint32_t));
     spirv_cross::ShaderResources resources = compiler.get_shader_resources();
-    ReflectStagePushConstantRanges(compiler, resources, push_constant_ranges);
-    ReflectStageUniforms(compiler, resources, sets);
-    if (stage_config->type == GPU_SHADER_STAGE_TYPE_VERTEX) {
+    VkShaderStageFlagBits stage_flag =
+        VulkanUtils::GPUShaderStageTypeToVulkanStage(stage->type);
+    ReflectStagePushConstantRanges(compiler, resources, stage_flag,
+                                   push_constant_ranges);
+    ReflectStageUniforms(compiler, resources, stage_flag, sets);
+    if (stage->type == GPU_SHADER_STAGE_TYPE_VERTEX) {
       if (!ReflectVertexAttributes(compiler, resources, attributes,
                                    &attributes_stride)) {
+        for (uint32_t j = 0; j < i; ++j) {
+          vkDestroyShaderModule(context->device->GetLogicalDevice(),
+                                stage_modules[j], context->allocator);
+        }
         return false;
       }
-    } else if (stage_config->type == GPU_SHADER_STAGE_TYPE_FRAGMENT) {
+    } else if (stage->type == GPU_SHADER_STAGE_TYPE_FRAGMENT) {
       fragment_output_count = ReflectFragmentOutputs(compiler, resources);
-    } else if (stage_config->type ==
-               GPU_SHADER_STAGE_TYPE_TESSELLATION_CONTROL) {
+    } else if (stage->type == GPU_SHADER_STAGE_TYPE_TESSELLATION_CONTROL) {
       tesselation_control_points =
           ReflectTesselationControlPoints(compiler, resources);
     }
@@ -87,15 +191,15 @@ bool VulkanShader::Create(GPUShaderConfig * config) {
     file_data.clear();
 
     VK_CHECK(vkCreateShaderModule(context->device->GetLogicalDevice(),
-                                  &create_info, 0, &stages[i]));
+                                  &create_info, 0, &stage_modules[i]));
 
     pipeline_stage_create_infos[i].sType =
         VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     pipeline_stage_create_infos[i].pNext = 0;
     pipeline_stage_create_infos[i].flags = 0;
     pipeline_stage_create_infos[i].stage =
-        VulkanUtils::GPUShaderStageTypeToVulkanStage(stage_config->type);
-    pipeline_stage_create_infos[i].module = stages[i];
+        VulkanUtils::GPUShaderStageTypeToVulkanStage(stage->type);
+    pipeline_stage_create_infos[i].module = stage_modules[i];
     pipeline_stage_create_infos[i].pName = "main";
     /* pipeline_stage_create_infos[i].pSpecializationInfo; */ /* TODO:
                                                                  specialization
@@ -115,69 +219,228 @@ bool VulkanShader::Create(GPUShaderConfig * config) {
   scissor.extent.width = viewport_width;
   scissor.extent.height = viewport_height;
 
-  std::vector<VkDescriptorSetLayout> descriptor_set_layouts;
-  for (uint32_t i = 0; i < sets.size(); ++i) {
-    VkDescriptorSetLayout set_layout;
-
-    VkDescriptorSetLayoutCreateInfo layout_create_info = {};
-    layout_create_info.sType =
-        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layout_create_info.pNext = 0;
-    layout_create_info.flags = 0;
-    layout_create_info.bindingCount = sets[i].bindings.size();
-    layout_create_info.pBindings = sets[i].bindings.data();
+  if (vertex_stride && vertex_stride < attributes_stride) {
+    ERROR("Vertex stride is smaller than the vertex attributes!");
+    for (uint32_t i = 0; i < stage_modules.size(); ++i) {
+      vkDestroyShaderModule(context->device->GetLogicalDevice(),
+                            stage_modules[i], context->allocator);
+    }
+    return false;
+  }
 
-    set_layout =
-        context->layout_cache->CreateDescriptorLayout(&layout_create_info);
+  FinalizeDescriptorSetsReflection(sets);
 
-    descriptor_set_layouts.emplace_back(set_layout);
+  std::vector<VkDescriptorSetLayout> descriptor_set_layouts;
+  int32_t bindless_set_index = -1;
+  if (!CreateDescriptorSetLayouts(sets, push_descriptor_set_mask,
+                                  descriptor_set_layouts,
+                                  &bindless_set_index)) {
+    for (uint32_t i = 0; i < stage_modules.size(); ++i) {
+      vkDestroyShaderModule(context->device->GetLogicalDevice(),
+                            stage_modules[i], context->allocator);
+    }
+    return false;
   }
 
-  /* TODO: maybe configurable? */
   std::vector<VkDynamicState> dynamic_states;
-  dynamic_states.emplace_back(VK_DYNAMIC_STATE_VIEWPORT);
-  dynamic_states.emplace_back(VK_DYNAMIC_STATE_SCISSOR);
+  VulkanDynamicState::GetDynamicStates(dynamic_states);
 
   VulkanPipelineConfig pipeline_config;
   pipeline_config.attributes = attributes;
   pipeline_config.descriptor_set_layouts = descriptor_set_layouts;
   pipeline_config.dynamic_states = dynamic_states;
   pipeline_config.push_constant_ranges = push_constant_ranges;
+  pipeline_config.bindless_set_index = bindless_set_index;
   pipeline_config.scissor = scissor;
   pipeline_config.stages = pipeline_stage_create_infos;
+  pipeline_config.stage_hashes = stage_hashes;
   pipeline_config.topology =
-      VulkanUtils::GPUShaderTopologyTypeToVulkanTopology(topology_type);
-  pipeline_config.stride = attributes_stride;
+      VulkanUtils::GPUShaderTopologyTypeToVulkanTopology(key.topology_type);
+  pipeline_config.stride = vertex_stride ? vertex_stride : attributes_stride;
   pipeline_config.viewport = viewport;
+  GPUShaderRenderState *render_state = &key.render_state;
+  pipeline_config.cull_mode =
+      VulkanUtils::GPUShaderCullModeToVulkanCullMode(render_state->cull_mode);
+  pipeline_config.front_face = VulkanUtils::GPUShaderFrontFaceToVulkanFrontFace(
+      render_state->front_face);
   pipeline_config.depth_test_enable =
-      depth_flags & GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE;
+      key.depth_flags & GPU_SHADER_DEPTH_FLAG_DEPTH_TEST_ENABLE;
   pipeline_config.depth_write_enable =
-      depth_flags & GPU_SHADER_DEPTH_FLAG_DEPTH_WRITE_ENABLE;
+      key.depth_flags & GPU_SHADER_DEPTH_FLAG_DEPTH_WRITE_ENABLE;
+  pipeline_config.depth_compare_operation =
+      VulkanUtils::GPUShaderCompareOperationToVulkanCompareOp(
+          render_state->depth_compare_operation);
+  pipeline_config.depth_bias_enable = render_state->depth_bias_enable;
+  pipeline_config.depth_bias_constant_factor =
+      render_state->depth_bias_constant_factor;
+  pipeline_config.depth_bias_clamp = render_state->depth_bias_clamp;
+  pipeline_config.depth_bias_slope_factor =
+      render_state->depth_bias_slope_factor;
+  pipeline_config.stencil_test_enable =
+      key.stencil_flags & GPU_SHADER_STENCIL_FLAG_STENCIL_TEST_ENABLE;
+  pipeline_config.stencil_front =
+      VulkanUtils::GPUShaderStencilStateToVulkanStencilOpState(
+          &render_state->stencil_front);
+  pipeline_config.stencil_back =
+      VulkanUtils::GPUShaderStencilStateToVulkanStencilOpState(
+          &render_state->stencil_back);
+  GPUShaderBlendState default_blend_state;
+  for (uint32_t i = 0; i < fragment_output_count; ++i) {
+    GPUShaderBlendState *blend_state = &default_blend_state;
+    if (!render_state->blend_states.empty()) {
+      blend_state = &render_state->blend_states[std::min<size_t>(
+          i, render_state->blend_states.size() - 1)];
+    }
+
+    pipeline_config.color_blend_states.emplace_back(
+        VulkanUtils::GPUShaderBlendStateToVulkanBlendAttachmentState(
+            blend_state));
+  }
   pipeline_config.fragment_output_count = fragment_output_count;
   pipeline_config.control_point_count = tesselation_control_points;
+  pipeline_config.subpass = subpass;
 
-  if (!pipeline.Create(&pipeline_config, native_pass)) {
-    return false;
+  bool result = out_pipeline->Create(&pipeline_config, render_pass);
+
+  for (uint32_t i = 0; i < stage_modules.size(); ++i) {
+    vkDestroyShaderModule(context->device->GetLogicalDevice(),
+                          stage_modules[i], context->allocator);
   }
 
-  for (uint32_t i = 0; i < stages.size(); ++i) {
-    vkDestroyShaderModule(context->device->GetLogicalDevice(), stages[i],
-                          context->allocator);
+  if (result && !debug_name.empty()) {
+    out_pipeline->SetDebugName(debug_name.c_str());
   }
 
-  return true;
+  return result;
 }
 
 void VulkanShader::Destroy() {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+  /* the pipelines are destroyed once the frames in flight are done */
+  for (auto it = pipelines.begin(); it != pipelines.end(); ++it) {
+    if (it->second.GetHandle()) {
+      it->second.Destroy();
+    }
+  }
+  pipelines.clear();
+  failed_keys.clear();
+  pipeline = 0;
+
+  if (context->bound_shader == this) {
+    context->bound_shader = 0;
+    context->bound_pipeline = 0;
+  }
+
+#ifdef RF3D_SHADER_HOT_RELOAD
+  if (context->shader_hot_reload) {
+    context->shader_hot_reload->Unregister(this);
+  }
+#endif
+}
+
+void VulkanShader::SetVariant(uint32_t variant_mask) {
+  if (variant_mask >> keywords.size()) {
+    WARN("Shader variant mask %u uses undeclared keywords!", variant_mask);
+  }
+
+  this->variant_mask = variant_mask;
+  shader_key.variant_mask = variant_mask;
+  current_key.variant_mask = variant_mask;
+
+  UpdatePipeline();
+}
+
+void VulkanShader::SetRenderState(GPUShaderRenderState *render_state) {
+  shader_key.render_state = *render_state;
+  current_key.render_state = *render_state;
 
-  pipeline.Destroy();
-  pipeline = {};
+  UpdatePipeline();
+}
+
+void VulkanShader::SetState(VulkanShaderPipelineKey &state) {
+  current_key = state;
+  variant_mask = state.variant_mask;
+  shader_key.variant_mask = state.variant_mask;
+  state_overridden = true;
+
+  UpdatePipeline();
+}
+
+bool VulkanShader::UsesStageSource(const std::string &file_name) {
+  for (uint32_t i = 0; i < stages.size(); ++i) {
+    if (IsStageSource(stages[i], file_name)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool VulkanShader::Reload() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  for (uint32_t i = 0; i < stages.size(); ++i) {
+    LoadStageKeywords(stages[i]);
+  }
+
+  /* only the variants that were in use are rebuilt, the rest is created
+   * lazily as usual */
+  std::unordered_map<VulkanShaderPipelineKey, VulkanPipeline,
+                     VulkanShaderPipelineKeyHash>
+      reloaded_pipelines;
+  for (auto it = pipelines.begin(); it != pipelines.end(); ++it) {
+    VulkanShaderPipelineKey key = it->first;
+    VulkanPipeline *reloaded_pipeline = &reloaded_pipelines[key];
+    *reloaded_pipeline = {};
+    if (!CreateVariant(key, reloaded_pipeline)) {
+      ERROR("Failed to reload shader variant %u, keeping the old pipelines",
+            key.variant_mask);
+      for (auto &pair : reloaded_pipelines) {
+        if (pair.second.GetHandle()) {
+          pair.second.Destroy();
+        }
+      }
+      return false;
+    }
+  }
+
+  for (auto it = pipelines.begin(); it != pipelines.end(); ++it) {
+    if (it->second.GetHandle()) {
+      it->second.Destroy();
+    }
+  }
+  /* swapping keeps the nodes in place, so the pipeline pointers handed to
+   * the pipeline library stay valid */
+  pipelines.swap(reloaded_pipelines);
+  /* the sources changed, so the broken variants may build now */
+  failed_keys.clear();
+
+  auto it = pipelines.find(GetPipelineKey(current_key));
+  pipeline = it != pipelines.end() ? &it->second : 0;
+  if (context->bound_shader == this) {
+    context->bound_shader = 0;
+    context->bound_pipeline = 0;
+  }
+
+  return true;
 }
 
 void VulkanShader::Bind() {
+  /* the per draw state of the previous binds doesn't carry over to the
+   * draws of this one */
+  if (state_overridden) {
+    current_key = shader_key;
+    state_overridden = false;
+
+    auto it = pipelines.find(GetPipelineKey(current_key));
+    pipeline = it != pipelines.end() ? &it->second : 0;
+  }
+
+  BindPipeline();
+}
+
+void VulkanShader::BindPipeline() {
   VulkanContext *context = VulkanBackend::GetContext();
 
   VulkanDeviceQueueInfo info =
@@ -186,7 +449,35 @@ void VulkanShader::Bind() {
   VulkanCommandBuffer *command_buffer =
       &info.command_buffers[context->image_index];
 
-  pipeline.Bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+  VulkanPipeline *variant_pipeline = GetVariantPipeline();
+  /* pipelines of the same shader often differ only by the dynamic state, so
+   * don't rebind those */
+  if (context->bound_pipeline != variant_pipeline->GetHandle()) {
+    variant_pipeline->Bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+    context->bound_pipeline = variant_pipeline->GetHandle();
+  }
+  context->bound_shader = this;
+
+  /* the table is shared by every shader, so it is bound only once for all
+   * the pipelines with the same layout */
+  int32_t bindless_set_index = variant_pipeline->GetBindlessSetIndex();
+  if (bindless_set_index != -1) {
+    VkDescriptorSet bindless_set = context->bindless_textures->GetSet();
+    VkPipelineLayout layout = variant_pipeline->GetLayout();
+    if (bindless_set_index >= VULKAN_MAX_BOUND_DESCRIPTOR_SETS ||
+        context->bound_descriptor_sets[bindless_set_index] != bindless_set ||
+        context->bound_descriptor_set_layouts[bindless_set_index] != layout) {
+      vkCmdBindDescriptorSets(command_buffer->GetHandle(),
+                              VK_PIPELINE_BIND_POINT_GRAPHICS, layout,
+                              bindless_set_index, 1, &bindless_set, 0, 0);
+      TrackBoundDescriptorSet(context, bindless_set_index, bindless_set,
+                              layout);
+    }
+  }
+
+  VulkanDynamicState::Set(command_buffer, &current_key.render_state,
+                          current_key.depth_flags, current_key.stencil_flags,
+                          variant_pipeline->GetColorAttachmentCount());
 }
 
 void VulkanShader::BindUniformBuffer(GPUDescriptorSet *set, uint32_t offset,
@@ -200,10 +491,13 @@ void VulkanShader::BindUniformBuffer(GPUDescriptorSet *set, uint32_t offset,
       &info.command_buffers[context->image_index];
 
   VulkanDescriptorSet *native_set = (VulkanDescriptorSet *)set;
+  VkPipelineLayout layout = GetVariantPipeline()->GetLayout();
 
   vkCmdBindDescriptorSets(command_buffer->GetHandle(),
-                          VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetLayout(),
-                          set_index, 1, &native_set->GetSet(), 1, &offset);
+                          VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set_index,
+                          1, &native_set->GetSet(), 1, &offset);
+  /* the offset changes between the draws, so it is never skipped */
+  TrackBoundDescriptorSet(context, set_index, 0, layout);
 }
 
 void VulkanShader::BindSampler(GPUDescriptorSet *set, int32_t set_index) {
@@ -216,24 +510,99 @@ void VulkanShader::BindSampler(GPUDescriptorSet *set, int32_t set_index) {
       &info.command_buffers[context->image_index];
 
   VulkanDescriptorSet *native_set = (VulkanDescriptorSet *)set;
+  VkPipelineLayout layout = GetVariantPipeline()->GetLayout();
+
+  /* meshes that share their resources share the set too, so it is often
+   * bound already */
+  if (set_index < VULKAN_MAX_BOUND_DESCRIPTOR_SETS &&
+      context->bound_descriptor_sets[set_index] == native_set->GetSet() &&
+      context->bound_descriptor_set_layouts[set_index] == layout) {
+    return;
+  }
+
+  vkCmdBindDescriptorSets(command_buffer->GetHandle(),
+                          VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set_index,
+                          1, &native_set->GetSet(), 0, 0);
+  TrackBoundDescriptorSet(context, set_index, native_set->GetSet(), layout);
+}
+
+void VulkanShader::PushDescriptorSet(
+    int32_t set_index, std::vector<GPUDescriptorBinding> &bindings,
+    uint32_t uniform_buffer_offset) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  VulkanDeviceQueueInfo info =
+      context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+
+  VulkanCommandBuffer *command_buffer =
+      &info.command_buffers[context->image_index];
+
+  VkDescriptorSetLayout set_layout = GetDescriptorSetLayout(set_index);
+  if (!set_layout) {
+    ERROR("Shader has no descriptor set %d!", set_index);
+    return;
+  }
+  VkPipelineLayout layout = GetVariantPipeline()->GetLayout();
+
+  VulkanDescriptorBuilder builder = VulkanDescriptorBuilder::Begin();
+  VulkanDescriptorSetCache::DescriptorSetInfo set_info;
+  set_info.layout = set_layout;
+
+  if (context->layout_cache->IsPushDescriptorLayout(set_layout)) {
+    VulkanDescriptorSet::GatherBindings(bindings, uniform_buffer_offset,
+                                        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                        builder, set_info);
+    builder.Push(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout,
+                 set_index, set_layout);
+    TrackBoundDescriptorSet(context, set_index, 0, layout);
+    return;
+  }
+
+  if (!(push_descriptor_set_mask & (1 << set_index))) {
+    WARN("Descriptor set %d is not marked for push descriptors!", set_index);
+  }
+
+  /* without push descriptor support, a transient set is written in place of
+   * the push and bound with dynamic offsets */
+  VulkanDescriptorSet::GatherBindings(bindings, 0,
+                                      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                                      builder, set_info);
+  VkDescriptorSet set;
+  if (!builder.BuildTransient(set_layout, &set)) {
+    return;
+  }
+
+  std::vector<uint32_t> offsets;
+  for (uint32_t i = 0; i < set_info.resources.size(); ++i) {
+    if (set_info.resources[i].type ==
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+      offsets.emplace_back(uniform_buffer_offset);
+    }
+  }
 
   vkCmdBindDescriptorSets(command_buffer->GetHandle(),
-                          VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetLayout(),
-                          set_index, 1, &native_set->GetSet(), 0, 0);
+                          VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set_index,
+                          1, &set, offsets.size(), offsets.data());
+  TrackBoundDescriptorSet(context, set_index, 0, layout);
 }
 
 void VulkanShader::SetDebugName(const char *name) {
-  VulkanDebugUtils::SetObjectName(name, (uint64_t)pipeline.GetHandle(),
-                                  VK_OBJECT_TYPE_PIPELINE);
+  debug_name = name;
+
+  for (auto it = pipelines.begin(); it != pipelines.end(); ++it) {
+    it->second.SetDebugName(name);
+  }
 }
 
 void VulkanShader::SetDebugTag(const void *tag, size_t tag_size) {
-  VulkanDebugUtils::SetObjectTag(tag, (uint64_t)pipeline.GetHandle(),
-                                 VK_OBJECT_TYPE_PIPELINE, 0, tag_size);
+  for (auto it = pipelines.begin(); it != pipelines.end(); ++it) {
+    VulkanDebugUtils::SetObjectTag(tag, (uint64_t)it->second.GetHandle(),
+                                   VK_OBJECT_TYPE_PIPELINE, 0, tag_size);
+  }
 }
 
-void VulkanShader::PushConstant(void *value, uint64_t size, uint32_t offset,
-                                uint8_t stage_flags) {
+void VulkanShader::PushConstant(void *value, uint64_t size,
+                                uint32_t offset) {
   VulkanContext *context = VulkanBackend::GetContext();
 
   VulkanDeviceQueueInfo info =
@@ -242,41 +611,72 @@ void VulkanShader::PushConstant(void *value, uint64_t size, uint32_t offset,
   VulkanCommandBuffer *command_buffer =
       &info.command_buffers[context->image_index];
 
-  vkCmdPushConstants(
-      command_buffer->GetHandle(), pipeline.GetLayout(),
-      VulkanUtils::GPUShaderStageFlagsToVulkanShaderStageFlags(stage_flags),
-      offset, size, value);
+  /* stages are taken from the reflected ranges, and the bytes outside of
+   * them are left out */
+  if (!GetVariantPipeline()->PushConstants(command_buffer, value, offset,
+                                           size)) {
+    WARN("Push constant range %u-%u isn't used by the shader!", offset,
+         offset + size);
+  }
 }
 
 void VulkanShader::ReflectStageUniforms(spirv_cross::Compiler &compiler,
                                         spirv_cross::ShaderResources &resources,
+                                        VkShaderStageFlagBits stage,
                                         std::vector<VulkanShaderSet> &sets) {
+  /* resources, which are declared, but never accessed by this stage, are not
+   * visible to it */
+  std::unordered_set<spirv_cross::VariableID> active_variables =
+      compiler.get_active_interface_variables();
+
   for (auto &buffer : resources.uniform_buffers) {
     uint32_t set =
         compiler.get_decoration(buffer.id, spv::DecorationDescriptorSet);
     uint32_t binding =
         compiler.get_decoration(buffer.id, spv::DecorationBinding);
 
-    int32_t set_index = -1;
-    if (!UpdateDescriptorSetsReflection(sets, set, binding, &set_index)) {
-      continue; /* set and binding are duplicated */
-    }
+    ReflectDescriptorBinding(sets, set, binding,
+                             VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, stage,
+                             active_variables.count(buffer.id) > 0);
+  }
 
-    uint32_t binding_size = 0;
-    auto ranges = compiler.get_active_buffer_ranges(buffer.id);
-    for (auto &range : ranges) {
-      binding_size += range.range;
-    }
+  for (auto &buffer : resources.storage_buffers) {
+    uint32_t set =
+        compiler.get_decoration(buffer.id, spv::DecorationDescriptorSet);
+    uint32_t binding =
+        compiler.get_decoration(buffer.id, spv::DecorationBinding);
+
+    ReflectDescriptorBinding(sets, set, binding,
+                             VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stage,
+                             active_variables.count(buffer.id) > 0);
+  }
+
+  for (auto &image : resources.storage_images) {
+    uint32_t set =
+        compiler.get_decoration(image.id, spv::DecorationDescriptorSet);
+    uint32_t binding =
+        compiler.get_decoration(image.id, spv::DecorationBinding);
+
+    /* "imageBuffer" is a storage texel buffer */
+    const spirv_cross::SPIRType &type = compiler.get_type(image.type_id);
+    VkDescriptorType descriptor_type =
+        type.image.dim == spv::DimBuffer
+            ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+            : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
 
-    VkDescriptorSetLayoutBinding layout_binding = {};
-    layout_binding.binding = binding;
-    layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    layout_binding.descriptorCount = 1; /* for array of uniforms */
-    layout_binding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS; /* TODO: we are
-                           not checking in which stages this is presented */
-    layout_binding.pImmutableSamplers = 0; /* texture samplers */
+    ReflectDescriptorBinding(sets, set, binding, descriptor_type, stage,
+                             active_variables.count(image.id) > 0);
+  }
 
-    sets[set_index].bindings.emplace_back(layout_binding);
+  for (auto &input : resources.subpass_inputs) {
+    uint32_t set =
+        compiler.get_decoration(input.id, spv::DecorationDescriptorSet);
+    uint32_t binding =
+        compiler.get_decoration(input.id, spv::DecorationBinding);
+
+    ReflectDescriptorBinding(sets, set, binding,
+                             VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, stage,
+                             active_variables.count(input.id) > 0);
   }
 
   for (auto &image : resources.sampled_images) {
@@ -285,45 +685,70 @@ void VulkanShader::ReflectStageUniforms(spirv_cross::Compiler &compiler,
     uint32_t binding =
         compiler.get_decoration(image.id, spv::DecorationBinding);
 
-    int32_t set_index = -1;
-    if (!UpdateDescriptorSetsReflection(sets, set, binding, &set_index)) {
-      continue; /* set and binding are duplicated */
+    /* "samplerBuffer" is a uniform texel buffer */
+    const spirv_cross::SPIRType &type = compiler.get_type(image.type_id);
+    VkDescriptorType descriptor_type =
+        type.image.dim == spv::DimBuffer
+            ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+            : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    ReflectDescriptorBinding(sets, set, binding, descriptor_type, stage,
+                             active_variables.count(image.id) > 0);
+
+    /* "sampler2D textures[]" */
+    if (descriptor_type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER &&
+        !type.array.empty() && type.array.back() == 0 &&
+        type.array_size_literal.back()) {
+      for (uint32_t i = 0; i < sets.size(); ++i) {
+        if (sets[i].index == set) {
+          sets[i].bindless = true;
+        }
+      }
     }
-
-    VkDescriptorSetLayoutBinding layout_binding = {};
-    layout_binding.binding = binding;
-    layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    layout_binding.descriptorCount = 1; /* for array of uniforms */
-    layout_binding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS; /* TODO: we are
-                           not checking in which stages this is presented */
-    layout_binding.pImmutableSamplers = 0; /* texture samplers */
-
-    sets[set_index].bindings.emplace_back(layout_binding);
   }
 }
 
 void VulkanShader::ReflectStagePushConstantRanges(
     spirv_cross::Compiler &compiler, spirv_cross::ShaderResources &resources,
+    VkShaderStageFlagBits stage,
     std::vector<VkPushConstantRange> &push_constant_ranges) {
   for (auto &push_constant : resources.push_constant_buffers) {
-    uint32_t min_offset = UINT32_MAX;
-    uint32_t total_size = 0;
     auto ranges = compiler.get_active_buffer_ranges(push_constant.id);
+    if (ranges.empty()) {
+      continue; /* not used by this stage */
+    }
+
+    /* the range covers the whole declared block, from the first member the
+     * stage reads. Members the optimizer left out are still pushed with the
+     * block, and would fall outside of a range fit to the used ones */
+    uint32_t min_offset = UINT32_MAX;
     for (auto &range : ranges) {
-      if (range.offset < min_offset) {
-        min_offset = range.offset;
+      min_offset = std::min<uint32_t>(min_offset, range.offset);
+    }
+    const spirv_cross::SPIRType &type =
+        compiler.get_type(push_constant.base_type_id);
+    uint32_t max_offset = compiler.get_declared_struct_size(type);
+
+    /* a stage can be presented in only one range, so stages share the range
+     * only if it is the same */
+    bool merged = false;
+    for (uint32_t i = 0; i < push_constant_ranges.size(); ++i) {
+      if (push_constant_ranges[i].offset == min_offset &&
+          push_constant_ranges[i].size == max_offset - min_offset) {
+        push_constant_ranges[i].stageFlags |= stage;
+        merged = true;
+        break;
       }
-      total_size += range.range;
     }
 
-    VkPushConstantRange range = {};
-    range.stageFlags =
-        VK_SHADER_STAGE_ALL_GRAPHICS; /* TODO: we are not checking in which
-                                         stages this is presented */
-    range.offset = min_offset;
-    range.size = total_size;
+    if (!merged) {
+      VkPushConstantRange range = {};
+      range.stageFlags = stage;
+      range.offset = min_offset;
+      range.size = max_offset - min_offset;
 
-    push_constant_ranges.emplace_back(range);
+      push_constant_ranges.emplace_back(range);
+    }
   }
 }
 
@@ -401,36 +826,352 @@ uint32_t VulkanShader::ReflectTesselationControlPoints(
   return entry_point.output_vertices;
 }
 
-bool VulkanShader::UpdateDescriptorSetsReflection(
-    std::vector<VulkanShaderSet> &sets, uint32_t set, uint32_t binding,
-    int32_t *out_set_index) {
-  /* check if binding is duplicated in shader stages */
+void VulkanShader::ReflectDescriptorBinding(std::vector<VulkanShaderSet> &sets,
+                                            uint32_t set, uint32_t binding,
+                                            VkDescriptorType type,
+                                            VkShaderStageFlagBits stage,
+                                            bool active) {
+  VulkanShaderSet *shader_set = 0;
   for (uint32_t i = 0; i < sets.size(); ++i) {
     if (sets[i].index == set) {
+      shader_set = &sets[i];
+      break;
+    }
+  }
+  if (!shader_set) {
+    VulkanShaderSet new_set;
+    new_set.index = set;
+    sets.emplace_back(new_set);
+    shader_set = &sets.back();
+  }
+
+  /* the binding is already presented in another stage */
+  for (uint32_t i = 0; i < shader_set->bindings.size(); ++i) {
+    VkDescriptorSetLayoutBinding &layout_binding = shader_set->bindings[i];
+    if (layout_binding.binding == binding) {
+      if (layout_binding.descriptorType != type) {
+        WARN("Set %u binding %u has different types across the stages!", set,
+             binding);
+      }
+
+      if (active) {
+        layout_binding.stageFlags |= stage;
+      }
+      shader_set->declared_stages[i] |= stage;
+
+      return;
+    }
+  }
+
+  VkDescriptorSetLayoutBinding layout_binding = {};
+  layout_binding.binding = binding;
+  layout_binding.descriptorType = type;
+  layout_binding.descriptorCount = 1; /* for array of uniforms */
+  layout_binding.stageFlags = active ? stage : 0;
+  layout_binding.pImmutableSamplers = 0; /* texture samplers */
+
+  shader_set->bindings.emplace_back(layout_binding);
+  shader_set->declared_stages.emplace_back(stage);
+}
+
+void VulkanShader::FinalizeDescriptorSetsReflection(
+    std::vector<VulkanShaderSet> &sets) {
+  /* bindings that are never accessed still have to be in the layout, so they
+   * are visible to the stages that declare them */
+  for (uint32_t i = 0; i < sets.size(); ++i) {
+    for (uint32_t j = 0; j < sets[i].bindings.size(); ++j) {
+      if (!sets[i].bindings[j].stageFlags) {
+        sets[i].bindings[j].stageFlags = sets[i].declared_stages[j];
+      }
+    }
+  }
+
+  /* pipeline layout expects the sets to be placed by their index */
+  std::sort(sets.begin(), sets.end(),
+            [](const VulkanShaderSet &a, const VulkanShaderSet &b) {
+              return a.index < b.index;
+            });
+
+  std::vector<VulkanShaderSet> result;
+  for (uint32_t i = 0; i < sets.size(); ++i) {
+    while (result.size() < sets[i].index) {
+      VulkanShaderSet empty_set;
+      empty_set.index = result.size();
+      result.emplace_back(empty_set);
+    }
+
+    result.emplace_back(sets[i]);
+  }
+
+  sets = result;
+}
+
+bool VulkanShader::CreateDescriptorSetLayouts(
+    std::vector<VulkanShaderSet> &sets, uint32_t push_descriptor_set_mask,
+    std::vector<VkDescriptorSetLayout> &out_layouts,
+    int32_t *out_bindless_set_index) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  out_layouts.clear();
+  *out_bindless_set_index = -1;
+  for (uint32_t i = 0; i < sets.size(); ++i) {
+    VkDescriptorSetLayout set_layout;
+
+    if (sets[i].bindless) {
+      if (!context->bindless_textures->IsActive() ||
+          sets[i].bindings.size() != 1) {
+        ERROR("Set %u can't be bound to the bindless texture table!", i);
+        return false;
+      }
+
+      out_layouts.emplace_back(context->bindless_textures->GetLayout());
+      *out_bindless_set_index = i;
+      continue;
+    }
+
+    /* push descriptors can't have dynamic offsets, the offset is written
+     * into the descriptor instead */
+    bool push_descriptors =
+        (push_descriptor_set_mask & (1 << i)) &&
+        context->device->GetOptionalFeatures().push_descriptor;
+    if (push_descriptors) {
       for (uint32_t j = 0; j < sets[i].bindings.size(); ++j) {
-        if (sets[i].bindings[j].binding == binding) {
-          return false;
+        if (sets[i].bindings[j].descriptorType ==
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+          sets[i].bindings[j].descriptorType =
+              VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         }
       }
     }
+
+    VkDescriptorSetLayoutCreateInfo layout_create_info = {};
+    layout_create_info.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_create_info.pNext = 0;
+    layout_create_info.flags = 0;
+    if (push_descriptors) {
+      layout_create_info.flags |=
+          VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+    }
+    layout_create_info.bindingCount = sets[i].bindings.size();
+    layout_create_info.pBindings = sets[i].bindings.data();
+
+    set_layout =
+        context->layout_cache->CreateDescriptorLayout(&layout_create_info);
+
+    out_layouts.emplace_back(set_layout);
+  }
+
+  return true;
+}
+
+bool VulkanShader::IsStageSource(VulkanShaderStage &stage,
+                                 const std::string &file_name) {
+  std::string binary_name = "/" + file_name + ".spv";
+  std::string path = "/" + stage.file_path;
+
+  return path.size() >= binary_name.size() &&
+         path.compare(path.size() - binary_name.size(), binary_name.size(),
+                      binary_name) == 0;
+}
+
+void VulkanShader::LoadStageKeywords(VulkanShaderStage &stage) {
+  stage.keywords.clear();
+
+  /* "name.stage.spv" is accompanied by "name.stage.keywords" if the stage was
+   * compiled into permutations */
+  std::string keywords_path = stage.file_path;
+  size_t extension = keywords_path.rfind(".spv");
+  if (extension == std::string::npos) {
+    return;
+  }
+  keywords_path.replace(extension, std::string::npos, ".keywords");
+
+  FILE *file = fopen(keywords_path.c_str(), "r");
+  if (!file) {
+    return;
+  }
+
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    std::string keyword = line;
+    while (!keyword.empty() &&
+           (keyword.back() == '\n' || keyword.back() == '\r')) {
+      keyword.pop_back();
+    }
+    if (!keyword.empty()) {
+      stage.keywords.emplace_back(keyword);
+    }
   }
 
-  /* check if set is already presented */
-  int32_t set_index = -1;
-  for (uint32_t i = 0; i < sets.size(); ++i) {
-    if (sets[i].index == set) {
-      set_index = i;
-      break;
+  fclose(file);
+}
+
+std::string
+VulkanShader::GetStageVariantPath(VulkanShaderStage &stage,
+                                  std::vector<std::string> &keywords,
+                                  uint32_t variant_mask) {
+  std::string suffix;
+  for (uint32_t i = 0; i < stage.keywords.size(); ++i) {
+    for (uint32_t j = 0; j < keywords.size(); ++j) {
+      if ((variant_mask & (1 << j)) && stage.keywords[i] == keywords[j]) {
+        suffix += "." + stage.keywords[i];
+        break;
+      }
     }
   }
-  if (set_index == -1) {
-    VulkanShaderSet shader_set;
-    shader_set.index = set;
-    sets.emplace_back(shader_set);
-    set_index = sets.size() - 1;
+
+  std::string result = stage.file_path;
+  size_t extension = result.rfind(".spv");
+  if (extension == std::string::npos) {
+    return result;
   }
+  result.insert(extension, suffix);
 
-  *out_set_index = set_index;
+  return result;
+}
+
+VulkanPipeline *VulkanShader::GetVariantPipeline() {
+  if (pipeline) {
+    return pipeline;
+  }
+
+  VulkanShaderPipelineKey key = GetPipelineKey(current_key);
+  if (failed_keys.count(key)) {
+    pipeline = &pipelines.at(base_key);
+    return pipeline;
+  }
+
+  pipeline = &pipelines[key];
+  *pipeline = {};
+  if (!CreateVariant(key, pipeline)) {
+    ERROR("Failed to create shader variant %u, falling back to the base "
+          "variant",
+          key.variant_mask);
+    pipelines.erase(key);
+    failed_keys.insert(key);
+    pipeline = &pipelines.at(base_key);
+  }
+
+  return pipeline;
+}
+
+VulkanShader::VulkanShaderPipelineKey
+VulkanShader::GetPipelineKey(VulkanShaderPipelineKey &state) {
+  VulkanShaderPipelineKey key = state;
+  VulkanDynamicState::ClearDynamicState(&key.render_state, &key.depth_flags,
+                                        &key.stencil_flags);
+
+  return key;
+}
+
+void VulkanShader::UpdatePipeline() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  auto it = pipelines.find(GetPipelineKey(current_key));
+  pipeline = it != pipelines.end() ? &it->second : 0;
+
+  /* the state is changed between the draws */
+  if (context->bound_shader == this) {
+    BindPipeline();
+  }
+}
+
+static void HashStencilState(uint64_t &seed,
+                             const GPUShaderStencilState &state) {
+  GPUUtils::HashCombine(seed, state.fail_operation);
+  GPUUtils::HashCombine(seed, state.pass_operation);
+  GPUUtils::HashCombine(seed, state.depth_fail_operation);
+  GPUUtils::HashCombine(seed, state.compare_operation);
+  GPUUtils::HashCombine(seed, state.compare_mask);
+  GPUUtils::HashCombine(seed, state.write_mask);
+  GPUUtils::HashCombine(seed, state.reference);
+}
+
+static bool StencilStatesEqual(const GPUShaderStencilState &a,
+                               const GPUShaderStencilState &b) {
+  return a.fail_operation == b.fail_operation &&
+         a.pass_operation == b.pass_operation &&
+         a.depth_fail_operation == b.depth_fail_operation &&
+         a.compare_operation == b.compare_operation &&
+         a.compare_mask == b.compare_mask && a.write_mask == b.write_mask &&
+         a.reference == b.reference;
+}
+
+bool VulkanShader::VulkanShaderPipelineKey::operator==(
+    const VulkanShaderPipelineKey &other) const {
+  const GPUShaderRenderState &a = render_state;
+  const GPUShaderRenderState &b = other.render_state;
+
+  if (variant_mask != other.variant_mask ||
+      depth_flags != other.depth_flags ||
+      stencil_flags != other.stencil_flags ||
+      topology_type != other.topology_type || a.cull_mode != b.cull_mode ||
+      a.front_face != b.front_face ||
+      a.depth_compare_operation != b.depth_compare_operation ||
+      a.depth_bias_enable != b.depth_bias_enable ||
+      a.depth_bias_constant_factor != b.depth_bias_constant_factor ||
+      a.depth_bias_clamp != b.depth_bias_clamp ||
+      a.depth_bias_slope_factor != b.depth_bias_slope_factor) {
+    return false;
+  }
+
+  if (!StencilStatesEqual(a.stencil_front, b.stencil_front) ||
+      !StencilStatesEqual(a.stencil_back, b.stencil_back)) {
+    return false;
+  }
+
+  if (a.blend_states.size() != b.blend_states.size()) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < a.blend_states.size(); ++i) {
+    const GPUShaderBlendState &x = a.blend_states[i];
+    const GPUShaderBlendState &y = b.blend_states[i];
+    if (x.blend_enable != y.blend_enable ||
+        x.src_color_factor != y.src_color_factor ||
+        x.dst_color_factor != y.dst_color_factor ||
+        x.color_operation != y.color_operation ||
+        x.src_alpha_factor != y.src_alpha_factor ||
+        x.dst_alpha_factor != y.dst_alpha_factor ||
+        x.alpha_operation != y.alpha_operation ||
+        x.color_write_mask != y.color_write_mask) {
+      return false;
+    }
+  }
 
   return true;
-}
\ No newline at end of file
+}
+
+size_t VulkanShader::VulkanShaderPipelineKey::hash() const {
+  uint64_t result = GPUUtils::HashMix(variant_mask);
+
+  GPUUtils::HashCombine(result, depth_flags);
+  GPUUtils::HashCombine(result, stencil_flags);
+  GPUUtils::HashCombine(result, topology_type);
+
+  GPUUtils::HashCombine(result, render_state.cull_mode);
+  GPUUtils::HashCombine(result, render_state.front_face);
+  GPUUtils::HashCombine(result, render_state.depth_compare_operation);
+  GPUUtils::HashCombine(result, render_state.depth_bias_enable);
+  GPUUtils::HashCombine(
+      result, std::hash<float>()(render_state.depth_bias_constant_factor));
+  GPUUtils::HashCombine(result,
+                        std::hash<float>()(render_state.depth_bias_clamp));
+  GPUUtils::HashCombine(
+      result, std::hash<float>()(render_state.depth_bias_slope_factor));
+  HashStencilState(result, render_state.stencil_front);
+  HashStencilState(result, render_state.stencil_back);
+  for (const GPUShaderBlendState &blend_state : render_state.blend_states) {
+    GPUUtils::HashCombine(result, blend_state.blend_enable);
+    GPUUtils::HashCombine(result, blend_state.src_color_factor);
+    GPUUtils::HashCombine(result, blend_state.dst_color_factor);
+    GPUUtils::HashCombine(result, blend_state.color_operation);
+    GPUUtils::HashCombine(result, blend_state.src_alpha_factor);
+    GPUUtils::HashCombine(result, blend_state.dst_alpha_factor);
+    GPUUtils::HashCombine(result, blend_state.alpha_operation);
+    GPUUtils::HashCombine(result, blend_state.color_write_mask);
+  }
+
+  return result;
+}
@@ -9,7 +9,9 @@
 
 #include <spirv_cross/spirv.hpp>
 #include <spirv_cross/spirv_glsl.hpp>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <vulkan/vulkan.h>
 
@@ -20,33 +22,106 @@ public:
   bool Create(GPUShaderConfig * config) override;
   void Destroy() override;
 
+  void SetVariant(uint32_t variant_mask) override;
+  void SetRenderState(GPUShaderRenderState *render_state) override;
+
   void Bind() override;
   void BindUniformBuffer(GPUDescriptorSet *set, uint32_t offset,
                          int32_t set_index) override;
   void BindSampler(GPUDescriptorSet *set, int32_t set_index) override;
-  void PushConstant(void *value, uint64_t size, uint32_t offset,
-                    uint8_t stage_flags) override;
+  void PushDescriptorSet(int32_t set_index,
+                         std::vector<GPUDescriptorBinding> &bindings,
+                         uint32_t uniform_buffer_offset) override;
+  void PushConstant(void *value, uint64_t size, uint32_t offset) override;
 
   void SetDebugName(const char *name) override;
   void SetDebugTag(const void *tag, size_t tag_size) override;
 
-  inline VulkanPipeline &GetPipeline() { return pipeline; }
+  inline VulkanPipeline &GetPipeline() { return *GetVariantPipeline(); }
+  /* layout of the set in the current variant */
+  inline VkDescriptorSetLayout GetDescriptorSetLayout(uint32_t set_index) {
+    return GetVariantPipeline()->GetDescriptorSetLayout(set_index);
+  }
+
+  /* everything a pipeline of this shader is created from */
+  struct VulkanShaderPipelineKey {
+    uint32_t variant_mask;
+    GPUShaderRenderState render_state;
+    uint8_t depth_flags;
+    uint8_t stencil_flags;
+    GPUShaderTopologyType topology_type;
+
+    bool operator==(const VulkanShaderPipelineKey &other) const;
+    size_t hash() const;
+  };
+
+  struct VulkanShaderPipelineKeyHash {
+    std::size_t operator()(const VulkanShaderPipelineKey &key) const {
+      return key.hash();
+    }
+  };
+
+  /* per draw state. If the shader is bound, the new state is applied right
+   * away, either dynamically or by binding another pipeline. It lasts until
+   * the shader is bound again */
+  inline VulkanShaderPipelineKey GetState() { return current_key; }
+  void SetState(VulkanShaderPipelineKey &state);
+
+  /* file_name is the name of a glsl source, like "mrt.frag" */
+  bool UsesStageSource(const std::string &file_name);
+  /* recreates every pipeline of the shader from the stage files. The old
+   * pipelines are kept if any of them fails */
+  bool Reload();
+
+  /* reflection and variant lookup, shared with the compute shaders */
+  struct VulkanShaderStage {
+    GPUShaderStageType type;
+    std::string file_path;
+    /* keywords this stage was compiled with, in the order of the variant file
+     * name suffixes */
+    std::vector<std::string> keywords;
+  };
 
-private:
-  /* used for reflection. TODO: just use unordered_map instead */
   struct VulkanShaderSet {
     std::vector<VkDescriptorSetLayoutBinding> bindings;
+    /* stages that declare the binding, used if none of them access it */
+    std::vector<VkShaderStageFlags> declared_stages;
     uint32_t index;
+    /* the set is a runtime sized texture array, bound to the bindless
+     * texture table instead of a layout of its own */
+    bool bindless = false;
   };
 
-  void ReflectStagePushConstantRanges(
+  static void ReflectStagePushConstantRanges(
       spirv_cross::Compiler &compiler, spirv_cross::ShaderResources &resources,
+      VkShaderStageFlagBits stage,
       std::vector<VkPushConstantRange> &push_constant_ranges);
-  /* TODO: for some reason, this function returns incorrect results when shader
-   * sets are not places in the increasing order */
-  void ReflectStageUniforms(spirv_cross::Compiler &compiler,
-                            spirv_cross::ShaderResources &resources,
-                            std::vector<VulkanShaderSet> &sets);
+  static void ReflectStageUniforms(spirv_cross::Compiler &compiler,
+                                   spirv_cross::ShaderResources &resources,
+                                   VkShaderStageFlagBits stage,
+                                   std::vector<VulkanShaderSet> &sets);
+  /* orders the sets by their index and fills the gaps with empty sets */
+  static void
+  FinalizeDescriptorSetsReflection(std::vector<VulkanShaderSet> &sets);
+  /* layouts of the reflected sets, with push descriptors for the sets in the
+   * mask. out_bindless_set_index is the set of the bindless texture table, or
+   * -1 */
+  static bool
+  CreateDescriptorSetLayouts(std::vector<VulkanShaderSet> &sets,
+                             uint32_t push_descriptor_set_mask,
+                             std::vector<VkDescriptorSetLayout> &out_layouts,
+                             int32_t *out_bindless_set_index);
+
+  static void LoadStageKeywords(VulkanShaderStage &stage);
+  static std::string
+  GetStageVariantPath(VulkanShaderStage &stage,
+                      std::vector<std::string> &keywords,
+                      uint32_t variant_mask);
+  /* the stage binary is compiled from the glsl source file_name */
+  static bool IsStageSource(VulkanShaderStage &stage,
+                            const std::string &file_name);
+
+private:
   bool ReflectVertexAttributes(
       spirv_cross::Compiler &compiler, spirv_cross::ShaderResources &resources,
       std::vector<VkVertexInputAttributeDescription> &attributes,
@@ -56,9 +131,47 @@ private:
   uint32_t
   ReflectTesselationControlPoints(spirv_cross::Compiler &compiler,
                                   spirv_cross::ShaderResources &resources);
-  bool UpdateDescriptorSetsReflection(std::vector<VulkanShaderSet> &sets,
-                                      uint32_t set, uint32_t binding,
-                                      int32_t *out_set_index);
+  /* merges the binding with the ones reflected from the other stages */
+  static void ReflectDescriptorBinding(std::vector<VulkanShaderSet> &sets,
+                                       uint32_t set, uint32_t binding,
+                                       VkDescriptorType type,
+                                       VkShaderStageFlagBits stage,
+                                       bool active);
+
+  bool CreateVariant(VulkanShaderPipelineKey &key,
+                     VulkanPipeline *out_pipeline);
+  VulkanPipeline *GetVariantPipeline();
+  /* key of the pipeline the state is drawn with, without the dynamic state */
+  VulkanShaderPipelineKey GetPipelineKey(VulkanShaderPipelineKey &state);
+  void UpdatePipeline();
+  /* binds the pipeline and the dynamic state of current_key */
+  void BindPipeline();
+
+  std::vector<VulkanShaderStage> stages;
+  std::vector<std::string> keywords;
+  uint32_t push_descriptor_set_mask;
+  uint32_t vertex_stride;
+  VulkanRenderPass *render_pass;
+  float viewport_width;
+  float viewport_height;
+  uint32_t subpass;
+  std::string debug_name;
 
-  VulkanPipeline pipeline;
+  std::unordered_map<VulkanShaderPipelineKey, VulkanPipeline,
+                     VulkanShaderPipelineKeyHash>
+      pipelines;
+  /* key of the pipeline created with the shader, used as a fallback */
+  VulkanShaderPipelineKey base_key;
+  /* keys that failed to build. They fall back to the base pipeline without
+   * being built again, until the shader is reloaded */
+  std::unordered_set<VulkanShaderPipelineKey, VulkanShaderPipelineKeyHash>
+      failed_keys;
+  /* state set through the shader config, SetVariant and SetRenderState */
+  VulkanShaderPipelineKey shader_key;
+  /* state requested by the user, including the dynamic state */
+  VulkanShaderPipelineKey current_key;
+  /* current_key was changed per draw, through SetState */
+  bool state_overridden;
+  /* pipeline of the current state, 0 until it is first used */
+  VulkanPipeline *pipeline;
 };
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "vulkan_shader_hot_reload.h"
+
+#include "../../logger.h"
+#include "vulkan_compute_shader.h"
+#include "vulkan_shader.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <filesystem>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef RF3D_GLSLANG
+#define RF3D_GLSLANG "glslangValidator"
+#endif
+
+/* editors often save a file in several writes, so the changes are compiled
+ * only once the directory is quiet for that long */
+#define HOT_RELOAD_SETTLE_MILLISECONDS 100
+#define HOT_RELOAD_POLL_MILLISECONDS 250
+
+static bool IsShaderSource(const std::string &file_name) {
+  static const char *extensions[] = {".vert", ".frag", ".geom",
+                                     ".tesc", ".tese", ".comp"};
+  for (uint32_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); ++i) {
+    std::string extension = extensions[i];
+    if (file_name.size() > extension.size() &&
+        file_name.compare(file_name.size() - extension.size(),
+                          extension.size(), extension) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* keywords are declared on a "keywords: A B" comment line of the source, see
+ * the shaders target */
+static std::vector<std::string> ReadSourceKeywords(const std::string &path) {
+  std::vector<std::string> keywords;
+
+  FILE *file = fopen(path.c_str(), "r");
+  if (!file) {
+    return keywords;
+  }
+
+  char line[512];
+  while (fgets(line, sizeof(line), file)) {
+    std::string text = line;
+    if (text.rfind("/* keywords:", 0) != 0) {
+      continue;
+    }
+    size_t end = text.find("*/");
+    if (end == std::string::npos) {
+      continue;
+    }
+
+    text = text.substr(12, end - 12);
+    size_t start = text.find_first_not_of(" \t");
+    while (start != std::string::npos) {
+      size_t stop = text.find_first_of(" \t", start);
+      keywords.emplace_back(text.substr(start, stop - start));
+      start = text.find_first_not_of(" \t", stop);
+    }
+    break;
+  }
+
+  fclose(file);
+
+  return keywords;
+}
+
+/* runs the compiler directly, without a shell, so that the paths need no
+ * quoting. Returns whether it exited with 0 */
+static bool RunCompiler(std::vector<std::string> &arguments) {
+  std::vector<char *> argv;
+  for (uint32_t i = 0; i < arguments.size(); ++i) {
+    argv.emplace_back(arguments[i].data());
+  }
+  argv.emplace_back((char *)0);
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    ERROR("Failed to start %s", argv[0]);
+    return false;
+  }
+  if (pid == 0) {
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      ERROR("Failed to wait for %s", argv[0]);
+      return false;
+    }
+  }
+
+  if (!WIFEXITED(status)) {
+    ERROR("%s was terminated", argv[0]);
+    return false;
+  }
+  if (WEXITSTATUS(status) == 127) {
+    ERROR("Failed to run %s", argv[0]);
+    return false;
+  }
+
+  return WEXITSTATUS(status) == 0;
+}
+
+bool VulkanShaderHotReload::Initialize(const char *source_directory,
+                                       const char *output_directory) {
+  this->source_directory = source_directory;
+  this->output_directory = output_directory;
+  directories.clear();
+  shaders.clear();
+  compute_shaders.clear();
+  compiled_files.clear();
+
+  inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd < 0) {
+    ERROR("Failed to initialize inotify, shader hot reload is disabled");
+    return false;
+  }
+
+  AddWatch(this->source_directory);
+  std::error_code error;
+  for (auto it = std::filesystem::recursive_directory_iterator(
+           this->source_directory, error);
+       it != std::filesystem::recursive_directory_iterator();
+       it.increment(error)) {
+    if (error) {
+      break;
+    }
+    if (it->is_directory()) {
+      AddWatch(it->path().string());
+    }
+  }
+
+  running = true;
+  worker = std::thread(&VulkanShaderHotReload::ProcessEvents, this);
+
+  INFO("Watching %s for shader changes", this->source_directory.c_str());
+
+  return true;
+}
+
+void VulkanShaderHotReload::Shutdown() {
+  running = false;
+  if (worker.joinable()) {
+    worker.join();
+  }
+
+  if (inotify_fd >= 0) {
+    close(inotify_fd);
+    inotify_fd = -1;
+  }
+  directories.clear();
+  shaders.clear();
+  compute_shaders.clear();
+  compiled_files.clear();
+}
+
+void VulkanShaderHotReload::Register(VulkanShader *shader) {
+  if (std::find(shaders.begin(), shaders.end(), shader) == shaders.end()) {
+    shaders.emplace_back(shader);
+  }
+}
+
+void VulkanShaderHotReload::Unregister(VulkanShader *shader) {
+  shaders.erase(std::remove(shaders.begin(), shaders.end(), shader),
+                shaders.end());
+}
+
+void VulkanShaderHotReload::Register(VulkanComputeShader *shader) {
+  if (std::find(compute_shaders.begin(), compute_shaders.end(), shader) ==
+      compute_shaders.end()) {
+    compute_shaders.emplace_back(shader);
+  }
+}
+
+void VulkanShaderHotReload::Unregister(VulkanComputeShader *shader) {
+  compute_shaders.erase(
+      std::remove(compute_shaders.begin(), compute_shaders.end(), shader),
+      compute_shaders.end());
+}
+
+void VulkanShaderHotReload::Update() {
+  std::vector<std::string> files;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    files.swap(compiled_files);
+  }
+
+  if (files.empty()) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < shaders.size(); ++i) {
+    bool affected = false;
+    for (uint32_t j = 0; j < files.size() && !affected; ++j) {
+      affected = shaders[i]->UsesStageSource(files[j]);
+    }
+
+    if (affected && shaders[i]->Reload()) {
+      INFO("Reloaded shader pipelines");
+    }
+  }
+
+  for (uint32_t i = 0; i < compute_shaders.size(); ++i) {
+    bool affected = false;
+    for (uint32_t j = 0; j < files.size() && !affected; ++j) {
+      affected = compute_shaders[i]->UsesStageSource(files[j]);
+    }
+
+    if (affected && compute_shaders[i]->Reload()) {
+      INFO("Reloaded compute shader pipelines");
+    }
+  }
+}
+
+void VulkanShaderHotReload::AddWatch(const std::string &directory) {
+  int watch = inotify_add_watch(inotify_fd, directory.c_str(),
+                                IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+  if (watch < 0) {
+    WARN("Failed to watch %s", directory.c_str());
+    return;
+  }
+
+  directories[watch] = directory;
+}
+
+void VulkanShaderHotReload::ReadEvents(std::set<std::string> &changed_files) {
+  alignas(struct inotify_event) char buffer[4096];
+
+  ssize_t length;
+  while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+    for (char *ptr = buffer; ptr < buffer + length;) {
+      const struct inotify_event *event = (const struct inotify_event *)ptr;
+      ptr += sizeof(struct inotify_event) + event->len;
+
+      auto directory = directories.find(event->wd);
+      if (!event->len || directory == directories.end()) {
+        continue;
+      }
+
+      std::string path = directory->second + "/" + event->name;
+      if (event->mask & IN_ISDIR) {
+        AddWatch(path);
+        continue;
+      }
+
+      /* IN_CREATE is only of interest for directories, the file is reported
+       * again once it is written */
+      if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) &&
+          IsShaderSource(event->name)) {
+        changed_files.insert(path);
+      }
+    }
+  }
+}
+
+bool VulkanShaderHotReload::Compile(const std::string &source_path) {
+  std::string file_name =
+      std::filesystem::path(source_path).filename().string();
+  std::vector<std::string> keywords = ReadSourceKeywords(source_path);
+
+  /* variants are compiled into temporary files first, so that a broken
+   * source leaves the previous binaries intact */
+  std::vector<std::string> outputs;
+  bool result = true;
+  for (uint32_t variant = 0; variant < (1u << keywords.size()); ++variant) {
+    std::vector<std::string> arguments = {RF3D_GLSLANG, "--target-env",
+                                          "vulkan1.2"};
+    std::string suffix;
+    for (uint32_t i = 0; i < keywords.size(); ++i) {
+      if (variant & (1 << i)) {
+        suffix += "." + keywords[i];
+        arguments.emplace_back("-D" + keywords[i]);
+      }
+    }
+
+    std::string output = output_directory + "/" + file_name + suffix + ".spv";
+    arguments.emplace_back(source_path);
+    arguments.emplace_back("-o");
+    arguments.emplace_back(output + ".tmp");
+    outputs.emplace_back(output);
+    if (!RunCompiler(arguments)) {
+      ERROR("Failed to compile %s", source_path.c_str());
+      result = false;
+      break;
+    }
+  }
+
+  for (uint32_t i = 0; i < outputs.size(); ++i) {
+    std::string temporary = outputs[i] + ".tmp";
+    if (result) {
+      rename(temporary.c_str(), outputs[i].c_str());
+    } else {
+      remove(temporary.c_str());
+    }
+  }
+
+  if (!result) {
+    return false;
+  }
+
+  std::string manifest_path = output_directory + "/" + file_name + ".keywords";
+  if (keywords.empty()) {
+    remove(manifest_path.c_str());
+  } else {
+    FILE *manifest = fopen(manifest_path.c_str(), "w");
+    if (manifest) {
+      for (uint32_t i = 0; i < keywords.size(); ++i) {
+        fprintf(manifest, "%s\n", keywords[i].c_str());
+      }
+      fclose(manifest);
+    }
+  }
+
+  return true;
+}
+
+void VulkanShaderHotReload::ProcessEvents() {
+  std::set<std::string> changed_files;
+
+  while (running) {
+    struct pollfd poll_fd = {};
+    poll_fd.fd = inotify_fd;
+    poll_fd.events = POLLIN;
+
+    int timeout = changed_files.empty() ? HOT_RELOAD_POLL_MILLISECONDS
+                                        : HOT_RELOAD_SETTLE_MILLISECONDS;
+    if (poll(&poll_fd, 1, timeout) > 0) {
+      ReadEvents(changed_files);
+      continue;
+    }
+
+    for (const std::string &path : changed_files) {
+      INFO("Recompiling %s", path.c_str());
+      if (Compile(path)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        compiled_files.emplace_back(
+            std::filesystem::path(path).filename().string());
+      }
+    }
+    changed_files.clear();
+  }
+}
\ No newline at end of file
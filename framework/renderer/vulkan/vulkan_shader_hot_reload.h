@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class VulkanShader;
+class VulkanComputeShader;
+
+/* Development helper: watches the glsl sources with inotify, recompiles the
+ * changed files on a worker thread and reloads the pipelines of the shaders
+ * that use them at the frame boundary. The frames keep the old pipelines
+ * until every variant of a source compiled, a broken source is never picked
+ * up. With the pipeline library the reload only links the fast pipelines,
+ * the optimized ones replace them once the library built them */
+class VulkanShaderHotReload {
+public:
+  bool Initialize(const char *source_directory, const char *output_directory);
+  void Shutdown();
+
+  void Register(VulkanShader *shader);
+  void Unregister(VulkanShader *shader);
+  void Register(VulkanComputeShader *shader);
+  void Unregister(VulkanComputeShader *shader);
+
+  /* reloads the shaders whose sources finished compiling since the last
+   * call, never waits for the compiler. The device should not be using the
+   * pipelines at this point */
+  void Update();
+
+private:
+  void AddWatch(const std::string &directory);
+  void ReadEvents(std::set<std::string> &changed_files);
+  /* compiles every keyword variant of the source, like the shaders target */
+  bool Compile(const std::string &source_path);
+  void ProcessEvents();
+
+  std::string source_directory;
+  std::string output_directory;
+  int inotify_fd;
+  /* inotify watch descriptor to the watched directory */
+  std::unordered_map<int, std::string> directories;
+  std::vector<VulkanShader *> shaders;
+  std::vector<VulkanComputeShader *> compute_shaders;
+
+  std::thread worker;
+  std::atomic<bool> running;
+  std::mutex mutex;
+  /* file names of the sources compiled since the last update */
+  std::vector<std::string> compiled_files;
+};
\ No newline at end of file
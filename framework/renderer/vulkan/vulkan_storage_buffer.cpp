@@ -0,0 +1,93 @@
+#include "vulkan_storage_buffer.h"
+
+#include "vulkan_backend.h"
+#include "vulkan_debug_marker.h"
+#include "vulkan_utils.h"
+
+bool VulkanStorageBuffer::Create(uint64_t buffer_size,
+                                 GPUFormat texel_format) {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  this->texel_format = texel_format;
+  view = 0;
+
+  VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                   VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                   VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                   VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  if (texel_format != GPU_FORMAT_NONE) {
+    usage_flags |= VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT |
+                   VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+  }
+
+  uint32_t device_local_bits = context->device->SupportsDeviceLocalHostVisible()
+                                   ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                                   : 0;
+
+  /* written by the cpu each frame as often as by the gpu, so it stays host
+   * visible */
+  if (!buffer.Create(buffer_size, usage_flags,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+                         device_local_bits,
+                     VMA_MEMORY_USAGE_CPU_TO_GPU)) {
+    return false;
+  }
+
+  if (texel_format != GPU_FORMAT_NONE) {
+    VkBufferViewCreateInfo view_create_info = {};
+    view_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO;
+    view_create_info.pNext = 0;
+    view_create_info.flags = 0;
+    view_create_info.buffer = buffer.GetHandle();
+    view_create_info.format =
+        VulkanUtils::GPUFormatToVulkanFormat(texel_format);
+    view_create_info.offset = 0;
+    view_create_info.range = VK_WHOLE_SIZE;
+
+    VK_CHECK(vkCreateBufferView(context->device->GetLogicalDevice(),
+                                &view_create_info, context->allocator, &view));
+  }
+
+  return true;
+}
+
+void VulkanStorageBuffer::Destroy() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  vkDeviceWaitIdle(context->device->GetLogicalDevice());
+
+  context->descriptor_set_cache->InvalidateResource(
+      (uint64_t)buffer.GetHandle());
+  if (view) {
+    context->descriptor_set_cache->InvalidateResource((uint64_t)view);
+    vkDestroyBufferView(context->device->GetLogicalDevice(), view,
+                        context->allocator);
+    view = 0;
+  }
+  buffer.Destroy();
+
+  texel_format = GPU_FORMAT_NONE;
+}
+
+void *VulkanStorageBuffer::Lock(uint64_t offset, uint64_t size) {
+  return buffer.Lock(offset, size);
+}
+
+void VulkanStorageBuffer::Unlock() { buffer.Unlock(); }
+
+bool VulkanStorageBuffer::LoadData(uint64_t offset, uint64_t size, void *data) {
+  return buffer.LoadData(offset, size, data);
+}
+
+void VulkanStorageBuffer::SetDebugName(const char *name) {
+  VulkanDebugUtils::SetObjectName(name, (uint64_t)buffer.GetHandle(),
+                                  VK_OBJECT_TYPE_BUFFER);
+}
+
+void VulkanStorageBuffer::SetDebugTag(const void *tag, size_t tag_size) {
+  VulkanDebugUtils::SetObjectTag(tag, (uint64_t)buffer.GetHandle(),
+                                 VK_OBJECT_TYPE_BUFFER, 0, tag_size);
+}
+
+uint64_t VulkanStorageBuffer::GetSize() const { return buffer.GetSize(); }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../gpu_storage_buffer.h"
+#include "vulkan_buffer.h"
+
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+class VulkanStorageBuffer : public GPUStorageBuffer {
+public:
+  bool Create(uint64_t buffer_size,
+              GPUFormat texel_format = GPU_FORMAT_NONE) override;
+  void Destroy() override;
+
+  void *Lock(uint64_t offset, uint64_t size) override;
+  void Unlock() override;
+
+  bool LoadData(uint64_t offset, uint64_t size, void *data) override;
+
+  void SetDebugName(const char *name) override;
+  void SetDebugTag(const void *tag, size_t tag_size) override;
+
+  inline uint64_t GetSize() const override;
+  inline VulkanBuffer &GetBuffer() { return buffer; }
+  /* 0 if the buffer has no texel format */
+  inline VkBufferView GetView() const { return view; }
+
+private:
+  VulkanBuffer buffer;
+  VkBufferView view;
+};
\ No newline at end of file
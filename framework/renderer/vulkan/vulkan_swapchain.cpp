@@ -5,10 +5,14 @@
 #include "vulkan_context.h"
 #include "vulkan_device.h"
 #include "vulkan_texture.h"
+#include "vulkan_utils.h"
 
 #include <glm/glm.hpp>
 
-bool VulkanSwapchain::Create(uint32_t width, uint32_t height) {
+bool VulkanSwapchain::Create(uint32_t width, uint32_t height,
+                             GPUPresentMode requested_present_mode,
+                             uint32_t requested_image_count,
+                             VulkanSwapchain *old_swapchain) {
   VulkanContext *context = VulkanBackend::GetContext();
 
   /* requery swapchain support and depth format, since after swapchain
@@ -19,7 +23,7 @@ bool VulkanSwapchain::Create(uint32_t width, uint32_t height) {
   VulkanSwapchainSupportInfo swapchain_support_info =
       context->device->GetSwapchainSupportInfo();
 
-  /* Select optimal format and present mode. TODO: maybe configurable */
+  /* Select optimal format. TODO: maybe configurable */
   image_format = swapchain_support_info.formats[0];
   for (uint32_t i = 0; i < swapchain_support_info.formats.size(); ++i) {
     VkSurfaceFormatKHR format = swapchain_support_info.formats[i];
@@ -30,14 +34,20 @@ bool VulkanSwapchain::Create(uint32_t width, uint32_t height) {
     }
   }
 
-  present_mode = swapchain_support_info.present_modes[0];
+  /* FIFO is the only present mode that is always supported */
+  VkPresentModeKHR requested_mode =
+      VulkanUtils::GPUPresentModeToVulkanPresentMode(requested_present_mode);
+  present_mode = VK_PRESENT_MODE_FIFO_KHR;
   for (uint32_t i = 0; i < swapchain_support_info.present_modes.size(); ++i) {
     VkPresentModeKHR mode = swapchain_support_info.present_modes[i];
-    if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
+    if (mode == requested_mode) {
       present_mode = mode;
       break;
     }
   }
+  if (present_mode != requested_mode) {
+    DEBUG("Present mode %d is not supported, using FIFO", requested_mode);
+  }
 
   extent = {width, height};
   if (swapchain_support_info.capabilities.currentExtent.width != UINT32_MAX) {
@@ -50,14 +60,17 @@ bool VulkanSwapchain::Create(uint32_t width, uint32_t height) {
       extent.height, swapchain_support_info.capabilities.minImageExtent.height,
       swapchain_support_info.capabilities.maxImageExtent.height);
 
-  uint32_t image_count = swapchain_support_info.capabilities.minImageCount + 1;
+  uint32_t image_count = requested_image_count;
+  if (image_count < swapchain_support_info.capabilities.minImageCount) {
+    image_count = requested_image_count
+                      ? swapchain_support_info.capabilities.minImageCount
+                      : swapchain_support_info.capabilities.minImageCount + 1;
+  }
   if (swapchain_support_info.capabilities.maxImageCount > 0 &&
       image_count > swapchain_support_info.capabilities.maxImageCount) {
     image_count = swapchain_support_info.capabilities.maxImageCount;
   }
 
-  max_frames_in_flight = image_count - 1;
-
   VulkanDeviceQueueInfo graphics_queue_info =
       context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
   VulkanDeviceQueueInfo present_queue_info =
@@ -90,7 +103,10 @@ bool VulkanSwapchain::Create(uint32_t width, uint32_t height) {
   swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
   swapchain_create_info.presentMode = present_mode;
   swapchain_create_info.clipped = VK_TRUE;
-  swapchain_create_info.oldSwapchain = 0;
+  /* lets the driver reuse the resources of the old swapchain, and present the
+   * already acquired images of it */
+  swapchain_create_info.oldSwapchain =
+      old_swapchain ? old_swapchain->handle : VK_NULL_HANDLE;
 
   VK_CHECK(vkCreateSwapchainKHR(context->device->GetLogicalDevice(),
                                 &swapchain_create_info, context->allocator,
@@ -131,9 +147,13 @@ bool VulkanSwapchain::Create(uint32_t width, uint32_t height) {
     native_attachment->CreateAsSwapchainAttachment(images[i], image_views[i]);
   }
 
-  depth_attachment.Create(GPU_FORMAT_D24_S8,
-                          GPU_ATTACHMENT_USAGE_DEPTH_STENCIL_ATTACHMENT,
-                          extent.width, extent.height);
+  depth_attachment = new VulkanAttachment();
+  depth_attachment->Create(GPU_FORMAT_D24_S8,
+                           GPU_ATTACHMENT_USAGE_DEPTH_STENCIL_ATTACHMENT,
+                           extent.width, extent.height);
+
+  out_of_date = false;
+  present_id = 0;
 
   return true;
 }
@@ -141,8 +161,11 @@ bool VulkanSwapchain::Create(uint32_t width, uint32_t height) {
 void VulkanSwapchain::Destroy() {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  depth_attachment.Destroy();
-  depth_attachment = {};
+  /* retired swapchains are destroyed by the deletion queue, after the frames
+   * that used them */
+  depth_attachment->DestroyImmediate();
+  delete depth_attachment;
+  depth_attachment = 0;
 
   for (uint32_t i = 0; i < color_attachments.size(); ++i) {
     VulkanAttachment *native_attachment =
@@ -155,21 +178,16 @@ void VulkanSwapchain::Destroy() {
                         context->allocator);
 
   handle = 0;
-  max_frames_in_flight = 0;
   color_attachments.clear();
   image_format = {};
   present_mode = {};
   extent = {};
-}
-
-bool VulkanSwapchain::Recreate(uint32_t width, uint32_t height) {
-  Destroy();
-  return Create(width, height);
+  out_of_date = false;
+  present_id = 0;
 }
 
 bool VulkanSwapchain::AcquireNextImage(uint64_t timeout_ns,
                                        VkSemaphore semaphor, VkFence fence,
-                                       uint32_t width, uint32_t height,
                                        uint32_t *out_image_index) {
   VulkanContext *context = VulkanBackend::GetContext();
 
@@ -178,9 +196,13 @@ bool VulkanSwapchain::AcquireNextImage(uint64_t timeout_ns,
                             timeout_ns, semaphor, fence, out_image_index);
 
   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-    Recreate(width, height);
+    out_of_date = true;
     return false;
-  } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+  } else if (result == VK_SUBOPTIMAL_KHR) {
+    /* the image is acquired and can still be presented, the swapchain is
+     * recreated after the frame */
+    out_of_date = true;
+  } else if (result != VK_SUCCESS) {
     FATAL("Failed to acquire swapchain image!");
     return false;
   }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../gpu_core.h"
 #include "vulkan_attachment.h"
 #include "vulkan_framebuffer.h"
 #include "vulkan_render_pass.h"
@@ -11,31 +12,46 @@ class VulkanContext;
 
 class VulkanSwapchain {
 public:
-  bool Create(uint32_t width, uint32_t height);
+  /* falls back to FIFO if the present mode is not supported. image_count is
+   * clamped to the surface limits, 0 for one more than the minimum. The
+   * images of the old swapchain are retired into the new one, which stays
+   * valid until it is destroyed, once the device no longer uses it */
+  bool Create(uint32_t width, uint32_t height,
+              GPUPresentMode requested_present_mode,
+              uint32_t requested_image_count,
+              VulkanSwapchain *old_swapchain = 0);
+  /* doesn't wait for the device */
   void Destroy();
 
-  bool Recreate(uint32_t width, uint32_t height);
+  /* returns false if no image was acquired. The swapchain is marked out of
+   * date if it no longer matches the surface */
   bool AcquireNextImage(uint64_t timeout_ns, VkSemaphore semaphor,
-                        VkFence fence, uint32_t width, uint32_t height,
-                        uint32_t *out_image_index);
+                        VkFence fence, uint32_t *out_image_index);
+
+  inline bool IsOutOfDate() const { return out_of_date; }
+  inline void MarkOutOfDate() { out_of_date = true; }
 
   inline VkSwapchainKHR &GetHandle() { return handle; }
-  inline uint32_t GetMaxFramesInFlights() const { return max_frames_in_flight; }
   inline std::vector<GPUAttachment *> &GetColorAttachments() {
     return color_attachments;
   }
-  inline VulkanAttachment &GetDepthAttachment() { return depth_attachment; }
+  inline VulkanAttachment *GetDepthAttachment() { return depth_attachment; }
   inline VkSurfaceFormatKHR GetImageFormat() const { return image_format; }
   inline VkExtent2D GetExtent() const { return extent; }
+  inline VkPresentModeKHR GetPresentMode() const { return present_mode; }
+  /* ids of VK_KHR_present_id, 0 until the first present */
+  inline uint64_t GetPresentId() const { return present_id; }
+  inline uint64_t NextPresentId() { return ++present_id; }
 
   inline uint32_t GetImageCount() const { return color_attachments.size(); }
 
 private:
   VkSwapchainKHR handle;
-  uint32_t max_frames_in_flight;
   std::vector<GPUAttachment *> color_attachments;
   VkSurfaceFormatKHR image_format;
   VkPresentModeKHR present_mode;
   VkExtent2D extent;
-  VulkanAttachment depth_attachment;
+  VulkanAttachment *depth_attachment;
+  bool out_of_date;
+  uint64_t present_id;
 };
\ No newline at end of file
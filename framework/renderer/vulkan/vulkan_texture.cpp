@@ -10,22 +10,16 @@
 
 bool VulkanTexture::Create(GPUFormat texture_format,
                            GPUTextureType texture_type, uint32_t texture_width,
-                           uint32_t texture_height) {
+                           uint32_t texture_height, uint32_t texture_flags) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  uint32_t mip_levels =
-      static_cast<uint32_t>(
-          std::floor(std::log2(std::max(texture_width, texture_height)))) +
-      1;
-  /* TODO: mip levels for a cubemap are not supported right now */
-  if (texture_type == GPU_TEXTURE_TYPE_CUBEMAP) {
-    mip_levels = 1;
-  }
-
   format = texture_format;
   type = texture_type;
   width = texture_width;
   height = texture_height;
+  flags = texture_flags;
+
+  uint32_t mip_levels = GetMipLevels();
 
   VkFormat native_format = VulkanUtils::GPUFormatToVulkanFormat(format);
   VkImageAspectFlags native_aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -68,9 +62,23 @@ bool VulkanTexture::Create(GPUFormat texture_format,
   image_create_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT |
                             VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
                             VK_IMAGE_USAGE_SAMPLED_BIT;
+  if (flags & GPU_TEXTURE_FLAG_STORAGE) {
+    image_create_info.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+  }
   image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   image_create_info.queueFamilyIndexCount = 0;
   image_create_info.pQueueFamilyIndices = 0;
+  /* storage textures may be written by the async compute queue. Concurrent
+   * sharing saves the ownership transfers */
+  uint32_t queue_family_indices[2];
+  if (flags & GPU_TEXTURE_FLAG_STORAGE) {
+    image_create_info.queueFamilyIndexCount =
+        context->device->GetConcurrentQueueFamilyIndices(queue_family_indices);
+    if (image_create_info.queueFamilyIndexCount) {
+      image_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+      image_create_info.pQueueFamilyIndices = queue_family_indices;
+    }
+  }
   image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
   VmaAllocationCreateInfo vma_allocation_create_info = {};
@@ -133,6 +141,26 @@ bool VulkanTexture::Create(GPUFormat texture_format,
   VK_CHECK(vkCreateSampler(context->device->GetLogicalDevice(),
                            &sampler_create_info, context->allocator, &sampler));
 
+  /* storage textures stay in the general layout, so that they can be
+   * written without a layout transition */
+  if (flags & GPU_TEXTURE_FLAG_STORAGE) {
+    VulkanDeviceQueueInfo queue_info =
+        context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
+
+    VulkanCommandBuffer temp_command_buffer;
+    temp_command_buffer.AllocateAndBeginSingleUse(queue_info.command_pool);
+    TransitionLayout(&temp_command_buffer, native_format,
+                     VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+    temp_command_buffer.FreeAndEndSingleUse(queue_info.command_pool,
+                                            queue_info.queue);
+  }
+
+  /* the table is an array of 2d samplers in the read only layout */
+  bindless_index = GPU_BINDLESS_INDEX_NONE;
+  if (type == GPU_TEXTURE_TYPE_2D && !(flags & GPU_TEXTURE_FLAG_STORAGE)) {
+    bindless_index = context->bindless_textures->Register(view, sampler);
+  }
+
   return true;
 }
 
@@ -141,6 +169,11 @@ void VulkanTexture::Destroy() {
 
   vkDeviceWaitIdle(context->device->GetLogicalDevice());
 
+  context->descriptor_set_cache->InvalidateResource((uint64_t)view);
+  context->descriptor_set_cache->InvalidateResource((uint64_t)sampler);
+  context->bindless_textures->Unregister(bindless_index);
+  bindless_index = GPU_BINDLESS_INDEX_NONE;
+
   vkDestroySampler(context->device->GetLogicalDevice(), sampler,
                    context->allocator);
 
@@ -150,6 +183,7 @@ void VulkanTexture::Destroy() {
 
   format = GPU_FORMAT_NONE;
   type = GPU_TEXTURE_TYPE_NONE;
+  flags = 0;
   handle = 0;
   view = 0;
   memory = 0;
@@ -158,12 +192,7 @@ void VulkanTexture::Destroy() {
 void VulkanTexture::WriteData(void *pixels, uint32_t offset) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  uint32_t mip_levels =
-      static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
-  /* TODO: mip levels for a cubemap are not supported right now */
-  if (type == GPU_TEXTURE_TYPE_CUBEMAP) {
-    mip_levels = 1;
-  }
+  uint32_t mip_levels = GetMipLevels();
 
   uint32_t array_layers = 0;
   switch (type) {
@@ -205,8 +234,7 @@ void VulkanTexture::WriteData(void *pixels, uint32_t offset) {
   CopyFromBuffer(&staging, &temp_command_buffer, 0);
   if (mip_levels < 2) {
     TransitionLayout(&temp_command_buffer, native_format,
-                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, GetShaderLayout());
   }
 
   temp_command_buffer.FreeAndEndSingleUse(command_pool, queue);
@@ -235,11 +263,7 @@ void VulkanTexture::TransitionLayout(VulkanCommandBuffer *command_buffer,
                                      VkImageLayout new_layout) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  uint32_t mip_levels =
-      static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
-  if (type == GPU_TEXTURE_TYPE_CUBEMAP) {
-    mip_levels = 1;
-  }
+  uint32_t mip_levels = GetMipLevels();
 
   VulkanDeviceQueueInfo graphics_queue_info =
       context->device->GetQueueInfo(VULKAN_DEVICE_QUEUE_TYPE_GRAPHICS);
@@ -297,6 +321,26 @@ void VulkanTexture::TransitionLayout(VulkanCommandBuffer *command_buffer,
     source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
     dest_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  } else if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
+             new_layout == VK_IMAGE_LAYOUT_GENERAL) {
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+    dest_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  } else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
+             new_layout == VK_IMAGE_LAYOUT_GENERAL) {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    dest_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
   } else if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
              new_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
     barrier.srcAccessMask = 0;
@@ -319,11 +363,7 @@ void VulkanTexture::CopyFromBuffer(VulkanBuffer *buffer,
                                    uint64_t offset) {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  uint32_t mip_levels =
-      static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
-  if (type == GPU_TEXTURE_TYPE_CUBEMAP) {
-    mip_levels = 1;
-  }
+  uint32_t mip_levels = GetMipLevels();
 
   uint32_t array_layers = 0;
   switch (type) {
@@ -377,11 +417,7 @@ void VulkanTexture::CopyFromBuffer(VulkanBuffer *buffer,
 bool VulkanTexture::GenerateMipMaps() {
   VulkanContext *context = VulkanBackend::GetContext();
 
-  uint32_t mip_levels =
-      static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
-  if (type == GPU_TEXTURE_TYPE_CUBEMAP) {
-    mip_levels = 1;
-  }
+  uint32_t mip_levels = GetMipLevels();
 
   VkFormat native_format = VulkanUtils::GPUFormatToVulkanFormat(format);
 
@@ -477,4 +513,15 @@ bool VulkanTexture::GenerateMipMaps() {
   temp_command_buffer.FreeAndEndSingleUse(command_pool, queue);
 
   return true;
+}
+
+uint32_t VulkanTexture::GetMipLevels() {
+  /* TODO: mip levels for a cubemap are not supported right now */
+  if (type == GPU_TEXTURE_TYPE_CUBEMAP || (flags & GPU_TEXTURE_FLAG_STORAGE)) {
+    return 1;
+  }
+
+  return static_cast<uint32_t>(
+             std::floor(std::log2(std::max(width, height)))) +
+         1;
 }
\ No newline at end of file
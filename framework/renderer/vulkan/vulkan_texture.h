@@ -11,7 +11,8 @@
 class VulkanTexture : public GPUTexture {
 public:
   bool Create(GPUFormat texture_format, GPUTextureType texture_type,
-              uint32_t texture_width, uint32_t texture_height) override;
+              uint32_t texture_width, uint32_t texture_height,
+              uint32_t texture_flags = 0) override;
   void Destroy() override;
 
   void WriteData(void *pixels, uint32_t offset) override;
@@ -23,8 +24,15 @@ public:
   inline VkImageView GetImageView() const { return view; }
   inline VmaAllocation GetMemory() const { return memory; }
   inline VkSampler GetSampler() const { return sampler; }
+  /* layout the texture is in while the shaders use it */
+  inline VkImageLayout GetShaderLayout() const {
+    return (flags & GPU_TEXTURE_FLAG_STORAGE)
+               ? VK_IMAGE_LAYOUT_GENERAL
+               : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  }
 
 private:
+  uint32_t GetMipLevels();
   void TransitionLayout(VulkanCommandBuffer *command_buffer, VkFormat format,
                         VkImageLayout old_layout, VkImageLayout new_layout);
   void CopyFromBuffer(VulkanBuffer *buffer, VulkanCommandBuffer *command_buffer,
@@ -27,7 +27,13 @@ bool VulkanUniformBuffer::Create(uint64_t buffer_element_size,
   return true;
 }
 
-void VulkanUniformBuffer::Destroy() { buffer.Destroy(); }
+void VulkanUniformBuffer::Destroy() {
+  VulkanContext *context = VulkanBackend::GetContext();
+
+  context->descriptor_set_cache->InvalidateResource(
+      (uint64_t)buffer.GetHandle());
+  buffer.Destroy();
+}
 
 void *VulkanUniformBuffer::Lock(uint64_t offset, uint64_t size) {
   return buffer.Lock(offset, size);
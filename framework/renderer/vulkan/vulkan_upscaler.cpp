@@ -0,0 +1,203 @@
+#include "vulkan_upscaler.h"
+
+#include "../../logger.h"
+
+#include <math.h>
+#include <vector>
+
+VulkanUpscaler::VulkanUpscaler(RendererBackend *upscaler_backend) {
+  backend = upscaler_backend;
+  sharpness = 0.0f;
+  easu_render_pass = 0;
+  easu_shader = 0;
+  rcas_shader = 0;
+  easu_source = 0;
+  easu_descriptor_set = 0;
+  rcas_source = 0;
+  rcas_descriptor_set = 0;
+  upscaled_attachment = 0;
+}
+
+bool VulkanUpscaler::Create(GPUUpscalerConfig *config) {
+  if (!config->render_pass) {
+    ERROR("Upscaler has no render pass!");
+    return false;
+  }
+
+  sharpness = config->sharpness;
+
+  /* every pixel is written, so nothing is loaded */
+  std::vector<GPURenderPassAttachmentConfig> attachment_configs;
+  attachment_configs.emplace_back(GPURenderPassAttachmentConfig{
+      GPU_FORMAT_DEVICE_COLOR_OPTIMAL, GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT,
+      GPU_RENDER_PASS_ATTACHMENT_LOAD_OPERATION_DONT_CARE,
+      GPU_RENDER_PASS_ATTACHMENT_STORE_OPERATION_STORE, false});
+
+  easu_render_pass = backend->RenderPassAllocate();
+  if (!easu_render_pass->Create(attachment_configs, glm::vec4(0, 0, 1, 1),
+                                glm::vec4(0, 0, 0, 1), 1.0f, 0.0f, 0)) {
+    ERROR("Failed to create the upscale render pass!");
+    return false;
+  }
+  easu_render_pass->SetDebugName("EASU render pass");
+
+  std::vector<GPUShaderStageConfig> stage_configs;
+  stage_configs.emplace_back(GPUShaderStageConfig{
+      GPU_SHADER_STAGE_TYPE_VERTEX, "assets/shaders/fsr.vert.spv"});
+  stage_configs.emplace_back(GPUShaderStageConfig{
+      GPU_SHADER_STAGE_TYPE_FRAGMENT, "assets/shaders/fsr_easu.frag.spv"});
+
+  GPUShaderConfig shader_config;
+  shader_config.stage_configs = stage_configs;
+  shader_config.topology_type = GPU_SHADER_TOPOLOGY_TYPE_TRIANGLE_LIST;
+  shader_config.depth_flags = 0;
+  shader_config.stencil_flags = 0;
+  shader_config.render_pass = easu_render_pass;
+  shader_config.subpass = 0;
+  /* the viewport is set by the render passes */
+  shader_config.viewport_width = 0.0f;
+  shader_config.viewport_height = 0.0f;
+
+  easu_shader = backend->ShaderAllocate();
+  if (!easu_shader->Create(&shader_config)) {
+    ERROR("Failed to create the EASU shader!");
+    return false;
+  }
+  easu_shader->SetDebugName("EASU shader");
+
+  shader_config.stage_configs[1].file_path =
+      "assets/shaders/fsr_rcas.frag.spv";
+  shader_config.render_pass = config->render_pass;
+
+  rcas_shader = backend->ShaderAllocate();
+  if (!rcas_shader->Create(&shader_config)) {
+    ERROR("Failed to create the RCAS shader!");
+    return false;
+  }
+  rcas_shader->SetDebugName("RCAS shader");
+
+  return true;
+}
+
+void VulkanUpscaler::Destroy() {
+  if (upscaled_attachment) {
+    backend->GetRenderTargetPool()->ReleaseAttachment(upscaled_attachment);
+  }
+  if (rcas_descriptor_set) {
+    rcas_descriptor_set->Destroy();
+    delete rcas_descriptor_set;
+  }
+  if (easu_descriptor_set) {
+    easu_descriptor_set->Destroy();
+    delete easu_descriptor_set;
+  }
+  if (rcas_shader) {
+    rcas_shader->Destroy();
+    delete rcas_shader;
+  }
+  if (easu_shader) {
+    easu_shader->Destroy();
+    delete easu_shader;
+  }
+  if (easu_render_pass) {
+    easu_render_pass->Destroy();
+    delete easu_render_pass;
+  }
+
+  easu_render_pass = 0;
+  easu_shader = 0;
+  rcas_shader = 0;
+  easu_source = 0;
+  easu_descriptor_set = 0;
+  rcas_source = 0;
+  rcas_descriptor_set = 0;
+  upscaled_attachment = 0;
+}
+
+void VulkanUpscaler::Upscale(GPUAttachment *source, glm::vec4 source_area,
+                             uint32_t output_width, uint32_t output_height) {
+  GPURenderTargetPool *pool = backend->GetRenderTargetPool();
+
+  if (upscaled_attachment) {
+    WARN("Upscale is called twice without Sharpen!");
+    pool->ReleaseAttachment(upscaled_attachment);
+  }
+
+  GPURenderTargetPoolAttachmentConfig attachment_config;
+  attachment_config.format = GPU_FORMAT_DEVICE_COLOR_OPTIMAL;
+  attachment_config.usage = GPU_ATTACHMENT_USAGE_COLOR_ATTACHMENT;
+  attachment_config.width = output_width;
+  attachment_config.height = output_height;
+  attachment_config.flags = 0;
+  upscaled_attachment = pool->AcquireAttachment(&attachment_config);
+
+  if (source != easu_source) {
+    if (easu_descriptor_set) {
+      easu_descriptor_set->Destroy();
+      delete easu_descriptor_set;
+    }
+
+    std::vector<GPUDescriptorBinding> bindings;
+    bindings.emplace_back(GPUDescriptorBinding{
+        0, GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT, 0, 0, source});
+    easu_descriptor_set = backend->DescriptorSetAllocate();
+    easu_descriptor_set->Create(easu_shader, 0, bindings);
+    easu_descriptor_set->SetDebugName("EASU descriptor set");
+    easu_source = source;
+  }
+
+  std::vector<GPUAttachment *> attachments = {upscaled_attachment};
+  GPURenderTarget *render_target =
+      pool->AcquireRenderTarget(easu_render_pass, attachments);
+
+  VulkanUpscalerEASUParams params = {};
+  params.source_area = source_area;
+  params.output_size = glm::vec2(output_width, output_height);
+
+  backend->BeginDebugRegion("EASU pass", glm::vec4(0.0, 0.5, 1.0, 1.0));
+  easu_render_pass->SetRenderArea(
+      glm::vec4(0, 0, output_width, output_height));
+  easu_render_pass->Begin(render_target);
+  easu_shader->Bind();
+  easu_shader->BindSampler(easu_descriptor_set, 0);
+  easu_shader->PushConstant(&params, sizeof(VulkanUpscalerEASUParams), 0);
+  backend->Draw(3);
+  easu_render_pass->End();
+  backend->EndDebugRegion();
+}
+
+void VulkanUpscaler::Sharpen() {
+  if (!upscaled_attachment) {
+    WARN("Sharpen is called without Upscale!");
+    return;
+  }
+
+  if (upscaled_attachment != rcas_source) {
+    if (rcas_descriptor_set) {
+      rcas_descriptor_set->Destroy();
+      delete rcas_descriptor_set;
+    }
+
+    std::vector<GPUDescriptorBinding> bindings;
+    bindings.emplace_back(GPUDescriptorBinding{
+        0, GPU_DESCRIPTOR_BINDING_TYPE_ATTACHMENT, 0, 0, upscaled_attachment});
+    rcas_descriptor_set = backend->DescriptorSetAllocate();
+    rcas_descriptor_set->Create(rcas_shader, 0, bindings);
+    rcas_descriptor_set->SetDebugName("RCAS descriptor set");
+    rcas_source = upscaled_attachment;
+  }
+
+  /* the shader takes the sharpening as a linear factor */
+  VulkanUpscalerRCASParams params = {};
+  params.sharpness = exp2f(-sharpness);
+
+  backend->BeginDebugRegion("RCAS pass", glm::vec4(0.0, 0.5, 1.0, 1.0));
+  rcas_shader->Bind();
+  rcas_shader->BindSampler(rcas_descriptor_set, 0);
+  rcas_shader->PushConstant(&params, sizeof(VulkanUpscalerRCASParams), 0);
+  backend->Draw(3);
+  backend->EndDebugRegion();
+
+  backend->GetRenderTargetPool()->ReleaseAttachment(upscaled_attachment);
+  upscaled_attachment = 0;
+}
\ No newline at end of file
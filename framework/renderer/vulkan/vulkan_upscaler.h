@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../gpu_upscaler.h"
+#include "../renderer_backend.h"
+
+class VulkanUpscaler : public GPUUpscaler {
+public:
+  VulkanUpscaler(RendererBackend *upscaler_backend);
+
+  bool Create(GPUUpscalerConfig *config) override;
+  void Destroy() override;
+
+  void Upscale(GPUAttachment *source, glm::vec4 source_area,
+               uint32_t output_width, uint32_t output_height) override;
+  void Sharpen() override;
+
+private:
+  /* push constants of the shaders */
+  struct VulkanUpscalerEASUParams {
+    glm::vec4 source_area;
+    glm::vec2 output_size;
+  };
+  struct VulkanUpscalerRCASParams {
+    float sharpness;
+  };
+
+  RendererBackend *backend;
+
+  GPURenderPass *easu_render_pass;
+  GPUShader *easu_shader;
+  GPUShader *rcas_shader;
+
+  /* sets are recreated when the attachments they sample change */
+  GPUAttachment *easu_source;
+  GPUDescriptorSet *easu_descriptor_set;
+  GPUAttachment *rcas_source;
+  GPUDescriptorSet *rcas_descriptor_set;
+
+  /* result of the upscale, acquired from the render target pool until it is
+   * sharpened */
+  GPUAttachment *upscaled_attachment;
+};
\ No newline at end of file
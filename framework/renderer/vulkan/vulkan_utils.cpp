@@ -46,6 +46,12 @@ VkFormat VulkanUtils::GPUFormatToVulkanFormat(GPUFormat format) {
   case GPU_FORMAT_RGB32F: {
     return VK_FORMAT_R32G32B32_SFLOAT;
   } break;
+  case GPU_FORMAT_R32F: {
+    return VK_FORMAT_R32_SFLOAT;
+  } break;
+  case GPU_FORMAT_RGBA32F: {
+    return VK_FORMAT_R32G32B32A32_SFLOAT;
+  } break;
   case GPU_FORMAT_RGB8: {
     return VK_FORMAT_R8G8B8A8_UNORM; /* TODO: what? */
   } break;
@@ -76,6 +82,12 @@ VkFormat VulkanUtils::GPUFormatToVulkanFormat(GPUFormat format) {
   return VK_FORMAT_UNDEFINED;
 }
 
+bool VulkanUtils::FormatHasStencil(VkFormat format) {
+  return format == VK_FORMAT_S8_UINT || format == VK_FORMAT_D16_UNORM_S8_UINT ||
+         format == VK_FORMAT_D24_UNORM_S8_UINT ||
+         format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
 VkShaderStageFlagBits
 VulkanUtils::GPUShaderStageTypeToVulkanStage(GPUShaderStageType stage) {
   switch (stage) {
@@ -94,6 +106,9 @@ VulkanUtils::GPUShaderStageTypeToVulkanStage(GPUShaderStageType stage) {
   case GPU_SHADER_STAGE_TYPE_TESSELLATION_EVALUATION: {
     return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
   } break;
+  case GPU_SHADER_STAGE_TYPE_COMPUTE: {
+    return VK_SHADER_STAGE_COMPUTE_BIT;
+  } break;
   default: {
     ERROR("Unsupported shader stage!")
     return VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
@@ -127,28 +142,6 @@ VulkanUtils::GPUTextureUsageToVulkanAspectFlags(GPUAttachmentUsage usage) {
   return VK_IMAGE_ASPECT_NONE_KHR;
 }
 
-VkShaderStageFlags
-VulkanUtils::GPUShaderStageFlagsToVulkanShaderStageFlags(uint8_t stage_flags) {
-  VkShaderStageFlags result = VK_SHADER_STAGE_ALL_GRAPHICS; /* TODO: */
-  if (stage_flags & GPU_SHADER_STAGE_TYPE_VERTEX) {
-    result |= VK_SHADER_STAGE_FRAGMENT_BIT;
-  }
-  if (stage_flags & GPU_SHADER_STAGE_TYPE_FRAGMENT) {
-    result |= VK_SHADER_STAGE_VERTEX_BIT;
-  }
-  if (stage_flags & GPU_SHADER_STAGE_TYPE_GEOMETRY) {
-    result |= VK_SHADER_STAGE_GEOMETRY_BIT;
-  }
-  if (stage_flags & GPU_SHADER_STAGE_TYPE_TESSELLATION_CONTROL) {
-    result |= VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
-  }
-  if (stage_flags & GPU_SHADER_STAGE_TYPE_TESSELLATION_EVALUATION) {
-    result |= VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
-  }
-
-  return result;
-}
-
 VkPrimitiveTopology
 VulkanUtils::GPUShaderTopologyTypeToVulkanTopology(GPUShaderTopologyType type) {
   switch (type) {
@@ -168,4 +161,283 @@ VulkanUtils::GPUShaderTopologyTypeToVulkanTopology(GPUShaderTopologyType type) {
   }
 
   return VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
-}
\ No newline at end of file
+}
+VkCullModeFlags
+VulkanUtils::GPUShaderCullModeToVulkanCullMode(GPUShaderCullMode mode) {
+  switch (mode) {
+  case GPU_SHADER_CULL_MODE_NONE: {
+    return VK_CULL_MODE_NONE;
+  } break;
+  case GPU_SHADER_CULL_MODE_FRONT: {
+    return VK_CULL_MODE_FRONT_BIT;
+  } break;
+  case GPU_SHADER_CULL_MODE_BACK: {
+    return VK_CULL_MODE_BACK_BIT;
+  } break;
+  case GPU_SHADER_CULL_MODE_FRONT_AND_BACK: {
+    return VK_CULL_MODE_FRONT_AND_BACK;
+  } break;
+  default: {
+    ERROR("Unsupported cull mode!");
+    return VK_CULL_MODE_NONE;
+  } break;
+  }
+
+  return VK_CULL_MODE_NONE;
+}
+
+VkFrontFace VulkanUtils::GPUShaderFrontFaceToVulkanFrontFace(
+    GPUShaderFrontFace front_face) {
+  switch (front_face) {
+  case GPU_SHADER_FRONT_FACE_COUNTER_CLOCKWISE: {
+    return VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  } break;
+  case GPU_SHADER_FRONT_FACE_CLOCKWISE: {
+    return VK_FRONT_FACE_CLOCKWISE;
+  } break;
+  default: {
+    ERROR("Unsupported front face!");
+    return VK_FRONT_FACE_MAX_ENUM;
+  } break;
+  }
+
+  return VK_FRONT_FACE_MAX_ENUM;
+}
+
+VkCompareOp VulkanUtils::GPUShaderCompareOperationToVulkanCompareOp(
+    GPUShaderCompareOperation operation) {
+  switch (operation) {
+  case GPU_SHADER_COMPARE_OPERATION_NEVER: {
+    return VK_COMPARE_OP_NEVER;
+  } break;
+  case GPU_SHADER_COMPARE_OPERATION_LESS: {
+    return VK_COMPARE_OP_LESS;
+  } break;
+  case GPU_SHADER_COMPARE_OPERATION_EQUAL: {
+    return VK_COMPARE_OP_EQUAL;
+  } break;
+  case GPU_SHADER_COMPARE_OPERATION_LESS_OR_EQUAL: {
+    return VK_COMPARE_OP_LESS_OR_EQUAL;
+  } break;
+  case GPU_SHADER_COMPARE_OPERATION_GREATER: {
+    return VK_COMPARE_OP_GREATER;
+  } break;
+  case GPU_SHADER_COMPARE_OPERATION_NOT_EQUAL: {
+    return VK_COMPARE_OP_NOT_EQUAL;
+  } break;
+  case GPU_SHADER_COMPARE_OPERATION_GREATER_OR_EQUAL: {
+    return VK_COMPARE_OP_GREATER_OR_EQUAL;
+  } break;
+  case GPU_SHADER_COMPARE_OPERATION_ALWAYS: {
+    return VK_COMPARE_OP_ALWAYS;
+  } break;
+  default: {
+    ERROR("Unsupported compare operation!");
+    return VK_COMPARE_OP_MAX_ENUM;
+  } break;
+  }
+
+  return VK_COMPARE_OP_MAX_ENUM;
+}
+
+VkStencilOp VulkanUtils::GPUShaderStencilOperationToVulkanStencilOp(
+    GPUShaderStencilOperation operation) {
+  switch (operation) {
+  case GPU_SHADER_STENCIL_OPERATION_KEEP: {
+    return VK_STENCIL_OP_KEEP;
+  } break;
+  case GPU_SHADER_STENCIL_OPERATION_ZERO: {
+    return VK_STENCIL_OP_ZERO;
+  } break;
+  case GPU_SHADER_STENCIL_OPERATION_REPLACE: {
+    return VK_STENCIL_OP_REPLACE;
+  } break;
+  case GPU_SHADER_STENCIL_OPERATION_INCREMENT_AND_CLAMP: {
+    return VK_STENCIL_OP_INCREMENT_AND_CLAMP;
+  } break;
+  case GPU_SHADER_STENCIL_OPERATION_DECREMENT_AND_CLAMP: {
+    return VK_STENCIL_OP_DECREMENT_AND_CLAMP;
+  } break;
+  case GPU_SHADER_STENCIL_OPERATION_INVERT: {
+    return VK_STENCIL_OP_INVERT;
+  } break;
+  case GPU_SHADER_STENCIL_OPERATION_INCREMENT_AND_WRAP: {
+    return VK_STENCIL_OP_INCREMENT_AND_WRAP;
+  } break;
+  case GPU_SHADER_STENCIL_OPERATION_DECREMENT_AND_WRAP: {
+    return VK_STENCIL_OP_DECREMENT_AND_WRAP;
+  } break;
+  default: {
+    ERROR("Unsupported stencil operation!");
+    return VK_STENCIL_OP_MAX_ENUM;
+  } break;
+  }
+
+  return VK_STENCIL_OP_MAX_ENUM;
+}
+
+VkStencilOpState
+VulkanUtils::GPUShaderStencilStateToVulkanStencilOpState(
+    GPUShaderStencilState *state) {
+  VkStencilOpState result = {};
+  result.failOp =
+      GPUShaderStencilOperationToVulkanStencilOp(state->fail_operation);
+  result.passOp =
+      GPUShaderStencilOperationToVulkanStencilOp(state->pass_operation);
+  result.depthFailOp =
+      GPUShaderStencilOperationToVulkanStencilOp(state->depth_fail_operation);
+  result.compareOp =
+      GPUShaderCompareOperationToVulkanCompareOp(state->compare_operation);
+  result.compareMask = state->compare_mask;
+  result.writeMask = state->write_mask;
+  result.reference = state->reference;
+
+  return result;
+}
+
+VkBlendFactor VulkanUtils::GPUShaderBlendFactorToVulkanBlendFactor(
+    GPUShaderBlendFactor factor) {
+  switch (factor) {
+  case GPU_SHADER_BLEND_FACTOR_ZERO: {
+    return VK_BLEND_FACTOR_ZERO;
+  } break;
+  case GPU_SHADER_BLEND_FACTOR_ONE: {
+    return VK_BLEND_FACTOR_ONE;
+  } break;
+  case GPU_SHADER_BLEND_FACTOR_SRC_COLOR: {
+    return VK_BLEND_FACTOR_SRC_COLOR;
+  } break;
+  case GPU_SHADER_BLEND_FACTOR_ONE_MINUS_SRC_COLOR: {
+    return VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+  } break;
+  case GPU_SHADER_BLEND_FACTOR_DST_COLOR: {
+    return VK_BLEND_FACTOR_DST_COLOR;
+  } break;
+  case GPU_SHADER_BLEND_FACTOR_ONE_MINUS_DST_COLOR: {
+    return VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+  } break;
+  case GPU_SHADER_BLEND_FACTOR_SRC_ALPHA: {
+    return VK_BLEND_FACTOR_SRC_ALPHA;
+  } break;
+  case GPU_SHADER_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA: {
+    return VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  } break;
+  case GPU_SHADER_BLEND_FACTOR_DST_ALPHA: {
+    return VK_BLEND_FACTOR_DST_ALPHA;
+  } break;
+  case GPU_SHADER_BLEND_FACTOR_ONE_MINUS_DST_ALPHA: {
+    return VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
+  } break;
+  default: {
+    ERROR("Unsupported blend factor!");
+    return VK_BLEND_FACTOR_MAX_ENUM;
+  } break;
+  }
+
+  return VK_BLEND_FACTOR_MAX_ENUM;
+}
+
+VkBlendOp VulkanUtils::GPUShaderBlendOperationToVulkanBlendOp(
+    GPUShaderBlendOperation operation) {
+  switch (operation) {
+  case GPU_SHADER_BLEND_OPERATION_ADD: {
+    return VK_BLEND_OP_ADD;
+  } break;
+  case GPU_SHADER_BLEND_OPERATION_SUBTRACT: {
+    return VK_BLEND_OP_SUBTRACT;
+  } break;
+  case GPU_SHADER_BLEND_OPERATION_REVERSE_SUBTRACT: {
+    return VK_BLEND_OP_REVERSE_SUBTRACT;
+  } break;
+  case GPU_SHADER_BLEND_OPERATION_MIN: {
+    return VK_BLEND_OP_MIN;
+  } break;
+  case GPU_SHADER_BLEND_OPERATION_MAX: {
+    return VK_BLEND_OP_MAX;
+  } break;
+  default: {
+    ERROR("Unsupported blend operation!");
+    return VK_BLEND_OP_MAX_ENUM;
+  } break;
+  }
+
+  return VK_BLEND_OP_MAX_ENUM;
+}
+
+VkPipelineColorBlendAttachmentState
+VulkanUtils::GPUShaderBlendStateToVulkanBlendAttachmentState(
+    GPUShaderBlendState *state) {
+  VkPipelineColorBlendAttachmentState result = {};
+  result.blendEnable = state->blend_enable ? VK_TRUE : VK_FALSE;
+  result.srcColorBlendFactor =
+      GPUShaderBlendFactorToVulkanBlendFactor(state->src_color_factor);
+  result.dstColorBlendFactor =
+      GPUShaderBlendFactorToVulkanBlendFactor(state->dst_color_factor);
+  result.colorBlendOp =
+      GPUShaderBlendOperationToVulkanBlendOp(state->color_operation);
+  result.srcAlphaBlendFactor =
+      GPUShaderBlendFactorToVulkanBlendFactor(state->src_alpha_factor);
+  result.dstAlphaBlendFactor =
+      GPUShaderBlendFactorToVulkanBlendFactor(state->dst_alpha_factor);
+  result.alphaBlendOp =
+      GPUShaderBlendOperationToVulkanBlendOp(state->alpha_operation);
+  result.colorWriteMask = 0;
+  if (state->color_write_mask & GPU_SHADER_COLOR_COMPONENT_FLAG_R) {
+    result.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
+  }
+  if (state->color_write_mask & GPU_SHADER_COLOR_COMPONENT_FLAG_G) {
+    result.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
+  }
+  if (state->color_write_mask & GPU_SHADER_COLOR_COMPONENT_FLAG_B) {
+    result.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
+  }
+  if (state->color_write_mask & GPU_SHADER_COLOR_COMPONENT_FLAG_A) {
+    result.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
+  }
+
+  return result;
+}
+
+VkPresentModeKHR
+VulkanUtils::GPUPresentModeToVulkanPresentMode(GPUPresentMode present_mode) {
+  switch (present_mode) {
+  case GPU_PRESENT_MODE_FIFO: {
+    return VK_PRESENT_MODE_FIFO_KHR;
+  } break;
+  case GPU_PRESENT_MODE_FIFO_RELAXED: {
+    return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+  } break;
+  case GPU_PRESENT_MODE_MAILBOX: {
+    return VK_PRESENT_MODE_MAILBOX_KHR;
+  } break;
+  case GPU_PRESENT_MODE_IMMEDIATE: {
+    return VK_PRESENT_MODE_IMMEDIATE_KHR;
+  } break;
+  default: {
+    ERROR("Unsupported present mode!");
+    return VK_PRESENT_MODE_FIFO_KHR;
+  } break;
+  }
+
+  return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+GPUPresentMode
+VulkanUtils::VulkanPresentModeToGPUPresentMode(VkPresentModeKHR present_mode) {
+  switch (present_mode) {
+  case VK_PRESENT_MODE_FIFO_RELAXED_KHR: {
+    return GPU_PRESENT_MODE_FIFO_RELAXED;
+  } break;
+  case VK_PRESENT_MODE_MAILBOX_KHR: {
+    return GPU_PRESENT_MODE_MAILBOX;
+  } break;
+  case VK_PRESENT_MODE_IMMEDIATE_KHR: {
+    return GPU_PRESENT_MODE_IMMEDIATE;
+  } break;
+  default: {
+    return GPU_PRESENT_MODE_FIFO;
+  } break;
+  }
+
+  return GPU_PRESENT_MODE_FIFO;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../gpu_core.h"
 #include "../gpu_shader.h"
 #include "../gpu_texture.h"
 
@@ -12,12 +13,31 @@ public:
                                  VkMemoryPropertyFlags property_flags);
   static size_t GetDynamicAlignment(size_t element_size);
   static VkFormat GPUFormatToVulkanFormat(GPUFormat format);
+  static bool FormatHasStencil(VkFormat format);
   static VkShaderStageFlagBits
   GPUShaderStageTypeToVulkanStage(GPUShaderStageType stage);
   static VkImageAspectFlags
   GPUTextureUsageToVulkanAspectFlags(GPUAttachmentUsage usage);
-  static VkShaderStageFlags
-  GPUShaderStageFlagsToVulkanShaderStageFlags(uint8_t stage_flags);
   static VkPrimitiveTopology
   GPUShaderTopologyTypeToVulkanTopology(GPUShaderTopologyType type);
+  static VkCullModeFlags
+  GPUShaderCullModeToVulkanCullMode(GPUShaderCullMode mode);
+  static VkFrontFace
+  GPUShaderFrontFaceToVulkanFrontFace(GPUShaderFrontFace front_face);
+  static VkCompareOp GPUShaderCompareOperationToVulkanCompareOp(
+      GPUShaderCompareOperation operation);
+  static VkStencilOp GPUShaderStencilOperationToVulkanStencilOp(
+      GPUShaderStencilOperation operation);
+  static VkStencilOpState
+  GPUShaderStencilStateToVulkanStencilOpState(GPUShaderStencilState *state);
+  static VkBlendFactor
+  GPUShaderBlendFactorToVulkanBlendFactor(GPUShaderBlendFactor factor);
+  static VkBlendOp
+  GPUShaderBlendOperationToVulkanBlendOp(GPUShaderBlendOperation operation);
+  static VkPipelineColorBlendAttachmentState
+  GPUShaderBlendStateToVulkanBlendAttachmentState(GPUShaderBlendState *state);
+  static VkPresentModeKHR
+  GPUPresentModeToVulkanPresentMode(GPUPresentMode present_mode);
+  static GPUPresentMode
+  VulkanPresentModeToGPUPresentMode(VkPresentModeKHR present_mode);
 };
\ No newline at end of file
@@ -0,0 +1,582 @@
+/* Static cost report of the compiled shaders.
+ *
+ * usage: shader_report [--format json|csv] [--output <file>]
+ *                      [--baseline <report.csv>] [--threshold <factor>]
+ *                      <directory or .spv files...>
+ *
+ * Every metric is derived from the SPIR-V alone, so the numbers are only
+ * proxies of the real cost on the GPU, but they are stable enough to be
+ * diffed between changes. With a baseline, the tool fails if any metric of a
+ * shader grew by the threshold factor or more */
+
+#define SPV_ENABLE_UTILITY_CODE
+#include <spirv_cross/spirv.hpp>
+#include <spirv_cross/spirv_cross.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum ShaderMetric {
+  SHADER_METRIC_INSTRUCTIONS,
+  SHADER_METRIC_ALU,
+  SHADER_METRIC_TEXTURE_SAMPLES,
+  SHADER_METRIC_MEMORY,
+  SHADER_METRIC_BRANCHES,
+  SHADER_METRIC_LOOPS,
+  SHADER_METRIC_CALLS,
+  SHADER_METRIC_PEAK_LIVE_VALUES,
+  SHADER_METRIC_LOCAL_VARIABLES,
+  SHADER_METRIC_UNIFORM_BUFFERS,
+  SHADER_METRIC_UNIFORM_BUFFER_BYTES,
+  SHADER_METRIC_STORAGE_BUFFERS,
+  SHADER_METRIC_SAMPLED_IMAGES,
+  SHADER_METRIC_STORAGE_IMAGES,
+  SHADER_METRIC_PUSH_CONSTANT_BYTES,
+  SHADER_METRIC_INPUT_COMPONENTS,
+  SHADER_METRIC_OUTPUT_COMPONENTS,
+  SHADER_METRIC_MAX,
+};
+
+static const char *metric_names[SHADER_METRIC_MAX] = {
+    "instructions",
+    "alu",
+    "texture_samples",
+    "memory",
+    "branches",
+    "loops",
+    "calls",
+    "peak_live_values",
+    "local_variables",
+    "uniform_buffers",
+    "uniform_buffer_bytes",
+    "storage_buffers",
+    "sampled_images",
+    "storage_images",
+    "push_constant_bytes",
+    "input_components",
+    "output_components",
+};
+
+struct ShaderReport {
+  std::string name;
+  std::string stage;
+  uint64_t metrics[SHADER_METRIC_MAX];
+};
+
+static bool ReadFile(const std::string &path, std::vector<uint32_t> &words) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    fprintf(stderr, "Failed to open file %s\n", path.c_str());
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  int64_t file_size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  words.resize(file_size / sizeof(uint32_t));
+  bool result = file_size % sizeof(uint32_t) == 0 &&
+                fread(words.data(), sizeof(uint32_t), words.size(), file) ==
+                    words.size();
+  fclose(file);
+
+  if (!result || words.size() < 5 || words[0] != spv::MagicNumber) {
+    fprintf(stderr, "%s is not a SPIR-V binary\n", path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+static const char *GetStageName(spv::ExecutionModel model) {
+  switch (model) {
+  case spv::ExecutionModelVertex: {
+    return "vert";
+  } break;
+  case spv::ExecutionModelTessellationControl: {
+    return "tesc";
+  } break;
+  case spv::ExecutionModelTessellationEvaluation: {
+    return "tese";
+  } break;
+  case spv::ExecutionModelGeometry: {
+    return "geom";
+  } break;
+  case spv::ExecutionModelFragment: {
+    return "frag";
+  } break;
+  case spv::ExecutionModelGLCompute: {
+    return "comp";
+  } break;
+  default: {
+    return "unknown";
+  } break;
+  }
+}
+
+static bool IsTextureSample(spv::Op op) {
+  return (op >= spv::OpImageSampleImplicitLod &&
+          op <= spv::OpImageSampleProjDrefExplicitLod) ||
+         op == spv::OpImageFetch || op == spv::OpImageGather ||
+         op == spv::OpImageDrefGather ||
+         (op >= spv::OpImageSparseSampleImplicitLod &&
+          op <= spv::OpImageSparseDrefGather);
+}
+
+static bool IsAlu(spv::Op op) {
+  return op == spv::OpExtInst ||
+         (op >= spv::OpConvertFToU && op <= spv::OpBitcast) ||
+         (op >= spv::OpSNegate && op <= spv::OpFwidthCoarse) ||
+         (op >= spv::OpVectorExtractDynamic && op <= spv::OpTranspose);
+}
+
+static bool IsMemory(spv::Op op) {
+  return op == spv::OpLoad || op == spv::OpStore || op == spv::OpImageRead ||
+         op == spv::OpImageWrite || op == spv::OpCopyMemory ||
+         (op >= spv::OpAtomicLoad && op <= spv::OpAtomicXor);
+}
+
+/* instructions that only describe the structure of the code */
+static bool IsBookkeeping(spv::Op op) {
+  return op == spv::OpLabel || op == spv::OpLine || op == spv::OpNoLine ||
+         op == spv::OpFunction || op == spv::OpFunctionParameter ||
+         op == spv::OpFunctionEnd || op == spv::OpVariable ||
+         op == spv::OpSelectionMerge || op == spv::OpLoopMerge;
+}
+
+/* the peak number of simultaneously live ssa values, with live ranges taken
+ * in the instruction order. Loops don't extend the ranges, so it is a lower
+ * bound of the register pressure */
+static uint64_t GetPeakLiveValues(std::vector<uint32_t> &words, size_t begin,
+                                  size_t end) {
+  std::unordered_map<uint32_t, uint32_t> definitions;
+  std::unordered_map<uint32_t, uint32_t> last_uses;
+
+  uint32_t index = 0;
+  for (size_t offset = begin; offset < end; offset += words[offset] >> 16) {
+    spv::Op op = (spv::Op)(words[offset] & 0xffff);
+    uint32_t word_count = words[offset] >> 16;
+    bool has_result = false;
+    bool has_result_type = false;
+    spv::HasResultAndType(op, &has_result, &has_result_type);
+
+    uint32_t first_operand = 1 + has_result + has_result_type;
+    for (uint32_t i = first_operand; i < word_count; ++i) {
+      auto it = definitions.find(words[offset + i]);
+      if (it != definitions.end()) {
+        last_uses[it->first] = index;
+      }
+    }
+
+    if (has_result && op != spv::OpLabel && op != spv::OpVariable &&
+        op != spv::OpFunction) {
+      uint32_t id = words[offset + 1 + has_result_type];
+      definitions[id] = index;
+      last_uses[id] = index;
+    }
+
+    ++index;
+  }
+
+  std::vector<int64_t> changes(index + 1, 0);
+  for (auto &pair : definitions) {
+    changes[pair.second]++;
+    changes[last_uses[pair.first] + 1]--;
+  }
+
+  int64_t live = 0;
+  int64_t peak = 0;
+  for (uint32_t i = 0; i < changes.size(); ++i) {
+    live += changes[i];
+    peak = std::max(peak, live);
+  }
+
+  return peak;
+}
+
+static bool ReportInstructions(std::vector<uint32_t> &words,
+                               ShaderReport &report) {
+  size_t function_begin = 0;
+  bool in_function = false;
+
+  for (size_t offset = 5; offset < words.size();) {
+    uint32_t word_count = words[offset] >> 16;
+    spv::Op op = (spv::Op)(words[offset] & 0xffff);
+    if (!word_count || offset + word_count > words.size()) {
+      fprintf(stderr, "%s has a malformed instruction\n",
+              report.name.c_str());
+      return false;
+    }
+
+    if (op == spv::OpFunction) {
+      function_begin = offset;
+      in_function = true;
+    } else if (op == spv::OpFunctionEnd) {
+      uint64_t peak = GetPeakLiveValues(words, function_begin, offset);
+      report.metrics[SHADER_METRIC_PEAK_LIVE_VALUES] =
+          std::max(report.metrics[SHADER_METRIC_PEAK_LIVE_VALUES], peak);
+      in_function = false;
+    }
+
+    if (in_function) {
+      if (op == spv::OpVariable) {
+        report.metrics[SHADER_METRIC_LOCAL_VARIABLES]++;
+      }
+      if (op == spv::OpLoopMerge) {
+        report.metrics[SHADER_METRIC_LOOPS]++;
+      }
+
+      if (!IsBookkeeping(op)) {
+        report.metrics[SHADER_METRIC_INSTRUCTIONS]++;
+        if (IsTextureSample(op)) {
+          report.metrics[SHADER_METRIC_TEXTURE_SAMPLES]++;
+        } else if (IsAlu(op)) {
+          report.metrics[SHADER_METRIC_ALU]++;
+        } else if (IsMemory(op)) {
+          report.metrics[SHADER_METRIC_MEMORY]++;
+        } else if (op == spv::OpBranchConditional || op == spv::OpSwitch) {
+          report.metrics[SHADER_METRIC_BRANCHES]++;
+        } else if (op == spv::OpFunctionCall) {
+          report.metrics[SHADER_METRIC_CALLS]++;
+        }
+      }
+    }
+
+    offset += word_count;
+  }
+
+  return true;
+}
+
+static uint64_t
+GetInterfaceComponents(spirv_cross::Compiler &compiler,
+                       spirv_cross::SmallVector<spirv_cross::Resource> &vars) {
+  uint64_t components = 0;
+  for (uint32_t i = 0; i < vars.size(); ++i) {
+    const spirv_cross::SPIRType &type = compiler.get_type(vars[i].type_id);
+    uint64_t count = type.vecsize * type.columns;
+    for (uint32_t j = 0; j < type.array.size(); ++j) {
+      count *= std::max<uint32_t>(type.array[j], 1);
+    }
+    components += count;
+  }
+
+  return components;
+}
+
+static uint64_t GetDescriptorCount(
+    spirv_cross::Compiler &compiler,
+    spirv_cross::SmallVector<spirv_cross::Resource> &resources) {
+  uint64_t count = 0;
+  for (uint32_t i = 0; i < resources.size(); ++i) {
+    const spirv_cross::SPIRType &type = compiler.get_type(resources[i].type_id);
+    uint64_t array_size = 1;
+    for (uint32_t j = 0; j < type.array.size(); ++j) {
+      array_size *= std::max<uint32_t>(type.array[j], 1);
+    }
+    count += array_size;
+  }
+
+  return count;
+}
+
+static void ReportResources(std::vector<uint32_t> &words,
+                            ShaderReport &report) {
+  spirv_cross::Compiler compiler(words.data(), words.size());
+  spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+  report.stage = GetStageName(compiler.get_execution_model());
+
+  report.metrics[SHADER_METRIC_UNIFORM_BUFFERS] =
+      GetDescriptorCount(compiler, resources.uniform_buffers);
+  for (uint32_t i = 0; i < resources.uniform_buffers.size(); ++i) {
+    const spirv_cross::SPIRType &type =
+        compiler.get_type(resources.uniform_buffers[i].base_type_id);
+    report.metrics[SHADER_METRIC_UNIFORM_BUFFER_BYTES] +=
+        compiler.get_declared_struct_size(type);
+  }
+  report.metrics[SHADER_METRIC_STORAGE_BUFFERS] =
+      GetDescriptorCount(compiler, resources.storage_buffers);
+  report.metrics[SHADER_METRIC_SAMPLED_IMAGES] =
+      GetDescriptorCount(compiler, resources.sampled_images) +
+      GetDescriptorCount(compiler, resources.separate_images);
+  report.metrics[SHADER_METRIC_STORAGE_IMAGES] =
+      GetDescriptorCount(compiler, resources.storage_images);
+  for (uint32_t i = 0; i < resources.push_constant_buffers.size(); ++i) {
+    const spirv_cross::SPIRType &type =
+        compiler.get_type(resources.push_constant_buffers[i].base_type_id);
+    report.metrics[SHADER_METRIC_PUSH_CONSTANT_BYTES] +=
+        compiler.get_declared_struct_size(type);
+  }
+  report.metrics[SHADER_METRIC_INPUT_COMPONENTS] =
+      GetInterfaceComponents(compiler, resources.stage_inputs);
+  report.metrics[SHADER_METRIC_OUTPUT_COMPONENTS] =
+      GetInterfaceComponents(compiler, resources.stage_outputs);
+}
+
+static bool CreateReport(const std::string &path, ShaderReport &report) {
+  report = {};
+  report.name = std::filesystem::path(path).filename().string();
+  if (report.name.size() > 4 &&
+      report.name.compare(report.name.size() - 4, 4, ".spv") == 0) {
+    report.name.resize(report.name.size() - 4);
+  }
+
+  std::vector<uint32_t> words;
+  if (!ReadFile(path, words)) {
+    return false;
+  }
+
+  if (!ReportInstructions(words, report)) {
+    return false;
+  }
+
+  try {
+    ReportResources(words, report);
+  } catch (const spirv_cross::CompilerError &error) {
+    fprintf(stderr, "Failed to reflect %s: %s\n", path.c_str(), error.what());
+    return false;
+  }
+
+  return true;
+}
+
+static void WriteJson(FILE *file, std::vector<ShaderReport> &reports) {
+  fprintf(file, "{\n  \"shaders\": [\n");
+  for (uint32_t i = 0; i < reports.size(); ++i) {
+    fprintf(file, "    {\n");
+    fprintf(file, "      \"name\": \"%s\",\n", reports[i].name.c_str());
+    fprintf(file, "      \"stage\": \"%s\",\n", reports[i].stage.c_str());
+    for (uint32_t j = 0; j < SHADER_METRIC_MAX; ++j) {
+      fprintf(file, "      \"%s\": %llu%s\n", metric_names[j],
+              (unsigned long long)reports[i].metrics[j],
+              j + 1 < SHADER_METRIC_MAX ? "," : "");
+    }
+    fprintf(file, "    }%s\n", i + 1 < reports.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+}
+
+static void WriteCsv(FILE *file, std::vector<ShaderReport> &reports) {
+  fprintf(file, "name,stage");
+  for (uint32_t i = 0; i < SHADER_METRIC_MAX; ++i) {
+    fprintf(file, ",%s", metric_names[i]);
+  }
+  fprintf(file, "\n");
+
+  for (uint32_t i = 0; i < reports.size(); ++i) {
+    fprintf(file, "%s,%s", reports[i].name.c_str(), reports[i].stage.c_str());
+    for (uint32_t j = 0; j < SHADER_METRIC_MAX; ++j) {
+      fprintf(file, ",%llu", (unsigned long long)reports[i].metrics[j]);
+    }
+    fprintf(file, "\n");
+  }
+}
+
+static std::vector<std::string> SplitCsvLine(const std::string &line) {
+  std::vector<std::string> fields;
+  size_t start = 0;
+  while (true) {
+    size_t end = line.find(',', start);
+    fields.emplace_back(line.substr(start, end - start));
+    if (end == std::string::npos) {
+      break;
+    }
+    start = end + 1;
+  }
+
+  return fields;
+}
+
+/* baseline is a csv report. Columns are matched by name, so the baselines
+ * stay usable when metrics are added */
+static bool ReadBaseline(const char *path,
+                         std::unordered_map<std::string, ShaderReport> &out) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr,
+            "Failed to open baseline %s, record one with the "
+            "shader_report_baseline target\n",
+            path);
+    return false;
+  }
+
+  std::vector<int32_t> columns;
+  char buffer[4096];
+  while (fgets(buffer, sizeof(buffer), file)) {
+    std::string line = buffer;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      continue;
+    }
+
+    std::vector<std::string> fields = SplitCsvLine(line);
+    if (columns.empty()) {
+      for (uint32_t i = 0; i < fields.size(); ++i) {
+        int32_t metric = -1;
+        for (uint32_t j = 0; j < SHADER_METRIC_MAX; ++j) {
+          if (fields[i] == metric_names[j]) {
+            metric = j;
+          }
+        }
+        columns.emplace_back(metric);
+      }
+      continue;
+    }
+
+    ShaderReport report = {};
+    report.name = fields[0];
+    for (uint32_t i = 0; i < fields.size() && i < columns.size(); ++i) {
+      if (columns[i] >= 0) {
+        report.metrics[columns[i]] = strtoull(fields[i].c_str(), 0, 10);
+      }
+    }
+    out[report.name] = report;
+  }
+
+  fclose(file);
+
+  return true;
+}
+
+/* returns the number of regressions */
+static uint32_t CompareWithBaseline(
+    std::vector<ShaderReport> &reports,
+    std::unordered_map<std::string, ShaderReport> &baseline,
+    double threshold) {
+  uint32_t regressions = 0;
+  for (uint32_t i = 0; i < reports.size(); ++i) {
+    auto it = baseline.find(reports[i].name);
+    if (it == baseline.end()) {
+      fprintf(stderr, "note: %s is not in the baseline\n",
+              reports[i].name.c_str());
+      continue;
+    }
+
+    for (uint32_t j = 0; j < SHADER_METRIC_MAX; ++j) {
+      uint64_t previous = it->second.metrics[j];
+      uint64_t current = reports[i].metrics[j];
+      /* a metric going from 0 to 1 is not worth failing the build for */
+      double limit = std::max<uint64_t>(previous, 1) * threshold;
+      if (current > previous && current >= limit) {
+        fprintf(stderr, "regression: %s %s %llu -> %llu\n",
+                reports[i].name.c_str(), metric_names[j],
+                (unsigned long long)previous, (unsigned long long)current);
+        ++regressions;
+      }
+    }
+  }
+
+  return regressions;
+}
+
+static void PrintUsage() {
+  fprintf(stderr,
+          "usage: shader_report [--format json|csv] [--output <file>]\n"
+          "                     [--baseline <report.csv>] "
+          "[--threshold <factor>]\n"
+          "                     <directory or .spv files...>\n");
+}
+
+int main(int argc, char **argv) {
+  const char *format = "json";
+  const char *output_path = 0;
+  const char *baseline_path = 0;
+  double threshold = 2.0;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--format") && has_value) {
+      format = argv[++i];
+    } else if (!strcmp(argv[i], "--output") && has_value) {
+      output_path = argv[++i];
+    } else if (!strcmp(argv[i], "--baseline") && has_value) {
+      baseline_path = argv[++i];
+    } else if (!strcmp(argv[i], "--threshold") && has_value) {
+      threshold = atof(argv[++i]);
+    } else if (argv[i][0] == '-') {
+      PrintUsage();
+      return 1;
+    } else {
+      paths.emplace_back(argv[i]);
+    }
+  }
+
+  if (paths.empty() || (strcmp(format, "json") && strcmp(format, "csv")) ||
+      threshold <= 1.0) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::vector<std::string> files;
+  for (uint32_t i = 0; i < paths.size(); ++i) {
+    if (!std::filesystem::is_directory(paths[i])) {
+      files.emplace_back(paths[i]);
+      continue;
+    }
+
+    for (auto &entry : std::filesystem::directory_iterator(paths[i])) {
+      if (entry.is_regular_file() && entry.path().extension() == ".spv") {
+        files.emplace_back(entry.path().string());
+      }
+    }
+  }
+  /* keep the report order stable, so that it can be diffed */
+  std::sort(files.begin(), files.end());
+
+  std::vector<ShaderReport> reports;
+  bool result = true;
+  for (uint32_t i = 0; i < files.size(); ++i) {
+    ShaderReport report;
+    if (!CreateReport(files[i], report)) {
+      result = false;
+      continue;
+    }
+    reports.emplace_back(report);
+  }
+
+  FILE *output = stdout;
+  if (output_path) {
+    output = fopen(output_path, "w");
+    if (!output) {
+      fprintf(stderr, "Failed to open file %s\n", output_path);
+      return 1;
+    }
+  }
+
+  if (!strcmp(format, "json")) {
+    WriteJson(output, reports);
+  } else {
+    WriteCsv(output, reports);
+  }
+
+  if (output != stdout) {
+    fclose(output);
+  }
+
+  if (baseline_path) {
+    std::unordered_map<std::string, ShaderReport> baseline;
+    if (!ReadBaseline(baseline_path, baseline)) {
+      return 1;
+    }
+
+    uint32_t regressions = CompareWithBaseline(reports, baseline, threshold);
+    if (regressions) {
+      fprintf(stderr, "%u shader cost regressions above %.2fx\n", regressions,
+              threshold);
+      result = false;
+    }
+  }
+
+  return result ? 0 : 1;
+}
\ No newline at end of file